@@ -0,0 +1,124 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "ARCoreIntegration.h"
+
+#include <Log.h>
+
+
+ARCoreIntegration::~ARCoreIntegration()
+{
+    reset();
+}
+
+
+void
+ARCoreIntegration::reset()
+{
+    if (mLightEstimate != nullptr)
+    {
+        ArLightEstimate_destroy(mLightEstimate);
+        mLightEstimate = nullptr;
+    }
+    if (mConfig != nullptr)
+    {
+        ArConfig_destroy(mConfig);
+        mConfig = nullptr;
+    }
+    mSession = nullptr;
+    mConfigValid = false;
+    mLastTimestamp = -1;
+}
+
+
+void
+ARCoreIntegration::update(VuController* platformController, FramePacket& packet)
+{
+    packet.fusionProviderValid = false;
+
+    // The ArFrame pointer is only guaranteed for the current Vuforia frame, the query fills a struct and allocates nothing
+    VuPlatformARCoreInfo arcoreInfo;
+    if (platformController == nullptr || vuPlatformControllerGetARCoreInfo(platformController, &arcoreInfo) != VU_SUCCESS ||
+        arcoreInfo.arSession == nullptr || arcoreInfo.arFrame == nullptr)
+    {
+        return;
+    }
+
+    auto session = static_cast<ArSession*>(arcoreInfo.arSession);
+    auto frame = static_cast<ArFrame*>(arcoreInfo.arFrame);
+    if (session != mSession)
+    {
+        reset();
+        mSession = session;
+        ArConfig_create(mSession, &mConfig);
+        ArLightEstimate_create(mSession, &mLightEstimate);
+    }
+    if (!mConfigValid)
+    {
+        readConfig();
+    }
+
+    int64_t timestamp = 0;
+    ArFrame_getTimestamp(mSession, frame, &timestamp);
+    if (timestamp != mLastTimestamp)
+    {
+        mLastTimestamp = timestamp;
+        mFrame.cameraTimestamp = timestamp;
+
+        ArCamera* camera = nullptr;
+        ArFrame_acquireCamera(mSession, frame, &camera);
+        ArTrackingState trackingState = AR_TRACKING_STATE_STOPPED;
+        ArCamera_getTrackingState(mSession, camera, &trackingState);
+        ArCamera_release(camera);
+        switch (trackingState)
+        {
+            case AR_TRACKING_STATE_TRACKING:
+                mFrame.trackingState = FramePacket::FusionProviderFrame::TrackingState::TRACKING;
+                break;
+            case AR_TRACKING_STATE_PAUSED:
+                mFrame.trackingState = FramePacket::FusionProviderFrame::TrackingState::PAUSED;
+                break;
+            default:
+                mFrame.trackingState = FramePacket::FusionProviderFrame::TrackingState::STOPPED;
+                break;
+        }
+
+        mFrame.lightEstimateValid = false;
+        if (mLightEstimationMode == AR_LIGHT_ESTIMATION_MODE_AMBIENT_INTENSITY && mLightEstimate != nullptr)
+        {
+            ArFrame_getLightEstimate(mSession, frame, mLightEstimate);
+            ArLightEstimateState lightEstimateState = AR_LIGHT_ESTIMATE_STATE_NOT_VALID;
+            ArLightEstimate_getState(mSession, mLightEstimate, &lightEstimateState);
+            if (lightEstimateState == AR_LIGHT_ESTIMATE_STATE_VALID)
+            {
+                ArLightEstimate_getPixelIntensity(mSession, mLightEstimate, &mFrame.pixelIntensity);
+                ArLightEstimate_getColorCorrection(mSession, mLightEstimate, mFrame.colorCorrection);
+                mFrame.lightEstimateValid = true;
+            }
+        }
+    }
+
+    packet.fusionProviderValid = true;
+    packet.fusionProvider = mFrame;
+}
+
+
+void
+ARCoreIntegration::readConfig()
+{
+    if (mConfig == nullptr)
+    {
+        return;
+    }
+    ArSession_getConfig(mSession, mConfig);
+    ArConfig_getLightEstimationMode(mSession, mConfig, &mLightEstimationMode);
+
+    ArFocusMode focusMode = AR_FOCUS_MODE_FIXED;
+    ArConfig_getFocusMode(mSession, mConfig, &focusMode);
+    LOG("ARCore session config: focus mode %d, light estimation mode %d", focusMode, mLightEstimationMode);
+    mConfigValid = true;
+}
@@ -0,0 +1,67 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_ARCOREINTEGRATION_H_
+#define _VUFORIA_ARCOREINTEGRATION_H_
+
+#include <FramePacket.h>
+
+#include <VuforiaEngine/VuforiaEngine.h>
+
+#include <arcore_c_api.h>
+
+#include <atomic>
+#include <cstdint>
+
+
+/// Access to the ARCore session Vuforia Engine runs on as its fusion provider
+/**
+ * The ArConfig and ArLightEstimate objects are created once per ARCore session and the session config
+ * is only read again after invalidateConfig, so a frame costs the Vuforia platform info query, the
+ * ArFrame timestamp and, for a new ARCore frame only, the camera tracking state and the light estimate.
+ * A restart of Vuforia may bring a new ARCore session, it is detected by its pointer and the cached
+ * objects are created again.
+ * Every call but invalidateConfig must be made on the render thread, the one Vuforia's state is updated on.
+ */
+class ARCoreIntegration
+{
+public:
+    ARCoreIntegration() = default;
+    ~ARCoreIntegration();
+
+    ARCoreIntegration(const ARCoreIntegration&) = delete;
+    ARCoreIntegration& operator=(const ARCoreIntegration&) = delete;
+
+    /// Read the session config again with the next frame, call after anything was done that changes it, e.g. a focus mode change
+    /// May be called from any thread.
+    void invalidateConfig() { mConfigValid = false; }
+
+    /// Release the ARCore objects, call before the engine is stopped
+    void reset();
+
+    /// Fill the fusion provider data of a frame packet from the current ARCore frame
+    void update(VuController* platformController, FramePacket& packet);
+
+    /// The cached config of the session, null before the first update
+    const ArConfig* getConfig() const { return mConfig; }
+
+private:
+    /// Read the config and the settings the frame update depends on
+    void readConfig();
+
+    ArSession* mSession = nullptr;
+    ArConfig* mConfig = nullptr;
+    ArLightEstimate* mLightEstimate = nullptr;
+    std::atomic<bool> mConfigValid{ false };
+    ArLightEstimationMode mLightEstimationMode = AR_LIGHT_ESTIMATION_MODE_DISABLED;
+
+    /// Data of the last ARCore frame, reported again until the timestamp changes
+    int64_t mLastTimestamp = -1;
+    FramePacket::FusionProviderFrame mFrame{};
+};
+
+#endif // _VUFORIA_ARCOREINTEGRATION_H_
@@ -0,0 +1,397 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "AssetCache.h"
+
+#include <Log.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <utility>
+
+
+namespace
+{
+/// "VACB", followed by the version of the file layout
+constexpr uint32_t FILE_MAGIC = 0x42434156;
+constexpr uint32_t FILE_VERSION = 1;
+
+constexpr const char* BLOB_SUFFIX = ".blob";
+
+/// Start of a blob file, followed by the content
+struct FileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint64_t size;
+};
+
+constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ull;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+/// Nanoseconds since the epoch, the resolution of the file modification times
+int64_t
+toNanoseconds(const timespec& time)
+{
+    return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+
+int64_t
+now()
+{
+    timespec time;
+    clock_gettime(CLOCK_REALTIME, &time);
+    return toNanoseconds(time);
+}
+
+
+/// Numbers the temporary files, so that threads storing the same key do not write into one file
+std::atomic<unsigned int> gTemporaryCount{ 0 };
+
+
+bool
+hasSuffix(const std::string& name, const char* suffix)
+{
+    size_t length = strlen(suffix);
+    return name.size() >= length && name.compare(name.size() - length, length, suffix) == 0;
+}
+
+
+/// Delete the files in a directory and the directory itself, the blob directories have no subdirectories
+void
+removeDirectory(const std::string& path)
+{
+    DIR* directory = opendir(path.c_str());
+    if (directory == nullptr)
+    {
+        return;
+    }
+    while (dirent* entry = readdir(directory))
+    {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+        {
+            unlink((path + "/" + entry->d_name).c_str());
+        }
+    }
+    closedir(directory);
+    rmdir(path.c_str());
+}
+
+} // anonymous namespace
+
+
+AssetCache::Blob::~Blob()
+{
+    close();
+}
+
+
+AssetCache::Blob::Blob(Blob&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+
+AssetCache::Blob&
+AssetCache::Blob::operator=(Blob&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        std::swap(mMapping, other.mMapping);
+        std::swap(mMappingSize, other.mMappingSize);
+        std::swap(mData, other.mData);
+        std::swap(mSize, other.mSize);
+    }
+    return *this;
+}
+
+
+void
+AssetCache::Blob::close()
+{
+    if (mMapping != nullptr)
+    {
+        munmap(mMapping, mMappingSize);
+        mMapping = nullptr;
+        mMappingSize = 0;
+    }
+    mData = nullptr;
+    mSize = 0;
+}
+
+
+void
+AssetCache::setDirectory(const std::string& directory, uint32_t version)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mDirectory.clear();
+    mEntries.clear();
+    mSizeBytes = 0;
+    if (directory.empty())
+    {
+        return;
+    }
+
+    // Blobs written by other versions are never read again
+    char versionName[16];
+    snprintf(versionName, sizeof(versionName), "v%" PRIu32, version);
+    mkdir(directory.c_str(), 0700);
+    if (DIR* parent = opendir(directory.c_str()))
+    {
+        while (dirent* entry = readdir(parent))
+        {
+            if (entry->d_name[0] == 'v' && strcmp(entry->d_name, versionName) != 0)
+            {
+                removeDirectory(directory + "/" + entry->d_name);
+            }
+        }
+        closedir(parent);
+    }
+
+    std::string versionDirectory = directory + "/" + versionName;
+    mkdir(versionDirectory.c_str(), 0700);
+    DIR* blobs = opendir(versionDirectory.c_str());
+    if (blobs == nullptr)
+    {
+        LOG("Error opening asset cache directory %s", versionDirectory.c_str());
+        return;
+    }
+    while (dirent* entry = readdir(blobs))
+    {
+        std::string name = entry->d_name;
+        std::string path = versionDirectory + "/" + name;
+        uint64_t key = 0;
+        struct stat status;
+        if (!hasSuffix(name, BLOB_SUFFIX))
+        {
+            // Temporary files of stores that did not finish
+            if (name != "." && name != "..")
+            {
+                unlink(path.c_str());
+            }
+        }
+        else if (sscanf(name.c_str(), "%016" SCNx64, &key) == 1 && stat(path.c_str(), &status) == 0)
+        {
+            mEntries[key] = Entry{ static_cast<size_t>(status.st_size), toNanoseconds(status.st_mtim) };
+            mSizeBytes += static_cast<size_t>(status.st_size);
+        }
+    }
+    closedir(blobs);
+
+    mDirectory = versionDirectory;
+    evict();
+    LOG("Asset cache %s holds %zu blobs, %zu bytes", mDirectory.c_str(), mEntries.size(), mSizeBytes);
+}
+
+
+void
+AssetCache::setBudget(size_t budgetBytes)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mBudgetBytes = budgetBytes;
+    evict();
+}
+
+
+bool
+AssetCache::isEnabled() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return !mDirectory.empty() && mBudgetBytes > 0;
+}
+
+
+uint64_t
+AssetCache::computeKey(const void* source, size_t size, const std::string& variant)
+{
+    // FNV-1a over 8 byte words with a shift folding the high bits back in,
+    // a byte at a time is too slow for sources of several megabytes
+    auto bytes = static_cast<const unsigned char*>(source);
+    uint64_t hash = FNV_OFFSET;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * FNV_PRIME;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    hash = (hash ^ size) * FNV_PRIME;
+    for (char c : variant)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * FNV_PRIME;
+    }
+    return hash;
+}
+
+
+bool
+AssetCache::load(uint64_t key, Blob& blob)
+{
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mDirectory.empty() || mEntries.count(key) == 0)
+        {
+            return false;
+        }
+        path = getPath(key);
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(FileHeader))
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        return false;
+    }
+    size_t fileSize = static_cast<size_t>(status.st_size);
+    void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    // Check the layout before trusting the content
+    FileHeader header;
+    memcpy(&header, mapping, sizeof(header));
+    if (header.magic != FILE_MAGIC || header.version != FILE_VERSION || header.key != key ||
+        header.size != fileSize - sizeof(header))
+    {
+        LOG("Asset cache blob %s is corrupt, deleted", path.c_str());
+        munmap(mapping, fileSize);
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto entry = mEntries.find(key);
+        if (entry != mEntries.end())
+        {
+            mSizeBytes -= entry->second.sizeBytes;
+            mEntries.erase(entry);
+        }
+        unlink(path.c_str());
+        return false;
+    }
+
+    blob.close();
+    blob.mMapping = mapping;
+    blob.mMappingSize = fileSize;
+    blob.mData = static_cast<const char*>(mapping) + sizeof(header);
+    blob.mSize = fileSize - sizeof(header);
+
+    // The modification time keeps the eviction order of this launch for the next ones
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto entry = mEntries.find(key);
+    if (entry != mEntries.end())
+    {
+        entry->second.lastUse = now();
+    }
+    return true;
+}
+
+
+bool
+AssetCache::store(uint64_t key, std::initializer_list<Part> parts)
+{
+    FileHeader header{ FILE_MAGIC, FILE_VERSION, key, 0 };
+    for (const auto& part : parts)
+    {
+        header.size += part.size;
+    }
+    size_t fileSize = sizeof(header) + static_cast<size_t>(header.size);
+
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mDirectory.empty() || fileSize > mBudgetBytes)
+        {
+            return false;
+        }
+        path = getPath(key);
+    }
+
+    // Written under a temporary name so that a crash never leaves a truncated blob behind
+    std::string temporaryPath = path + "." + std::to_string(gTemporaryCount++) + ".tmp";
+    FILE* file = fopen(temporaryPath.c_str(), "wb");
+    if (file == nullptr)
+    {
+        LOG("Error writing asset cache blob %s", temporaryPath.c_str());
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (const auto& part : parts)
+    {
+        written = written && (part.size == 0 || fwrite(part.data, 1, part.size, file) == part.size);
+    }
+    written = fclose(file) == 0 && written;
+    if (!written || rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        LOG("Error writing asset cache blob %s", path.c_str());
+        remove(temporaryPath.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    Entry& entry = mEntries[key];
+    mSizeBytes = mSizeBytes - entry.sizeBytes + fileSize;
+    entry = Entry{ fileSize, now() };
+    evict();
+    return true;
+}
+
+
+std::string
+AssetCache::getPath(uint64_t key) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/%016" PRIx64 "%s", key, BLOB_SUFFIX);
+    return mDirectory + name;
+}
+
+
+void
+AssetCache::evict()
+{
+    if (mDirectory.empty())
+    {
+        return;
+    }
+    // Linear in the number of blobs, which stays in the hundreds for the assets of an app
+    while (mSizeBytes > mBudgetBytes && !mEntries.empty())
+    {
+        auto oldest = mEntries.begin();
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it)
+        {
+            if (it->second.lastUse < oldest->second.lastUse)
+            {
+                oldest = it;
+            }
+        }
+        unlink(getPath(oldest->first).c_str());
+        mSizeBytes -= oldest->second.sizeBytes;
+        mEntries.erase(oldest);
+    }
+}
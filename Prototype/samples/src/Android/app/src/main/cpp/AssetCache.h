@@ -0,0 +1,111 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_ASSETCACHE_H_
+#define _VUFORIA_ASSETCACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+
+/// Processed assets kept as files on disk, so that later launches map them instead of processing their sources again
+/**
+ * A blob is stored per source and processing, keyed by a hash of the source bytes and of a variant string
+ * naming the processing and its parameters, e.g. the quantization of a mesh or the size a texture is decoded at.
+ * Blobs are written under a temporary name and renamed, so a crash never leaves a truncated blob behind.
+ *
+ * The blobs live in a subdirectory per version, blobs of other versions are deleted when the directory is set.
+ * Once the blobs exceed the budget the least recently used ones are deleted, a load marks a blob used by
+ * setting its modification time, which carries the order over to the next launch.
+ * All methods are thread safe, the loader threads load and store blobs concurrently.
+ */
+class AssetCache
+{
+public:
+    /// A blob mapped read-only, valid for the lifetime of the object
+    class Blob
+    {
+    public:
+        Blob() = default;
+        ~Blob();
+
+        Blob(const Blob&) = delete;
+        Blob& operator=(const Blob&) = delete;
+        Blob(Blob&& other) noexcept;
+        Blob& operator=(Blob&& other) noexcept;
+
+        /// Unmap the blob, data() is invalid afterwards
+        void close();
+
+        bool isOpen() const { return mMapping != nullptr; }
+
+        /// Content of the blob as it was passed to store
+        const char* data() const { return mData; }
+        size_t size() const { return mSize; }
+
+    private:
+        friend class AssetCache;
+
+        void* mMapping = nullptr;
+        size_t mMappingSize = 0;
+        const char* mData = nullptr;
+        size_t mSize = 0;
+    };
+
+    /// A piece of the content of a blob, see store
+    struct Part
+    {
+        const void* data;
+        size_t size;
+    };
+
+    /// Keep the blobs in a subdirectory of directory for version, an empty directory disables the cache
+    /// Deletes the blobs of other versions, and the least recently used blobs until the rest fit the budget.
+    void setDirectory(const std::string& directory, uint32_t version);
+
+    /// Set the disk space the blobs may take, 0 disables the cache
+    void setBudget(size_t budgetBytes);
+
+    bool isEnabled() const;
+
+    /// Key of what is processed from a source, variant names how and is part of the key
+    static uint64_t computeKey(const void* source, size_t size, const std::string& variant);
+
+    /// Map the blob of a key, returns false if there is none
+    bool load(uint64_t key, Blob& blob);
+
+    /// Store the parts of a blob in order, replacing any blob of the key
+    /// Blobs larger than the budget are not stored.
+    bool store(uint64_t key, std::initializer_list<Part> parts);
+
+private:
+    struct Entry
+    {
+        size_t sizeBytes;
+        /// Nanoseconds since the epoch the blob was last stored or loaded
+        int64_t lastUse;
+    };
+
+    /// Path of the blob of a key in mDirectory
+    std::string getPath(uint64_t key) const;
+
+    /// Delete the least recently used blobs until the rest fit the budget, called with mMutex held
+    void evict();
+
+    mutable std::mutex mMutex;
+    /// Directory of the current version, empty if the cache is disabled
+    std::string mDirectory;
+    size_t mBudgetBytes = 0;
+    size_t mSizeBytes = 0;
+    std::unordered_map<uint64_t, Entry> mEntries;
+};
+
+#endif // _VUFORIA_ASSETCACHE_H_
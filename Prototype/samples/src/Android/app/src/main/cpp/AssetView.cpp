@@ -0,0 +1,127 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "AssetView.h"
+
+#include <Log.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <utility>
+
+
+AssetView::~AssetView()
+{
+    close();
+}
+
+
+AssetView::AssetView(AssetView&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+
+AssetView&
+AssetView::operator=(AssetView&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        std::swap(mAsset, other.mAsset);
+        std::swap(mMapping, other.mMapping);
+        std::swap(mMappingSize, other.mMappingSize);
+        std::swap(mData, other.mData);
+        std::swap(mSize, other.mSize);
+    }
+    return *this;
+}
+
+
+bool
+AssetView::open(AAssetManager* assetManager, const char* filename)
+{
+    close();
+
+    AAsset* asset = AAssetManager_open(assetManager, filename, AASSET_MODE_BUFFER);
+    if (asset == nullptr)
+    {
+        return false;
+    }
+
+    if (map(asset))
+    {
+        // The mapping stays valid after the asset is closed
+        AAsset_close(asset);
+        return true;
+    }
+
+    // Compressed asset, the asset manager inflates it into a buffer owned by the asset
+    const void* buffer = AAsset_getBuffer(asset);
+    if (buffer == nullptr)
+    {
+        LOG("Error reading asset file %s", filename);
+        AAsset_close(asset);
+        return false;
+    }
+    mAsset = asset;
+    mData = static_cast<const char*>(buffer);
+    mSize = static_cast<size_t>(AAsset_getLength64(asset));
+    return true;
+}
+
+
+void
+AssetView::close()
+{
+    if (mMapping != nullptr)
+    {
+        munmap(mMapping, mMappingSize);
+        mMapping = nullptr;
+        mMappingSize = 0;
+    }
+    if (mAsset != nullptr)
+    {
+        AAsset_close(mAsset);
+        mAsset = nullptr;
+    }
+    mData = nullptr;
+    mSize = 0;
+}
+
+
+bool
+AssetView::map(AAsset* asset)
+{
+    off64_t start = 0;
+    off64_t length = 0;
+    int fd = AAsset_openFileDescriptor64(asset, &start, &length);
+    if (fd < 0)
+    {
+        // Only assets stored uncompressed have a file descriptor
+        return false;
+    }
+
+    // mmap requires a page aligned file offset
+    static const off64_t pageSize = sysconf(_SC_PAGESIZE);
+    off64_t mapStart = start - (start % pageSize);
+    size_t mapSize = static_cast<size_t>(length + (start - mapStart));
+
+    void* mapping = mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE, fd, mapStart);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    mMapping = mapping;
+    mMappingSize = mapSize;
+    mData = static_cast<const char*>(mapping) + (start - mapStart);
+    mSize = static_cast<size_t>(length);
+    return true;
+}
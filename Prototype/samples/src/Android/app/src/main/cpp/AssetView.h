@@ -0,0 +1,62 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_ASSETVIEW_H_
+#define _VUFORIA_ASSETVIEW_H_
+
+#include <android/asset_manager.h>
+
+#include <cstddef>
+
+
+/// Read-only view of the content of an asset, valid for the lifetime of the object
+/**
+ * Assets stored uncompressed in the APK are memory mapped through their file descriptor,
+ * other assets are accessed through AAsset_getBuffer. In both cases no copy is made by
+ * the app and the memory is released when the view is closed or destroyed.
+ */
+class AssetView
+{
+public:
+    AssetView() = default;
+    ~AssetView();
+
+    AssetView(const AssetView&) = delete;
+    AssetView& operator=(const AssetView&) = delete;
+    AssetView(AssetView&& other) noexcept;
+    AssetView& operator=(AssetView&& other) noexcept;
+
+    /// Open an asset, any asset previously held by this view is closed first
+    bool open(AAssetManager* assetManager, const char* filename);
+
+    /// Release the asset, data() is invalid afterwards
+    void close();
+
+    bool isOpen() const { return mData != nullptr; }
+
+    /// Start of the asset content
+    const char* data() const { return mData; }
+
+    /// Size of the asset content in bytes
+    size_t size() const { return mSize; }
+
+private:
+    /// Try to memory map an uncompressed asset directly from the APK
+    bool map(AAsset* asset);
+
+    /// Asset kept open while its buffer is in use, null when the asset is mapped
+    AAsset* mAsset = nullptr;
+
+    /// Page aligned mapping containing the asset, null when the asset buffer is used
+    void* mMapping = nullptr;
+    size_t mMappingSize = 0;
+
+    const char* mData = nullptr;
+    size_t mSize = 0;
+};
+
+#endif // _VUFORIA_ASSETVIEW_H_
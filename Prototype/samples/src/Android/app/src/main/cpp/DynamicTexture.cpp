@@ -0,0 +1,220 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "DynamicTexture.h"
+
+#include "GLESUtils.h"
+
+#include <PixelConvert.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+
+namespace
+{
+/// Upload layout of a Vuforia image pixel format
+struct PixelLayout
+{
+    GLenum internalFormat;
+    GLenum format;
+    GLenum type;
+    int bytesPerPixel;
+    /// Expand the pixels from RGB888 while copying them, uploading 3 bytes per pixel takes a slow path in many drivers
+    bool expandRgb;
+};
+
+bool
+getPixelLayout(VuImagePixelFormat pixelFormat, PixelLayout& layout)
+{
+    switch (pixelFormat)
+    {
+        case VuImagePixelFormat::VU_IMAGE_PIXEL_FORMAT_RGBA8888:
+            layout = { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, false };
+            return true;
+        case VuImagePixelFormat::VU_IMAGE_PIXEL_FORMAT_RGB888:
+            layout = { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 3, true };
+            return true;
+        case VuImagePixelFormat::VU_IMAGE_PIXEL_FORMAT_RGB565:
+            layout = { GL_RGB565, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, 2, false };
+            return true;
+        case VuImagePixelFormat::VU_IMAGE_PIXEL_FORMAT_GRAYSCALE:
+            // Immutable storage has no luminance format, the red channel is swizzled into all three
+            layout = { GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1, false };
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // anonymous namespace
+
+
+bool
+DynamicTexture::update(const VuImageInfo& image)
+{
+    PixelLayout layout;
+    if (!getPixelLayout(image.format, layout) || image.buffer == nullptr || image.width <= 0 || image.height <= 0)
+    {
+        LOG("Error: Cannot upload image in pixel format %d", image.format);
+        return false;
+    }
+
+    GLsizei requiredSize = std::max(image.width, image.height);
+    if (mTexture == 0 || layout.internalFormat != mInternalFormat || requiredSize > mStorageSize)
+    {
+        allocate(layout.internalFormat, requiredSize);
+    }
+
+    int stride = image.stride > 0 ? image.stride : image.width * layout.bytesPerPixel;
+    // Expanded pixels are written tightly packed
+    int uploadBytesPerPixel = layout.expandRgb ? 4 : layout.bytesPerPixel;
+    int uploadStride = layout.expandRgb ? image.width * uploadBytesPerPixel : stride;
+    GLsizeiptr bytes = static_cast<GLsizeiptr>(uploadStride) * image.height;
+
+    auto copyPixels = [&](uint8_t* destination) {
+        auto source = static_cast<const uint8_t*>(image.buffer);
+        if (!layout.expandRgb)
+        {
+            memcpy(destination, source, static_cast<size_t>(bytes));
+            return;
+        }
+        for (int row = 0; row < image.height; ++row)
+        {
+            PixelConvert::rgbToRgba(source + row * stride, destination + row * uploadStride, image.width);
+        }
+    };
+
+    // Orphan the previous buffer content so that the copy does not wait for an upload still in flight
+    const void* pixels = image.buffer;
+    std::vector<uint8_t> expanded;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mPixelBuffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    mPixelBufferBytes = bytes;
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped != nullptr)
+    {
+        copyPixels(static_cast<uint8_t*>(mapped));
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        // Offset into the bound pixel buffer
+        pixels = nullptr;
+    }
+    else
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if (layout.expandRgb)
+        {
+            expanded.resize(static_cast<size_t>(bytes));
+            copyPixels(expanded.data());
+            pixels = expanded.data();
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, uploadStride / uploadBytesPerPixel);
+
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height, layout.format, layout.type, pixels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    mWidth = image.width;
+    mHeight = image.height;
+
+    GLESUtils::checkGlError("Update dynamic texture");
+    return true;
+}
+
+
+void
+DynamicTexture::destroy()
+{
+    if (mTexture != 0)
+    {
+        glDeleteTextures(1, &mTexture);
+    }
+    if (mPixelBuffer != 0)
+    {
+        glDeleteBuffers(1, &mPixelBuffer);
+    }
+    forget();
+}
+
+
+void
+DynamicTexture::forget()
+{
+    mTexture = 0;
+    mPixelBuffer = 0;
+    mInternalFormat = 0;
+    mStorageSize = 0;
+    mPixelBufferBytes = 0;
+    mWidth = 0;
+    mHeight = 0;
+}
+
+
+VuVector4F
+DynamicTexture::getTexCoordTransform() const
+{
+    if (mStorageSize == 0)
+    {
+        return VuVector4F{ 1.0f, 1.0f, 0.0f, 0.0f };
+    }
+
+    // Map [0;1] onto the centers of the outer texels of the image, so that linear filtering
+    // never reads from the unused part of the storage
+    float texel = 1.0f / mStorageSize;
+    return VuVector4F{ (mWidth - 1) * texel, (mHeight - 1) * texel, 0.5f * texel, 0.5f * texel };
+}
+
+
+size_t
+DynamicTexture::getSizeBytes() const
+{
+    size_t texelBytes = mInternalFormat == GL_RGBA8 ? 4 : mInternalFormat == GL_RGB565 ? 2 : 1;
+    return static_cast<size_t>(mStorageSize) * mStorageSize * texelBytes + static_cast<size_t>(mPixelBufferBytes);
+}
+
+
+void
+DynamicTexture::allocate(GLenum internalFormat, GLsizei size)
+{
+    // Immutable storage cannot be resized, a new texture is needed
+    if (mTexture != 0)
+    {
+        glDeleteTextures(1, &mTexture);
+    }
+    if (mPixelBuffer == 0)
+    {
+        glGenBuffers(1, &mPixelBuffer);
+    }
+
+    glGenTextures(1, &mTexture);
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, size, size);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (internalFormat == GL_R8)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    mInternalFormat = internalFormat;
+    mStorageSize = size;
+
+    LOG("Allocated %dx%d dynamic texture storage", size, size);
+    GLESUtils::checkGlError("Allocate dynamic texture");
+}
@@ -0,0 +1,74 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_DYNAMICTEXTURE_H_
+#define _VUFORIA_DYNAMICTEXTURE_H_
+
+#include <GLES3/gl31.h>
+
+#include <cstddef>
+
+#include <VuforiaEngine/VuforiaEngine.h>
+
+
+/// Texture whose content is replaced in place by images of varying size
+/**
+ * The storage is allocated once with glTexStorage2D, square and large enough for the image in
+ * both orientations. Updates are written with glTexSubImage2D from a pixel buffer object, so the
+ * copy into GPU memory is done by the driver while the frame keeps rendering. The storage is only
+ * reallocated when a larger image or one in a different pixel format arrives.
+ * The image covers the lower left part of the storage, use getTexCoordTransform to sample it.
+ * All methods must be called on the rendering thread with a current GL context.
+ */
+class DynamicTexture
+{
+public:
+    DynamicTexture() = default;
+    /// The GL objects are not freed on destruction, call destroy on the rendering thread
+    ~DynamicTexture() = default;
+
+    DynamicTexture(const DynamicTexture&) = delete;
+    DynamicTexture& operator=(const DynamicTexture&) = delete;
+
+    /// Replace the content of the texture with an image
+    /// Returns false if the pixel format of the image cannot be uploaded.
+    bool update(const VuImageInfo& image);
+
+    /// Free the GL objects
+    void destroy();
+
+    /// Drop the GL object handles without deleting them, used after the GL context was lost
+    void forget();
+
+    bool isValid() const { return mTexture != 0; }
+
+    GLuint getTexture() const { return mTexture; }
+
+    /// Scale and offset mapping texture coordinates in [0;1] onto the image within the storage,
+    /// in the layout of the texCoordTransform shader uniform
+    VuVector4F getTexCoordTransform() const;
+
+    /// GPU memory of the storage and the pixel buffer
+    size_t getSizeBytes() const;
+
+private:
+    /// Allocate the storage, any previous storage is deleted
+    void allocate(GLenum internalFormat, GLsizei size);
+
+    GLuint mTexture = 0;
+    GLuint mPixelBuffer = 0;
+
+    GLenum mInternalFormat = 0;
+    GLsizei mStorageSize = 0;
+    GLsizeiptr mPixelBufferBytes = 0;
+
+    /// Size of the image last written
+    GLsizei mWidth = 0;
+    GLsizei mHeight = 0;
+};
+
+#endif // _VUFORIA_DYNAMICTEXTURE_H_
@@ -0,0 +1,159 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "FramePacing.h"
+
+#include <Log.h>
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+
+namespace
+{
+int64_t
+now()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+}
+
+
+bool
+FramePacing::start(int targetFrameRate, int64_t refreshPeriod, RequestRenderCallback requestRender)
+{
+    if (mChoreographer == nullptr)
+    {
+        // Only succeeds on a thread with a looper
+        mChoreographer = AChoreographer_getInstance();
+        if (mChoreographer == nullptr)
+        {
+            LOG("Error: No choreographer for frame pacing");
+            return false;
+        }
+    }
+
+    mTargetFrameRate = targetFrameRate;
+    setFrameRateCap(mFrameRateCap);
+    mPacer.setRefreshPeriod(refreshPeriod);
+    mPacer.reset();
+    mRequestRender = std::move(requestRender);
+    mRunning = true;
+
+    // A callback still pending from before stop keeps the chain going
+    if (!mCallbackPosted)
+    {
+        mCallbackPosted = true;
+        AChoreographer_postFrameCallback(mChoreographer, &FramePacing::onVsync, this);
+    }
+
+    LOG("Frame pacing at %d vsyncs per frame", mPacer.getSwapInterval());
+    return true;
+}
+
+
+void
+FramePacing::setFrameRateCap(int framesPerSecond)
+{
+    mFrameRateCap = framesPerSecond;
+    int target = mTargetFrameRate;
+    if (framesPerSecond > 0 && (target == 0 || framesPerSecond < target))
+    {
+        target = framesPerSecond;
+    }
+    mPacer.setTargetFrameRate(target);
+}
+
+
+void
+FramePacing::stop()
+{
+    mRunning = false;
+}
+
+
+void
+FramePacing::beginFrame()
+{
+    if (!mRunning)
+    {
+        return;
+    }
+
+    int64_t startTime = mPacer.getFrameStartTime();
+    if (startTime > now())
+    {
+        std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(startTime)));
+    }
+    mFrameStartTime = now();
+}
+
+
+void
+FramePacing::endFrame()
+{
+    if (!mRunning || mFrameStartTime == 0)
+    {
+        return;
+    }
+    mPacer.addFrameDuration(now() - mFrameStartTime);
+    mFrameStartTime = 0;
+
+    EGLDisplay display = eglGetCurrentDisplay();
+    EGLSurface surface = eglGetCurrentSurface(EGL_DRAW);
+    if (!mPresentationTimeQueried && display != EGL_NO_DISPLAY)
+    {
+        mPresentationTimeQueried = true;
+        const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+        if (extensions != nullptr && strstr(extensions, "EGL_ANDROID_presentation_time") != nullptr)
+        {
+            mPresentationTime = reinterpret_cast<PFNEGLPRESENTATIONTIMEANDROIDPROC>(eglGetProcAddress("eglPresentationTimeANDROID"));
+        }
+    }
+
+    // Half a period early, the compositor shows the frame at the first vsync after the presentation time
+    int64_t deadline = mPacer.getDeadline();
+    if (mPresentationTime != nullptr && surface != EGL_NO_SURFACE && deadline != 0)
+    {
+        mPresentationTime(display, surface, deadline - mPacer.getRefreshPeriod() / 2);
+    }
+}
+
+
+void
+FramePacing::onVsync(long frameTimeNanos, void* data)
+{
+    auto pacing = static_cast<FramePacing*>(data);
+    pacing->mCallbackPosted = false;
+    if (!pacing->mRunning)
+    {
+        return;
+    }
+
+    // The timestamp is a 32 bit long on 32 bit ABIs, restore the upper bits from the current time
+    // as the vsync is less than 2^32 ns in the past
+    int64_t vsyncTime = frameTimeNanos;
+    if (sizeof(long) < sizeof(int64_t))
+    {
+        int64_t currentTime = now();
+        vsyncTime = (currentTime & ~int64_t(0xFFFFFFFF)) | static_cast<uint32_t>(frameTimeNanos);
+        if (vsyncTime > currentTime)
+        {
+            vsyncTime -= int64_t(1) << 32;
+        }
+    }
+
+    if (pacing->mPacer.onVsync(vsyncTime))
+    {
+        pacing->mRequestRender();
+    }
+
+    pacing->mCallbackPosted = true;
+    AChoreographer_postFrameCallback(pacing->mChoreographer, &FramePacing::onVsync, pacing);
+}
@@ -0,0 +1,74 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_FRAMEPACING_H_
+#define _VUFORIA_FRAMEPACING_H_
+
+#include <FramePacer.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <android/choreographer.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+
+/// Drives the rendering of a GLSurfaceView in RENDERMODE_WHEN_DIRTY from AChoreographer vsyncs
+/**
+ * For every vsync the FramePacer accepts a render is requested. The rendering thread then waits in
+ * beginFrame until the frame start time of the pacer, so that the camera frame acquired by
+ * prepareToRender is the most recent one that can still be shown at the deadline, and sets the
+ * deadline as the presentation time of the frame in endFrame if EGL_ANDROID_presentation_time is
+ * available. That keeps frames of a target frame rate below the refresh rate from being shown early.
+ */
+class FramePacing
+{
+public:
+    using RequestRenderCallback = std::function<void()>;
+
+    /// Start receiving vsyncs, called on the main thread, which also receives the vsyncs
+    /// The callback is called on the main thread and should request a render of the view.
+    bool start(int targetFrameRate, int64_t refreshPeriod, RequestRenderCallback requestRender);
+
+    /// Stop requesting renders, called on the main thread
+    void stop();
+
+    /// Can be called on any thread
+    bool isRunning() const { return mRunning; }
+
+    /// Limit the frame rate below the target frame rate, 0 for no limit, can be called on any thread
+    void setFrameRateCap(int framesPerSecond);
+
+    /// Called on the rendering thread before prepareToRender, waits until the frame should start
+    void beginFrame();
+
+    /// Called on the rendering thread once the frame is submitted, before the view swaps buffers
+    void endFrame();
+
+private:
+    static void onVsync(long frameTimeNanos, void* data);
+
+    /// Main thread
+    AChoreographer* mChoreographer = nullptr;
+    RequestRenderCallback mRequestRender;
+    /// A vsync callback was posted and not called yet
+    bool mCallbackPosted = false;
+
+    std::atomic<bool> mRunning{ false };
+    FramePacer mPacer;
+    std::atomic<int> mTargetFrameRate{ 0 };
+    std::atomic<int> mFrameRateCap{ 0 };
+
+    /// Rendering thread
+    int64_t mFrameStartTime = 0;
+    bool mPresentationTimeQueried = false;
+    PFNEGLPRESENTATIONTIMEANDROIDPROC mPresentationTime = nullptr;
+};
+
+#endif // _VUFORIA_FRAMEPACING_H_
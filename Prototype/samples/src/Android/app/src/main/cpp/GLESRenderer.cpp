@@ -8,530 +8,2301 @@ countries.
 #include "GLESRenderer.h"
 
 #include "GLESUtils.h"
+#include "ProgramCache.h"
 #include "Shaders.h"
 
+#include <AppController.h>
+#include <GalleryTargets.h>
+#include <MatrixMath.h>
 #include <MemoryStream.h>
 #include <Models.h>
+#include <PseudoNormalBaker.h>
 
 #include <android/asset_manager.h>
 
+#include <AllocationCounter.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <string>
+
+
+namespace
+{
+/// Names the memory of the renderer objects not loaded from an asset is accounted to
+constexpr const char* ARTWORK_ARRAY_NAME = "artwork array";
+constexpr const char* GUIDE_VIEW_NAME = "guide view";
+constexpr const char* AUGMENTATION_TARGET_NAME = "augmentation target";
+
+/// Start of a texture blob in the asset cache, followed by the pixels
+struct CachedImageHeader
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t bytesPerPixel;
+    float meanLuma;
+};
+
+/// Variants of the asset cache blobs, part of their keys, see AssetCache::computeKey
+/// Textures decoded in native code and by the platform at full size share a variant.
+std::string
+getMeshVariant(bool quantize)
+{
+    return "mesh v" + std::to_string(MeshFormat::VERSION) + (quantize ? " quantized" : "");
+}
+
+
+std::string
+getLumaVariant(int downscale)
+{
+    return "luma downscale " + std::to_string(downscale);
+}
+
+
+constexpr const char* RGBA_VARIANT = "rgba";
+
+
+/// Key of what is processed from an asset, false if the asset cannot be opened
+bool
+computeAssetKey(AAssetManager* assetManager, const char* filename, const std::string& variant, uint64_t& key)
+{
+    AssetView asset;
+    if (!asset.open(assetManager, filename))
+    {
+        return false;
+    }
+    key = AssetCache::computeKey(asset.data(), asset.size(), variant);
+    return true;
+}
+
+
+size_t
+getSizeBytes(const MeshData& data)
+{
+    return data.positions.capacity() * sizeof(float) + data.texCoords.capacity() * sizeof(float) +
+           data.indices.capacity() * sizeof(uint32_t) + data.shortIndices.capacity() * sizeof(uint16_t) +
+           data.quantizedVertices.capacity() * sizeof(MeshFormat::QuantizedVertex) + data.lods.capacity() * sizeof(MeshFormat::Lod);
+}
+} // anonymous namespace
+
+bool
+GLESRenderer::init(AAssetManager* assetManager, TextureRequestCallback textureRequestCallback,
+                   ContentRequestCallback contentRequestCallback)
+{
+    // Setup for Video Background rendering
+    mVbShaderProgramID = createProgram(textureVertexShaderSrc, textureFragmentShaderSrc, {});
+    mVbTexSampler2DHandle = ProgramCache::getUniformLocation(mVbShaderProgramID, "texSampler2D");
+    mVbTextureUnit = -1;
+
+    // Setup for augmentation rendering
+    mUniformColorShaderProgramID = createProgram(uniformColorVertexShaderSrc, uniformColorFragmentShaderSrc, {});
+
+    // Setup for guide view rendering
+    mTextureUniformColorShaderProgramID = createProgram(textureColorVertexShaderSrc, textureColorFragmentShaderSrc, { "texSampler2D" });
+
+    // Setup for models textured from the artwork array
+    mTextureArrayShaderProgramID = createProgram(textureColorVertexShaderSrc, textureArrayFragmentShaderSrc, { "texSamplerArray" });
+
+    // Setup for alpha-tested models, separate programs so that opaque ones never run a shader that discards
+    mAlphaTestShaderProgramID =
+        createProgram(textureColorVertexShaderSrc, textureColorFragmentShaderSrc, { "texSampler2D" }, ALPHA_TEST_DEFINE_GLSL);
+    mAlphaTestArrayShaderProgramID =
+        createProgram(textureColorVertexShaderSrc, textureArrayFragmentShaderSrc, { "texSamplerArray" }, ALPHA_TEST_DEFINE_GLSL);
+
+    // Setup for pseudo normal shading, normal maps are baked into the textures if this fails
+    mPseudoNormalShaderProgramID =
+        createProgram(textureColorVertexShaderSrc, pseudoNormalFragmentShaderSrc, { "texSampler2D", "normalSampler2D" });
+
+    // Setup for models with baked shading, modulating the texture by the shade of every vertex
+    mShadedTextureUniformColorShaderProgramID =
+        createProgram(textureColorVertexShaderSrc, textureColorFragmentShaderSrc, { "texSampler2D" }, SHADED_DEFINE_GLSL);
+    mShadedTextureArrayShaderProgramID =
+        createProgram(textureColorVertexShaderSrc, textureArrayFragmentShaderSrc, { "texSamplerArray" }, SHADED_DEFINE_GLSL);
+    mShadedAlphaTestShaderProgramID = createProgram(textureColorVertexShaderSrc, textureColorFragmentShaderSrc, { "texSampler2D" },
+                                                    ALPHA_TEST_DEFINE_GLSL SHADED_DEFINE_GLSL);
+    mShadedAlphaTestArrayShaderProgramID = createProgram(textureColorVertexShaderSrc, textureArrayFragmentShaderSrc, { "texSamplerArray" },
+                                                         ALPHA_TEST_DEFINE_GLSL SHADED_DEFINE_GLSL);
+    mShadedPseudoNormalShaderProgramID = createProgram(textureColorVertexShaderSrc, pseudoNormalFragmentShaderSrc,
+                                                       { "texSampler2D", "normalSampler2D" }, SHADED_DEFINE_GLSL);
+
+    // Setup for axis rendering
+    mVertexColorShaderProgramID = createProgram(vertexColorVertexShaderSrc, vertexColorFragmentShaderSrc, {});
+
+    // Uniform blocks of every draw for the frames in flight
+    mUniformRing.forget();
+    mUniformRing.create(UNIFORM_RING_FRAME_SIZE);
+
+    // Instance matrices, draws without an instance buffer read the identity from the generic attribute values
+    glGenBuffers(1, &mInstanceBuffer);
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        glVertexAttrib4f(GLESUtils::ATTRIBUTE_INSTANCE_MATRIX + column, column == 0 ? 1.0f : 0.0f, column == 1 ? 1.0f : 0.0f,
+                         column == 2 ? 1.0f : 0.0f, column == 3 ? 1.0f : 0.0f);
+    }
+
+    // The guide view texture and video background mesh went with the previous context
+    mModelTargetGuideViewTexture.forget();
+    mAugmentationTarget.forget();
+    mAugmentationTimer.forget();
+    mVideoBackgroundMesh.forget();
+    mCulledDrawCount.store(0, std::memory_order_relaxed);
+
+    createShapeMeshes();
+
+    // Neutral gray shown on models until their texture is resident
+    unsigned char placeholderPixel[] = { 128, 128, 128, 255 };
+    TextureOptions placeholderOptions;
+    placeholderOptions.mipmaps = false;
+    mPlaceholderTexture = GLESUtils::createTexture(1, 1, placeholderPixel, GL_RGBA, placeholderOptions);
+
+    // Models are parsed on the loader threads while the video background is already rendering
+    if (!mLoaderPool)
+    {
+        mLoaderPool = std::make_unique<WorkerPool>(WorkerPool::defaultThreadCount(), "AssetLoader");
+    }
+
+    mAssetManager = assetManager;
+    mTextureRequestCallback = std::move(textureRequestCallback);
+    mContentRequestCallback = std::move(contentRequestCallback);
+
+    // Any GL objects the models referred to went with the previous context
+    mTextureCache.setMemoryAccounting(&mMemoryAccounting);
+    mTextureCache.forget();
+    mTextureUploader.forget();
+    mArtworkArray.forget();
+    mMemoryAccounting.clear(MemoryAccounting::Pool::GPU);
+    mMemoryAccounting.clear(MemoryAccounting::Pool::PENDING);
+    for (auto& model : mModels)
+    {
+        model->gpuMesh.forget();
+        model->textureUnit = -1;
+        model->textureId = nullptr;
+        model->textureLevel = -1;
+        model->textureLayer = -1;
+        model->normalMapUnit = -1;
+        model->normalMapId = nullptr;
+        evictModel(*model);
+    }
+
+    // A manifest set by the platform before is kept across GL contexts
+    if (mContents.empty())
+    {
+        AssetView manifestAsset;
+        if (!manifestAsset.open(assetManager, CONTENT_MANIFEST_ASSET) ||
+            !setContentManifest(manifestAsset.data(), manifestAsset.size()))
+        {
+            LOG("Error reading content manifest %s", CONTENT_MANIFEST_ASSET);
+        }
+    }
+
+    return true;
+}
+
+
+bool
+GLESRenderer::setContentManifest(const char* text, size_t size)
+{
+    auto content = std::make_unique<Content>();
+    if (!content->manifest.parse(text, size))
+    {
+        return false;
+    }
+
+    // The names of the entries point into their URLs, which must not move once the entries are built
+    const auto& artworks = content->manifest.getArtworks();
+    content->entries.reserve(artworks.size());
+    for (const auto& artwork : artworks)
+    {
+        int target = getTargetId(artwork.target);
+        if (target == -1)
+        {
+            LOG("Content manifest artwork %s for unknown target %s skipped", artwork.model.c_str(), artwork.target.c_str());
+            continue;
+        }
+
+        content->entries.emplace_back();
+        ManifestEntry& entry = content->entries.back();
+        entry.target = target;
+        entry.model = &getModel(artwork.model.c_str());
+        entry.modelName = artwork.model.c_str();
+        entry.quantize = artwork.quantize;
+        entry.textureOptions.mipmaps = artwork.mipmaps;
+        entry.textureOptions.maxAnisotropy = artwork.anisotropy;
+        entry.normalMapDownscale = artwork.normalMapDownscale;
+        entry.blendMode = artwork.blend == "alpha_test" ? BlendMode::ALPHA_TEST
+                          : artwork.blend == "blended"  ? BlendMode::BLENDED
+                                                        : BlendMode::OPAQUE;
+        entry.model->blendMode = entry.blendMode;
+        entry.remote = !artwork.url.empty();
+        if (!entry.remote)
+        {
+            entry.textureName = artwork.texture.c_str();
+            entry.normalMapName = artwork.normalMap.empty() ? nullptr : artwork.normalMap.c_str();
+            entry.textureArray = artwork.textureArray;
+            continue;
+        }
+
+        entry.modelUrl = ContentManifest::getUrl(artwork, artwork.model);
+        if (!artwork.coarseModel.empty())
+        {
+            entry.coarseModelUrl = ContentManifest::getUrl(artwork, artwork.coarseModel);
+        }
+        for (const auto& preview : artwork.texturePreviews)
+        {
+            entry.textureUrls.push_back(ContentManifest::getUrl(artwork, preview));
+        }
+        entry.textureUrls.push_back(ContentManifest::getUrl(artwork, artwork.texture));
+        if (!artwork.normalMap.empty())
+        {
+            entry.normalMapUrl = ContentManifest::getUrl(artwork, artwork.normalMap);
+        }
+        entry.textureName = entry.textureUrls.back().c_str();
+        entry.normalMapName = entry.normalMapUrl.empty() ? nullptr : entry.normalMapUrl.c_str();
+        // Layers are decoded at the layer size, the texture levels of remote artworks are used at the size they come in
+        entry.textureArray = false;
+    }
+
+    // The assets of the previous manifest are requested again if the new one uses them, loads in flight are dropped
+    for (auto& model : mModels)
+    {
+        evictModel(*model);
+    }
+    ++mLoadGeneration;
+    mDownloads.clear();
+    mContents.push_back(std::move(content));
+    LOG("Content manifest with %zu artworks", getManifest().size());
+    return true;
+}
+
+
+const std::vector<GLESRenderer::ManifestEntry>&
+GLESRenderer::getManifest() const
+{
+    static const std::vector<ManifestEntry> NO_ENTRIES;
+    return mContents.empty() ? NO_ENTRIES : mContents.back()->entries;
+}
+
+
+GLESRenderer::Model&
+GLESRenderer::getModel(const char* name)
+{
+    for (auto& model : mModels)
+    {
+        if (strcmp(model->name, name) == 0)
+        {
+            return *model;
+        }
+    }
+    mModels.push_back(std::make_unique<Model>());
+    mModels.back()->name = name;
+    return *mModels.back();
+}
+
+
+int
+GLESRenderer::getTargetId(const std::string& name)
+{
+    if (name == "image")
+    {
+        return AppController::IMAGE_TARGET_ID;
+    }
+    if (name == "model")
+    {
+        return AppController::MODEL_TARGET_ID;
+    }
+    return -1;
+}
+
+
+const char*
+GLESRenderer::getTextureName(const ManifestEntry& entry, int level)
+{
+    return entry.remote ? entry.textureUrls[level].c_str() : entry.textureName;
+}
+
+
+int
+GLESRenderer::getTextureLevel(const ManifestEntry& entry, const std::string& id)
+{
+    if (!entry.remote)
+    {
+        return id == entry.textureName ? 0 : -1;
+    }
+    auto found = std::find(entry.textureUrls.begin(), entry.textureUrls.end(), id);
+    return found != entry.textureUrls.end() ? static_cast<int>(found - entry.textureUrls.begin()) : -1;
+}
+
+
+void
+GLESRenderer::deinit()
+{
+    mModelTargetGuideViewTexture.destroy();
+    mAugmentationTarget.destroy();
+    mAugmentationTimer.destroy();
+    if (mProfiler != nullptr)
+    {
+        mProfiler->setGpuRanges(nullptr);
+    }
+    mGpuProfiler.destroy();
+    mGpuProfilerUnsupported = false;
+
+    // Drop any load still in flight
+    ++mLoadGeneration;
+    {
+        std::lock_guard<std::mutex> lock(mLoadedAssetsMutex);
+        mLoadedModels.clear();
+        mLoadedTextures.clear();
+    }
+    mDownloads.clear();
+
+    for (auto& model : mModels)
+    {
+        evictModel(*model);
+    }
+    mTextureUploader.destroy();
+    mTextureCache.clear();
+    mArtworkArray.destroy();
+    GLESUtils::destroyTexture(mPlaceholderTexture);
+    mPlaceholderTexture = 0;
+
+    mUniformRing.destroy();
+    if (mInstanceBuffer != 0)
+    {
+        glDeleteBuffers(1, &mInstanceBuffer);
+        mInstanceBuffer = 0;
+    }
+    mVideoBackgroundMesh.destroy();
+    mSquareMesh.destroy();
+    mCubeMesh.destroy();
+    mAxisMesh.destroy();
+
+    // The loads dropped above and the uploads still queued held pending memory
+    mMemoryAccounting.clear(MemoryAccounting::Pool::GPU);
+    mMemoryAccounting.clear(MemoryAccounting::Pool::PENDING);
+}
+
+
+void
+GLESRenderer::beginFrame()
+{
+    mStateCache.beginFrame();
+    mUniformRing.beginFrame();
+    mFrameProjectionBound = false;
+
+    if (mProfiler != nullptr && mProfiler->isEnabled())
+    {
+        if (!mGpuProfiler.isValid() && !mGpuProfilerUnsupported)
+        {
+            mGpuProfilerUnsupported = !mGpuProfiler.create();
+            mProfiler->setGpuRanges(mGpuProfilerUnsupported ? nullptr : &mGpuProfiler);
+            if (mGpuProfilerUnsupported)
+            {
+                LOG("GPU timestamp queries not supported, profiling on the CPU only");
+            }
+        }
+        if (mGpuProfiler.isValid())
+        {
+            mGpuProfiler.collect(*mProfiler);
+        }
+    }
+}
+
+
+void
+GLESRenderer::setProfiler(Profiler* profiler, bool overlay)
+{
+    if (mProfiler != nullptr)
+    {
+        mProfiler->setGpuRanges(nullptr);
+    }
+    mProfiler = profiler;
+    mProfilerOverlay = overlay;
+    mOverlayStatistics.clear();
+    // Refreshed while rendering, without allocating
+    mOverlayStatistics.reserve(Profiler::MAX_SECTIONS);
+    mOverlayRefreshCountdown = 0;
+    if (mProfiler != nullptr && mGpuProfiler.isValid())
+    {
+        mProfiler->setGpuRanges(&mGpuProfiler);
+    }
+}
+
+
+void
+GLESRenderer::renderProfilerOverlay()
+{
+    if (mProfiler == nullptr || !mProfilerOverlay || !mProfiler->isEnabled())
+    {
+        return;
+    }
+
+    if (--mOverlayRefreshCountdown <= 0)
+    {
+        mProfiler->getStatistics(mOverlayStatistics);
+        mOverlayRefreshCountdown = OVERLAY_REFRESH_FRAMES;
+    }
+
+    mStateCache.setEnabled(GL_DEPTH_TEST, false);
+    mStateCache.setEnabled(GL_CULL_FACE, false);
+    mStateCache.setEnabled(GL_BLEND, true);
+    mStateCache.blendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    mStateCache.useProgram(mUniformColorShaderProgramID);
+    bindFrameUniforms(MatrixMath::identity());
+
+    // Bars are drawn from the unit square in clip space, starting at the left edge
+    auto drawBar = [this](float milliseconds, float top, float height, const VuVector4F& color) {
+        float width = 2.0f * std::min(milliseconds / OVERLAY_FULL_SCALE_MILLISECONDS, 1.0f);
+        if (width <= 0.0f)
+        {
+            return;
+        }
+        VuMatrix44F modelViewMatrix = MatrixMath::translation({ -1.0f + 0.5f * width, top - 0.5f * height, 0.0f });
+        modelViewMatrix = MatrixMath::multiply(modelViewMatrix, MatrixMath::scaling({ width, height, 1.0f }));
+        bindDrawUniforms(modelViewMatrix, color);
+        mSquareMesh.draw(GL_TRIANGLES, NUM_SQUARE_INDEX, 0);
+    };
+
+    const float rowHeight = 0.04f;
+    const float barHeight = 0.45f * rowHeight;
+    // The p99 bars translucent behind the p50 bars
+    const VuVector4F cpuColor{ 1.0f, 0.8f, 0.0f, 1.0f };
+    const VuVector4F cpuTailColor{ 1.0f, 0.8f, 0.0f, 0.35f };
+    const VuVector4F gpuColor{ 0.0f, 0.8f, 1.0f, 1.0f };
+    const VuVector4F gpuTailColor{ 0.0f, 0.8f, 1.0f, 0.35f };
+    float top = 0.95f;
+    for (const auto& section : mOverlayStatistics)
+    {
+        drawBar(section.cpu.p99, top, barHeight, cpuTailColor);
+        drawBar(section.cpu.p50, top, barHeight, cpuColor);
+        drawBar(section.gpu.p99, top - 0.5f * rowHeight, barHeight, gpuTailColor);
+        drawBar(section.gpu.p50, top - 0.5f * rowHeight, barHeight, gpuColor);
+        top -= rowHeight;
+    }
+
+    // A thin bar up to the budget would hide the times, draw only its end as a line
+    float budget = 2.0f * (1000.0f / 60.0f) / OVERLAY_FULL_SCALE_MILLISECONDS - 1.0f;
+    float height = 0.95f - top;
+    VuMatrix44F modelViewMatrix = MatrixMath::translation({ budget, 0.95f - 0.5f * height, 0.0f });
+    modelViewMatrix = MatrixMath::multiply(modelViewMatrix, MatrixMath::scaling({ 0.005f, height, 1.0f }));
+    bindDrawUniforms(modelViewMatrix, WHITE);
+    mSquareMesh.draw(GL_TRIANGLES, NUM_SQUARE_INDEX, 0);
+
+    GLESUtils::checkGlError("Render profiler overlay");
+}
+
+
+void
+GLESRenderer::setViewport(int x, int y, int width, int height)
+{
+    mViewportX = x;
+    mViewportY = y;
+    mViewportWidth = width;
+    mViewportHeight = height;
+}
+
+
+void
+GLESRenderer::setMaxAugmentationScale(float scale)
+{
+    DynamicResolution::Config config = mDynamicResolution.getConfig();
+    config.maxScale = scale;
+    config.minScale = std::min(config.minScale, scale);
+    mDynamicResolution.setConfig(config);
+}
+
+
+void
+GLESRenderer::setDynamicResolution(bool enabled, const DynamicResolution::Config& config)
+{
+    mDynamicResolutionEnabled = enabled;
+    mDynamicResolution.setConfig(config);
+    if (!enabled)
+    {
+        mAugmentationTarget.destroy();
+        mAugmentationTimer.destroy();
+    }
+}
+
+
+void
+GLESRenderer::processLoadedAssets()
+{
+    Profiler::Scope scope(mProfiler, "processLoadedAssets");
+
+    std::vector<LoadedModel> loadedModels;
+    std::vector<LoadedTexture> loadedTextures;
+    std::vector<const char*> platformTextureRequests;
+    {
+        std::lock_guard<std::mutex> lock(mLoadedAssetsMutex);
+        loadedModels.swap(mLoadedModels);
+        loadedTextures.swap(mLoadedTextures);
+        platformTextureRequests.swap(mPlatformTextureRequests);
+    }
+
+    // Handing over assets allocates by design, frames without anything to hand over must not
+    AllocationCounter::Pause pause(!loadedModels.empty() || !loadedTextures.empty() || !platformTextureRequests.empty() ||
+                                   !mTextureUploader.isIdle());
+
+    // The callback calls into the platform, which only works from the rendering thread
+    for (const char* textureName : platformTextureRequests)
+    {
+        if (mTextureRequestCallback)
+        {
+            mTextureRequestCallback(textureName);
+        }
+    }
+
+    for (auto& loaded : loadedModels)
+    {
+        // Skip models that were evicted while they were loading, and coarse models arriving after the full one
+        Model& model = *loaded.destination;
+        if (loaded.generation != mLoadGeneration || !model.requested || loaded.level <= model.geometryLevel)
+        {
+            accountModel(model.name, model);
+            continue;
+        }
+
+        // A refined model replaces the buffers of the coarser one
+        model.gpuMesh.destroy();
+        model.mesh = loaded.model.mesh;
+        model.data = std::move(loaded.model.data);
+        model.asset = std::move(loaded.model.asset);
+        model.download = std::move(loaded.model.download);
+        model.cached = std::move(loaded.model.cached);
+        model.vertices = std::move(loaded.model.vertices);
+        model.geometryLevel = loaded.level;
+        model.ready = uploadModel(model);
+        if (mReleaseMeshCopies)
+        {
+            model.mesh = MeshView();
+            model.data = MeshData();
+            model.asset.close();
+            model.download = std::vector<char>();
+            model.cached.close();
+        }
+        accountModel(model.name, model);
+    }
+
+    for (auto& loaded : loadedTextures)
+    {
+        Model& model = *loaded.entry->model;
+        bool superseded = !loaded.normalMap && getTextureLevel(*loaded.entry, loaded.id) <= model.textureLevel;
+        if (loaded.generation != mLoadGeneration || !model.requested || superseded)
+        {
+            mMemoryAccounting.set(loaded.id, MemoryAccounting::Category::TEXTURE, MemoryAccounting::Pool::PENDING, 0);
+            continue;
+        }
+
+        if (loaded.normalMap)
+        {
+            model.normalMeanLuma = loaded.meanLuma;
+            mTextureUploader.enqueue(loaded.id, loaded.image.width, loaded.image.height, GL_LUMINANCE, TextureOptions(),
+                                     std::move(loaded.image.pixels));
+        }
+        else
+        {
+            model.colorMeanLuma = loaded.meanLuma;
+            uploadTexture(*loaded.entry, loaded.id, loaded.image.width, loaded.image.height, std::move(loaded.image.pixels));
+        }
+    }
+
+    std::vector<TextureUploader::Finished> uploadedTextures;
+    mTextureUploader.process(uploadedTextures);
+    // The uploads bind textures directly, and the cache may have deleted bound ones
+    mStateCache.invalidateTextures();
+    for (const auto& finished : uploadedTextures)
+    {
+        mMemoryAccounting.set(finished.id, MemoryAccounting::Category::TEXTURE, MemoryAccounting::Pool::PENDING, 0);
+        assignUploadedTexture(finished);
+    }
+}
+
+
+void
+GLESRenderer::setActiveTarget(int target)
+{
+    for (const auto& entry : getManifest())
+    {
+        if (!isUsedByTarget(entry, target))
+        {
+            evictModel(*entry.model);
+        }
+    }
+}
+
+
+void
+GLESRenderer::prefetchAssets(int target)
+{
+    if (target != AppController::GALLERY_TARGET_ID)
+    {
+        requireTargetAssets(target);
+        return;
+    }
+    for (const auto& galleryTarget : GALLERY_TARGETS)
+    {
+        requireTargetAssets(galleryTarget.assetTarget);
+    }
+}
+
+
+bool
+GLESRenderer::areAssetsReady(int target) const
+{
+    for (const auto& entry : getManifest())
+    {
+        const Model& model = *entry.model;
+        if (isUsedByTarget(entry, target) && (!model.ready || model.textureId == nullptr))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void
+GLESRenderer::setTexture(const char* textureName, int width, int height, unsigned char* bytes)
+{
+    // Remote images the platform was asked to decode arrive here as well
+    mDownloads.erase(textureName);
+    for (const auto& entry : getManifest())
+    {
+        Model& model = *entry.model;
+        if (!model.requested)
+        {
+            continue;
+        }
+        size_t pixelCount = static_cast<size_t>(width) * height;
+        int level = getTextureLevel(entry, textureName);
+        if (level > model.textureLevel)
+        {
+            // The bytes belong to the caller, the upload takes several frames
+            model.colorMeanLuma = PseudoNormalBaker::computeMeanLuma(bytes, pixelCount);
+            mMemoryAccounting.set(textureName, MemoryAccounting::Category::TEXTURE, MemoryAccounting::Pool::PENDING, pixelCount * 4);
+            std::vector<unsigned char> pixels(bytes, bytes + pixelCount * 4);
+            cachePlatformTexture(entry, false, width, height, pixels, model.colorMeanLuma);
+            uploadTexture(entry, getTextureName(entry, level), width, height, std::move(pixels));
+        }
+        else if (entry.normalMapName != nullptr && strcmp(entry.normalMapName, textureName) == 0)
+        {
+            std::vector<unsigned char> luma(pixelCount);
+            model.normalMeanLuma = PseudoNormalBaker::computeLuma(bytes, pixelCount, luma.data());
+            mMemoryAccounting.set(textureName, MemoryAccounting::Category::TEXTURE, MemoryAccounting::Pool::PENDING, pixelCount);
+            cachePlatformTexture(entry, true, width, height, luma, model.normalMeanLuma);
+            mTextureUploader.enqueue(entry.normalMapName, width, height, GL_LUMINANCE, TextureOptions(), std::move(luma));
+        }
+    }
+}
+
+
+void
+GLESRenderer::renderVideoBackground(const VuMatrix44F& projectionMatrix, const VuMesh& mesh, unsigned int meshVersion, int textureUnit)
+{
+    Profiler::Scope scope(mProfiler, "renderVideoBackground");
+
+    // The mesh only changes with the render view, also check its size in case a reconfiguration took effect late
+    bool meshChanged = meshVersion != mVideoBackgroundMeshVersion || mVideoBackgroundMesh.getVertexCount() != mesh.numVertices ||
+                       mVideoBackgroundMesh.getIndexCount() != mesh.numFaces * 3;
+    if (!mVideoBackgroundMesh.isValid() || meshChanged)
+    {
+        if (!uploadVideoBackgroundMesh(mesh))
+        {
+            return;
+        }
+        mVideoBackgroundMeshVersion = meshVersion;
+    }
+
+    mStateCache.setEnabled(GL_DEPTH_TEST, false);
+    mStateCache.setEnabled(GL_CULL_FACE, false);
+    mStateCache.setEnabled(GL_BLEND, false);
+
+    mStateCache.useProgram(mVbShaderProgramID);
+    if (textureUnit != mVbTextureUnit)
+    {
+        glUniform1i(mVbTexSampler2DHandle, textureUnit);
+        mVbTextureUnit = textureUnit;
+    }
+    // The video background has its own projection, which is its whole transform
+    bindDrawUniforms(projectionMatrix, WHITE);
+
+    mVideoBackgroundMesh.draw(GL_TRIANGLES);
+
+    GLESUtils::checkGlError("Render video background");
+}
+
+
+void
+GLESRenderer::renderFrame(const FramePacket& packet, FrameArena& arena)
+{
+    Profiler::Scope scope(mProfiler, "renderFrame");
+    mFrameArena = &arena;
+
+    bool offscreen = beginAugmentationPass();
+
+    mDrawQueue.clear();
+    if (packet.originValid)
+    {
+        enqueueWorldOrigin(packet.projectionMatrix, packet.originModelViewMatrix);
+    }
+    for (int i = 0; i < packet.targetCount; ++i)
+    {
+        enqueueTarget(packet.projectionMatrix, packet.targets[i]);
+    }
+    if (packet.guideViewValid)
+    {
+        enqueueGuideView(packet);
+    }
+
+    // Opaque and alpha-tested items grouped by program, texture and mesh and front to back within a group, so that
+    // the drivers can skip occluded fragments. Blending needs back to front, blended items are sorted by depth only.
+    // Ties keep the order of the queue, std::stable_sort would allocate a buffer every frame.
+    std::sort(mDrawQueue.begin(), mDrawQueue.end(), [](const DrawItem& a, const DrawItem& b) {
+        if (a.blendMode != b.blendMode)
+        {
+            return a.blendMode < b.blendMode;
+        }
+        if (a.blendMode == BlendMode::BLENDED)
+        {
+            return a.depth != b.depth ? a.depth > b.depth : a.sequence < b.sequence;
+        }
+        if (a.program != b.program)
+        {
+            return a.program < b.program;
+        }
+        if (a.texture != b.texture)
+        {
+            return a.texture < b.texture;
+        }
+        if (a.kind != b.kind)
+        {
+            return a.kind < b.kind;
+        }
+        if (a.model != b.model)
+        {
+            return std::less<const Model*>()(a.model, b.model);
+        }
+        return a.depth != b.depth ? a.depth < b.depth : a.sequence < b.sequence;
+    });
+
+    for (size_t i = 0; i < mDrawQueue.size();)
+    {
+        const DrawItem& item = mDrawQueue[i];
+        size_t end = i + 1;
+        if (item.kind == DrawItem::Kind::MODEL)
+        {
+            // Neighbouring copies of a model are drawn with one instanced call
+            for (; end < mDrawQueue.size(); ++end)
+            {
+                const DrawItem& next = mDrawQueue[end];
+                if (next.kind != DrawItem::Kind::MODEL || next.model != item.model || next.projectionMatrix != item.projectionMatrix)
+                {
+                    break;
+                }
+            }
+            auto modelViewMatrices = arena.allocateArray<VuMatrix44F>(end - i);
+            for (size_t copy = i; copy < end; ++copy)
+            {
+                modelViewMatrices[copy - i] = mDrawQueue[copy].modelViewMatrix;
+            }
+            renderModel(*item.projectionMatrix, modelViewMatrices, end - i, *item.model);
+        }
+        else
+        {
+            renderDrawItem(item);
+        }
+        i = end;
+    }
+
+    if (offscreen)
+    {
+        endAugmentationPass();
+    }
+    mFrameArena = nullptr;
+}
+
+
+bool
+GLESRenderer::beginAugmentationPass()
+{
+    mAugmentationScale = 1.0f;
+    if (!mDynamicResolutionEnabled || mViewportWidth <= 0 || mViewportHeight <= 0)
+    {
+        return false;
+    }
+
+    if (!mAugmentationTimer.isValid() && !mAugmentationTimer.create())
+    {
+        LOG("GPU timer queries not supported, dynamic resolution disabled");
+        mDynamicResolutionEnabled = false;
+        return false;
+    }
+    if (mAugmentationTarget.getWidth() != mViewportWidth || mAugmentationTarget.getHeight() != mViewportHeight)
+    {
+        bool created = mAugmentationTarget.create(mViewportWidth, mViewportHeight);
+        mMemoryAccounting.set(AUGMENTATION_TARGET_NAME, MemoryAccounting::Category::RENDER_TARGET, MemoryAccounting::Pool::GPU,
+                              mAugmentationTarget.getSizeBytes());
+        if (!created)
+        {
+            mDynamicResolutionEnabled = false;
+            return false;
+        }
+        mDynamicResolution.reset();
+    }
+
+    float milliseconds = 0.0f;
+    if (mAugmentationTimer.getResult(milliseconds) && mDynamicResolution.addFrameTime(milliseconds))
+    {
+        LOG("Augmentations take %.1f ms on the GPU, drawing them at scale %.2f", milliseconds, mDynamicResolution.getScale());
+    }
+    mAugmentationScale = mDynamicResolution.getScale();
+    mAugmentationWidth = std::max(1, static_cast<int>(std::lround(mViewportWidth * mAugmentationScale)));
+    mAugmentationHeight = std::max(1, static_cast<int>(std::lround(mViewportHeight * mAugmentationScale)));
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mAugmentationTarget.getFramebuffer());
+    glViewport(0, 0, mAugmentationWidth, mAugmentationHeight);
+    // Cleared to transparent black, the pass is composited with premultiplied alpha
+    const GLfloat transparent[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const GLfloat farDepth = 1.0f;
+    glClearBufferfv(GL_COLOR, 0, transparent);
+    glClearBufferfv(GL_DEPTH, 0, &farDepth);
+
+    mAugmentationTimer.begin();
+    return true;
+}
+
+
+void
+GLESRenderer::endAugmentationPass()
+{
+    Profiler::Scope scope(mProfiler, "compositeAugmentations");
+
+    mAugmentationTimer.end();
+    RenderTarget::discardDepth();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(mViewportX, mViewportY, mViewportWidth, mViewportHeight);
+
+    mStateCache.setEnabled(GL_DEPTH_TEST, false);
+    mStateCache.setEnabled(GL_CULL_FACE, false);
+    mStateCache.setEnabled(GL_BLEND, true);
+    mStateCache.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    mStateCache.useProgram(mTextureUniformColorShaderProgramID);
+    mStateCache.bindTexture(0, GL_TEXTURE_2D, mAugmentationTarget.getTexture());
+
+    // The unit square scaled over the whole clip space, sampling the part of the target that was drawn.
+    // The square has its texture origin at the top, the framebuffer at the bottom.
+    float u = static_cast<float>(mAugmentationWidth) / mAugmentationTarget.getWidth();
+    float v = static_cast<float>(mAugmentationHeight) / mAugmentationTarget.getHeight();
+    bindFrameUniforms(MatrixMath::identity());
+    bindDrawUniforms(MatrixMath::scaling({ 2.0f, 2.0f, 1.0f }), WHITE, { u, -v, 0.0f, v });
+    mSquareMesh.draw(GL_TRIANGLES, NUM_SQUARE_INDEX, 0);
+
+    GLESUtils::checkGlError("Composite augmentations");
+}
+
+
+GLESRenderer::DrawItem&
+GLESRenderer::enqueue(DrawItem::Kind kind, GLuint program, GLuint texture, BlendMode blendMode, const VuMatrix44F& projectionMatrix,
+                      const VuMatrix44F& modelViewMatrix)
+{
+    DrawItem item{};
+    item.kind = kind;
+    item.program = program;
+    item.texture = texture;
+    item.blendMode = blendMode;
+    // View space looks down -z, the matrix is column-major
+    item.depth = -modelViewMatrix.data[14];
+    item.projectionMatrix = &projectionMatrix;
+    item.modelViewMatrix = modelViewMatrix;
+    item.color = WHITE;
+    item.sequence = static_cast<unsigned int>(mDrawQueue.size());
+    mDrawQueue.push_back(item);
+    return mDrawQueue.back();
+}
+
+
+void
+GLESRenderer::enqueueWorldOrigin(const VuMatrix44F& projectionMatrix, const VuMatrix44F& modelViewMatrix)
+{
+    DrawItem& axis = enqueue(DrawItem::Kind::AXIS, mVertexColorShaderProgramID, 0, BlendMode::OPAQUE, projectionMatrix, modelViewMatrix);
+    axis.scale = { 0.1f, 0.1f, 0.1f };
+    axis.lineWidth = 4.0f;
+
+    DrawItem& cube = enqueue(DrawItem::Kind::CUBE, mUniformColorShaderProgramID, 0, BlendMode::OPAQUE, projectionMatrix, modelViewMatrix);
+    cube.scale = { 0.015f, 0.015f, 0.015f };
+    cube.color = { 0.8f, 0.8f, 0.8f, 1.0f };
+}
+
+
+void
+GLESRenderer::enqueueTarget(const VuMatrix44F& projectionMatrix, const FramePacket::Target& target)
+{
+    // A gallery target draws the model of the target it is bound to
+    int assetTarget =
+        target.targetId == AppController::GALLERY_TARGET_ID ? GALLERY_TARGETS[target.galleryIndex].assetTarget : target.targetId;
+    requireTargetAssets(assetTarget);
+
+    if (target.targetId == AppController::IMAGE_TARGET_ID || target.targetId == AppController::GALLERY_TARGET_ID)
+    {
+        // Translucent solid overlay and solid outline of the target bounds
+        DrawItem& overlay = enqueue(DrawItem::Kind::TARGET_OVERLAY, mUniformColorShaderProgramID, 0, BlendMode::BLENDED, projectionMatrix,
+                                    target.scaledModelViewMatrix);
+        overlay.color = { 1.0f, 0.0f, 0.0f, 0.1f };
+        DrawItem& outline = enqueue(DrawItem::Kind::TARGET_OUTLINE, mUniformColorShaderProgramID, 0, BlendMode::OPAQUE, projectionMatrix,
+                                    target.scaledModelViewMatrix);
+        outline.color = { 1.0f, 0.0f, 0.0f, 1.0f };
+        outline.lineWidth = 4.0f;
+
+        DrawItem& axis =
+            enqueue(DrawItem::Kind::AXIS, mVertexColorShaderProgramID, 0, BlendMode::OPAQUE, projectionMatrix, target.modelViewMatrix);
+        axis.scale = { 0.02f, 0.02f, 0.02f };
+        axis.lineWidth = 4.0f;
+    }
+    else if (target.targetId == AppController::MODEL_TARGET_ID)
+    {
+        DrawItem& axis =
+            enqueue(DrawItem::Kind::AXIS, mVertexColorShaderProgramID, 0, BlendMode::OPAQUE, projectionMatrix, target.modelViewMatrix);
+        axis.scale = { 0.1f, 0.1f, 0.1f };
+        axis.lineWidth = 4.0f;
+    }
+
+    Model* model = nullptr;
+    for (const auto& entry : getManifest())
+    {
+        if (entry.target == assetTarget)
+        {
+            model = entry.model;
+        }
+    }
+    if (model != nullptr && model->ready)
+    {
+        DrawItem& item = enqueue(DrawItem::Kind::MODEL, getModelProgram(*model), getModelTexture(*model), model->blendMode,
+                                 projectionMatrix, target.modelViewMatrix);
+        item.model = model;
+    }
+}
+
+
+void
+GLESRenderer::enqueueGuideView(const FramePacket& packet)
+{
+    // The guide view image is updated if the device orientation changes.
+    // This is indicated by the guideViewImageChanged flag. In that case,
+    // write the latest content of the image into the existing texture storage.
+    if (!mModelTargetGuideViewTexture.isValid() || packet.guideViewImageChanged == VU_TRUE)
+    {
+        mModelTargetGuideViewTexture.update(packet.guideViewImage);
+        // The update binds the texture behind the state cache, and may replace it
+        mStateCache.invalidateTextures();
+
+        // The image itself is owned by Vuforia and accounted as its CPU memory
+        const VuImageInfo& image = packet.guideViewImage;
+        mMemoryAccounting.set(GUIDE_VIEW_NAME, MemoryAccounting::Category::GUIDE_VIEW, MemoryAccounting::Pool::CPU,
+                              image.buffer != nullptr && image.stride > 0 ? static_cast<size_t>(image.stride) * image.height : 0);
+        mMemoryAccounting.set(GUIDE_VIEW_NAME, MemoryAccounting::Category::GUIDE_VIEW, MemoryAccounting::Pool::GPU,
+                              mModelTargetGuideViewTexture.getSizeBytes());
+    }
+
+    // Drawn over everything else without depth testing, it sorts in front of all blended items
+    DrawItem& item = enqueue(DrawItem::Kind::GUIDE_VIEW, mTextureUniformColorShaderProgramID, mModelTargetGuideViewTexture.getTexture(),
+                             BlendMode::BLENDED, packet.guideViewProjectionMatrix, packet.guideViewModelViewMatrix);
+    item.depth = 0.0f;
+    item.color = { 1.0f, 1.0f, 1.0f, 0.7f };
+}
+
+
+void
+GLESRenderer::renderDrawItem(const DrawItem& item)
+{
+    switch (item.kind)
+    {
+        case DrawItem::Kind::AXIS:
+            renderAxis(*item.projectionMatrix, item.modelViewMatrix, item.scale, item.lineWidth);
+            break;
+        case DrawItem::Kind::CUBE:
+            renderCube(*item.projectionMatrix, item.modelViewMatrix, item.scale.data[0], item.color);
+            break;
+        case DrawItem::Kind::TARGET_OVERLAY:
+        case DrawItem::Kind::TARGET_OUTLINE:
+        case DrawItem::Kind::GUIDE_VIEW:
+            renderSquare(item);
+            break;
+        case DrawItem::Kind::MODEL:
+            renderModel(*item.projectionMatrix, &item.modelViewMatrix, 1, *item.model);
+            break;
+    }
+}
+
+
+void
+GLESRenderer::renderSquare(const DrawItem& item)
+{
+    bindFrameUniforms(*item.projectionMatrix);
+
+    bool guideView = item.kind == DrawItem::Kind::GUIDE_VIEW;
+    mStateCache.setEnabled(GL_DEPTH_TEST, !guideView);
+    mStateCache.setEnabled(GL_CULL_FACE, false);
+    mStateCache.setEnabled(GL_BLEND, item.blendMode == BlendMode::BLENDED);
+    // Alpha accumulates as coverage, offscreen augmentations are premultiplied for compositing
+    mStateCache.blendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    mStateCache.useProgram(item.program);
+    if (guideView)
+    {
+        mStateCache.bindTexture(0, GL_TEXTURE_2D, item.texture);
+        bindDrawUniforms(item.modelViewMatrix, item.color, mModelTargetGuideViewTexture.getTexCoordTransform());
+    }
+    else
+    {
+        bindDrawUniforms(item.modelViewMatrix, item.color);
+    }
+
+    // The wireframe indices follow the triangle indices in the index buffer
+    if (item.kind == DrawItem::Kind::TARGET_OUTLINE)
+    {
+        mStateCache.lineWidth(item.lineWidth * mAugmentationScale);
+        mSquareMesh.draw(GL_LINES, NUM_SQUARE_WIREFRAME_INDEX, NUM_SQUARE_INDEX);
+    }
+    else
+    {
+        mSquareMesh.draw(GL_TRIANGLES, NUM_SQUARE_INDEX, 0);
+    }
+
+    GLESUtils::checkGlError("Render square");
+}
+
+
+void
+GLESRenderer::assignUploadedTexture(const TextureUploader::Finished& finished)
+{
+    if (finished.layer != -1)
+    {
+        for (const auto& entry : getManifest())
+        {
+            Model& model = *entry.model;
+            if (model.requested && model.textureId == nullptr && finished.id == entry.textureName)
+            {
+                model.textureLayer = mArtworkArray.acquire(finished.id);
+                model.textureId = entry.textureName;
+                model.textureLevel = 0;
+            }
+        }
+        // Drop the reference held while the layer was written, it stays filled without references
+        mArtworkArray.release(finished.id);
+        return;
+    }
+
+    GLuint texture = mTextureCache.insert(finished.id, finished.texture, finished.sizeBytes);
+
+    // The reference taken by insert goes to the first model needing the texture
+    bool referenced = false;
+    for (const auto& entry : getManifest())
+    {
+        Model& model = *entry.model;
+        if (!model.requested)
+        {
+            continue;
+        }
+        int level = getTextureLevel(entry, finished.id);
+        if (level > model.textureLevel)
+        {
+            // A finer level of a remote artwork replaces the coarser one, which stays cached without the reference
+            if (model.textureId != nullptr)
+            {
+                mTextureCache.release(model.textureId);
+            }
+            model.textureUnit = referenced ? mTextureCache.acquire(finished.id) : texture;
+            model.textureId = getTextureName(entry, level);
+            model.textureLevel = level;
+            referenced = true;
+        }
+        else if (model.normalMapId == nullptr && entry.normalMapName != nullptr && finished.id == entry.normalMapName)
+        {
+            model.normalMapUnit = referenced ? mTextureCache.acquire(finished.id) : texture;
+            model.normalMapId = entry.normalMapName;
+            referenced = true;
+        }
+    }
+
+    if (!referenced)
+    {
+        mTextureCache.release(finished.id);
+    }
+}
+
+
+void
+GLESRenderer::uploadTexture(const ManifestEntry& entry, const char* id, int width, int height, std::vector<unsigned char> pixels)
+{
+    if (entry.textureArray && width == ARTWORK_LAYER_SIZE && height == ARTWORK_LAYER_SIZE && mTextureArrayShaderProgramID != 0 &&
+        !mTextureUploader.isPending(id))
+    {
+        if (!mArtworkArray.isValid() &&
+            mArtworkArray.create(ARTWORK_LAYER_SIZE, ARTWORK_LAYER_SIZE, ARTWORK_LAYER_COUNT, entry.textureOptions))
+        {
+            size_t layerBytes = TextureCache::estimateSize(ARTWORK_LAYER_SIZE, ARTWORK_LAYER_SIZE, 4, mArtworkArray.getOptions().mipmaps);
+            mMemoryAccounting.set(ARTWORK_ARRAY_NAME, MemoryAccounting::Category::TEXTURE, MemoryAccounting::Pool::GPU,
+                                  layerBytes * ARTWORK_LAYER_COUNT);
+        }
+        int layer = mArtworkArray.isValid() ? mArtworkArray.allocate(id) : -1;
+        if (layer != -1)
+        {
+            mTextureUploader.enqueueLayer(id, mArtworkArray.getTexture(), layer, width, height, mArtworkArray.getOptions().mipmaps,
+                                          std::move(pixels));
+            return;
+        }
+        LOG("No free layer for texture %s", id);
+    }
+
+    mTextureUploader.enqueue(id, width, height, GL_RGBA, entry.textureOptions, std::move(pixels));
+}
+
+
+GLuint
+GLESRenderer::createProgram(const char* vertexShaderSource, const char* fragmentShaderSource, std::initializer_list<const char*> samplers,
+                            const char* defines)
+{
+    // Defines must follow the version line
+    std::string vertexSource = vertexShaderSource;
+    std::string fragmentSource = fragmentShaderSource;
+    if (defines != nullptr)
+    {
+        vertexSource.insert(vertexSource.find('\n') + 1, defines);
+        fragmentSource.insert(fragmentSource.find('\n') + 1, defines);
+    }
+
+    GLuint program = GLESUtils::createProgramFromBuffer(vertexSource.c_str(), fragmentSource.c_str());
+    if (program == 0)
+    {
+        return 0;
+    }
+
+    // Block bindings and samplers are program state, they are set once here instead of on every draw
+    GLuint frameBlock = glGetUniformBlockIndex(program, "FrameUniforms");
+    if (frameBlock != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(program, frameBlock, FRAME_UNIFORMS_BINDING);
+    }
+    GLuint drawBlock = glGetUniformBlockIndex(program, "DrawUniforms");
+    if (drawBlock != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(program, drawBlock, DRAW_UNIFORMS_BINDING);
+    }
+
+    glUseProgram(program);
+    GLint unit = 0;
+    for (const char* sampler : samplers)
+    {
+        glUniform1i(ProgramCache::getUniformLocation(program, sampler), unit++);
+    }
+    glUseProgram(0);
+    return program;
+}
+
+
+void
+GLESRenderer::bindFrameUniforms(const VuMatrix44F& projectionMatrix)
+{
+    // All augmentations of a frame usually share the projection, it is only written once
+    if (mFrameProjectionBound && memcmp(&mFrameProjection, &projectionMatrix, sizeof(projectionMatrix)) == 0)
+    {
+        return;
+    }
+    FrameUniforms uniforms{ projectionMatrix };
+    mUniformRing.bind(FRAME_UNIFORMS_BINDING, &uniforms, sizeof(uniforms));
+    mFrameProjection = projectionMatrix;
+    mFrameProjectionBound = true;
+}
+
+
+void
+GLESRenderer::bindDrawUniforms(const VuMatrix44F& modelViewMatrix, const VuVector4F& color, const VuVector4F& texCoordTransform,
+                               const VuVector4F& params)
+{
+    DrawUniforms uniforms{ modelViewMatrix, color, texCoordTransform, params };
+    mUniformRing.bind(DRAW_UNIFORMS_BINDING, &uniforms, sizeof(uniforms));
+}
+
+
+void
+GLESRenderer::renderCube(const VuMatrix44F& projectionMatrix, const VuMatrix44F& modelViewMatrix, float scale, const VuVector4F& color)
+{
+    VuVector3F scaleVec{ scale, scale, scale };
+    VuMatrix44F scaledModelViewMatrix = MatrixMath::scale(scaleVec, modelViewMatrix);
+
+    ///////////////////////////////////////////////////////////////
+    // Render with const ambient diffuse light uniform color shader
+    mStateCache.setEnabled(GL_DEPTH_TEST, true);
+    mStateCache.setEnabled(GL_CULL_FACE, false);
+    mStateCache.setEnabled(GL_BLEND, false);
+    mStateCache.useProgram(mUniformColorShaderProgramID);
+
+    bindFrameUniforms(projectionMatrix);
+    bindDrawUniforms(scaledModelViewMatrix, color);
+
+    // Draw
+    mCubeMesh.draw(GL_TRIANGLES);
+
+    GLESUtils::checkGlError("Render cube");
+    ///////////////////////////////////////////////////////
+}
+
+
+void
+GLESRenderer::renderAxis(const VuMatrix44F& projectionMatrix, const VuMatrix44F& modelViewMatrix, const VuVector3F& scale, float lineWidth)
+{
+    VuMatrix44F scaledModelViewMatrix = MatrixMath::scale(scale, modelViewMatrix);
+
+    ///////////////////////////////////////////////////////
+    // Render with vertex color shader
+    mStateCache.setEnabled(GL_DEPTH_TEST, true);
+    mStateCache.setEnabled(GL_CULL_FACE, false);
+    mStateCache.setEnabled(GL_BLEND, false);
+    mStateCache.useProgram(mVertexColorShaderProgramID);
+
+    bindFrameUniforms(projectionMatrix);
+    bindDrawUniforms(scaledModelViewMatrix, WHITE);
+
+    // Draw
+    mStateCache.lineWidth(lineWidth * mAugmentationScale);
+    mAxisMesh.draw(GL_LINES);
+
+    GLESUtils::checkGlError("Render axis");
+    ///////////////////////////////////////////////////////
+}
+
+
+void
+GLESRenderer::renderModel(const VuMatrix44F& projectionMatrix, const VuMatrix44F* modelViewMatrices, size_t count, Model& model)
+{
+    Profiler::Scope scope(mProfiler, "renderModel");
+
+    // Extended tracking keeps the pose of targets that left the camera view, skip them entirely
+    auto visibleInstances = mFrameArena->allocateArray<VuMatrix44F>(count);
+    size_t visibleCount = 0;
+    int lod = -1;
+    int previousLod = model.currentLod;
+    auto modelViewProjections = mFrameArena->allocateArray<VuMatrix44F>(count);
+    MatrixMath::multiplyBatch(projectionMatrix, modelViewMatrices, count, modelViewProjections);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const VuMatrix44F& modelViewProjectionMatrix = modelViewProjections[i];
+        if (!isInFrustum(modelViewProjectionMatrix, model.bounds))
+        {
+            mCulledDrawCount.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        // Every copy starts from the level of the previous frame, so that the hysteresis applies to each of them
+        model.currentLod = previousLod;
+        int instanceLod = selectLod(model, modelViewProjectionMatrix);
+        lod = lod == -1 ? instanceLod : std::min(lod, instanceLod);
+        visibleInstances[visibleCount++] = modelViewMatrices[i];
+    }
+    if (visibleCount == 0)
+    {
+        model.currentLod = previousLod;
+        return;
+    }
+    model.currentLod = lod;
+
+    // A single copy goes through the draw uniforms, copies drawn together only share the dequantization
+    bool instanced = visibleCount > 1;
+    VuMatrix44F meshModelViewMatrix = instanced ? model.positionTransform : MatrixMath::multiply(visibleInstances[0], model.positionTransform);
+    bindFrameUniforms(projectionMatrix);
+
+    mStateCache.setEnabled(GL_DEPTH_TEST, true);
+    mStateCache.setEnabled(GL_CULL_FACE, true);
+    mStateCache.cullFace(GL_BACK);
+    mStateCache.frontFace(GL_CCW);
+
+    // Blending stays off for opaque and alpha-tested materials, they keep the early depth test of tile-based GPUs
+    mStateCache.setEnabled(GL_BLEND, model.blendMode == BlendMode::BLENDED);
+    // Alpha accumulates as coverage, offscreen augmentations are premultiplied for compositing
+    mStateCache.blendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    GLuint program = getModelProgram(model);
+    bool layered = program == mTextureArrayShaderProgramID || program == mShadedTextureArrayShaderProgramID;
+    mStateCache.bindTexture(0, layered ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D, getModelTexture(model));
+    mStateCache.useProgram(program);
+
+    if (layered)
+    {
+        // Models drawn from the array only differ in their uniforms
+        bindDrawUniforms(meshModelViewMatrix, WHITE, model.texCoordTransform, { static_cast<float>(model.textureLayer), 0.0f, 0.0f, 0.0f });
+    }
+    else if (program == mPseudoNormalShaderProgramID || program == mShadedPseudoNormalShaderProgramID)
+    {
+        mStateCache.bindTexture(1, GL_TEXTURE_2D, model.normalMapUnit);
+
+        float valueOffset = PseudoNormalBaker::estimateValueOffset(model.colorMeanLuma, model.normalMeanLuma);
+        bindDrawUniforms(meshModelViewMatrix, WHITE, model.texCoordTransform,
+                         { PseudoNormalBaker::COLOR_WEIGHT, valueOffset, PseudoNormalBaker::SATURATION, 0.0f });
+    }
+    else
+    {
+        bindDrawUniforms(meshModelViewMatrix, WHITE, model.texCoordTransform);
+    }
+
+    // Draw
+    GLsizei indexCount = model.lods.empty() ? 0 : model.lods[lod].indexCount;
+    GLsizei firstIndex = model.lods.empty() ? 0 : model.lods[lod].firstIndex;
+    if (instanced)
+    {
+        submitInstanced(model.gpuMesh, GL_TRIANGLES, visibleInstances, visibleCount, indexCount, firstIndex);
+    }
+    else if (indexCount == 0)
+    {
+        model.gpuMesh.draw(GL_TRIANGLES);
+    }
+    else
+    {
+        model.gpuMesh.draw(GL_TRIANGLES, indexCount, firstIndex);
+    }
+
+    GLESUtils::checkGlError("Render model");
+}
+
+
+void
+GLESRenderer::submitInstanced(const GpuMesh& mesh, GLenum mode, const VuMatrix44F* modelViewMatrices, size_t instanceCount, GLsizei count,
+                              GLsizei firstIndex)
+{
+    if (instanceCount == 0)
+    {
+        return;
+    }
+
+    // Respecifying the whole store orphans the one still read by the previous instanced draw
+    glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(instanceCount * sizeof(VuMatrix44F)), modelViewMatrices, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (count == 0)
+    {
+        mesh.drawInstanced(mode, static_cast<GLsizei>(instanceCount), mInstanceBuffer);
+    }
+    else
+    {
+        mesh.drawInstanced(mode, count, firstIndex, static_cast<GLsizei>(instanceCount), mInstanceBuffer);
+    }
+}
+
+
+GLuint
+GLESRenderer::getModelProgram(const Model& model) const
+{
+    // The shade attribute of shaded meshes is simply not read by the unshaded programs
+    auto select = [&model](GLuint program, GLuint shadedProgram) { return model.shaded && shadedProgram != 0 ? shadedProgram : program; };
+    if (model.blendMode == BlendMode::ALPHA_TEST)
+    {
+        return model.textureLayer != -1 ? select(mAlphaTestArrayShaderProgramID, mShadedAlphaTestArrayShaderProgramID)
+                                        : select(mAlphaTestShaderProgramID, mShadedAlphaTestShaderProgramID);
+    }
+    if (model.textureLayer != -1)
+    {
+        return select(mTextureArrayShaderProgramID, mShadedTextureArrayShaderProgramID);
+    }
+    if (model.normalMapUnit != -1 && mPseudoNormalShaderProgramID != 0)
+    {
+        return select(mPseudoNormalShaderProgramID, mShadedPseudoNormalShaderProgramID);
+    }
+    return select(mTextureUniformColorShaderProgramID, mShadedTextureUniformColorShaderProgramID);
+}
+
+
+GLuint
+GLESRenderer::getModelTexture(const Model& model) const
+{
+    if (model.textureLayer != -1)
+    {
+        return mArtworkArray.getTexture();
+    }
+    return model.textureUnit != -1 ? model.textureUnit : mPlaceholderTexture;
+}
+
+
+bool
+GLESRenderer::isInFrustum(const VuMatrix44F& modelViewProjectionMatrix, const MeshFormat::Bounds& bounds)
+{
+    if (bounds.radius <= 0.0f)
+    {
+        // No bounds known for this mesh
+        return true;
+    }
+
+    // Column-major matrix, row i is (m[i], m[i + 4], m[i + 8], m[i + 12])
+    const float* m = modelViewProjectionMatrix.data;
+    for (int row = 0; row < 3; ++row)
+    {
+        for (float sign : { 1.0f, -1.0f })
+        {
+            // Plane w + sign * row >= 0
+            float plane[4];
+            for (int column = 0; column < 4; ++column)
+            {
+                plane[column] = m[column * 4 + 3] + sign * m[column * 4 + row];
+            }
+            float distance = plane[3];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                distance += plane[axis] * (plane[axis] >= 0.0f ? bounds.max[axis] : bounds.min[axis]);
+            }
+            if (distance < 0.0f)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+int
+GLESRenderer::selectLod(Model& model, const VuMatrix44F& modelViewProjectionMatrix) const
+{
+    const int lodCount = static_cast<int>(model.lods.size());
+    if (lodCount < 2 || mViewportHeight <= 0)
+    {
+        return 0;
+    }
+
+    // Clip space w of the bounding sphere center, the matrix is column-major
+    const float* m = modelViewProjectionMatrix.data;
+    const float* c = model.bounds.center;
+    float w = m[3] * c[0] + m[7] * c[1] + m[11] * c[2] + m[15];
+    if (w <= model.bounds.radius)
+    {
+        // The camera is inside or close to the sphere, the model covers the screen
+        model.currentLod = 0;
+        return 0;
+    }
+
+    // Pixels covered by one model unit at the distance of the center, taken from the scale of the x and y rows
+    // Offscreen augmentations cover fewer pixels
+    float rowX = std::sqrt(m[0] * m[0] + m[4] * m[4] + m[8] * m[8]) * 0.5f * mViewportWidth * mAugmentationScale;
+    float rowY = std::sqrt(m[1] * m[1] + m[5] * m[5] + m[9] * m[9]) * 0.5f * mViewportHeight * mAugmentationScale;
+    float pixelsPerUnit = std::max(rowX, rowY) / w;
+
+    int lod = std::min(model.currentLod, lodCount - 1);
+    while (lod > 0 && model.lods[lod].error * pixelsPerUnit > LOD_ERROR_PIXELS)
+    {
+        --lod;
+    }
+    while (lod + 1 < lodCount && model.lods[lod + 1].error * pixelsPerUnit < LOD_ERROR_PIXELS * LOD_HYSTERESIS)
+    {
+        ++lod;
+    }
+    model.currentLod = lod;
+    return lod;
+}
+
+
+bool
+GLESRenderer::loadModel(AAssetManager* assetManager, AssetCache& assetCache, const char* name, Model& model)
+{
+    releaseModel(model);
+
+    // Prefer the pre-baked binary mesh, it is mapped and used in place without parsing
+    std::string filename = std::string(name) + ".mesh";
+    if (model.asset.open(assetManager, filename.c_str()))
+    {
+        if (MeshLoader::parseBinary(model.asset.data(), model.asset.size(), model.mesh))
+        {
+            LOG("Mapped binary mesh %s", filename.c_str());
+            MeshLoader::interleave(model.mesh, model.vertices);
+            return true;
+        }
+        LOG("Error loading binary mesh %s, falling back to OBJ", filename.c_str());
+        model.asset.close();
+    }
+
+    // Fall back to parsing the OBJ file, the parser reads straight from the asset view
+    filename = std::string(name) + ".obj";
+    LOG("Reading asset %s", filename.c_str());
+    AssetView objAsset;
+    if (!objAsset.open(assetManager, filename.c_str()))
+    {
+        LOG("Error opening asset file %s", filename.c_str());
+        return false;
+    }
+
+    // Parsed on an earlier launch, the binary mesh stored then is mapped like a pre-baked one
+    uint64_t key = AssetCache::computeKey(objAsset.data(), objAsset.size(), getMeshVariant(model.quantize));
+    if (assetCache.load(key, model.cached))
+    {
+        if (MeshLoader::parseBinary(model.cached.data(), model.cached.size(), model.mesh))
+        {
+            LOG("Mapped cached mesh of %s", filename.c_str());
+            MeshLoader::interleave(model.mesh, model.vertices);
+            return true;
+        }
+        model.cached.close();
+    }
+
+    if (!MeshLoader::loadObjStreaming(objAsset.data(), objAsset.size(), model.data))
+    {
+        return false;
+    }
+    if (model.quantize)
+    {
+        MeshLoader::quantize(model.data);
+    }
+    model.mesh = MeshLoader::view(model.data);
+    MeshLoader::interleave(model.mesh, model.vertices);
+
+    std::vector<char> binary;
+    if (assetCache.isEnabled() && MeshLoader::writeBinary(model.mesh, binary))
+    {
+        assetCache.store(key, { { binary.data(), binary.size() } });
+    }
+    return true;
+}
+
+
 bool
-GLESRenderer::init(AAssetManager* assetManager)
+GLESRenderer::loadDownloadedModel(AssetCache& assetCache, const std::string& url, std::vector<char> data, Model& model)
 {
-    // Setup for Video Background rendering
-    mVbShaderProgramID = GLESUtils::createProgramFromBuffer(textureVertexShaderSrc, textureFragmentShaderSrc);
-    mVbVertexPositionHandle = glGetAttribLocation(mVbShaderProgramID, "vertexPosition");
-    mVbTextureCoordHandle = glGetAttribLocation(mVbShaderProgramID, "vertexTextureCoord");
-    mVbMvpMatrixHandle = glGetUniformLocation(mVbShaderProgramID, "modelViewProjectionMatrix");
-    mVbTexSampler2DHandle = glGetUniformLocation(mVbShaderProgramID, "texSampler2D");
+    releaseModel(model);
 
-    // Setup for augmentation rendering
-    mUniformColorShaderProgramID = GLESUtils::createProgramFromBuffer(uniformColorVertexShaderSrc, uniformColorFragmentShaderSrc);
-    mUniformColorVertexPositionHandle = glGetAttribLocation(mUniformColorShaderProgramID, "vertexPosition");
-    mUniformColorMvpMatrixHandle = glGetUniformLocation(mUniformColorShaderProgramID, "modelViewProjectionMatrix");
-    mUniformColorColorHandle = glGetUniformLocation(mUniformColorShaderProgramID, "uniformColor");
+    // A binary mesh is used in place like a mapped asset, the model keeps the download instead
+    bool obj = url.size() >= 4 && url.compare(url.size() - 4, 4, ".obj") == 0;
+    if (!obj)
+    {
+        model.download = std::move(data);
+        if (!MeshLoader::parseBinary(model.download.data(), model.download.size(), model.mesh))
+        {
+            LOG("Error parsing binary mesh %s", url.c_str());
+            return false;
+        }
+        MeshLoader::interleave(model.mesh, model.vertices);
+        return true;
+    }
 
-    // Setup for guide view rendering
-    mTextureUniformColorShaderProgramID = GLESUtils::createProgramFromBuffer(textureColorVertexShaderSrc, textureColorFragmentShaderSrc);
-    mTextureUniformColorVertexPositionHandle = glGetAttribLocation(mTextureUniformColorShaderProgramID, "vertexPosition");
-    mTextureUniformColorTextureCoordHandle = glGetAttribLocation(mTextureUniformColorShaderProgramID, "vertexTextureCoord");
-    mTextureUniformColorMvpMatrixHandle = glGetUniformLocation(mTextureUniformColorShaderProgramID, "modelViewProjectionMatrix");
-    mTextureUniformColorTexSampler2DHandle = glGetUniformLocation(mTextureUniformColorShaderProgramID, "texSampler2D");
-    mTextureUniformColorColorHandle = glGetUniformLocation(mTextureUniformColorShaderProgramID, "uniformColor");
+    uint64_t key = AssetCache::computeKey(data.data(), data.size(), getMeshVariant(model.quantize));
+    if (assetCache.load(key, model.cached))
+    {
+        if (MeshLoader::parseBinary(model.cached.data(), model.cached.size(), model.mesh))
+        {
+            MeshLoader::interleave(model.mesh, model.vertices);
+            return true;
+        }
+        model.cached.close();
+    }
+
+    if (!MeshLoader::loadObjStreaming(data.data(), data.size(), model.data))
+    {
+        return false;
+    }
+    if (model.quantize)
+    {
+        MeshLoader::quantize(model.data);
+    }
+    model.mesh = MeshLoader::view(model.data);
+    MeshLoader::interleave(model.mesh, model.vertices);
+
+    std::vector<char> binary;
+    if (assetCache.isEnabled() && MeshLoader::writeBinary(model.mesh, binary))
+    {
+        assetCache.store(key, { { binary.data(), binary.size() } });
+    }
+    return true;
+}
 
-    // Setup for axis rendering
-    mVertexColorShaderProgramID = GLESUtils::createProgramFromBuffer(vertexColorVertexShaderSrc, vertexColorFragmentShaderSrc);
-    mVertexColorVertexPositionHandle = glGetAttribLocation(mVertexColorShaderProgramID, "vertexPosition");
-    mVertexColorColorHandle = glGetAttribLocation(mVertexColorShaderProgramID, "vertexColor");
-    mVertexColorMvpMatrixHandle = glGetUniformLocation(mVertexColorShaderProgramID, "modelViewProjectionMatrix");
 
-    mModelTargetGuideViewTextureUnit = -1;
+bool
+GLESRenderer::loadCompressedTexture(const char* textureName, const TextureOptions& options, Model& model)
+{
+    // Preferred variant first, ETC2 is supported by every OpenGL ES 3.0 device
+    static const char* const VARIANT_SUFFIXES[] = { ".astc.ktx", ".etc2.ktx" };
 
-    std::vector<char> data; // for reading model files
+    std::string baseName(textureName);
+    baseName = baseName.substr(0, baseName.rfind('.'));
 
-    // Load Astronaut model
+    for (const char* suffix : VARIANT_SUFFIXES)
     {
-        if (!readAsset(assetManager, "Venus_01.obj", data))
+        std::string filename = baseName + suffix;
+        AssetView asset;
+        if (!asset.open(mAssetManager, filename.c_str()))
         {
-            return false;
+            continue;
         }
-        if (!loadObjModel(data, mAstronautVertexCount, mAstronautVertices, mAstronautTexCoords))
+
+        CompressedTextureView texture;
+        if (!TextureLoader::parseKtx(asset.data(), asset.size(), texture) ||
+            !GLESUtils::isCompressedFormatSupported(texture.internalFormat))
         {
-            return false;
+            continue;
         }
-        data.clear();
-        mAstronautTextureUnit = -1;
-        if (!readAsset(assetManager, "plane.obj", data))
+
+        GLuint compressedTextureId = GLESUtils::createCompressedTexture(texture, options);
+        if (compressedTextureId == -1)
         {
-            return false;
+            continue;
         }
-        if (!loadObjModel(data, mPlaneVertexCount, mPlaneVertices, mPlaneTexCoords))
+
+        size_t sizeBytes = 0;
+        for (size_t level = 0; level < (options.mipmaps ? texture.levels.size() : 1); ++level)
         {
-            return false;
+            sizeBytes += texture.levels[level].size;
         }
-        data.clear();
-        mPlaneTextureUnit = -1;
+        model.textureUnit = mTextureCache.insert(textureName, compressedTextureId, sizeBytes);
+        model.textureId = textureName;
+        model.textureLevel = 0;
+        LOG("Created compressed texture %s", filename.c_str());
+        return true;
     }
+    return false;
+}
 
-    // Load Lander model
+
+void
+GLESRenderer::requireTargetAssets(int target)
+{
+    for (const auto& entry : getManifest())
     {
-        if (!readAsset(assetManager, "VikingLander.obj", data))
+        Model& model = *entry.model;
+        if (entry.target != target || model.requested)
         {
-            return false;
+            continue;
         }
-        if (!loadObjModel(data, mLanderVertexCount, mLanderVertices, mLanderTexCoords))
+
+        LOG("Loading the assets of target %d", target);
+        model.requested = true;
+        if (entry.remote)
         {
-            return false;
+            requireRemoteAssets(entry);
+            continue;
+        }
+        requestModel(mAssetManager, entry.modelName, model, entry.quantize);
+        // Creating a compressed texture binds it directly
+        mStateCache.invalidateTextures();
+
+        // Without the pseudo normal shader the normal map is baked into the texture, which needs the decoded pixels
+        bool bakeNormalMap = entry.normalMapName != nullptr && mPseudoNormalShaderProgramID == 0;
+
+        // The textures may still be cached from an earlier detection, or still uploading,
+        // in which case assignUploadedTexture hands them over
+        model.textureLayer = entry.textureArray ? mArtworkArray.acquire(entry.textureName) : -1;
+        model.textureUnit = model.textureLayer == -1 ? mTextureCache.acquire(entry.textureName) : -1;
+        if (model.textureLayer != -1 || model.textureUnit != -1)
+        {
+            model.textureId = entry.textureName;
+            model.textureLevel = 0;
+        }
+        else if (!mTextureUploader.isPending(entry.textureName) &&
+                 (bakeNormalMap || entry.textureArray || !loadCompressedTexture(entry.textureName, entry.textureOptions, model)))
+        {
+            requestTexture(entry, bakeNormalMap);
         }
-        data.clear();
-        mLanderTextureUnit = -1;
-    }
 
-    return true;
+        if (entry.normalMapName != nullptr && !bakeNormalMap)
+        {
+            model.normalMapUnit = mTextureCache.acquire(entry.normalMapName);
+            if (model.normalMapUnit != -1)
+            {
+                model.normalMapId = entry.normalMapName;
+            }
+            else if (!mTextureUploader.isPending(entry.normalMapName))
+            {
+                requestNormalMap(entry);
+            }
+        }
+    }
 }
 
 
 void
-GLESRenderer::deinit()
+GLESRenderer::requireRemoteAssets(const ManifestEntry& entry)
 {
-    if (mModelTargetGuideViewTextureUnit != -1)
+    Model& model = *entry.model;
+    releaseModel(model);
+    accountModel(model.name, model);
+    model.quantize = entry.quantize;
+    if (!entry.coarseModelUrl.empty())
     {
-        GLESUtils::destroyTexture(mModelTargetGuideViewTextureUnit);
-        mModelTargetGuideViewTextureUnit = -1;
+        requestDownload(entry, Download::Kind::MODEL, 0, entry.coarseModelUrl);
     }
-    if (mAstronautTextureUnit != -1)
+    requestDownload(entry, Download::Kind::MODEL, GEOMETRY_FULL, entry.modelUrl);
+
+    // Start from the finest texture level still cached, only the finer ones are downloaded
+    int textureLevelCount = static_cast<int>(entry.textureUrls.size());
+    for (int level = textureLevelCount - 1; level >= 0 && model.textureId == nullptr; --level)
     {
-        GLESUtils::destroyTexture(mAstronautTextureUnit);
-        mAstronautTextureUnit = -1;
+        model.textureUnit = mTextureCache.acquire(entry.textureUrls[level]);
+        if (model.textureUnit != -1)
+        {
+            model.textureId = entry.textureUrls[level].c_str();
+            model.textureLevel = level;
+        }
     }
-    if (mLanderTextureUnit != -1)
+    for (int level = model.textureLevel + 1; level < textureLevelCount; ++level)
     {
-        GLESUtils::destroyTexture(mLanderTextureUnit);
-        mLanderTextureUnit = -1;
+        requestDownload(entry, Download::Kind::TEXTURE, level, entry.textureUrls[level]);
     }
-}
-
-
-void
-GLESRenderer::setAstronautTexture(int width, int height, unsigned char* bytes)
-{
-    createTexture(width, height, bytes, mAstronautTextureUnit);
-}
 
-void
-GLESRenderer::setPlaneTexture(int width, int height, unsigned char* bytes)
-{
-    createTexture(width, height, bytes, mPlaneTextureUnit);
+    // Baking the normal map would need every texture level decoded in native code,
+    // without the pseudo normal shader remote artworks are plainly textured instead
+    if (entry.normalMapName != nullptr && mPseudoNormalShaderProgramID != 0)
+    {
+        model.normalMapUnit = mTextureCache.acquire(entry.normalMapName);
+        if (model.normalMapUnit != -1)
+        {
+            model.normalMapId = entry.normalMapName;
+        }
+        else
+        {
+            requestDownload(entry, Download::Kind::NORMAL_MAP, 0, entry.normalMapUrl);
+        }
+    }
 }
 
 
 void
-GLESRenderer::setLanderTexture(int width, int height, unsigned char* bytes)
+GLESRenderer::requestDownload(const ManifestEntry& entry, Download::Kind kind, int level, const std::string& url)
 {
-    createTexture(width, height, bytes, mLanderTextureUnit);
+    // Still downloading, or decoded and uploading, from an earlier detection
+    if (mDownloads.count(url) != 0 || mTextureUploader.isPending(url))
+    {
+        return;
+    }
+    if (!mContentRequestCallback)
+    {
+        LOG("Cannot download %s, the platform set no content request callback", url.c_str());
+        return;
+    }
+    mDownloads[url] = Download{ &entry, kind, level };
+
+    // Where images cannot be decoded in native code the platform decodes them and answers with setTexture
+    mContentRequestCallback(url.c_str(), kind != Download::Kind::MODEL && !ImageDecoder::isAvailable());
 }
 
 
 void
-GLESRenderer::renderVideoBackground(const VuMatrix44F& projectionMatrix, const float* vertices, const float* textureCoordinates,
-                                    const int numTriangles, const unsigned int* indices, int textureUnit)
+GLESRenderer::setContent(const char* url, std::vector<char> data)
 {
-    GLboolean depthTest = GL_FALSE;
-    GLboolean cullTest = GL_FALSE;
-
-    glGetBooleanv(GL_DEPTH_TEST, &depthTest);
-    glGetBooleanv(GL_CULL_FACE, &cullTest);
-
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE);
-
-    // Load the shader and upload the vertex/texcoord/index data
-    glUseProgram(mVbShaderProgramID);
-    glVertexAttribPointer(static_cast<GLuint>(mVbVertexPositionHandle), 3, GL_FLOAT, GL_FALSE, 0, vertices);
-    glVertexAttribPointer(static_cast<GLuint>(mVbTextureCoordHandle), 2, GL_FLOAT, GL_FALSE, 0, textureCoordinates);
-
-    glUniform1i(mVbTexSampler2DHandle, textureUnit);
-
-    // Render the video background with the custom shader
-    // First, we enable the vertex arrays
-    glEnableVertexAttribArray(static_cast<GLuint>(mVbVertexPositionHandle));
-    glEnableVertexAttribArray(static_cast<GLuint>(mVbTextureCoordHandle));
+    // Files requested before the manifest changed or the renderer was deinitialized are no longer known
+    auto found = mDownloads.find(url);
+    if (found == mDownloads.end())
+    {
+        return;
+    }
+    Download download = found->second;
+    mDownloads.erase(found);
+    if (data.empty())
+    {
+        LOG("Error downloading %s", url);
+        return;
+    }
 
-    // Pass the projection matrix to OpenGL
-    glUniformMatrix4fv(mVbMvpMatrixHandle, 1, GL_FALSE, projectionMatrix.data);
+    const ManifestEntry* entry = download.entry;
+    unsigned int generation = mLoadGeneration;
+    if (download.kind == Download::Kind::MODEL)
+    {
+        mLoaderPool->submit([this, entry, level = download.level, url = std::string(url), data = std::move(data), generation]() mutable {
+            waitForCpuBudget(entry->modelName);
+            LoadedModel loaded{ entry->model, generation, level, {} };
+            loaded.model.quantize = entry->quantize;
+            if (!loadDownloadedModel(mAssetCache, url, std::move(data), loaded.model))
+            {
+                LOG("Error loading model %s", url.c_str());
+                return;
+            }
+            accountModel(entry->modelName, loaded.model);
+            std::lock_guard<std::mutex> lock(mLoadedAssetsMutex);
+            mLoadedModels.push_back(std::move(loaded));
+        });
+        return;
+    }
 
-    // Then, we issue the render call
-    glDrawElements(GL_TRIANGLES, numTriangles * 3, GL_UNSIGNED_INT, indices);
+    bool normalMap = download.kind == Download::Kind::NORMAL_MAP;
+    const char* id = normalMap ? entry->normalMapName : getTextureName(*entry, download.level);
+    mLoaderPool->submit([this, entry, id, normalMap, data = std::move(data), generation]() {
+        waitForCpuBudget(id);
+        LoadedTexture loaded{ entry, generation, id, {}, 0.0f, normalMap };
+        DecodedImage& image = loaded.image;
+        uint64_t key = AssetCache::computeKey(data.data(), data.size(), normalMap ? getLumaVariant(entry->normalMapDownscale) : RGBA_VARIANT);
+        if (!loadCachedImage(mAssetCache, key, image, loaded.meanLuma))
+        {
+            if (!ImageDecoder::decodeBuffer(data.data(), data.size(), id, image, normalMap ? entry->normalMapDownscale : 1))
+            {
+                return;
+            }
 
-    // Finally, we disable the vertex arrays
-    glDisableVertexAttribArray(static_cast<GLuint>(mVbVertexPositionHandle));
-    glDisableVertexAttribArray(static_cast<GLuint>(mVbTextureCoordHandle));
+            size_t pixelCount = static_cast<size_t>(image.width) * image.height;
+            if (normalMap)
+            {
+                // Only the luma is kept, like for normal map assets
+                loaded.meanLuma = PseudoNormalBaker::computeLuma(image.pixels.data(), pixelCount, image.pixels.data());
+                image.pixels.resize(pixelCount);
+                image.pixels.shrink_to_fit();
+            }
+            else
+            {
+                loaded.meanLuma = PseudoNormalBaker::computeMeanLuma(image.pixels.data(), pixelCount);
+            }
+            storeCachedImage(mAssetCache, key, image, loaded.meanLuma);
+        }
 
-    if (depthTest)
-        glEnable(GL_DEPTH_TEST);
+        mMemoryAccounting.set(id, MemoryAccounting::Category::TEXTURE, MemoryAccounting::Pool::PENDING, image.pixels.size());
+        std::lock_guard<std::mutex> lock(mLoadedAssetsMutex);
+        mLoadedTextures.push_back(std::move(loaded));
+    });
+}
 
-    if (cullTest)
-        glEnable(GL_CULL_FACE);
 
-    GLESUtils::checkGlError("Render video background");
+bool
+GLESRenderer::isUsedByTarget(const ManifestEntry& entry, int target)
+{
+    // The gallery shows the assets of the targets its entries are bound to
+    bool used = entry.target == target;
+    for (const auto& galleryTarget : GALLERY_TARGETS)
+    {
+        used = used || (target == AppController::GALLERY_TARGET_ID && galleryTarget.assetTarget == entry.target);
+    }
+    return used;
 }
 
 
 void
-GLESRenderer::renderWorldOrigin(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix)
+GLESRenderer::evictModel(Model& model)
 {
-    VuVector3F axis10cmSize{ 0.1f, 0.1f, 0.1f };
-    renderAxis(projectionMatrix, modelViewMatrix, axis10cmSize, 4.0f);
-    VuVector4F cubeColor{ 0.8, 0.8, 0.8, 1.0 };
-    renderCube(projectionMatrix, modelViewMatrix, 0.015f, cubeColor);
+    if (model.textureId != nullptr && model.textureLayer != -1)
+    {
+        mArtworkArray.release(model.textureId);
+    }
+    else if (model.textureId != nullptr)
+    {
+        mTextureCache.release(model.textureId);
+    }
+    model.textureId = nullptr;
+    model.textureLevel = -1;
+    model.textureUnit = -1;
+    model.textureLayer = -1;
+    if (model.normalMapId != nullptr)
+    {
+        mTextureCache.release(model.normalMapId);
+        model.normalMapId = nullptr;
+    }
+    model.normalMapUnit = -1;
+    releaseModel(model);
+    accountModel(model.name, model);
+    model.requested = false;
 }
 
 
 void
-GLESRenderer::renderImageTarget(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix, VuMatrix44F& scaledModelViewMatrix)
+GLESRenderer::requestTexture(const ManifestEntry& entry, bool bakeNormalMap)
 {
-    VuMatrix44F scaledModelViewProjectionMatrix = vuMatrix44FMultiplyMatrix(projectionMatrix, scaledModelViewMatrix);
-
-
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    float stateLineWidth;
-    glGetFloatv(GL_LINE_WIDTH, &stateLineWidth);
-
-    glUseProgram(mUniformColorShaderProgramID);
-
-    glVertexAttribPointer(mUniformColorVertexPositionHandle, 3, GL_FLOAT, GL_TRUE, 0, (const GLvoid*)&squareVertices[0]);
-
-    glEnableVertexAttribArray(mUniformColorVertexPositionHandle);
-
-    glUniformMatrix4fv(mUniformColorMvpMatrixHandle, 1, GL_FALSE, &scaledModelViewProjectionMatrix.data[0]);
-
-    // Draw translucent solid overlay
-    // Color RGBA
-    glUniform4f(mUniformColorColorHandle, 1.0, 0.0, 0.0, 0.1);
-    glDrawElements(GL_TRIANGLES, NUM_SQUARE_INDEX, GL_UNSIGNED_SHORT, (const GLvoid*)&squareIndices[0]);
-
-    // Draw solid outline
-    glUniform4f(mUniformColorColorHandle, 1.0, 0.0, 0.0, 1.0);
-    glLineWidth(4.0f);
-    glDrawElements(GL_LINES, NUM_SQUARE_WIREFRAME_INDEX, GL_UNSIGNED_SHORT, (const GLvoid*)&squareWireframeIndices[0]);
-
-    glDisableVertexAttribArray(mUniformColorVertexPositionHandle);
-
-    GLESUtils::checkGlError("Render Image Target");
+    if (!ImageDecoder::isAvailable())
+    {
+        if (bakeNormalMap)
+        {
+            LOG("Cannot bake normal map %s without the native image decoder", entry.normalMapName);
+        }
+        requestPlatformTexture(entry, false);
+        return;
+    }
 
-    glLineWidth(stateLineWidth);
+    unsigned int generation = mLoadGeneration;
+    AAssetManager* assetManager = mAssetManager;
+    mLoaderPool->submit([this, assetManager, entry = &entry, generation, bakeNormalMap]() {
+        waitForCpuBudget(entry->textureName);
+        LoadedTexture loaded{ entry, generation, entry->textureName, {}, 0.0f, false };
+        DecodedImage& image = loaded.image;
+
+        // Textures decoded at the layer size or with a baked normal map are variants of their own
+        std::string variant = entry->textureArray ? "rgba layer " + std::to_string(ARTWORK_LAYER_SIZE) : RGBA_VARIANT;
+        uint64_t normalMapKey = 0;
+        if (bakeNormalMap && computeAssetKey(assetManager, entry->normalMapName, getLumaVariant(entry->normalMapDownscale), normalMapKey))
+        {
+            variant += " baked " + std::to_string(normalMapKey);
+        }
+        uint64_t key = 0;
+        bool cacheable = computeAssetKey(assetManager, entry->textureName, variant, key);
+        if (cacheable && loadCachedImage(mAssetCache, key, image, loaded.meanLuma))
+        {
+            mMemoryAccounting.set(entry->textureName, MemoryAccounting::Category::TEXTURE, MemoryAccounting::Pool::PENDING,
+                                  image.pixels.size());
+            std::lock_guard<std::mutex> lock(mLoadedAssetsMutex);
+            mLoadedTextures.push_back(std::move(loaded));
+            return;
+        }
 
-    glDisable(GL_BLEND);
-    glDisable(GL_DEPTH_TEST);
+        bool decoded = entry->textureArray ? ImageDecoder::decodeToSize(assetManager, entry->textureName, image, ARTWORK_LAYER_SIZE,
+                                                                        ARTWORK_LAYER_SIZE)
+                                           : ImageDecoder::decode(assetManager, entry->textureName, image);
+        if (!decoded)
+        {
+            return;
+        }
+        loaded.meanLuma = PseudoNormalBaker::computeMeanLuma(image.pixels.data(), image.pixels.size() / 4);
 
-    VuVector3F axis2cmSize{ 0.02f, 0.02f, 0.02f };
-    renderAxis(projectionMatrix, modelViewMatrix, axis2cmSize, 4.0f);
+        DecodedImage normalMap;
+        if (bakeNormalMap && ImageDecoder::decode(assetManager, entry->normalMapName, normalMap, entry->normalMapDownscale))
+        {
+            // The luma is written over the start of the normal map pixels, it is not needed afterwards
+            size_t normalPixelCount = static_cast<size_t>(normalMap.width) * normalMap.height;
+            PseudoNormalBaker::computeLuma(normalMap.pixels.data(), normalPixelCount, normalMap.pixels.data());
+            PseudoNormalBaker::bake(image.pixels.data(), image.width, image.height, normalMap.pixels.data(), normalMap.width,
+                                    normalMap.height);
+        }
+        if (cacheable)
+        {
+            storeCachedImage(mAssetCache, key, image, loaded.meanLuma);
+        }
 
-    VuMatrix44F modelViewProjectionMatrix = vuMatrix44FMultiplyMatrix(projectionMatrix, modelViewMatrix);
-    renderModel(modelViewProjectionMatrix, mAstronautVertexCount, mAstronautVertices.data(), mAstronautTexCoords.data(),
-                mAstronautTextureUnit);
+        mMemoryAccounting.set(entry->textureName, MemoryAccounting::Category::TEXTURE, MemoryAccounting::Pool::PENDING,
+                              image.pixels.size());
+        std::lock_guard<std::mutex> lock(mLoadedAssetsMutex);
+        mLoadedTextures.push_back(std::move(loaded));
+    });
 }
 
 
 void
-GLESRenderer::renderModelTarget(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix, VuMatrix44F& /*scaledModelViewMatrix*/)
+GLESRenderer::requestNormalMap(const ManifestEntry& entry)
 {
-    VuMatrix44F modelViewProjectionMatrix = vuMatrix44FMultiplyMatrix(projectionMatrix, modelViewMatrix);
+    if (!ImageDecoder::isAvailable())
+    {
+        // The platform answers with setTexture, the luma is computed there
+        requestPlatformTexture(entry, true);
+        return;
+    }
+
+    unsigned int generation = mLoadGeneration;
+    AAssetManager* assetManager = mAssetManager;
+    mLoaderPool->submit([this, assetManager, entry = &entry, generation]() {
+        waitForCpuBudget(entry->normalMapName);
+        LoadedTexture loaded{ entry, generation, entry->normalMapName, {}, 0.0f, true };
+        DecodedImage& image = loaded.image;
+        uint64_t key = 0;
+        bool cacheable = computeAssetKey(assetManager, entry->normalMapName, getLumaVariant(entry->normalMapDownscale), key);
+        if (!cacheable || !loadCachedImage(mAssetCache, key, image, loaded.meanLuma))
+        {
+            if (!ImageDecoder::decode(assetManager, entry->normalMapName, image, entry->normalMapDownscale))
+            {
+                return;
+            }
 
-    renderModel(modelViewProjectionMatrix, mLanderVertexCount, mLanderVertices.data(), mLanderTexCoords.data(), mLanderTextureUnit);
+            // Only the luma is kept, a quarter of the decoded size
+            size_t pixelCount = static_cast<size_t>(image.width) * image.height;
+            loaded.meanLuma = PseudoNormalBaker::computeLuma(image.pixels.data(), pixelCount, image.pixels.data());
+            image.pixels.resize(pixelCount);
+            image.pixels.shrink_to_fit();
+            if (cacheable)
+            {
+                storeCachedImage(mAssetCache, key, image, loaded.meanLuma);
+            }
+        }
 
-    VuVector3F axis10cmSize{ 0.1f, 0.1f, 0.1f };
-    renderAxis(projectionMatrix, modelViewMatrix, axis10cmSize, 4.0f);
+        mMemoryAccounting.set(entry->normalMapName, MemoryAccounting::Category::TEXTURE, MemoryAccounting::Pool::PENDING,
+                              image.pixels.size());
+        std::lock_guard<std::mutex> lock(mLoadedAssetsMutex);
+        mLoadedTextures.push_back(std::move(loaded));
+    });
 }
 
 
 void
-GLESRenderer::renderModelTargetGuideView(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix, const VuImageInfo& image,
-                                         VuBool guideViewImageHasChanged)
+GLESRenderer::requestPlatformTexture(const ManifestEntry& entry, bool normalMap)
 {
-    VuMatrix44F modelViewProjectionMatrix = vuMatrix44FMultiplyMatrix(projectionMatrix, modelViewMatrix);
-
-
-    glDisable(GL_DEPTH_TEST);
-
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    glActiveTexture(GL_TEXTURE0);
-
-    // The guide view image is updated if the device orientation changes.
-    // This is indicated by the guideViewImageHasChanged flag. In that case,
-    // recreate the texture with the latest content of the image.
-    if (mModelTargetGuideViewTextureUnit == -1 || guideViewImageHasChanged == VU_TRUE)
+    const char* name = normalMap ? entry.normalMapName : entry.textureName;
+    if (!mAssetCache.isEnabled() || entry.remote)
     {
-        // Free the previous texture
-        if (mModelTargetGuideViewTextureUnit != -1)
+        if (mTextureRequestCallback)
         {
-            GLESUtils::destroyTexture(mModelTargetGuideViewTextureUnit);
+            mTextureRequestCallback(name);
         }
-
-        mModelTargetGuideViewTextureUnit = GLESUtils::createTexture(image);
+        return;
     }
-    glBindTexture(GL_TEXTURE_2D, mModelTargetGuideViewTextureUnit);
 
-    glEnableVertexAttribArray(mTextureUniformColorVertexPositionHandle);
-    glVertexAttribPointer(mTextureUniformColorVertexPositionHandle, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)&squareVertices[0]);
-
-    glEnableVertexAttribArray(mTextureUniformColorTextureCoordHandle);
-    glVertexAttribPointer(mTextureUniformColorTextureCoordHandle, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)&squareTexCoords[0]);
-
-    glUseProgram(mTextureUniformColorShaderProgramID);
-    glUniformMatrix4fv(mTextureUniformColorMvpMatrixHandle, 1, GL_FALSE, (GLfloat*)modelViewProjectionMatrix.data);
-    glUniform4f(mTextureUniformColorColorHandle, 1.0f, 1.0f, 1.0f, 0.7f);
-    glUniform1i(mTextureUniformColorTexSampler2DHandle, 0); // texture unit, not handle
+    // The source asset is hashed for the key, which is left to the loader threads
+    unsigned int generation = mLoadGeneration;
+    AAssetManager* assetManager = mAssetManager;
+    mLoaderPool->submit([this, assetManager, entry = &entry, name, normalMap, generation]() {
+        LoadedTexture loaded{ entry, generation, name, {}, 0.0f, normalMap };
+        uint64_t key = 0;
+        if (computeAssetKey(assetManager, name, normalMap ? getLumaVariant(1) : RGBA_VARIANT, key) &&
+            loadCachedImage(mAssetCache, key, loaded.image, loaded.meanLuma))
+        {
+            mMemoryAccounting.set(name, MemoryAccounting::Category::TEXTURE, MemoryAccounting::Pool::PENDING, loaded.image.pixels.size());
+            std::lock_guard<std::mutex> lock(mLoadedAssetsMutex);
+            mLoadedTextures.push_back(std::move(loaded));
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mLoadedAssetsMutex);
+        mPlatformTextureRequests.push_back(name);
+    });
+}
 
-    // Draw
-    glDrawElements(GL_TRIANGLES, NUM_SQUARE_INDEX, GL_UNSIGNED_SHORT, (const GLvoid*)&squareIndices[0]);
 
-    // disable input data structures
-    glDisableVertexAttribArray(mTextureUniformColorTextureCoordHandle);
-    glDisableVertexAttribArray(mTextureUniformColorVertexPositionHandle);
-    glUseProgram(0);
+void
+GLESRenderer::cachePlatformTexture(const ManifestEntry& entry, bool normalMap, int width, int height,
+                                   const std::vector<unsigned char>& pixels, float meanLuma)
+{
+    // Remote images are keyed by the downloaded file, which the platform kept
+    if (!mAssetCache.isEnabled() || entry.remote)
+    {
+        return;
+    }
+    const char* name = normalMap ? entry.normalMapName : entry.textureName;
+    AAssetManager* assetManager = mAssetManager;
+    DecodedImage image{ width, height, pixels };
+    mLoaderPool->submit([this, assetManager, name, normalMap, image = std::move(image), meanLuma]() {
+        uint64_t key = 0;
+        if (computeAssetKey(assetManager, name, normalMap ? getLumaVariant(1) : RGBA_VARIANT, key))
+        {
+            storeCachedImage(mAssetCache, key, image, meanLuma);
+        }
+    });
+}
 
-    glBindTexture(GL_TEXTURE_2D, 0);
 
-    GLESUtils::checkGlError("Render guide view");
+bool
+GLESRenderer::loadCachedImage(AssetCache& assetCache, uint64_t key, DecodedImage& image, float& meanLuma)
+{
+    AssetCache::Blob blob;
+    CachedImageHeader header;
+    if (!assetCache.load(key, blob) || blob.size() < sizeof(header))
+    {
+        return false;
+    }
+    memcpy(&header, blob.data(), sizeof(header));
+    size_t pixelBytes = static_cast<size_t>(header.width) * header.height * header.bytesPerPixel;
+    if (blob.size() - sizeof(header) != pixelBytes)
+    {
+        return false;
+    }
 
-    glDisable(GL_BLEND);
-    glEnable(GL_DEPTH_TEST);
+    // The uploader takes the pixels over, the blob is unmapped right after
+    image.width = static_cast<int>(header.width);
+    image.height = static_cast<int>(header.height);
+    image.pixels.assign(blob.data() + sizeof(header), blob.data() + blob.size());
+    meanLuma = header.meanLuma;
+    return true;
 }
 
 
 void
-GLESRenderer::createTexture(int width, int height, unsigned char* bytes, GLuint& textureId)
+GLESRenderer::storeCachedImage(AssetCache& assetCache, uint64_t key, const DecodedImage& image, float meanLuma)
 {
-    if (textureId != -1)
+    size_t pixelCount = static_cast<size_t>(image.width) * image.height;
+    if (pixelCount == 0 || !assetCache.isEnabled())
     {
-        GLESUtils::destroyTexture(textureId);
-        textureId = -1;
+        return;
     }
-    textureId = GLESUtils::createTexture(width, height, bytes);
+    CachedImageHeader header{ static_cast<uint32_t>(image.width), static_cast<uint32_t>(image.height),
+                              static_cast<uint32_t>(image.pixels.size() / pixelCount), meanLuma };
+    assetCache.store(key, { { &header, sizeof(header) }, { image.pixels.data(), image.pixels.size() } });
 }
 
 
 void
-GLESRenderer::renderCube(const VuMatrix44F& projectionMatrix, const VuMatrix44F& modelViewMatrix, float scale, const VuVector4F& color)
+GLESRenderer::requestModel(AAssetManager* assetManager, const char* name, Model& model, bool quantize)
 {
-    VuMatrix44F scaledModelViewMatrix;
-    VuMatrix44F modelViewProjectionMatrix;
-    VuVector3F scaleVec{ scale, scale, scale };
-
-    scaledModelViewMatrix = vuMatrix44FScale(scaleVec, modelViewMatrix);
-    modelViewProjectionMatrix = vuMatrix44FMultiplyMatrix(projectionMatrix, scaledModelViewMatrix);
-
-    ///////////////////////////////////////////////////////////////
-    // Render with const ambient diffuse light uniform color shader
-    glEnable(GL_DEPTH_TEST);
-    glUseProgram(mUniformColorShaderProgramID);
-
-    glEnableVertexAttribArray(mUniformColorVertexPositionHandle);
-
-    glVertexAttribPointer(mUniformColorVertexPositionHandle, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)&cubeVertices[0]);
-
-    glUniformMatrix4fv(mUniformColorMvpMatrixHandle, 1, GL_FALSE, (GLfloat*)modelViewProjectionMatrix.data);
-    glUniform4f(mUniformColorColorHandle, color.data[0], color.data[1], color.data[2], color.data[3]);
-
-    // Draw
-    glDrawElements(GL_TRIANGLES, NUM_CUBE_INDEX, GL_UNSIGNED_SHORT, (const GLvoid*)&cubeIndices[0]);
-
-    // disable input data structures
-    glDisableVertexAttribArray(mUniformColorVertexPositionHandle);
-    glUseProgram(0);
-    glDisable(GL_DEPTH_TEST);
-
-    GLESUtils::checkGlError("Render cube");
-    ///////////////////////////////////////////////////////
+    releaseModel(model);
+    accountModel(model.name, model);
+    model.quantize = quantize;
+
+    unsigned int generation = mLoadGeneration;
+    std::string modelName(name);
+    mLoaderPool->submit([this, assetManager, modelName, destination = &model, generation, quantize]() {
+        waitForCpuBudget(modelName.c_str());
+        LoadedModel loaded{ destination, generation, GEOMETRY_FULL, {} };
+        loaded.model.quantize = quantize;
+        if (!loadModel(assetManager, mAssetCache, modelName.c_str(), loaded.model))
+        {
+            LOG("Error loading model %s", modelName.c_str());
+            return;
+        }
+        accountModel(modelName.c_str(), loaded.model);
+        std::lock_guard<std::mutex> lock(mLoadedAssetsMutex);
+        mLoadedModels.push_back(std::move(loaded));
+    });
 }
 
 
 void
-GLESRenderer::renderAxis(const VuMatrix44F& projectionMatrix, const VuMatrix44F& modelViewMatrix, const VuVector3F& scale, float lineWidth)
+GLESRenderer::accountModel(const char* name, const Model& model)
 {
-    VuMatrix44F scaledModelViewMatrix;
-    VuMatrix44F modelViewProjectionMatrix;
-
-    scaledModelViewMatrix = vuMatrix44FScale(scale, modelViewMatrix);
-    modelViewProjectionMatrix = vuMatrix44FMultiplyMatrix(projectionMatrix, scaledModelViewMatrix);
-
-    ///////////////////////////////////////////////////////
-    // Render with vertex color shader
-    glEnable(GL_DEPTH_TEST);
-    glUseProgram(mVertexColorShaderProgramID);
-
-    glEnableVertexAttribArray(mVertexColorVertexPositionHandle);
-    glVertexAttribPointer(mVertexColorVertexPositionHandle, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)&axisVertices[0]);
-
-    glEnableVertexAttribArray(mVertexColorColorHandle);
-    glVertexAttribPointer(mVertexColorColorHandle, 4, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)&axisColors[0]);
-
-    glUniformMatrix4fv(mVertexColorMvpMatrixHandle, 1, GL_FALSE, (GLfloat*)modelViewProjectionMatrix.data);
-
-    // Draw
-    float stateLineWidth;
-    glGetFloatv(GL_LINE_WIDTH, &stateLineWidth);
-
-    glLineWidth(lineWidth);
-
-    glDrawElements(GL_LINES, NUM_AXIS_INDEX, GL_UNSIGNED_SHORT, (const GLvoid*)&axisIndices[0]);
-
-    // disable input data structures
-    glDisableVertexAttribArray(mVertexColorVertexPositionHandle);
-    glDisableVertexAttribArray(mVertexColorColorHandle);
-    glUseProgram(0);
-    glDisable(GL_DEPTH_TEST);
-
-    glLineWidth(stateLineWidth);
-
-    GLESUtils::checkGlError("Render axis");
-    ///////////////////////////////////////////////////////
+    if (name == nullptr)
+    {
+        return;
+    }
+    // The mapped or buffered binary mesh asset counts as CPU memory, the driver holds its own copy of the buffers
+    mMemoryAccounting.set(name, MemoryAccounting::Category::MESH, MemoryAccounting::Pool::CPU,
+                          getSizeBytes(model.data) + model.asset.size() + model.download.capacity() + model.cached.size());
+    mMemoryAccounting.set(name, MemoryAccounting::Category::MESH, MemoryAccounting::Pool::PENDING,
+                          model.vertices.capacity() * sizeof(float));
+    mMemoryAccounting.set(name, MemoryAccounting::Category::MESH, MemoryAccounting::Pool::GPU, model.gpuMesh.getSizeBytes());
 }
 
 
 void
-GLESRenderer::renderModel(VuMatrix44F modelViewProjectionMatrix, const int numVertices, const float* vertices,
-                          const float* textureCoordinates, GLuint textureId)
+GLESRenderer::waitForCpuBudget(const char* name)
 {
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
-    glFrontFace(GL_CCW);
-
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    glUseProgram(mTextureUniformColorShaderProgramID);
-
-    glEnableVertexAttribArray(mTextureUniformColorVertexPositionHandle);
-    glVertexAttribPointer(mTextureUniformColorVertexPositionHandle, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)vertices);
-
-    glEnableVertexAttribArray(mTextureUniformColorTextureCoordHandle);
-    glVertexAttribPointer(mTextureUniformColorTextureCoordHandle, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)textureCoordinates);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureId);
-
-    glUniformMatrix4fv(mTextureUniformColorMvpMatrixHandle, 1, GL_FALSE, (GLfloat*)modelViewProjectionMatrix.data);
-    glUniform4f(mTextureUniformColorColorHandle, 1.0f, 1.0f, 1.0f, 1.0f);
-    glUniform1i(mTextureUniformColorTexSampler2DHandle, 0); // texture unit, not handle
-
-    // Draw
-    glDrawArrays(GL_TRIANGLES, 0, numVertices);
-
-    // disable input data structures
-    glDisableVertexAttribArray(mTextureUniformColorTextureCoordHandle);
-    glDisableVertexAttribArray(mTextureUniformColorVertexPositionHandle);
-    glUseProgram(0);
-
-    glBindTexture(GL_TEXTURE_2D, 0);
+    if (!mMemoryAccounting.waitForCpuBudget())
+    {
+        LOG("Loading %s over the CPU memory budget, the pending uploads did not free enough", name);
+    }
+}
 
-    GLESUtils::checkGlError("Render model");
 
-    glDisable(GL_BLEND);
-    glDisable(GL_CULL_FACE);
-    glDisable(GL_DEPTH_TEST);
+void
+GLESRenderer::releaseModel(Model& model)
+{
+    model.ready = false;
+    model.gpuMesh.destroy();
+    model.vertices.clear();
+    model.lods.clear();
+    model.mesh = MeshView();
+    model.data = MeshData();
+    model.asset.close();
+    model.download = std::vector<char>();
+    model.cached.close();
+    model.geometryLevel = -1;
 }
 
 
 bool
-GLESRenderer::readAsset(AAssetManager* assetManager, const char* filename, std::vector<char>& data)
+GLESRenderer::uploadModel(Model& model)
 {
-    LOG("Reading asset %s", filename);
-    AAsset* asset = AAssetManager_open(assetManager, filename, AASSET_MODE_STREAMING);
-    if (asset == nullptr)
-    {
-        LOG("Error opening asset file %s", filename);
-        return false;
-    }
-    auto assetSize = AAsset_getLength(asset);
-    data.reserve(assetSize);
-    char buf[BUFSIZ];
-    int nb_read = 0;
-    while ((nb_read = AAsset_read(asset, buf, BUFSIZ)) > 0)
+    const MeshView& mesh = model.mesh;
+    GLenum indexType = mesh.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    bool created = false;
+    if (mesh.quantizedVertices != nullptr)
     {
-        std::copy(&buf[0], &buf[BUFSIZ], std::back_inserter(data));
+        // Quantized vertices are uploaded as they are stored, the normalized values are mapped back
+        // to the bounding box by positionTransform and to the texture coordinate range by texCoordTransform
+        using Vertex = MeshFormat::QuantizedVertex;
+        const MeshFormat::Quantization& quantization = mesh.quantization;
+        GpuMesh::Attribute position{ GLESUtils::ATTRIBUTE_POSITION, 3, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(Vertex, position) };
+        GpuMesh::Attribute texCoord{ GLESUtils::ATTRIBUTE_TEXTURE_COORD, 2, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(Vertex, texCoord) };
+        GpuMesh::Attribute shade{ GLESUtils::ATTRIBUTE_SHADE, 1, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Vertex, shade) };
+        GLsizeiptr vertexBytes = static_cast<GLsizeiptr>(mesh.vertexCount * sizeof(Vertex));
+        created = mesh.shaded ? model.gpuMesh.create(mesh.quantizedVertices, vertexBytes, sizeof(Vertex), { position, texCoord, shade },
+                                                     mesh.indices, mesh.indexCount, indexType)
+                              : model.gpuMesh.create(mesh.quantizedVertices, vertexBytes, sizeof(Vertex), { position, texCoord },
+                                                     mesh.indices, mesh.indexCount, indexType);
+
+        VuVector3F positionMin{ quantization.positionMin[0], quantization.positionMin[1], quantization.positionMin[2] };
+        VuVector3F positionScale{ quantization.positionScale[0], quantization.positionScale[1], quantization.positionScale[2] };
+        model.positionTransform = MatrixMath::scale(positionScale, MatrixMath::translation(positionMin));
+        model.texCoordTransform = VuVector4F{ quantization.texCoordScale[0], quantization.texCoordScale[1], quantization.texCoordMin[0],
+                                              quantization.texCoordMin[1] };
     }
-    AAsset_close(asset);
-    if (nb_read < 0)
+    else
     {
-        LOG("Error reading asset file %s", filename);
-        return false;
+        GpuMesh::Attribute position{ GLESUtils::ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, 0 };
+        GpuMesh::Attribute texCoord{ GLESUtils::ATTRIBUTE_TEXTURE_COORD, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float) };
+        GpuMesh::Attribute shade{ GLESUtils::ATTRIBUTE_SHADE, 1, GL_FLOAT, GL_FALSE, 5 * sizeof(float) };
+        GLsizeiptr vertexBytes = static_cast<GLsizeiptr>(model.vertices.size() * sizeof(float));
+        GLsizei stride = static_cast<GLsizei>(MeshLoader::getInterleavedStride(mesh) * sizeof(float));
+        created = mesh.shaded ? model.gpuMesh.create(model.vertices.data(), vertexBytes, stride, { position, texCoord, shade }, mesh.indices,
+                                                     mesh.indexCount, indexType)
+                              : model.gpuMesh.create(model.vertices.data(), vertexBytes, stride, { position, texCoord }, mesh.indices,
+                                                     mesh.indexCount, indexType);
+
+        model.positionTransform = MatrixMath::identity();
+        model.texCoordTransform = VuVector4F{ 1.0f, 1.0f, 0.0f, 0.0f };
     }
-    return true;
+
+    model.lods.assign(mesh.lods, mesh.lods + mesh.lodCount);
+    model.bounds = mesh.bounds;
+    model.shaded = mesh.shaded;
+    model.currentLod = 0;
+
+    // The driver has its own copy now
+    std::vector<float>().swap(model.vertices);
+    return created;
 }
 
 
 bool
-GLESRenderer::loadObjModel(const std::vector<char>& data, int& numVertices, std::vector<float>& vertices, std::vector<float>& texCoords)
+GLESRenderer::uploadVideoBackgroundMesh(const VuMesh& mesh)
 {
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-
-    std::string warn;
-    std::string err;
-
-    MemoryInputStream aFileDataStream(data.data(), data.size());
-    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &aFileDataStream);
-    if (!ret || !err.empty())
+    if (mesh.pos == nullptr || mesh.tex == nullptr || mesh.numVertices <= 0)
     {
-        LOG("Error loading model (%s)", err.c_str());
+        LOG("Error: Video background mesh without vertices");
         return false;
     }
-    if (!warn.empty())
+
+    // Interleaved position and texture coordinate
+    std::vector<float> vertices;
+    vertices.reserve(static_cast<size_t>(mesh.numVertices) * 5);
+    for (int i = 0; i < mesh.numVertices; ++i)
     {
-        LOG("Warning loading model (%s)", warn.c_str());
+        vertices.insert(vertices.end(), &mesh.pos[i * 3], &mesh.pos[i * 3 + 3]);
+        vertices.insert(vertices.end(), &mesh.tex[i * 2], &mesh.tex[i * 2 + 2]);
     }
 
-    numVertices = 0;
-    vertices.clear();
-    texCoords.clear();
-    // Loop over shapes
-    // s is the index into the shapes vector
-    // f is the index of the current face
-    // v is the index of the current vertex
-    for (size_t s = 0; s < shapes.size(); ++s)
+    // The mesh is a small grid, 16 bit indices are enough for it
+    GLsizei indexCount = mesh.numFaces * 3;
+    std::vector<unsigned short> shortIndices;
+    const void* indices = mesh.faceIndices;
+    GLenum indexType = GL_UNSIGNED_INT;
+    if (mesh.numVertices <= 0xFFFF)
     {
-        // Loop over faces(polygon)
-        size_t index_offset = 0;
-        for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); ++f)
-        {
-            int fv = shapes[s].mesh.num_face_vertices[f];
-            numVertices += fv;
+        shortIndices.assign(mesh.faceIndices, mesh.faceIndices + indexCount);
+        indices = shortIndices.data();
+        indexType = GL_UNSIGNED_SHORT;
+    }
 
-            // Loop over vertices in the face.
-            for (size_t v = 0; v < fv; ++v)
-            {
-                // access to vertex
-                tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
+    LOG("Uploading video background mesh with %d vertices", mesh.numVertices);
+    return mVideoBackgroundMesh.create(vertices.data(), static_cast<GLsizeiptr>(vertices.size() * sizeof(float)), 5 * sizeof(float),
+                                       {
+                                           { GLESUtils::ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, 0 },
+                                           { GLESUtils::ATTRIBUTE_TEXTURE_COORD, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float) },
+                                       },
+                                       indices, indexCount, indexType);
+}
 
-                vertices.push_back(attrib.vertices[3 * idx.vertex_index + 0]);
-                vertices.push_back(attrib.vertices[3 * idx.vertex_index + 1]);
-                vertices.push_back(attrib.vertices[3 * idx.vertex_index + 2]);
 
-                // The model may not have texture coordinates for every vertex
-                // If a texture coordinate is missing we just set it to 0,0
-                // This may not be suitable for rendering some OBJ model files
-                if (idx.texcoord_index < 0)
-                {
-                    texCoords.push_back(0.f);
-                    texCoords.push_back(0.f);
-                }
-                else
-                {
-                    texCoords.push_back(attrib.texcoords[2 * idx.texcoord_index + 0]);
-                    texCoords.push_back(attrib.texcoords[2 * idx.texcoord_index + 1]);
-                }
-            }
-            index_offset += fv;
-        }
+void
+GLESRenderer::createShapeMeshes()
+{
+    // Square: interleaved position and texture coordinate, triangle indices followed by wireframe indices
+    std::vector<float> squareData;
+    squareData.reserve(NUM_SQUARE_VERTEX * 5);
+    for (int i = 0; i < NUM_SQUARE_VERTEX; ++i)
+    {
+        squareData.insert(squareData.end(), &squareVertices[i * 3], &squareVertices[i * 3 + 3]);
+        squareData.insert(squareData.end(), &squareTexCoords[i * 2], &squareTexCoords[i * 2 + 2]);
     }
-    return true;
+    std::vector<unsigned short> squareIndexData(std::begin(squareIndices), std::end(squareIndices));
+    squareIndexData.insert(squareIndexData.end(), std::begin(squareWireframeIndices), std::end(squareWireframeIndices));
+    mSquareMesh.create(squareData.data(), static_cast<GLsizeiptr>(squareData.size() * sizeof(float)), 5 * sizeof(float),
+                       {
+                           { GLESUtils::ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, 0 },
+                           { GLESUtils::ATTRIBUTE_TEXTURE_COORD, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float) },
+                       },
+                       squareIndexData.data(), static_cast<GLsizei>(squareIndexData.size()), GL_UNSIGNED_SHORT);
+
+    // Cube: position only
+    mCubeMesh.create(cubeVertices, sizeof(cubeVertices), 3 * sizeof(float),
+                     {
+                         { GLESUtils::ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, 0 },
+                     },
+                     cubeIndices, NUM_CUBE_INDEX, GL_UNSIGNED_SHORT);
+
+    // Axis: interleaved position and color
+    std::vector<float> axisData;
+    axisData.reserve(NUM_AXIS_VERTEX * 7);
+    for (int i = 0; i < NUM_AXIS_VERTEX; ++i)
+    {
+        axisData.insert(axisData.end(), &axisVertices[i * 3], &axisVertices[i * 3 + 3]);
+        axisData.insert(axisData.end(), &axisColors[i * 4], &axisColors[i * 4 + 4]);
+    }
+    mAxisMesh.create(axisData.data(), static_cast<GLsizeiptr>(axisData.size() * sizeof(float)), 7 * sizeof(float),
+                     {
+                         { GLESUtils::ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, 0 },
+                         { GLESUtils::ATTRIBUTE_COLOR, 4, GL_FLOAT, GL_FALSE, 3 * sizeof(float) },
+                     },
+                     axisIndices, NUM_AXIS_INDEX, GL_UNSIGNED_SHORT);
 }
@@ -13,12 +13,41 @@ countries.
 #include <GLES2/gl2ext.h>
 // clang-format on
 
+#include "AssetCache.h"
+#include "AssetView.h"
+#include "DynamicTexture.h"
+#include "GLESUtils.h"
+#include "GLStateCache.h"
+#include "GpuMesh.h"
+#include "GpuProfiler.h"
+#include "GpuTimer.h"
+#include "ImageDecoder.h"
+#include "RenderTarget.h"
+#include "TextureArray.h"
+#include "TextureCache.h"
+#include "TextureUploader.h"
+#include "UniformRing.h"
+
 #include <android/asset_manager.h>
 
-#include <tiny_obj_loader.h>
+#include <ContentManifest.h>
+#include <DynamicResolution.h>
+#include <FrameArena.h>
+#include <FramePacket.h>
+#include <MemoryAccounting.h>
+#include <MeshLoader.h>
+#include <Profiler.h>
+#include <WorkerPool.h>
 
 #include <VuforiaEngine/VuforiaEngine.h>
 
+#include <atomic>
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 
@@ -26,37 +55,418 @@ countries.
 class GLESRenderer
 {
 public:
+    /// Called on the rendering thread to ask the platform for a texture, the platform answers with setTexture
+    /// Only used on devices where the texture cannot be decoded in native code, see ImageDecoder.
+    using TextureRequestCallback = std::function<void(const char* textureName)>;
+
+    /// Called on the rendering thread to download a file of a remote artwork, see ContentManifest
+    /// The platform answers with setContent, or with setTexture for images it is asked to decode.
+    using ContentRequestCallback = std::function<void(const char* url, bool decodeImage)>;
+
     /// Initialize the renderer ready for use
-    bool init(AAssetManager* assetManager);
+    /*
+     * No assets are loaded yet, the assets a target needs according to the content manifest are
+     * requested when the target is rendered for the first time, or ahead of that by prefetchAssets.
+     * Models and textures are loaded asynchronously on worker threads and appear once
+     * processLoadedAssets has handed them over. The manifest is read from CONTENT_MANIFEST_ASSET
+     * unless one was set with setContentManifest before.
+     */
+    bool init(AAssetManager* assetManager, TextureRequestCallback textureRequestCallback,
+              ContentRequestCallback contentRequestCallback = nullptr);
     /// Clean up objects created during rendering
     void deinit();
 
-    void setAstronautTexture(int width, int height, unsigned char* bytes);
-    void setPlaneTexture(int width, int height, unsigned char* bytes);
-    void setLanderTexture(int width, int height, unsigned char* bytes);
+    /// Replace the content manifest, e.g. with one downloaded from a content service
+    /// The assets of the previous manifest are evicted and those of the new one requested as the targets are rendered.
+    /// Returns false and keeps the previous manifest if the text cannot be parsed. Call on the rendering thread.
+    bool setContentManifest(const char* text, size_t size);
+
+    /// Hand over a file downloaded for the ContentRequestCallback, an empty buffer if the download failed
+    /// Decoded on the loader threads, files that are no longer needed by the time they arrive are ignored.
+    /// Call on the rendering thread.
+    void setContent(const char* url, std::vector<char> data);
+
+    /// Set the target the app observes, the assets of every other target are evicted
+    /// For the gallery the assets its targets are bound to in GALLERY_TARGETS are kept.
+    void setActiveTarget(int target);
+
+    /// Request the assets of a target ahead of its first detection, e.g. while the engine is still starting
+    void prefetchAssets(int target);
+
+    /// True once the models and textures of a target are ready to draw
+    bool areAssetsReady(int target) const;
+
+    /// Start rendering a frame, call before any other rendering method of the frame
+    /// The GL state is treated as unknown from here on, as the platform and Vuforia may have changed it.
+    void beginFrame();
+
+    /// GL calls made and filtered out by the state cache in the last complete frame
+    const GLStateCache::Counters& getStateCounters() const { return mStateCache.getFrameCounters(); }
+
+    /// Set the viewport in pixels the frame is rendered to
+    /// Used to pick the level of detail of models, and restored after drawing the augmentations offscreen.
+    void setViewport(int x, int y, int width, int height);
+
+    /// Draw the augmentations at a resolution adapted to their GPU time, see DynamicResolution
+    /*
+     * The augmentations are drawn into an offscreen target at the scale picked from the GPU time
+     * of the previous frames and composited over the video background, which keeps its full resolution.
+     * Needs GL_EXT_disjoint_timer_query, without it the augmentations are drawn directly.
+     */
+    void setDynamicResolution(bool enabled, const DynamicResolution::Config& config = DynamicResolution::Config());
+
+    /// Limit the resolution scale of the dynamic resolution, the scale restarts at the limit
+    void setMaxAugmentationScale(float scale);
+
+    /// Resolution scale the augmentations were last drawn at, 1 when they are drawn directly
+    float getAugmentationScale() const { return mAugmentationScale; }
+
+    /// Time the rendering methods with a profiler, nullptr to stop timing them
+    /*
+     * The sections are timed on the GPU as well where timestamp queries are supported, see GpuProfiler.
+     * With overlay the times are drawn over the frame by renderProfilerOverlay.
+     */
+    void setProfiler(Profiler* profiler, bool overlay = false);
+
+    /// Draw the p50 and p99 times of the profiled sections as bars, call last in the frame
+    /*
+     * One row per section in the order of Profiler::getStatistics, the CPU time in the upper half of
+     * the row and the GPU time in the lower half. The full width is OVERLAY_FULL_SCALE_MILLISECONDS,
+     * a vertical line marks the budget of a 60 Hz frame.
+     */
+    void renderProfilerOverlay();
+
+    /// Hand models and textures finished by the loader threads over to rendering
+    /// Call once per frame on the rendering thread before rendering augmentations.
+    /// Textures are streamed to the GPU over the following frames, see TextureUploader.
+    void processLoadedAssets();
+
+    /// Create the texture requested through the TextureRequestCallback
+    /// Textures that are no longer needed by the time they arrive are ignored.
+    void setTexture(const char* textureName, int width, int height, unsigned char* bytes);
+
+    /// Set the GPU memory kept for model textures, see TextureCache
+    void setTextureBudget(size_t budgetBytes) { mTextureCache.setBudget(budgetBytes); }
+
+    /// Keep processed assets in a directory across launches, see AssetCache, an empty directory disables it
+    /*
+     * Models parsed from OBJ files are stored as binary meshes and mapped on later launches, decoded
+     * textures and normal map lumas are stored as pixels, also those the platform decoded for setTexture.
+     * The blobs are keyed by a hash of their source asset or download, so changed sources are processed again.
+     */
+    void setAssetCacheDirectory(const std::string& directory) { mAssetCache.setDirectory(directory, ASSET_CACHE_VERSION); }
+
+    /// Set the disk space kept for processed assets, least recently used ones are deleted beyond it
+    void setAssetCacheBudget(size_t budgetBytes) { mAssetCache.setBudget(budgetBytes); }
+
+    /// CPU and GPU memory held by the models, textures, guide view and offscreen target
+    /// The loader threads keep to its CPU budget, see MemoryAccounting.
+    MemoryAccounting& getMemoryAccounting() { return mMemoryAccounting; }
+
+    /// Free the CPU geometry of a model once it is in GPU buffers
+    /*
+     * Drawing only needs the buffers, and a model whose buffers went with a lost GL context is loaded
+     * again from its assets anyway. Without it the parsed or mapped mesh is kept while the model is loaded.
+     */
+    void setReleaseMeshCopies(bool release) { mReleaseMeshCopies = release; }
+
+    /// Number of model draws skipped since init because the model was outside the view frustum
+    /// Callable from any thread, logged with the profiler statistics
+    unsigned int getCulledDrawCount() const { return mCulledDrawCount.load(std::memory_order_relaxed); }
 
     /// Render the video background
-    void renderVideoBackground(const VuMatrix44F& projectionMatrix, const float* vertices, const float* textureCoordinates,
-                               const int numTriangles, const unsigned int* indices, int textureUnit);
+    /*
+     * The mesh is kept in GPU buffers and only uploaded again when meshVersion changes, pass the render
+     * view version of the AppController.
+     */
+    void renderVideoBackground(const VuMatrix44F& projectionMatrix, const VuMesh& mesh, unsigned int meshVersion, int textureUnit);
+
+    /// Render the augmentations of everything in a frame packet
+    /*
+     * The items of the packet are expanded into a queue of draws: axes and a cube for the world origin,
+     * the bounds, axes and model of each target, and the guide view. The queue is sorted before it is drawn,
+     * opaque draws before alpha-tested and blended ones, see BlendMode. Call after renderVideoBackground.
+     * The transient data of the frame is allocated from arena, which the caller resets once the frame is finished.
+     */
+    void renderFrame(const FramePacket& packet, FrameArena& arena);
+
+private: // types
+    /// How the fragments of a material combine with what is behind them
+    /*
+     * Blending costs fill rate and keeps tile-based GPUs from discarding hidden fragments early,
+     * so it is only enabled for BLENDED materials. Every model texture without an alpha channel is OPAQUE.
+     */
+    enum class BlendMode
+    {
+        /// Blending off, drawn first
+        OPAQUE,
+        /// Blending off, fragments below half alpha are discarded, drawn after the opaque draws
+        ALPHA_TEST,
+        /// Blended with GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, drawn back to front after everything else
+        BLENDED,
+    };
+
+    /// Geometry and texture of a model loaded from the assets
+    struct Model
+    {
+        /// Base name of the model assets, the asset the memory of the model is accounted to
+        const char* name = nullptr;
+        /// Geometry used for rendering, refers either to data or to a mapped binary mesh asset
+        MeshView mesh;
+        /// Owns the geometry when the model was parsed from an OBJ file
+        MeshData data;
+        /// Keeps a binary mesh asset mapped while mesh refers to it
+        AssetView asset;
+        /// Holds a downloaded binary mesh while mesh refers to it
+        std::vector<char> download;
+        /// Keeps a binary mesh from mAssetCache mapped while mesh refers to it
+        AssetCache::Blob cached;
+        /// Interleaved vertices prepared by the loader thread, freed once uploaded
+        std::vector<float> vertices;
+        /// The geometry uploaded to GPU buffers, drawn by renderModel
+        GpuMesh gpuMesh;
+        /// Dequantization of the vertices in gpuMesh, identity for float meshes
+        VuMatrix44F positionTransform;
+        VuVector4F texCoordTransform;
+        /// Quantize the vertices when the model is parsed from an OBJ file, baked meshes carry their own layout
+        bool quantize = false;
+        /// Levels of detail within the index buffer of gpuMesh, empty for a single level
+        std::vector<MeshFormat::Lod> lods;
+        MeshFormat::Bounds bounds{};
+        /// Level drawn in the last frame, kept to apply hysteresis when switching
+        int currentLod = 0;
+        /// Refinement of the geometry held, 0 for the coarse model of a remote artwork, GEOMETRY_FULL for the model
+        /// itself and -1 without geometry. Downloads of a coarser level arriving late are dropped.
+        int geometryLevel = -1;
+        /// Texture owned by mTextureCache, textureId is the asset it was created from and is set
+        /// while the model holds a reference to it. -1 while the texture is loading or uploading.
+        GLuint textureUnit = -1;
+        const char* textureId = nullptr;
+        /// Refinement of the texture held, see getTextureName, -1 without texture
+        int textureLevel = -1;
+        /// Layer of mArtworkArray holding the texture instead, textureId is then the reference to the layer
+        int textureLayer = -1;
+        /// Luma of the normal map for pseudo normal shading, owned by mTextureCache like the texture
+        GLuint normalMapUnit = -1;
+        const char* normalMapId = nullptr;
+        /// Mean lumas of the texture and normal map in [0;1], give the brightness correction of pseudo normal shading.
+        /// Kept across evictions so that they stay known when the textures are picked up from the cache again.
+        float colorMeanLuma = 0.5f;
+        float normalMeanLuma = 0.0f;
+        /// Material of the model, taken from its ManifestEntry
+        BlendMode blendMode = BlendMode::OPAQUE;
+        /// The vertices carry a baked shade, the model is drawn with the SHADED program variants
+        bool shaded = false;
+        /// Set once the geometry has been handed over to the rendering thread
+        bool ready = false;
+        /// Set once the geometry and texture have been requested, cleared on eviction
+        bool requested = false;
+    };
+
+    /// Assets needed to render the augmentation of a target, built from an artwork of the content manifest
+    /// The names point into the ContentManifest or the URLs of the entry.
+    struct ManifestEntry
+    {
+        int target;
+        /// Model receiving the assets, shared by the entries of all manifests with the same model name
+        Model* model;
+        /// Base name of the model assets, see loadModel, the file name of remote models
+        const char* modelName;
+        /// Texture asset, a pre-compressed variant is used if present, see loadCompressedTexture
+        /// The URL of the finest texture level for remote artworks.
+        const char* textureName;
+        /// Quantize the vertices when the model is parsed from an OBJ file
+        bool quantize;
+        /// Mip mapping and anisotropic filtering of the texture
+        TextureOptions textureOptions;
+        /// Normal map for pseudo normal shading, null for plain texturing
+        const char* normalMapName;
+        /// The normal map is decoded at 1/normalMapDownscale of its size in each direction
+        int normalMapDownscale;
+        /// Pack the texture into a layer of mArtworkArray, it is decoded at the layer size
+        /// Pre-compressed variants are not used for these, and the texture must not be pseudo normal mapped.
+        bool textureArray;
+        /// Material of the model, alpha-tested models are drawn without pseudo normal shading
+        BlendMode blendMode;
+
+        /// The artwork is downloaded, see requireRemoteAssets, textureArray is never set then
+        bool remote = false;
+        /// Remote artworks only, empty if there is no coarse model
+        std::string modelUrl;
+        std::string coarseModelUrl;
+        /// Remote artworks only, the texture previews coarse to fine followed by the texture
+        std::vector<std::string> textureUrls;
+        std::string normalMapUrl;
+    };
+
+    /// A content manifest and the entries built from it
+    /// Kept until the renderer is destroyed, as loads still in flight may refer to the entries.
+    struct Content
+    {
+        ContentManifest manifest;
+        std::vector<ManifestEntry> entries;
+    };
+
+    /// A file requested through the ContentRequestCallback, keyed by its URL in mDownloads
+    /// mDownloads is cleared whenever mLoadGeneration changes, so that files arriving afterwards are ignored.
+    struct Download
+    {
+        enum class Kind
+        {
+            MODEL,
+            TEXTURE,
+            NORMAL_MAP,
+        };
+        const ManifestEntry* entry;
+        Kind kind;
+        /// Geometry or texture level the file refines the model to
+        int level;
+    };
 
-    /// Render augmentation for the world origin
-    void renderWorldOrigin(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix);
+    /// One draw of the render queue of renderFrame
+    struct DrawItem
+    {
+        /// What is drawn, each kind has its mesh
+        enum class Kind
+        {
+            AXIS,
+            CUBE,
+            TARGET_OVERLAY,
+            TARGET_OUTLINE,
+            MODEL,
+            GUIDE_VIEW,
+        };
+        Kind kind;
 
-    /// Render a bounding box augmentation on an Image Target
-    void renderImageTarget(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix, VuMatrix44F& scaledModelViewMatrix);
+        /// Program and texture the draw binds, the texture is 0 for untextured draws
+        /// Together with the mesh and depth these are the sort keys of the queue.
+        GLuint program;
+        GLuint texture;
+        /// Draws are grouped by blend mode in the order of BlendMode, blended draws back to front
+        BlendMode blendMode;
+        /// Distance of the item origin from the camera along the view direction
+        float depth;
+        /// Position in the queue when enqueued, the last sort key so that the sort is stable without a buffer
+        unsigned int sequence;
 
-    /// Render a bounding cube augmentation on a Model Target
-    void renderModelTarget(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix, VuMatrix44F& scaledModelViewMatrix);
+        /// Points into the FramePacket being rendered
+        const VuMatrix44F* projectionMatrix;
+        VuMatrix44F modelViewMatrix;
+        /// Scale of axes and cubes
+        VuVector3F scale;
+        /// Width of axes and outlines
+        float lineWidth;
+        VuVector4F color;
+        /// The model drawn by MODEL items
+        Model* model;
+    };
 
-    /// Render the Guide View for a Model Target
-    void renderModelTargetGuideView(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix, const VuImageInfo& Image,
-                                    VuBool guideViewImageHasChanged);
+    /// The FrameUniforms block of the shaders in std140 layout
+    struct FrameUniforms
+    {
+        VuMatrix44F projectionMatrix;
+    };
+
+    /// The DrawUniforms block of the shaders in std140 layout
+    struct DrawUniforms
+    {
+        /// Applied before the frame projection, the whole transform of the video background
+        VuMatrix44F modelViewMatrix;
+        VuVector4F color;
+        /// Scale in xy and offset in zw
+        VuVector4F texCoordTransform;
+        /// Pseudo normal parameters, or the texture array layer in x
+        VuVector4F params;
+    };
+
+    /// A model loaded by a worker thread, waiting to be handed over to its destination
+    struct LoadedModel
+    {
+        Model* destination;
+        unsigned int generation;
+        /// Geometry level of the model, see Model::geometryLevel
+        int level;
+        Model model;
+    };
+
+    /// A texture decoded by a worker thread, waiting to be uploaded
+    struct LoadedTexture
+    {
+        const ManifestEntry* entry;
+        unsigned int generation;
+        /// Name the texture is uploaded and cached as, the texture or normal map name of the entry or a texture level
+        const char* id;
+        DecodedImage image;
+        /// Mean luma of the image in [0;1]
+        float meanLuma;
+        /// The image is the luma of the normal map of the entry, one byte per pixel
+        bool normalMap;
+    };
 
 private: // methods
-    /// Attempt to create a texture from bytes
-    /// If the value of textureId is not -1 it is assumed that it refers to an existing texture
-    /// that should be destroyed and replaced with a new one.
-    void createTexture(int width, int height, unsigned char* bytes, GLuint& textureId);
+    /// Register a texture finished by mTextureUploader in the texture cache and hand it to the models waiting for it
+    /// The texture stays cached without references if no model needs it any more.
+    void assignUploadedTexture(const TextureUploader::Finished& finished);
+
+    /// Queue the decoded texture of a manifest entry for upload
+    /// Goes into a layer of mArtworkArray if the entry asks for it and the image has the layer size,
+    /// otherwise into a texture of its own.
+    void uploadTexture(const ManifestEntry& entry, const char* id, int width, int height, std::vector<unsigned char> pixels);
+
+    /// Entries of the current content manifest
+    const std::vector<ManifestEntry>& getManifest() const;
+
+    /// The model of a name, created on first use, models are kept for the lifetime of the renderer
+    /// A created model keeps the name pointer, it must point into a Content.
+    Model& getModel(const char* name);
+
+    /// Target id of a target name of the content manifest, -1 for unknown names
+    static int getTargetId(const std::string& name);
+
+    /// Name of a texture level of an entry, levels are only refined for remote artworks
+    static const char* getTextureName(const ManifestEntry& entry, int level);
+    /// Level of a texture name of an entry, -1 if the entry has no such texture
+    static int getTextureLevel(const ManifestEntry& entry, const std::string& id);
+
+    /// Create a program whose uniform blocks are bound to FRAME_UNIFORMS_BINDING and DRAW_UNIFORMS_BINDING
+    /// The samplers are assigned the texture units 0, 1, ... in order.
+    /// defines are inserted after the version line of both shaders, e.g. ALPHA_TEST_DEFINE_GLSL.
+    static GLuint createProgram(const char* vertexShaderSource, const char* fragmentShaderSource,
+                                std::initializer_list<const char*> samplers, const char* defines = nullptr);
+
+    /// Bind the frame uniforms for a projection, nothing is written if they are bound for it already
+    void bindFrameUniforms(const VuMatrix44F& projectionMatrix);
+
+    /// Write the uniforms of a draw into mUniformRing and bind them
+    void bindDrawUniforms(const VuMatrix44F& modelViewMatrix, const VuVector4F& color,
+                          const VuVector4F& texCoordTransform = IDENTITY_TEX_COORD_TRANSFORM, const VuVector4F& params = {});
+
+    /// Append a draw to mDrawQueue, the depth is taken from modelViewMatrix
+    /// Returns the item to fill in the parameters of its kind.
+    DrawItem& enqueue(DrawItem::Kind kind, GLuint program, GLuint texture, BlendMode blendMode, const VuMatrix44F& projectionMatrix,
+                      const VuMatrix44F& modelViewMatrix);
+
+    /// Append the axes and cube marking the world origin
+    void enqueueWorldOrigin(const VuMatrix44F& projectionMatrix, const VuMatrix44F& modelViewMatrix);
+
+    /// Append the augmentation of an observed target, requesting its assets if that has not happened yet
+    void enqueueTarget(const VuMatrix44F& projectionMatrix, const FramePacket::Target& target);
+
+    /// Append the Model Target guide view, its texture is updated from the packet first
+    void enqueueGuideView(const FramePacket& packet);
+
+    /// Bind the offscreen target for the augmentations if dynamic resolution is on
+    /// Returns false if the augmentations are to be drawn directly.
+    bool beginAugmentationPass();
+
+    /// Composite the offscreen augmentations over the video background
+    void endAugmentationPass();
+
+    /// Draw a single item of the render queue
+    void renderDrawItem(const DrawItem& item);
+
+    /// Draw a TARGET_OVERLAY, TARGET_OUTLINE or GUIDE_VIEW item, all drawn from mSquareMesh
+    void renderSquare(const DrawItem& item);
 
     /// Render a filled 3D cube
     /*
@@ -77,65 +487,290 @@ private: // methods
     void renderAxis(const VuMatrix44F& projectionMatrix, const VuMatrix44F& modelViewMatrix, const VuVector3F& scale,
                     float lineWidth = 2.0f);
 
-    /// Render a 3D model
-    void renderModel(VuMatrix44F modelViewProjectionMatrix, const int numVertices, const float* vertices, const float* textureCoordinates,
-                     GLuint textureId);
+    /// Render copies of a 3D model, one per model view matrix
+    /*
+     * Indexed meshes are drawn with glDrawElements, meshes without indices as a plain triangle list.
+     * The dequantization of quantized meshes is folded into the model view matrix.
+     * The level of detail is picked from the projected size of the model, see selectLod.
+     * Copies whose bounds are outside the view frustum are not submitted. Several visible copies share
+     * the finest level of detail any of them needs and are drawn with a single call, see submitInstanced.
+     * Only called by renderFrame, the matrices of the copies are allocated from its frame arena.
+     */
+    void renderModel(const VuMatrix44F& projectionMatrix, const VuMatrix44F* modelViewMatrices, size_t count, Model& model);
+
+    /// Draw copies of a mesh with the bound program, one per model view matrix
+    /*
+     * The matrices are streamed into mInstanceBuffer, orphaning the storage of the previous submission,
+     * and fed to the instanceModelViewMatrix attribute; the draw uniforms hold what the copies share.
+     * count and firstIndex select a range of the index buffer, a count of 0 draws the whole mesh.
+     */
+    void submitInstanced(const GpuMesh& mesh, GLenum mode, const VuMatrix44F* modelViewMatrices, size_t instanceCount, GLsizei count = 0,
+                         GLsizei firstIndex = 0);
+
+    /// Program and texture renderModel binds for a model
+    /// The texture is a texture array if the model is textured from mArtworkArray.
+    GLuint getModelProgram(const Model& model) const;
+    GLuint getModelTexture(const Model& model) const;
+
+    /// Check whether a bounding box intersects the view frustum of a model view projection matrix
+    /*
+     * The frustum planes are taken from the rows of the matrix, the box is outside when the corner
+     * farthest along the normal of any plane is behind that plane. A box intersecting the frustum
+     * corners may be reported visible even though it is not, which only costs a draw.
+     */
+    static bool isInFrustum(const VuMatrix44F& modelViewProjectionMatrix, const MeshFormat::Bounds& bounds);
+
+    /// Pick the coarsest level of detail whose error stays below LOD_ERROR_PIXELS on screen
+    /*
+     * A coarser level is only picked once its error fell clearly below the threshold,
+     * so that a model hovering around a switching distance does not flicker between levels.
+     */
+    int selectLod(Model& model, const VuMatrix44F& modelViewProjectionMatrix) const;
+
+    /// Upload the static shapes from Models.h into GPU buffers
+    void createShapeMeshes();
 
-    /// Read an asset file into a byte vector
-    bool readAsset(AAssetManager* assetManager, const char* filename, std::vector<char>& data);
+    /// Upload the video background mesh of the render state into mVideoBackgroundMesh
+    bool uploadVideoBackgroundMesh(const VuMesh& mesh);
 
-    /// Load a model from an OBJ file
+    /// Load the geometry of a model
     /*
-     * The model is input as the data array, the vertex and texture coordinate
-     * vectors are populated by this method as it reads the input.
+     * The pre-baked binary mesh <name>.mesh is mapped if it is present in the assets,
+     * otherwise the model is parsed from <name>.obj, or its binary mesh is mapped from the asset cache
+     * if it was parsed on an earlier launch.
      */
-    bool loadObjModel(const std::vector<char>& data, int& numVertices, std::vector<float>& vertices, std::vector<float>& texCoords);
+    /// This method is safe to call from any thread.
+    static bool loadModel(AAssetManager* assetManager, AssetCache& assetCache, const char* name, Model& model);
+
+    /// Create a texture from a pre-compressed variant of a texture asset
+    /*
+     * The variants <base name>.astc.ktx and <base name>.etc2.ktx are written by Tools/TextureCompressor,
+     * the first one whose format the GPU supports is used. Returns false if there is no usable variant,
+     * the texture is then requested uncompressed through the TextureRequestCallback.
+     */
+    bool loadCompressedTexture(const char* textureName, const TextureOptions& options, Model& model);
+
+    /// Decode the texture of a manifest entry on the loader threads
+    /*
+     * Falls back to the TextureRequestCallback where the image cannot be decoded in native code.
+     * With bakeNormalMap the pseudo normal mapping is baked into the decoded texture.
+     */
+    void requestTexture(const ManifestEntry& entry, bool bakeNormalMap);
+
+    /// Decode the normal map of a manifest entry on the loader threads, converted to luma for pseudoNormalFragmentShaderSrc
+    void requestNormalMap(const ManifestEntry& entry);
+
+    /// Ask the platform for the texture or normal map of an entry unless it is in the asset cache
+    /// The cache is looked up on the loader threads, misses are passed to the TextureRequestCallback by processLoadedAssets.
+    void requestPlatformTexture(const ManifestEntry& entry, bool normalMap);
+
+    /// Store a texture or normal map luma the platform decoded for setTexture, keyed by its asset
+    void cachePlatformTexture(const ManifestEntry& entry, bool normalMap, int width, int height, const std::vector<unsigned char>& pixels,
+                              float meanLuma);
+
+    /// Map a texture stored by storeCachedImage and copy out its pixels, returns false if it is not cached
+    static bool loadCachedImage(AssetCache& assetCache, uint64_t key, DecodedImage& image, float& meanLuma);
+    /// Store a decoded texture or normal map luma with its mean luma
+    static void storeCachedImage(AssetCache& assetCache, uint64_t key, const DecodedImage& image, float meanLuma);
+
+    /// Request the assets of a target that have not been requested yet
+    void requireTargetAssets(int target);
+
+    /// Request the files of a remote artwork, refining the coarsest first
+    /*
+     * The coarse model and the model are downloaded in that order, and the texture previews followed by the
+     * texture; the platform downloads in request order. Each file replaces what the model holds once decoded,
+     * so the artwork appears as soon as the coarse files are in and sharpens as the rest arrives.
+     * Texture levels still cached from an earlier detection are used right away and not downloaded again.
+     */
+    void requireRemoteAssets(const ManifestEntry& entry);
+
+    /// Ask the platform for a file of a remote artwork unless it was requested already
+    void requestDownload(const ManifestEntry& entry, Download::Kind kind, int level, const std::string& url);
+
+    /// Load the geometry of a model from a downloaded .mesh or .obj file, OBJ files go through the asset cache like in loadModel
+    /// This method is safe to call from any thread.
+    static bool loadDownloadedModel(AssetCache& assetCache, const std::string& url, std::vector<char> data, Model& model);
+
+    /// The entry holds assets of the target, for the gallery of any of its targets
+    static bool isUsedByTarget(const ManifestEntry& entry, int target);
+
+    /// Release the geometry and texture of a model so that they are requested again when needed
+    /// The texture stays in the texture cache until the budget needs its memory.
+    void evictModel(Model& model);
+
+    /// Queue a model to be loaded on the loader threads
+    void requestModel(AAssetManager* assetManager, const char* name, Model& model, bool quantize = false);
+
+    /// Upload the geometry of a model handed over by the loader threads into GPU buffers
+    /// Must be called on the rendering thread.
+    static bool uploadModel(Model& model);
+
+    /// Report the geometry a model holds on the CPU and GPU under name
+    void accountModel(const char* name, const Model& model);
+
+    /// Called by the loader jobs before they load an asset, see MemoryAccounting::waitForCpuBudget
+    void waitForCpuBudget(const char* name);
+
+    /// Release the geometry of a model, the texture is not affected
+    /// The GPU buffers are freed as well, the GPU side is only ever created on the rendering thread.
+    static void releaseModel(Model& model);
 
 private: // data members
+    /// Content manifest in the assets, used until one is set with setContentManifest
+    static constexpr const char* CONTENT_MANIFEST_ASSET = "content_manifest.txt";
+
+    /// Geometry level of models loaded in full, from the assets or downloaded
+    static constexpr int GEOMETRY_FULL = 1;
+
+    /// Version of the blobs the renderer stores in mAssetCache, bump it when their layout changes
+    /// Meshes are stored in MeshFormat, whose version is part of their key instead.
+    static constexpr uint32_t ASSET_CACHE_VERSION = 1;
+
+    /// Largest error of a level of detail in pixels before a finer level is used
+    static constexpr float LOD_ERROR_PIXELS = 1.5f;
+    /// A coarser level is picked once its error fell below this fraction of LOD_ERROR_PIXELS
+    static constexpr float LOD_HYSTERESIS = 0.7f;
+
+    /// Size and number of the layers of mArtworkArray
+    /// One layer per artwork that can be on screen at once, grow it as more targets get textured models.
+    static constexpr int ARTWORK_LAYER_SIZE = 1024;
+    static constexpr int ARTWORK_LAYER_COUNT = 4;
+
+    /// Uniform buffer binding points of the FrameUniforms and DrawUniforms blocks
+    static constexpr GLuint FRAME_UNIFORMS_BINDING = 0;
+    static constexpr GLuint DRAW_UNIFORMS_BINDING = 1;
+    /// Room for the uniform blocks of one frame, a few hundred draws at the usual 256 byte alignment
+    static constexpr GLsizeiptr UNIFORM_RING_FRAME_SIZE = 64 * 1024;
+
+    /// Time at the right edge of the profiler overlay
+    static constexpr float OVERLAY_FULL_SCALE_MILLISECONDS = 33.3f;
+    /// Frames between refreshes of the overlay statistics, sorting the sample windows every frame costs more than the overlay
+    static constexpr int OVERLAY_REFRESH_FRAMES = 15;
+
+    static constexpr VuVector4F WHITE{ 1.0f, 1.0f, 1.0f, 1.0f };
+    static constexpr VuVector4F IDENTITY_TEX_COORD_TRANSFORM{ 1.0f, 1.0f, 0.0f, 0.0f };
+
+    int mViewportX = 0;
+    int mViewportY = 0;
+    int mViewportWidth = 0;
+    int mViewportHeight = 0;
+
+    // Dynamic resolution of the augmentations, see setDynamicResolution
+    bool mDynamicResolutionEnabled = false;
+    DynamicResolution mDynamicResolution;
+    /// Viewport sized, the augmentations cover its lower left part at the current scale
+    RenderTarget mAugmentationTarget;
+    GpuTimer mAugmentationTimer;
+    /// Scale and size of the augmentations in the frame being rendered
+    float mAugmentationScale = 1.0f;
+    int mAugmentationWidth = 0;
+    int mAugmentationHeight = 0;
+
+    /// Incremented on the rendering thread, read by the profiler log on another thread
+    std::atomic<unsigned int> mCulledDrawCount{ 0 };
+
+    // Profiling of the rendering methods, see setProfiler
+    Profiler* mProfiler = nullptr;
+    bool mProfilerOverlay = false;
+    GpuProfiler mGpuProfiler;
+    /// Set if the GPU has no timestamp queries, the sections are then timed on the CPU only
+    bool mGpuProfilerUnsupported = false;
+    std::vector<Profiler::SectionStatistics> mOverlayStatistics;
+    int mOverlayRefreshCountdown = 0;
+
+    /// Per-instance model view matrices of submitInstanced
+    GLuint mInstanceBuffer = 0;
+    /// Draws of the frame being rendered, see renderFrame
+    std::vector<DrawItem> mDrawQueue;
+    /// Transient data of the frame, set for the duration of renderFrame
+    FrameArena* mFrameArena = nullptr;
+
+    // All state changes of the draw helpers go through the cache, which never queries GL
+    GLStateCache mStateCache;
+
+    // Uniform blocks of the draws, see bindFrameUniforms and bindDrawUniforms
+    UniformRing mUniformRing;
+    /// Projection of the frame uniforms bound in this frame, valid if mFrameProjectionBound is set
+    VuMatrix44F mFrameProjection;
+    bool mFrameProjectionBound = false;
+
     // For video background rendering
     GLuint mVbShaderProgramID = 0;
-    GLint mVbVertexPositionHandle = 0;
-    GLint mVbTextureCoordHandle = 0;
-    GLint mVbMvpMatrixHandle = 0;
     GLint mVbTexSampler2DHandle = 0;
+    /// Texture unit the sampler of the video background program is set to, -1 if not yet set
+    int mVbTextureUnit = -1;
+    GpuMesh mVideoBackgroundMesh;
+    /// Render view version mVideoBackgroundMesh was uploaded for
+    unsigned int mVideoBackgroundMeshVersion = 0;
 
     // For augmentation rendering
     GLuint mUniformColorShaderProgramID = 0;
-    GLint mUniformColorVertexPositionHandle = 0;
-    GLint mUniformColorMvpMatrixHandle = 0;
-    GLint mUniformColorColorHandle = 0;
+
+    // For pseudo normal shading of models, 0 if the shader is not available and normal maps are baked instead
+    GLuint mPseudoNormalShaderProgramID = 0;
 
     // For Model Target guide view rendering
     GLuint mTextureUniformColorShaderProgramID = 0;
-    GLint mTextureUniformColorVertexPositionHandle = 0;
-    GLint mTextureUniformColorTextureCoordHandle = 0;
-    GLint mTextureUniformColorMvpMatrixHandle = 0;
-    GLint mTextureUniformColorTexSampler2DHandle = 0;
-    GLint mTextureUniformColorColorHandle = 0;
-    GLuint mModelTargetGuideViewTextureUnit = -1;
+
+    // For alpha-tested models, textured from their own texture or from the artwork array
+    GLuint mAlphaTestShaderProgramID = 0;
+    GLuint mAlphaTestArrayShaderProgramID = 0;
+    DynamicTexture mModelTargetGuideViewTexture;
+
+    // For models textured from mArtworkArray
+    GLuint mTextureArrayShaderProgramID = 0;
+
+    // SHADED variants of the model programs above for shaded meshes, 0 falls back to the unshaded program
+    GLuint mShadedTextureUniformColorShaderProgramID = 0;
+    GLuint mShadedTextureArrayShaderProgramID = 0;
+    GLuint mShadedAlphaTestShaderProgramID = 0;
+    GLuint mShadedAlphaTestArrayShaderProgramID = 0;
+    GLuint mShadedPseudoNormalShaderProgramID = 0;
 
     // For axis rendering
     GLuint mVertexColorShaderProgramID = 0;
-    GLint mVertexColorVertexPositionHandle = 0;
-    GLint mVertexColorColorHandle = 0;
-    GLint mVertexColorMvpMatrixHandle = 0;
-
-    // For rendering the Astronaut, loaded from the obj file
-    int mAstronautVertexCount;
-    std::vector<float> mAstronautVertices;
-    std::vector<float> mAstronautTexCoords;
-    GLuint mAstronautTextureUnit = -1;
-
-    int mPlaneVertexCount;
-    std::vector<float> mPlaneVertices;
-    std::vector<float> mPlaneTexCoords;
-    GLuint mPlaneTextureUnit = -1;
-
-    // For rendering the Lander, loaded from the obj file
-    int mLanderVertexCount;
-    std::vector<float> mLanderVertices;
-    std::vector<float> mLanderTexCoords;
-    GLuint mLanderTextureUnit = -1;
+
+    // Textures of the models, shared by asset name
+    TextureCache mTextureCache;
+    // Streams decoded textures to the GPU over several frames
+    TextureUploader mTextureUploader;
+    // Drawn on models until their texture is resident
+    GLuint mPlaceholderTexture = 0;
+    // Same-sized artworks sharing one texture binding, created when the first one is uploaded
+    TextureArray mArtworkArray;
+
+    // Static shapes, uploaded once in init
+    GpuMesh mSquareMesh;
+    GpuMesh mCubeMesh;
+    GpuMesh mAxisMesh;
+
+    // The content manifests set so far, the last one is current, see getManifest
+    std::vector<std::unique_ptr<Content>> mContents;
+    // The models of all manifests, see getModel
+    std::vector<std::unique_ptr<Model>> mModels;
+
+    // For asynchronous asset loading
+    AAssetManager* mAssetManager = nullptr;
+    TextureRequestCallback mTextureRequestCallback;
+    ContentRequestCallback mContentRequestCallback;
+    /// Files of remote artworks requested from the platform and not handed over yet
+    std::map<std::string, Download> mDownloads;
+    std::mutex mLoadedAssetsMutex;
+    std::vector<LoadedModel> mLoadedModels;
+    std::vector<LoadedTexture> mLoadedTextures;
+    /// Textures the asset cache did not have, to be requested through the TextureRequestCallback on the rendering thread
+    std::vector<const char*> mPlatformTextureRequests;
+    AssetCache mAssetCache;
+    /// Incremented on deinit so that results of loads requested before are dropped
+    std::atomic<unsigned int> mLoadGeneration{ 0 };
+
+    // Memory held by the assets, see getMemoryAccounting
+    MemoryAccounting mMemoryAccounting;
+    std::atomic<bool> mReleaseMeshCopies{ false };
+
+    // Declared last so that it is destroyed first, joining the loader threads while everything their jobs use still exists
+    std::unique_ptr<WorkerPool> mLoaderPool;
 };
 
 #endif //_VUFORIA_GLESRENDERER_H_
@@ -7,7 +7,12 @@ countries.
 
 #include "GLESUtils.h"
 
+#include "ProgramCache.h"
+
 #include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
 
 #include <GLES2/gl2ext.h>
 #include <GLES3/gl31.h>
@@ -62,6 +67,10 @@ GLESUtils::initShader(GLenum shaderType, const char* source)
 GLuint
 GLESUtils::createProgramFromBuffer(const char* vertexShaderBuffer, const char* fragmentShaderBuffer)
 {
+    GLuint cachedProgram = ProgramCache::load(vertexShaderBuffer, fragmentShaderBuffer);
+    if (cachedProgram)
+        return cachedProgram;
+
     GLuint vertexShader = initShader(GL_VERTEX_SHADER, vertexShaderBuffer);
     if (!vertexShader)
         return 0;
@@ -79,6 +88,14 @@ GLESUtils::createProgramFromBuffer(const char* vertexShaderBuffer, const char* f
         glAttachShader(program, fragmentShader);
         checkGlError("glAttachShader");
 
+        glBindAttribLocation(program, ATTRIBUTE_POSITION, "vertexPosition");
+        glBindAttribLocation(program, ATTRIBUTE_TEXTURE_COORD, "vertexTextureCoord");
+        glBindAttribLocation(program, ATTRIBUTE_COLOR, "vertexColor");
+        glBindAttribLocation(program, ATTRIBUTE_INSTANCE_MATRIX, "instanceModelViewMatrix");
+        glBindAttribLocation(program, ATTRIBUTE_SHADE, "vertexShade");
+
+        // The attribute bindings above are part of the binary
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
         glLinkProgram(program);
         GLint linkStatus = GL_FALSE;
         glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
@@ -100,6 +117,10 @@ GLESUtils::createProgramFromBuffer(const char* vertexShaderBuffer, const char* f
             glDeleteProgram(program);
             program = 0;
         }
+        else
+        {
+            ProgramCache::store(program, vertexShaderBuffer, fragmentShaderBuffer);
+        }
     }
     return program;
 }
@@ -161,7 +182,7 @@ GLESUtils::createTexture(const VuImageInfo& image)
 
 
 GLuint
-GLESUtils::createTexture(int width, int height, unsigned char* data, GLenum format)
+GLESUtils::createTexture(int width, int height, unsigned char* data, GLenum format, const TextureOptions& options)
 {
     GLuint gl_TextureID = -1;
 
@@ -174,12 +195,16 @@ GLESUtils::createTexture(int width, int height, unsigned char* data, GLenum form
     glGenTextures(1, &gl_TextureID);
 
     glBindTexture(GL_TEXTURE_2D, gl_TextureID);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    applyTextureOptions(options, options.mipmaps);
 
+    // Rows are tightly packed, which matters for single channel textures of odd width
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (options.mipmaps)
+    {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
 
     glBindTexture(GL_TEXTURE_2D, 0);
 
@@ -189,6 +214,114 @@ GLESUtils::createTexture(int width, int height, unsigned char* data, GLenum form
 }
 
 
+bool
+GLESUtils::hasExtension(const char* name)
+{
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount; ++i)
+    {
+        auto extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (extension != nullptr && strcmp(extension, name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool
+GLESUtils::isCompressedFormatSupported(GLenum internalFormat)
+{
+    if (internalFormat >= GL_COMPRESSED_R11_EAC && internalFormat <= GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC)
+    {
+        return true;
+    }
+    if ((internalFormat >= GL_COMPRESSED_RGBA_ASTC_4x4_KHR && internalFormat <= GL_COMPRESSED_RGBA_ASTC_12x12_KHR) ||
+        (internalFormat >= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR && internalFormat <= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x12_KHR))
+    {
+        return hasExtension("GL_KHR_texture_compression_astc_ldr");
+    }
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &formatCount);
+    std::vector<GLint> formats(static_cast<size_t>(std::max(formatCount, 0)));
+    if (!formats.empty())
+    {
+        glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+    }
+    return std::find(formats.begin(), formats.end(), static_cast<GLint>(internalFormat)) != formats.end();
+}
+
+
+void
+GLESUtils::applyTextureOptions(const TextureOptions& options, bool hasMipmaps, GLenum target)
+{
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, hasMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, options.wrap);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, options.wrap);
+
+    if (options.maxAnisotropy > 1.0f && hasExtension("GL_EXT_texture_filter_anisotropic"))
+    {
+        GLfloat limit = 1.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &limit);
+        glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, std::min(options.maxAnisotropy, limit));
+    }
+}
+
+
+GLuint
+GLESUtils::createCompressedTexture(const CompressedTextureView& texture, const TextureOptions& options)
+{
+    GLuint gl_TextureID = -1;
+
+    if (texture.levels.empty() || !isCompressedFormatSupported(texture.internalFormat))
+    {
+        LOG("Error: Compressed texture format 0x%x is not supported", texture.internalFormat);
+        return gl_TextureID;
+    }
+
+    // Drop errors left by earlier calls so that a failed upload can be told apart
+    while (glGetError() != GL_NO_ERROR)
+    {
+    }
+
+    glGenTextures(1, &gl_TextureID);
+
+    // Only the stored levels are uploaded, the base level alone when mip mapping is disabled
+    size_t levelCount = options.mipmaps ? texture.levels.size() : 1;
+    if (options.mipmaps && levelCount == 1)
+    {
+        LOG("Compressed texture has no mip levels, sampling the base level only");
+    }
+
+    glBindTexture(GL_TEXTURE_2D, gl_TextureID);
+    applyTextureOptions(options, levelCount > 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levelCount) - 1);
+
+    for (size_t level = 0; level < levelCount; ++level)
+    {
+        const auto& image = texture.levels[level];
+        glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), texture.internalFormat, static_cast<GLsizei>(image.width),
+                               static_cast<GLsizei>(image.height), 0, static_cast<GLsizei>(image.size), image.data);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR)
+    {
+        LOG("Error: Uploading compressed texture failed (0x%x)", error);
+        glDeleteTextures(1, &gl_TextureID);
+        gl_TextureID = -1;
+    }
+
+    return gl_TextureID;
+}
+
+
 bool
 GLESUtils::destroyTexture(GLuint textureId)
 {
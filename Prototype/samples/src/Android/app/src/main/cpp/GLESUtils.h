@@ -10,11 +10,25 @@ countries.
 
 // Includes:
 #include <Log.h>
+#include <TextureLoader.h>
 #include <VuforiaEngine/VuforiaEngine.h>
 
 #include <GLES3/gl31.h>
 #include <vector>
 
+/// Sampling setup of a texture created by createTexture or createCompressedTexture
+struct TextureOptions
+{
+    /// Sample from a mip chain with trilinear filtering
+    /// Raw uploads generate the chain, compressed textures use the levels stored in the file.
+    bool mipmaps = true;
+    /// Maximum anisotropy, only applied where GL_EXT_texture_filter_anisotropic is supported.
+    /// 1 disables anisotropic filtering, larger values are clamped to the limit of the GPU.
+    float maxAnisotropy = 1.0f;
+    GLenum wrap = GL_REPEAT;
+};
+
+
 /// A utility class used by the Vuforia Engine samples.
 class GLESUtils
 {
@@ -23,6 +37,19 @@ private:
     static const bool DEBUG_GL = false;
 
 public:
+    /// Vertex attribute locations bound by createProgramFromBuffer
+    /*
+     * Every program uses the same location for an attribute name, so that a vertex array object
+     * set up once can be drawn with any of the sample programs.
+     */
+    static const GLuint ATTRIBUTE_POSITION = 0;
+    static const GLuint ATTRIBUTE_TEXTURE_COORD = 1;
+    static const GLuint ATTRIBUTE_COLOR = 2;
+    /// Per-instance model view matrix, one column per location from here up to ATTRIBUTE_INSTANCE_MATRIX + 3
+    static const GLuint ATTRIBUTE_INSTANCE_MATRIX = 3;
+    /// Baked shade of shaded meshes, see SHADED_DEFINE_GLSL
+    static const GLuint ATTRIBUTE_SHADE = 7;
+
     /// Prints GL error information.
     static void checkGlError(const char* operation);
 
@@ -30,13 +57,36 @@ public:
     static GLuint initShader(GLenum shaderType, const char* source);
 
     /// Create a shader program.
+    /// The linked program is loaded from the ProgramCache if a binary is stored for the sources, and stored otherwise.
+    /// Look its uniforms up with ProgramCache::getUniformLocation.
     static GLuint createProgramFromBuffer(const char* vertexShaderBuffer, const char* fragmentShaderBuffer);
 
     /// Create a texture from a Vuforia Image
     static GLuint createTexture(const VuImageInfo& image);
 
     /// Create a texture from a byte vector
-    static unsigned int createTexture(int width, int height, unsigned char* data, GLenum format = GL_RGBA);
+    static unsigned int createTexture(int width, int height, unsigned char* data, GLenum format = GL_RGBA,
+                                      const TextureOptions& options = TextureOptions());
+
+    /// Check whether the GL implementation advertises an extension
+    static bool hasExtension(const char* name);
+
+    /// Check whether textures in a compressed internal format can be created
+    /*
+     * ETC2 and EAC are core in OpenGL ES 3.0, ASTC needs GL_KHR_texture_compression_astc_ldr.
+     * Other formats are looked up in GL_COMPRESSED_TEXTURE_FORMATS.
+     */
+    static bool isCompressedFormatSupported(GLenum internalFormat);
+
+    /// Create a texture from pre-compressed blocks, every level of the view is uploaded
+    /// Returns -1 if the format is not supported or the upload failed, in which case the
+    /// caller is expected to fall back to an uncompressed texture.
+    /// Compressed mip levels cannot be generated, a texture without them is sampled from the base level only.
+    static GLuint createCompressedTexture(const CompressedTextureView& texture, const TextureOptions& options = TextureOptions());
+
+    /// Set the filtering and wrapping of the texture bound to target
+    /// hasMipmaps selects trilinear filtering, the texture must then have a complete mip chain.
+    static void applyTextureOptions(const TextureOptions& options, bool hasMipmaps, GLenum target = GL_TEXTURE_2D);
 
     /// Clean up texture
     static bool destroyTexture(GLuint textureId);
@@ -0,0 +1,198 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "GLStateCache.h"
+
+
+void
+GLStateCache::beginFrame()
+{
+    mLastFrameCounters = mFrameCounters;
+    mFrameCounters = Counters();
+    invalidate();
+}
+
+
+void
+GLStateCache::invalidate()
+{
+    for (auto& capability : mCapabilities)
+    {
+        capability = UNKNOWN;
+    }
+    mBlendSourceFactor = UNKNOWN;
+    mBlendDestinationFactor = UNKNOWN;
+    mBlendSourceAlphaFactor = UNKNOWN;
+    mBlendDestinationAlphaFactor = UNKNOWN;
+    mCullFace = UNKNOWN;
+    mFrontFace = UNKNOWN;
+    // Line widths are positive, a negative one is never current
+    mLineWidth = -1.0f;
+    mProgram = UNKNOWN;
+    invalidateTextures();
+}
+
+
+void
+GLStateCache::invalidateTextures()
+{
+    mActiveTextureUnit = UNKNOWN;
+    for (auto& unit : mTextures)
+    {
+        for (auto& texture : unit)
+        {
+            texture = UNKNOWN;
+        }
+    }
+}
+
+
+void
+GLStateCache::setEnabled(GLenum capability, bool enabled)
+{
+    int index = -1;
+    switch (capability)
+    {
+        case GL_DEPTH_TEST:
+            index = CAPABILITY_DEPTH_TEST;
+            break;
+        case GL_BLEND:
+            index = CAPABILITY_BLEND;
+            break;
+        case GL_CULL_FACE:
+            index = CAPABILITY_CULL_FACE;
+            break;
+        default:
+            break;
+    }
+
+    if (index == -1 || update(mCapabilities[index], enabled ? 1 : 0, mFrameCounters.stateChanges))
+    {
+        if (enabled)
+        {
+            glEnable(capability);
+        }
+        else
+        {
+            glDisable(capability);
+        }
+    }
+}
+
+
+void
+GLStateCache::blendFunc(GLenum sourceFactor, GLenum destinationFactor)
+{
+    blendFuncSeparate(sourceFactor, destinationFactor, sourceFactor, destinationFactor);
+}
+
+
+void
+GLStateCache::blendFuncSeparate(GLenum sourceFactor, GLenum destinationFactor, GLenum sourceAlphaFactor, GLenum destinationAlphaFactor)
+{
+    if (sourceFactor == mBlendSourceFactor && destinationFactor == mBlendDestinationFactor &&
+        sourceAlphaFactor == mBlendSourceAlphaFactor && destinationAlphaFactor == mBlendDestinationAlphaFactor)
+    {
+        ++mFrameCounters.redundantCalls;
+        return;
+    }
+    mBlendSourceFactor = sourceFactor;
+    mBlendDestinationFactor = destinationFactor;
+    mBlendSourceAlphaFactor = sourceAlphaFactor;
+    mBlendDestinationAlphaFactor = destinationAlphaFactor;
+    ++mFrameCounters.stateChanges;
+    glBlendFuncSeparate(sourceFactor, destinationFactor, sourceAlphaFactor, destinationAlphaFactor);
+}
+
+
+void
+GLStateCache::cullFace(GLenum mode)
+{
+    if (update(mCullFace, mode, mFrameCounters.stateChanges))
+    {
+        glCullFace(mode);
+    }
+}
+
+
+void
+GLStateCache::frontFace(GLenum mode)
+{
+    if (update(mFrontFace, mode, mFrameCounters.stateChanges))
+    {
+        glFrontFace(mode);
+    }
+}
+
+
+void
+GLStateCache::lineWidth(GLfloat width)
+{
+    if (width == mLineWidth)
+    {
+        ++mFrameCounters.redundantCalls;
+        return;
+    }
+    mLineWidth = width;
+    ++mFrameCounters.stateChanges;
+    glLineWidth(width);
+}
+
+
+void
+GLStateCache::useProgram(GLuint program)
+{
+    if (update(mProgram, program, mFrameCounters.programBinds))
+    {
+        glUseProgram(program);
+    }
+}
+
+
+void
+GLStateCache::bindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    if (update(mActiveTextureUnit, unit, mFrameCounters.textureBinds))
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    int targetIndex = getTargetIndex(target);
+    if (unit >= TEXTURE_UNIT_COUNT || targetIndex == -1 || update(mTextures[unit][targetIndex], texture, mFrameCounters.textureBinds))
+    {
+        glBindTexture(target, texture);
+    }
+}
+
+
+bool
+GLStateCache::update(GLuint& current, GLuint value, unsigned int& counter)
+{
+    if (current == value)
+    {
+        ++mFrameCounters.redundantCalls;
+        return false;
+    }
+    current = value;
+    ++counter;
+    return true;
+}
+
+
+int
+GLStateCache::getTargetIndex(GLenum target)
+{
+    switch (target)
+    {
+        case GL_TEXTURE_2D:
+            return TARGET_2D;
+        case GL_TEXTURE_2D_ARRAY:
+            return TARGET_2D_ARRAY;
+        default:
+            return -1;
+    }
+}
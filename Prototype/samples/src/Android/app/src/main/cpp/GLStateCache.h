@@ -0,0 +1,111 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_GLSTATECACHE_H_
+#define _VUFORIA_GLSTATECACHE_H_
+
+#include <GLES3/gl31.h>
+
+
+/// Shadow copy of the GL state the renderer changes, filtering out calls that would not change anything
+/**
+ * The state is only ever written, never queried from the driver. Anything set outside the cache is
+ * unknown to it: beginFrame forgets all state, as Vuforia updates the video background texture between
+ * frames, and invalidateTextures must be called after code binding textures directly, such as
+ * TextureUploader or DynamicTexture, or deleting textures that may still be bound.
+ * State unknown to the cache is always set on first use.
+ * Draw helpers set all the state they depend on instead of restoring it afterwards.
+ * All methods must be called on the rendering thread with a current GL context.
+ */
+class GLStateCache
+{
+public:
+    GLStateCache() { invalidate(); }
+
+    /// GL calls made or filtered out during a frame
+    struct Counters
+    {
+        /// Capability, blend, cull and line width changes passed on to GL
+        unsigned int stateChanges = 0;
+        unsigned int programBinds = 0;
+        /// Texture binds and active texture unit changes passed on to GL
+        unsigned int textureBinds = 0;
+        /// Calls dropped because GL already had the state
+        unsigned int redundantCalls = 0;
+    };
+
+    /// Start counting a new frame, the counters of the previous one become available from getFrameCounters
+    /// All state is forgotten as other code may have changed it since the last frame.
+    void beginFrame();
+
+    /// Forget all state, the next call for each state is passed on to GL
+    void invalidate();
+
+    /// Forget the active texture unit and all texture bindings
+    void invalidateTextures();
+
+    /// Enable or disable GL_DEPTH_TEST, GL_BLEND or GL_CULL_FACE, other capabilities are passed on unfiltered
+    void setEnabled(GLenum capability, bool enabled);
+
+    void blendFunc(GLenum sourceFactor, GLenum destinationFactor);
+    void blendFuncSeparate(GLenum sourceFactor, GLenum destinationFactor, GLenum sourceAlphaFactor, GLenum destinationAlphaFactor);
+    void cullFace(GLenum mode);
+    void frontFace(GLenum mode);
+    void lineWidth(GLfloat width);
+    void useProgram(GLuint program);
+
+    /// Bind a texture to a texture unit, the active texture unit is switched if needed
+    /// GL_TEXTURE_2D and GL_TEXTURE_2D_ARRAY are tracked, binds to other targets are passed on unfiltered.
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    /// Counters of the last frame completed with beginFrame
+    const Counters& getFrameCounters() const { return mLastFrameCounters; }
+
+private:
+    enum Capability
+    {
+        CAPABILITY_DEPTH_TEST,
+        CAPABILITY_BLEND,
+        CAPABILITY_CULL_FACE,
+        CAPABILITY_COUNT
+    };
+
+    enum TextureTarget
+    {
+        TARGET_2D,
+        TARGET_2D_ARRAY,
+        TARGET_COUNT
+    };
+
+    /// Units tracked, binds to higher units are passed on unfiltered
+    static constexpr GLuint TEXTURE_UNIT_COUNT = 4;
+    /// Marks enums and object names the cache does not know
+    static constexpr GLuint UNKNOWN = 0xFFFFFFFF;
+
+    /// Count a call that changes the state, returns false if it is redundant
+    bool update(GLuint& current, GLuint value, unsigned int& counter);
+
+    static int getTargetIndex(GLenum target);
+
+    /// 0 disabled, 1 enabled, UNKNOWN
+    GLuint mCapabilities[CAPABILITY_COUNT];
+    GLuint mBlendSourceFactor;
+    GLuint mBlendDestinationFactor;
+    GLuint mBlendSourceAlphaFactor;
+    GLuint mBlendDestinationAlphaFactor;
+    GLuint mCullFace;
+    GLuint mFrontFace;
+    GLfloat mLineWidth;
+    GLuint mProgram;
+    GLuint mActiveTextureUnit;
+    GLuint mTextures[TEXTURE_UNIT_COUNT][TARGET_COUNT];
+
+    Counters mFrameCounters;
+    Counters mLastFrameCounters;
+};
+
+#endif // _VUFORIA_GLSTATECACHE_H_
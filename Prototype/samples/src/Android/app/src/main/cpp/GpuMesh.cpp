@@ -0,0 +1,199 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "GpuMesh.h"
+
+#include "GLESUtils.h"
+
+#include <cstdint>
+#include <utility>
+
+
+GpuMesh::GpuMesh(GpuMesh&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+
+GpuMesh&
+GpuMesh::operator=(GpuMesh&& other) noexcept
+{
+    if (this != &other)
+    {
+        std::swap(mVertexArray, other.mVertexArray);
+        std::swap(mVertexBuffer, other.mVertexBuffer);
+        std::swap(mIndexBuffer, other.mIndexBuffer);
+        std::swap(mVertexCount, other.mVertexCount);
+        std::swap(mIndexCount, other.mIndexCount);
+        std::swap(mIndexType, other.mIndexType);
+        std::swap(mSizeBytes, other.mSizeBytes);
+    }
+    return *this;
+}
+
+
+bool
+GpuMesh::create(const void* vertices, GLsizeiptr vertexBytes, GLsizei vertexStride, std::initializer_list<Attribute> attributes,
+                const void* indices, GLsizei indexCount, GLenum indexType)
+{
+    destroy();
+
+    if (vertices == nullptr || vertexBytes <= 0 || vertexStride <= 0)
+    {
+        LOG("Error: Cannot create a mesh without vertices");
+        return false;
+    }
+
+    glGenVertexArrays(1, &mVertexArray);
+    glBindVertexArray(mVertexArray);
+
+    glGenBuffers(1, &mVertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertices, GL_STATIC_DRAW);
+    mSizeBytes = static_cast<size_t>(vertexBytes);
+
+    for (const auto& attribute : attributes)
+    {
+        glEnableVertexAttribArray(attribute.location);
+        glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized, vertexStride,
+                              reinterpret_cast<const GLvoid*>(static_cast<uintptr_t>(attribute.offset)));
+    }
+
+    if (indices != nullptr && indexCount > 0)
+    {
+        GLsizeiptr indexBytes = indexCount * (indexType == GL_UNSIGNED_INT ? 4 : indexType == GL_UNSIGNED_SHORT ? 2 : 1);
+        glGenBuffers(1, &mIndexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indices, GL_STATIC_DRAW);
+        mSizeBytes += static_cast<size_t>(indexBytes);
+    }
+
+    // Unbind the vertex array first so that the element buffer binding stays recorded in it
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    mVertexCount = static_cast<GLsizei>(vertexBytes / vertexStride);
+    mIndexCount = mIndexBuffer != 0 ? indexCount : 0;
+    mIndexType = indexType;
+
+    GLESUtils::checkGlError("Create mesh");
+    return true;
+}
+
+
+void
+GpuMesh::destroy()
+{
+    if (mVertexArray != 0)
+    {
+        glDeleteVertexArrays(1, &mVertexArray);
+    }
+    if (mVertexBuffer != 0)
+    {
+        glDeleteBuffers(1, &mVertexBuffer);
+    }
+    if (mIndexBuffer != 0)
+    {
+        glDeleteBuffers(1, &mIndexBuffer);
+    }
+    forget();
+}
+
+
+void
+GpuMesh::forget()
+{
+    mVertexArray = 0;
+    mVertexBuffer = 0;
+    mIndexBuffer = 0;
+    mVertexCount = 0;
+    mIndexCount = 0;
+    mSizeBytes = 0;
+}
+
+
+void
+GpuMesh::draw(GLenum mode) const
+{
+    glBindVertexArray(mVertexArray);
+    if (mIndexCount > 0)
+    {
+        glDrawElements(mode, mIndexCount, mIndexType, nullptr);
+    }
+    else
+    {
+        glDrawArrays(mode, 0, mVertexCount);
+    }
+    glBindVertexArray(0);
+}
+
+
+void
+GpuMesh::draw(GLenum mode, GLsizei count, GLsizei firstIndex) const
+{
+    GLsizei indexBytes = mIndexType == GL_UNSIGNED_INT ? 4 : mIndexType == GL_UNSIGNED_SHORT ? 2 : 1;
+    glBindVertexArray(mVertexArray);
+    glDrawElements(mode, count, mIndexType, reinterpret_cast<const GLvoid*>(static_cast<uintptr_t>(firstIndex * indexBytes)));
+    glBindVertexArray(0);
+}
+
+
+void
+GpuMesh::drawInstanced(GLenum mode, GLsizei instanceCount, GLuint instanceBuffer) const
+{
+    bindInstanceBuffer(instanceBuffer);
+    if (mIndexCount > 0)
+    {
+        glDrawElementsInstanced(mode, mIndexCount, mIndexType, nullptr, instanceCount);
+    }
+    else
+    {
+        glDrawArraysInstanced(mode, 0, mVertexCount, instanceCount);
+    }
+    unbindInstanceBuffer();
+    glBindVertexArray(0);
+}
+
+
+void
+GpuMesh::drawInstanced(GLenum mode, GLsizei count, GLsizei firstIndex, GLsizei instanceCount, GLuint instanceBuffer) const
+{
+    GLsizei indexBytes = mIndexType == GL_UNSIGNED_INT ? 4 : mIndexType == GL_UNSIGNED_SHORT ? 2 : 1;
+    bindInstanceBuffer(instanceBuffer);
+    glDrawElementsInstanced(mode, count, mIndexType, reinterpret_cast<const GLvoid*>(static_cast<uintptr_t>(firstIndex * indexBytes)),
+                            instanceCount);
+    unbindInstanceBuffer();
+    glBindVertexArray(0);
+}
+
+
+void
+GpuMesh::bindInstanceBuffer(GLuint instanceBuffer) const
+{
+    glBindVertexArray(mVertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        GLuint location = GLESUtils::ATTRIBUTE_INSTANCE_MATRIX + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(GLfloat),
+                              reinterpret_cast<const GLvoid*>(column * 4 * sizeof(GLfloat)));
+        glVertexAttribDivisor(location, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+void
+GpuMesh::unbindInstanceBuffer()
+{
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        glDisableVertexAttribArray(GLESUtils::ATTRIBUTE_INSTANCE_MATRIX + column);
+    }
+}
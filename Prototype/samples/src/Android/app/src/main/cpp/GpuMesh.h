@@ -0,0 +1,105 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_GPUMESH_H_
+#define _VUFORIA_GPUMESH_H_
+
+#include <GLES3/gl31.h>
+
+#include <cstddef>
+#include <initializer_list>
+
+
+/// Geometry uploaded once into GPU buffers and drawn with a single vertex array object bind
+/**
+ * The vertex attributes are bound to the fixed locations set up by GLESUtils::createProgramFromBuffer,
+ * so the same mesh can be drawn with any of the sample programs.
+ * All methods must be called on the rendering thread with a current GL context.
+ */
+class GpuMesh
+{
+public:
+    /// Description of one vertex attribute within the vertex buffer
+    struct Attribute
+    {
+        GLuint location;
+        GLint components;
+        GLenum type;
+        GLboolean normalized;
+        /// Byte offset of the attribute within a vertex
+        GLuint offset;
+    };
+
+    GpuMesh() = default;
+    /// The GL objects are not freed on destruction, call destroy on the rendering thread
+    ~GpuMesh() = default;
+
+    GpuMesh(const GpuMesh&) = delete;
+    GpuMesh& operator=(const GpuMesh&) = delete;
+    GpuMesh(GpuMesh&& other) noexcept;
+    GpuMesh& operator=(GpuMesh&& other) noexcept;
+
+    /// Upload vertex and optional index data
+    /*
+     * indices may be null, in which case the mesh is drawn with glDrawArrays.
+     * Any geometry previously held by this mesh is destroyed first.
+     */
+    bool create(const void* vertices, GLsizeiptr vertexBytes, GLsizei vertexStride, std::initializer_list<Attribute> attributes,
+                const void* indices = nullptr, GLsizei indexCount = 0, GLenum indexType = GL_UNSIGNED_SHORT);
+
+    /// Free the GL objects, the mesh can be created again afterwards
+    /*
+     * The GL objects are only deleted if the context they were created in is still alive,
+     * call forget instead when the context has been lost.
+     */
+    void destroy();
+
+    /// Drop the GL object handles without deleting them, used after the GL context was lost
+    void forget();
+
+    bool isValid() const { return mVertexArray != 0; }
+
+    /// Draw all vertices or indices of the mesh
+    void draw(GLenum mode) const;
+
+    /// Draw a range of the index buffer
+    void draw(GLenum mode, GLsizei count, GLsizei firstIndex) const;
+
+    /// Draw instanceCount copies of the mesh, reading one model view matrix per copy from instanceBuffer
+    /*
+     * The matrices are tightly packed column-major 4x4 floats from the start of the buffer, fed to
+     * GLESUtils::ATTRIBUTE_INSTANCE_MATRIX. The instance attributes are only enabled for the draw, plain
+     * draws read the generic attribute values instead.
+     */
+    void drawInstanced(GLenum mode, GLsizei instanceCount, GLuint instanceBuffer) const;
+
+    /// Draw instanceCount copies of a range of the index buffer, see drawInstanced
+    void drawInstanced(GLenum mode, GLsizei count, GLsizei firstIndex, GLsizei instanceCount, GLuint instanceBuffer) const;
+
+    GLsizei getVertexCount() const { return mVertexCount; }
+    GLsizei getIndexCount() const { return mIndexCount; }
+    /// GPU memory of the vertex and index buffers
+    size_t getSizeBytes() const { return mSizeBytes; }
+
+private:
+    /// Point the instance attributes of the vertex array at an instance buffer and enable them
+    void bindInstanceBuffer(GLuint instanceBuffer) const;
+
+    /// Disable the instance attributes, leaving the vertex array bound
+    static void unbindInstanceBuffer();
+
+    GLuint mVertexArray = 0;
+    GLuint mVertexBuffer = 0;
+    GLuint mIndexBuffer = 0;
+
+    GLsizei mVertexCount = 0;
+    GLsizei mIndexCount = 0;
+    GLenum mIndexType = GL_UNSIGNED_SHORT;
+    size_t mSizeBytes = 0;
+};
+
+#endif // _VUFORIA_GPUMESH_H_
@@ -0,0 +1,134 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "GpuProfiler.h"
+
+#include "GLESUtils.h"
+
+#include <EGL/egl.h>
+
+
+bool
+GpuProfiler::create()
+{
+    destroy();
+
+    if (!GLESUtils::hasExtension("GL_EXT_disjoint_timer_query"))
+    {
+        return false;
+    }
+
+    // Some GPUs support the extension for elapsed time queries only
+    GLint timestampBits = 0;
+    glGetQueryiv(GL_TIMESTAMP_EXT, GL_QUERY_COUNTER_BITS_EXT, &timestampBits);
+    mQueryCounter = reinterpret_cast<PFNGLQUERYCOUNTEREXTPROC>(eglGetProcAddress("glQueryCounterEXT"));
+    mGetQueryObjectui64v = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VEXTPROC>(eglGetProcAddress("glGetQueryObjectui64vEXT"));
+    if (timestampBits == 0 || mQueryCounter == nullptr || mGetQueryObjectui64v == nullptr)
+    {
+        return false;
+    }
+    glGenQueries(2 * RANGE_COUNT, mQueries);
+
+    // Reading the flag clears it
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    return isValid();
+}
+
+
+void
+GpuProfiler::destroy()
+{
+    if (isValid())
+    {
+        glDeleteQueries(2 * RANGE_COUNT, mQueries);
+    }
+    forget();
+}
+
+
+void
+GpuProfiler::forget()
+{
+    for (auto& query : mQueries)
+    {
+        query = 0;
+    }
+    for (auto& range : mOpenRanges)
+    {
+        range = -1;
+    }
+    mNext = 0;
+    mPending = 0;
+}
+
+
+void
+GpuProfiler::begin(int section)
+{
+    mOpenRanges[section] = -1;
+    if (!isValid() || mPending == RANGE_COUNT)
+    {
+        return;
+    }
+
+    mRanges[mNext] = { section, false };
+    mQueryCounter(mQueries[2 * mNext], GL_TIMESTAMP_EXT);
+    mOpenRanges[section] = mNext;
+    mNext = (mNext + 1) % RANGE_COUNT;
+    ++mPending;
+}
+
+
+void
+GpuProfiler::end(int section)
+{
+    int range = mOpenRanges[section];
+    if (range < 0)
+    {
+        return;
+    }
+    mQueryCounter(mQueries[2 * range + 1], GL_TIMESTAMP_EXT);
+    mRanges[range].ended = true;
+    mOpenRanges[section] = -1;
+}
+
+
+void
+GpuProfiler::collect(Profiler& profiler)
+{
+    // Read before the results so that a disjoint event during any of them is noticed
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+    while (mPending > 0)
+    {
+        int range = (mNext - mPending + RANGE_COUNT) % RANGE_COUNT;
+        if (!mRanges[range].ended)
+        {
+            break;
+        }
+
+        // The end timestamp completes after the begin timestamp
+        GLuint available = 0;
+        glGetQueryObjectuiv(mQueries[2 * range + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == 0)
+        {
+            break;
+        }
+
+        GLuint64 beginTime = 0;
+        GLuint64 endTime = 0;
+        mGetQueryObjectui64v(mQueries[2 * range], GL_QUERY_RESULT, &beginTime);
+        mGetQueryObjectui64v(mQueries[2 * range + 1], GL_QUERY_RESULT, &endTime);
+        --mPending;
+        if (disjoint == 0 && endTime >= beginTime)
+        {
+            profiler.addGpuTime(mRanges[range].section, (endTime - beginTime) / 1.0e6f);
+        }
+    }
+}
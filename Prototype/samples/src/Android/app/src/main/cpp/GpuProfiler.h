@@ -0,0 +1,81 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_GPUPROFILER_H_
+#define _VUFORIA_GPUPROFILER_H_
+
+// clang-format off
+#include <GLES3/gl31.h>
+#include <GLES2/gl2ext.h>
+// clang-format on
+
+#include <Profiler.h>
+
+
+/// Times the sections of a Profiler on the GPU with GL_EXT_disjoint_timer_query timestamps
+/**
+ * Unlike the elapsed time queries of GpuTimer, timestamp queries can nest and run alongside an
+ * elapsed time query, so the sections can be timed while the augmentation pass is measured for
+ * dynamic resolution. Each range takes a pair of query objects from a ring of RANGE_COUNT pairs;
+ * results are read once available, and a range is not measured while every pair is still waiting
+ * for its result. Results of frames in which the GPU timer was disjoint are dropped.
+ * All methods must be called on the rendering thread with a current GL context.
+ */
+class GpuProfiler : public Profiler::GpuRanges
+{
+public:
+    /// Enough for a few frames of a dozen sections
+    static constexpr int RANGE_COUNT = 64;
+
+    GpuProfiler() = default;
+    /// The GL objects are not freed on destruction, call destroy on the rendering thread
+    ~GpuProfiler() override = default;
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    /// Create the queries, returns false if the GPU has no timestamp queries
+    bool create();
+
+    /// Free the GL objects
+    void destroy();
+
+    /// Drop the GL object handles without deleting them, used after the GL context was lost
+    void forget();
+
+    bool isValid() const { return mQueries[0] != 0; }
+
+    void begin(int section) override;
+    void end(int section) override;
+
+    /// Pass the results that became available to the profiler
+    /// Call between frames, when no range is open.
+    void collect(Profiler& profiler);
+
+private:
+    struct Range
+    {
+        int section;
+        /// Set once the end timestamp was queried
+        bool ended;
+    };
+
+    PFNGLQUERYCOUNTEREXTPROC mQueryCounter = nullptr;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC mGetQueryObjectui64v = nullptr;
+
+    /// The begin and end timestamps of range i are 2 * i and 2 * i + 1
+    GLuint mQueries[2 * RANGE_COUNT] = {};
+    Range mRanges[RANGE_COUNT] = {};
+    /// Range used by the next begin
+    int mNext = 0;
+    /// Ranges begun whose result has not been read yet, the oldest ones before mNext
+    int mPending = 0;
+    /// Range of each open section, -1 if the section is not measured
+    int mOpenRanges[Profiler::MAX_SECTIONS] = {};
+};
+
+#endif // _VUFORIA_GPUPROFILER_H_
@@ -0,0 +1,108 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "GpuTimer.h"
+
+#include "GLESUtils.h"
+
+#include <GLES2/gl2ext.h>
+
+
+bool
+GpuTimer::create()
+{
+    destroy();
+
+    // The core query functions take the timer target of the extension on OpenGL ES 3
+    if (!GLESUtils::hasExtension("GL_EXT_disjoint_timer_query"))
+    {
+        return false;
+    }
+    glGenQueries(QUERY_COUNT, mQueries);
+
+    // Reading the flag clears it
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    return isValid();
+}
+
+
+void
+GpuTimer::destroy()
+{
+    if (isValid())
+    {
+        glDeleteQueries(QUERY_COUNT, mQueries);
+    }
+    forget();
+}
+
+
+void
+GpuTimer::forget()
+{
+    for (auto& query : mQueries)
+    {
+        query = 0;
+    }
+    mNext = 0;
+    mPending = 0;
+    mMeasuring = false;
+}
+
+
+void
+GpuTimer::begin()
+{
+    mMeasuring = isValid() && mPending < QUERY_COUNT;
+    if (mMeasuring)
+    {
+        glBeginQuery(GL_TIME_ELAPSED_EXT, mQueries[mNext]);
+    }
+}
+
+
+void
+GpuTimer::end()
+{
+    if (!mMeasuring)
+    {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED_EXT);
+    mNext = (mNext + 1) % QUERY_COUNT;
+    ++mPending;
+    mMeasuring = false;
+}
+
+
+bool
+GpuTimer::getResult(float& milliseconds)
+{
+    bool found = false;
+    while (mPending > 0)
+    {
+        GLuint query = mQueries[(mNext - mPending + QUERY_COUNT) % QUERY_COUNT];
+        GLuint available = 0;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == 0)
+        {
+            break;
+        }
+
+        // Nanoseconds, a 32 bit result covers more than four seconds
+        GLuint nanoseconds = 0;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT, &nanoseconds);
+        --mPending;
+        milliseconds = nanoseconds / 1.0e6f;
+        found = true;
+    }
+
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    return found && disjoint == 0;
+}
@@ -0,0 +1,63 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_GPUTIMER_H_
+#define _VUFORIA_GPUTIMER_H_
+
+#include <GLES3/gl31.h>
+
+
+/// Measures the GPU time of a range of GL commands with GL_EXT_disjoint_timer_query
+/**
+ * Results arrive some frames after the range was submitted. The queries cycle through QUERY_COUNT
+ * objects and are only read once available, so measuring never stalls the pipeline; a range is not
+ * measured while every query still waits for its result. Results of ranges during which the GPU
+ * timer was disjoint, e.g. after a frequency change, are dropped.
+ * All methods must be called on the rendering thread with a current GL context.
+ */
+class GpuTimer
+{
+public:
+    static constexpr int QUERY_COUNT = 4;
+
+    GpuTimer() = default;
+    /// The GL objects are not freed on destruction, call destroy on the rendering thread
+    ~GpuTimer() = default;
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    /// Create the queries, returns false if the GPU has no timer queries
+    bool create();
+
+    /// Free the GL objects
+    void destroy();
+
+    /// Drop the GL object handles without deleting them, used after the GL context was lost
+    void forget();
+
+    bool isValid() const { return mQueries[0] != 0; }
+
+    /// Start and end the measured range, ranges must not be nested
+    void begin();
+    void end();
+
+    /// Collect the results that became available, milliseconds is set to the most recent one
+    /// Returns false if no valid result became available since the last call.
+    bool getResult(float& milliseconds);
+
+private:
+    GLuint mQueries[QUERY_COUNT] = {};
+    /// Query used by the next range
+    int mNext = 0;
+    /// Ranges ended whose result has not been read yet, the oldest ones before mNext
+    int mPending = 0;
+    /// Set between begin and end if the range is measured
+    bool mMeasuring = false;
+};
+
+#endif // _VUFORIA_GPUTIMER_H_
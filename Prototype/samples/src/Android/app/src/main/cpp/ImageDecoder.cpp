@@ -0,0 +1,227 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "ImageDecoder.h"
+
+#include <Log.h>
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+
+namespace
+{
+/*
+ * The declarations of <android/imagedecoder.h> are hidden below API level 30,
+ * the functions are resolved from libjnigraphics.so instead.
+ */
+struct AImageDecoder;
+struct AImageDecoderHeaderInfo;
+
+/// Values from <android/imagedecoder.h> and <android/bitmap.h>
+constexpr int IMAGE_DECODER_SUCCESS = 0;
+constexpr int32_t BITMAP_FORMAT_RGBA_8888 = 1;
+
+/// Entry points of AImageDecoder, all null if the decoder is not available
+struct DecoderFunctions
+{
+    int (*createFromAAsset)(AAsset*, AImageDecoder**) = nullptr;
+    int (*createFromBuffer)(const void*, size_t, AImageDecoder**) = nullptr;
+    void (*destroy)(AImageDecoder*) = nullptr;
+    int (*setAndroidBitmapFormat)(AImageDecoder*, int32_t) = nullptr;
+    int (*setUnpremultipliedRequired)(AImageDecoder*, bool) = nullptr;
+    int (*setTargetSize)(AImageDecoder*, int32_t, int32_t) = nullptr;
+    const AImageDecoderHeaderInfo* (*getHeaderInfo)(const AImageDecoder*) = nullptr;
+    int32_t (*getWidth)(const AImageDecoderHeaderInfo*) = nullptr;
+    int32_t (*getHeight)(const AImageDecoderHeaderInfo*) = nullptr;
+    int (*decodeImage)(AImageDecoder*, void*, size_t, size_t) = nullptr;
+
+    bool isValid() const
+    {
+        return createFromAAsset && createFromBuffer && destroy && setAndroidBitmapFormat && setUnpremultipliedRequired && setTargetSize && getHeaderInfo &&
+               getWidth && getHeight && decodeImage;
+    }
+};
+
+template <typename Function>
+void
+resolve(void* library, const char* name, Function& function)
+{
+    function = reinterpret_cast<Function>(dlsym(library, name));
+}
+
+const DecoderFunctions&
+getDecoderFunctions()
+{
+    // Resolved once, the library stays loaded for the lifetime of the process
+    static const DecoderFunctions functions = []() {
+        DecoderFunctions result;
+        void* library = dlopen("libjnigraphics.so", RTLD_NOW | RTLD_LOCAL);
+        if (library == nullptr)
+        {
+            return result;
+        }
+        resolve(library, "AImageDecoder_createFromAAsset", result.createFromAAsset);
+        resolve(library, "AImageDecoder_createFromBuffer", result.createFromBuffer);
+        resolve(library, "AImageDecoder_delete", result.destroy);
+        resolve(library, "AImageDecoder_setAndroidBitmapFormat", result.setAndroidBitmapFormat);
+        resolve(library, "AImageDecoder_setUnpremultipliedRequired", result.setUnpremultipliedRequired);
+        resolve(library, "AImageDecoder_setTargetSize", result.setTargetSize);
+        resolve(library, "AImageDecoder_getHeaderInfo", result.getHeaderInfo);
+        resolve(library, "AImageDecoderHeaderInfo_getWidth", result.getWidth);
+        resolve(library, "AImageDecoderHeaderInfo_getHeight", result.getHeight);
+        resolve(library, "AImageDecoder_decodeImage", result.decodeImage);
+        if (!result.isValid())
+        {
+            LOG("AImageDecoder is not available, images are decoded by the platform");
+            result = DecoderFunctions();
+        }
+        return result;
+    }();
+    return functions;
+}
+
+/// Reverse the order of the rows in place
+void
+flipRows(unsigned char* pixels, size_t rowSize, int height)
+{
+    std::vector<unsigned char> row(rowSize);
+    for (int top = 0, bottom = height - 1; top < bottom; ++top, --bottom)
+    {
+        unsigned char* topRow = pixels + top * rowSize;
+        unsigned char* bottomRow = pixels + bottom * rowSize;
+        memcpy(row.data(), topRow, rowSize);
+        memcpy(topRow, bottomRow, rowSize);
+        memcpy(bottomRow, row.data(), rowSize);
+    }
+}
+
+
+/// Decode the image of a decoder created from an asset or a buffer, see ImageDecoder::decodeScaled
+bool
+decodeImage(const DecoderFunctions& functions, AImageDecoder* decoder, DecodedImage& image, int downscale, int width, int height)
+{
+    if (functions.setAndroidBitmapFormat(decoder, BITMAP_FORMAT_RGBA_8888) != IMAGE_DECODER_SUCCESS ||
+        // GL blends with straight alpha, the same as the pixels read by Texture.kt
+        functions.setUnpremultipliedRequired(decoder, true) != IMAGE_DECODER_SUCCESS)
+    {
+        return false;
+    }
+
+    const AImageDecoderHeaderInfo* info = functions.getHeaderInfo(decoder);
+    image.width = functions.getWidth(info);
+    image.height = functions.getHeight(info);
+    if (width <= 0 && downscale > 1)
+    {
+        width = std::max(image.width / downscale, 1);
+        height = std::max(image.height / downscale, 1);
+    }
+    if (width > 0 && (width != image.width || height != image.height) &&
+        functions.setTargetSize(decoder, width, height) == IMAGE_DECODER_SUCCESS)
+    {
+        image.width = width;
+        image.height = height;
+    }
+
+    size_t rowSize = static_cast<size_t>(image.width) * 4;
+    image.pixels.resize(rowSize * image.height);
+    if (functions.decodeImage(decoder, image.pixels.data(), rowSize, image.pixels.size()) != IMAGE_DECODER_SUCCESS)
+    {
+        return false;
+    }
+    flipRows(image.pixels.data(), rowSize, image.height);
+    return true;
+}
+
+} // anonymous namespace
+
+
+bool
+ImageDecoder::isAvailable()
+{
+    return getDecoderFunctions().isValid();
+}
+
+
+bool
+ImageDecoder::decode(AAssetManager* assetManager, const char* filename, DecodedImage& image, int downscale)
+{
+    return decodeScaled(assetManager, filename, image, downscale, 0, 0);
+}
+
+
+bool
+ImageDecoder::decodeToSize(AAssetManager* assetManager, const char* filename, DecodedImage& image, int width, int height)
+{
+    return decodeScaled(assetManager, filename, image, 1, width, height);
+}
+
+
+bool
+ImageDecoder::decodeScaled(AAssetManager* assetManager, const char* filename, DecodedImage& image, int downscale, int width,
+                           int height)
+{
+    const DecoderFunctions& functions = getDecoderFunctions();
+    if (!functions.isValid())
+    {
+        return false;
+    }
+
+    AAsset* asset = AAssetManager_open(assetManager, filename, AASSET_MODE_STREAMING);
+    if (asset == nullptr)
+    {
+        LOG("Error opening image asset %s", filename);
+        return false;
+    }
+
+    AImageDecoder* decoder = nullptr;
+    bool success = functions.createFromAAsset(asset, &decoder) == IMAGE_DECODER_SUCCESS &&
+                   decodeImage(functions, decoder, image, downscale, width, height);
+
+    if (decoder != nullptr)
+    {
+        functions.destroy(decoder);
+    }
+    AAsset_close(asset);
+
+    if (!success)
+    {
+        LOG("Error decoding image asset %s", filename);
+        image = DecodedImage();
+    }
+    return success;
+}
+
+
+bool
+ImageDecoder::decodeBuffer(const void* data, size_t size, const char* name, DecodedImage& image, int downscale)
+{
+    const DecoderFunctions& functions = getDecoderFunctions();
+    if (!functions.isValid())
+    {
+        return false;
+    }
+
+    // The decoder reads from the buffer while decoding, it must stay alive until the decoder is deleted
+    AImageDecoder* decoder = nullptr;
+    bool success = functions.createFromBuffer(data, size, &decoder) == IMAGE_DECODER_SUCCESS &&
+                   decodeImage(functions, decoder, image, downscale, 0, 0);
+    if (decoder != nullptr)
+    {
+        functions.destroy(decoder);
+    }
+
+    if (!success)
+    {
+        LOG("Error decoding image %s", name);
+        image = DecodedImage();
+    }
+    return success;
+}
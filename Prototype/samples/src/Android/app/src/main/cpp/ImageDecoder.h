@@ -0,0 +1,61 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_IMAGEDECODER_H_
+#define _VUFORIA_IMAGEDECODER_H_
+
+#include <android/asset_manager.h>
+
+#include <cstddef>
+#include <vector>
+
+
+/// Decoded image owned by the app, ready to be uploaded as a GL_RGBA texture
+struct DecodedImage
+{
+    int width = 0;
+    int height = 0;
+    /// Tightly packed unpremultiplied RGBA8 pixels, rows stored bottom-up as GL expects them
+    std::vector<unsigned char> pixels;
+};
+
+
+/// Decoding of JPEG and PNG assets in native code with the NDK AImageDecoder
+/**
+ * The image is decoded straight from the asset into a buffer owned by the caller, without
+ * going through the Java heap. AImageDecoder is only available from Android 11 (API level 30),
+ * it is looked up at runtime so that the app still runs on older devices, where isAvailable
+ * returns false and the platform has to decode the image instead.
+ */
+class ImageDecoder
+{
+public:
+    /// Check whether the NDK decoder can be used on this device
+    static bool isAvailable();
+
+    /// Decode an image asset
+    /// The image is decoded at 1/downscale of its size in each direction, which is cheaper than
+    /// decoding at full size and resizing afterwards.
+    /// This method is safe to call from any thread.
+    static bool decode(AAssetManager* assetManager, const char* filename, DecodedImage& image, int downscale = 1);
+
+    /// Decode an image asset scaled to exactly width x height, ignoring its aspect ratio
+    /// Used for images going into a texture array, whose layers all have the same size.
+    /// This method is safe to call from any thread.
+    static bool decodeToSize(AAssetManager* assetManager, const char* filename, DecodedImage& image, int width, int height);
+
+    /// Decode an image file held in memory, e.g. downloaded content, like decode
+    /// name is only used in log messages. This method is safe to call from any thread.
+    static bool decodeBuffer(const void* data, size_t size, const char* name, DecodedImage& image, int downscale = 1);
+
+private:
+    /// Decode at the given size, or at 1/downscale of the image size if width is 0
+    static bool decodeScaled(AAssetManager* assetManager, const char* filename, DecodedImage& image, int downscale, int width,
+                             int height);
+};
+
+#endif // _VUFORIA_IMAGEDECODER_H_
@@ -0,0 +1,294 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "ProgramCache.h"
+
+#include <Log.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+
+namespace
+{
+/// "VPBC", followed by the version of the file layout
+constexpr uint32_t FILE_MAGIC = 0x43425056;
+constexpr uint32_t FILE_VERSION = 1;
+
+/// Start of a cache file, followed by the uniforms and the program binary
+struct FileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t binaryFormat;
+    uint32_t binaryLength;
+    uint32_t uniformCount;
+};
+
+/// Written for every uniform, followed by its name without terminator
+struct FileUniform
+{
+    int32_t location;
+    uint32_t nameLength;
+};
+
+using UniformLocations = std::unordered_map<std::string, GLint>;
+
+std::mutex gDirectoryMutex;
+std::string gDirectory;
+
+/// Uniform locations per program created by load or passed to store, replaced when a program name is reused
+std::unordered_map<GLuint, UniformLocations> gUniformLocations;
+
+
+/// 64-bit FNV-1a, continuing from hash
+uint64_t
+hashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull)
+{
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+
+uint64_t
+hashString(const char* string, uint64_t hash)
+{
+    // The terminator separates consecutive strings
+    return string != nullptr ? hashBytes(string, strlen(string) + 1, hash) : hashBytes("", 1, hash);
+}
+
+
+uint64_t
+computeKey(const char* vertexShaderSource, const char* fragmentShaderSource)
+{
+    uint64_t key = hashString(vertexShaderSource, 0xcbf29ce484222325ull);
+    key = hashString(fragmentShaderSource, key);
+    key = hashString(reinterpret_cast<const char*>(glGetString(GL_VENDOR)), key);
+    key = hashString(reinterpret_cast<const char*>(glGetString(GL_RENDERER)), key);
+    key = hashString(reinterpret_cast<const char*>(glGetString(GL_VERSION)), key);
+    return key;
+}
+
+
+/// Path of the cache file for a key, empty if the cache is disabled
+std::string
+getPath(uint64_t key)
+{
+    std::lock_guard<std::mutex> lock(gDirectoryMutex);
+    if (gDirectory.empty())
+    {
+        return std::string();
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "/program_%016" PRIx64 ".bin", key);
+    return gDirectory + name;
+}
+
+
+bool
+hasBinaryFormats()
+{
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    return formatCount > 0;
+}
+
+
+UniformLocations
+queryUniformLocations(GLuint program)
+{
+    UniformLocations locations;
+    GLint uniformCount = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    std::vector<char> name(static_cast<size_t>(std::max(maxNameLength, 1)));
+    for (GLint i = 0; i < uniformCount; ++i)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+        std::string uniformName(name.data(), static_cast<size_t>(length));
+        locations[uniformName] = glGetUniformLocation(program, uniformName.c_str());
+    }
+    return locations;
+}
+
+
+bool
+readFile(const std::string& path, std::vector<unsigned char>& contents)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    bool success = fseek(file, 0, SEEK_END) == 0;
+    long size = success ? ftell(file) : -1;
+    success = size > 0 && fseek(file, 0, SEEK_SET) == 0;
+    if (success)
+    {
+        contents.resize(static_cast<size_t>(size));
+        success = fread(contents.data(), 1, contents.size(), file) == contents.size();
+    }
+    fclose(file);
+    return success;
+}
+
+} // anonymous namespace
+
+
+void
+ProgramCache::setDirectory(const std::string& directory)
+{
+    std::lock_guard<std::mutex> lock(gDirectoryMutex);
+    gDirectory = directory;
+}
+
+
+GLuint
+ProgramCache::load(const char* vertexShaderSource, const char* fragmentShaderSource)
+{
+    uint64_t key = computeKey(vertexShaderSource, fragmentShaderSource);
+    std::string path = getPath(key);
+    std::vector<unsigned char> contents;
+    if (path.empty() || !hasBinaryFormats() || !readFile(path, contents))
+    {
+        return 0;
+    }
+
+    // Check the layout before trusting any length read from the file
+    FileHeader header;
+    if (contents.size() < sizeof(header))
+    {
+        return 0;
+    }
+    memcpy(&header, contents.data(), sizeof(header));
+    if (header.magic != FILE_MAGIC || header.version != FILE_VERSION || header.key != key)
+    {
+        return 0;
+    }
+
+    UniformLocations locations;
+    size_t offset = sizeof(header);
+    for (uint32_t i = 0; i < header.uniformCount; ++i)
+    {
+        FileUniform uniform;
+        if (contents.size() - offset < sizeof(uniform))
+        {
+            return 0;
+        }
+        memcpy(&uniform, contents.data() + offset, sizeof(uniform));
+        offset += sizeof(uniform);
+        if (contents.size() - offset < uniform.nameLength)
+        {
+            return 0;
+        }
+        locations[std::string(reinterpret_cast<const char*>(contents.data() + offset), uniform.nameLength)] = uniform.location;
+        offset += uniform.nameLength;
+    }
+    if (contents.size() - offset != header.binaryLength)
+    {
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.binaryFormat, contents.data() + offset, static_cast<GLsizei>(header.binaryLength));
+    GLint linkStatus = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+    if (linkStatus != GL_TRUE)
+    {
+        // Usually a driver update the version string did not reveal, the binary is written again
+        LOG("Program binary %s rejected by the driver", path.c_str());
+        glDeleteProgram(program);
+        // Clear the error of a rejected format
+        glGetError();
+        return 0;
+    }
+
+    gUniformLocations[program] = std::move(locations);
+    return program;
+}
+
+
+void
+ProgramCache::store(GLuint program, const char* vertexShaderSource, const char* fragmentShaderSource)
+{
+    UniformLocations locations = queryUniformLocations(program);
+
+    uint64_t key = computeKey(vertexShaderSource, fragmentShaderSource);
+    std::string path = getPath(key);
+    GLint binaryLength = 0;
+    if (!path.empty() && hasBinaryFormats())
+    {
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    }
+    if (binaryLength <= 0)
+    {
+        gUniformLocations[program] = std::move(locations);
+        return;
+    }
+
+    std::vector<unsigned char> binary(static_cast<size_t>(binaryLength));
+    GLenum binaryFormat = 0;
+    GLsizei length = 0;
+    glGetProgramBinary(program, binaryLength, &length, &binaryFormat, binary.data());
+
+    FileHeader header{ FILE_MAGIC, FILE_VERSION, key, binaryFormat, static_cast<uint32_t>(length),
+                       static_cast<uint32_t>(locations.size()) };
+    std::vector<unsigned char> contents(reinterpret_cast<unsigned char*>(&header), reinterpret_cast<unsigned char*>(&header + 1));
+    for (const auto& location : locations)
+    {
+        FileUniform uniform{ location.second, static_cast<uint32_t>(location.first.size()) };
+        contents.insert(contents.end(), reinterpret_cast<unsigned char*>(&uniform), reinterpret_cast<unsigned char*>(&uniform + 1));
+        contents.insert(contents.end(), location.first.begin(), location.first.end());
+    }
+    contents.insert(contents.end(), binary.begin(), binary.begin() + length);
+    gUniformLocations[program] = std::move(locations);
+
+    // Written under a temporary name so that a crash never leaves a truncated binary behind
+    std::string temporaryPath = path + ".tmp";
+    FILE* file = fopen(temporaryPath.c_str(), "wb");
+    if (file == nullptr)
+    {
+        LOG("Error writing program binary %s", temporaryPath.c_str());
+        return;
+    }
+    bool written = fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+    written = fclose(file) == 0 && written;
+    if (!written || rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        LOG("Error writing program binary %s", path.c_str());
+        remove(temporaryPath.c_str());
+    }
+}
+
+
+GLint
+ProgramCache::getUniformLocation(GLuint program, const char* name)
+{
+    UniformLocations& locations = gUniformLocations[program];
+    auto it = locations.find(name);
+    if (it == locations.end())
+    {
+        it = locations.emplace(name, glGetUniformLocation(program, name)).first;
+    }
+    return it->second;
+}
@@ -0,0 +1,46 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_PROGRAMCACHE_H_
+#define _VUFORIA_PROGRAMCACHE_H_
+
+#include <GLES3/gl31.h>
+
+#include <string>
+
+
+/// Linked programs kept as driver binaries on disk, so that a new GL context does not compile them again
+/**
+ * A binary is stored per pair of shader sources, keyed by a hash of the sources and of the
+ * GL vendor, renderer and version strings, so a driver update makes the old binaries unused.
+ * The uniform locations of the program are stored with the binary and returned by
+ * getUniformLocation without asking the driver.
+ * Drivers may reject a binary they wrote earlier, load then fails and the caller compiles the
+ * program from source again, storing a fresh binary.
+ * All methods except setDirectory must be called on the rendering thread with a current GL context.
+ */
+class ProgramCache
+{
+public:
+    /// Set the directory the binaries are kept in, usually the cache directory of the app
+    /// An empty directory disables the cache.
+    static void setDirectory(const std::string& directory);
+
+    /// Create a program from the binary stored for a pair of shader sources
+    /// Returns 0 if there is no binary or the driver rejects it.
+    static GLuint load(const char* vertexShaderSource, const char* fragmentShaderSource);
+
+    /// Store the binary of a program linked from a pair of shader sources
+    /// The program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+    static void store(GLuint program, const char* vertexShaderSource, const char* fragmentShaderSource);
+
+    /// Location of a uniform of a program created by load or passed to store
+    /// Names not known for the program are resolved with glGetUniformLocation and remembered.
+    static GLint getUniformLocation(GLuint program, const char* name);
+};
+
+#endif // _VUFORIA_PROGRAMCACHE_H_
@@ -0,0 +1,88 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "RenderTarget.h"
+
+#include <Log.h>
+
+
+bool
+RenderTarget::create(GLsizei width, GLsizei height)
+{
+    destroy();
+
+    glGenTextures(1, &mColorTexture);
+    glBindTexture(GL_TEXTURE_2D, mColorTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+    // Upscaled when composited
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &mDepthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, mDepthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &mFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mColorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepthBuffer);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        LOG("Error: Offscreen framebuffer of %dx%d incomplete, status 0x%x", width, height, status);
+        destroy();
+        return false;
+    }
+
+    mWidth = width;
+    mHeight = height;
+    return true;
+}
+
+
+void
+RenderTarget::destroy()
+{
+    if (mFramebuffer != 0)
+    {
+        glDeleteFramebuffers(1, &mFramebuffer);
+    }
+    if (mColorTexture != 0)
+    {
+        glDeleteTextures(1, &mColorTexture);
+    }
+    if (mDepthBuffer != 0)
+    {
+        glDeleteRenderbuffers(1, &mDepthBuffer);
+    }
+    forget();
+}
+
+
+void
+RenderTarget::forget()
+{
+    mFramebuffer = 0;
+    mColorTexture = 0;
+    mDepthBuffer = 0;
+    mWidth = 0;
+    mHeight = 0;
+}
+
+
+void
+RenderTarget::discardDepth()
+{
+    const GLenum attachment = GL_DEPTH_ATTACHMENT;
+    glInvalidateFramebuffer(GL_FRAMEBUFFER, 1, &attachment);
+}
@@ -0,0 +1,63 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_RENDERTARGET_H_
+#define _VUFORIA_RENDERTARGET_H_
+
+#include <GLES3/gl31.h>
+
+#include <cstddef>
+
+
+/// Offscreen framebuffer with an RGBA8 color texture and a depth buffer
+/**
+ * Passes rendering at a reduced resolution draw into the lower left part of the target and
+ * sample that part when compositing, so that changing the resolution needs no reallocation.
+ * All methods must be called on the rendering thread with a current GL context.
+ */
+class RenderTarget
+{
+public:
+    RenderTarget() = default;
+    /// The GL objects are not freed on destruction, call destroy on the rendering thread
+    ~RenderTarget() = default;
+
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    /// Allocate the framebuffer, any previous one is deleted
+    /// Returns false if the framebuffer is not complete on this GPU.
+    bool create(GLsizei width, GLsizei height);
+
+    /// Free the GL objects
+    void destroy();
+
+    /// Drop the GL object handles without deleting them, used after the GL context was lost
+    void forget();
+
+    bool isValid() const { return mFramebuffer != 0; }
+
+    /// Tell the driver the depth buffer content is not needed any more
+    /// Call with the framebuffer bound once the pass is drawn, tile-based GPUs then skip writing it to memory.
+    static void discardDepth();
+
+    GLuint getFramebuffer() const { return mFramebuffer; }
+    GLuint getTexture() const { return mColorTexture; }
+    GLsizei getWidth() const { return mWidth; }
+    GLsizei getHeight() const { return mHeight; }
+    /// GPU memory of the color texture and depth buffer, drivers store 24 bit depth in 4 bytes
+    size_t getSizeBytes() const { return static_cast<size_t>(mWidth) * mHeight * 8; }
+
+private:
+    GLuint mFramebuffer = 0;
+    GLuint mColorTexture = 0;
+    GLuint mDepthBuffer = 0;
+    GLsizei mWidth = 0;
+    GLsizei mHeight = 0;
+};
+
+#endif // _VUFORIA_RENDERTARGET_H_
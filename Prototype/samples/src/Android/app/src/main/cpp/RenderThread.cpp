@@ -0,0 +1,394 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "RenderThread.h"
+
+#include <Log.h>
+
+#include <EGL/eglext.h>
+#include <android/native_window.h>
+
+#include <chrono>
+#include <future>
+
+
+namespace
+{
+/// How long the loop waits for commands after a frame in which nothing was drawn, e.g. before AR started
+constexpr std::chrono::milliseconds IDLE_INTERVAL{ 10 };
+}
+
+
+RenderThread::~RenderThread()
+{
+    stop();
+}
+
+
+bool
+RenderThread::start(JavaVM* vm, Callbacks callbacks, int swapInterval)
+{
+    if (isRunning())
+    {
+        return true;
+    }
+
+    mVm = vm;
+    mCallbacks = std::move(callbacks);
+    mSwapInterval = swapInterval;
+    mStopRequested = false;
+
+    // The context has to be created on the thread it is used on, start returns once that is done
+    std::promise<bool> created;
+    std::future<bool> result = created.get_future();
+    mThread = std::thread([this, &created]() {
+        JNIEnv* env = nullptr;
+        JavaVMAttachArgs attachArgs{ JNI_VERSION_1_6, "VuforiaRender", nullptr };
+        bool attached = mVm != nullptr && mVm->AttachCurrentThread(&env, &attachArgs) == JNI_OK;
+
+        bool contextCreated = createContext();
+        created.set_value(contextCreated);
+        if (contextCreated)
+        {
+            run();
+        }
+        destroyContext();
+
+        if (attached)
+        {
+            mVm->DetachCurrentThread();
+        }
+    });
+
+    if (!result.get())
+    {
+        mThread.join();
+        return false;
+    }
+    return true;
+}
+
+
+void
+RenderThread::stop()
+{
+    if (!isRunning())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopRequested = true;
+    }
+    mCondition.notify_one();
+    mThread.join();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCommands.clear();
+}
+
+
+void
+RenderThread::setWindow(ANativeWindow* window)
+{
+    post([this, window]() {
+        if (mWindow != nullptr)
+        {
+            eglMakeCurrent(mDisplay, mPbufferSurface, mPbufferSurface, mContext);
+            eglDestroySurface(mDisplay, mWindowSurface);
+            mWindowSurface = EGL_NO_SURFACE;
+            ANativeWindow_release(mWindow);
+        }
+        mWindow = window;
+
+        // The buffers of the window have to match the format of the config
+        EGLint format = 0;
+        eglGetConfigAttrib(mDisplay, mConfig, EGL_NATIVE_VISUAL_ID, &format);
+        ANativeWindow_setBuffersGeometry(mWindow, 0, 0, format);
+        mWindowSurface = eglCreateWindowSurface(mDisplay, mConfig, mWindow, nullptr);
+        if (mWindowSurface == EGL_NO_SURFACE)
+        {
+            LOG("Error: Failed to create the window surface, EGL error 0x%x", eglGetError());
+        }
+        makeCurrent();
+    });
+}
+
+
+void
+RenderThread::releaseWindow()
+{
+    auto release = [this]() {
+        if (mWindow == nullptr)
+        {
+            return;
+        }
+        eglMakeCurrent(mDisplay, mPbufferSurface, mPbufferSurface, mContext);
+        if (mWindowSurface != EGL_NO_SURFACE)
+        {
+            eglDestroySurface(mDisplay, mWindowSurface);
+            mWindowSurface = EGL_NO_SURFACE;
+        }
+        ANativeWindow_release(mWindow);
+        mWindow = nullptr;
+    };
+    if (!isRunning())
+    {
+        release();
+        return;
+    }
+
+    std::promise<void> released;
+    std::future<void> result = released.get_future();
+    post([&release, &released]() {
+        release();
+        released.set_value();
+    });
+    result.wait();
+}
+
+
+void
+RenderThread::setConfiguration(int width, int height, int orientation, int rotation)
+{
+    post([this, width, height, orientation, rotation]() {
+        mWidth = width;
+        mHeight = height;
+        mOrientation = orientation;
+        mRotation = rotation;
+        mConfigurationPending = true;
+    });
+}
+
+
+void
+RenderThread::setPaused(bool paused)
+{
+    if (!paused || !isRunning())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mPaused = paused;
+        }
+        mCondition.notify_one();
+        return;
+    }
+
+    // Commands run between frames, so no frame is in progress once this one ran
+    std::promise<void> pausedPromise;
+    std::future<void> result = pausedPromise.get_future();
+    post([this, &pausedPromise]() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mPaused = true;
+        }
+        pausedPromise.set_value();
+    });
+    result.wait();
+}
+
+
+void
+RenderThread::setRenderOnRequest(bool renderOnRequest)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRenderOnRequest = renderOnRequest;
+        mFrameRequested = false;
+    }
+    mCondition.notify_one();
+}
+
+
+void
+RenderThread::requestFrame()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFrameRequested = true;
+    }
+    mCondition.notify_one();
+}
+
+
+void
+RenderThread::post(std::function<void()> command)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCommands.push_back(std::move(command));
+    }
+    mCondition.notify_one();
+}
+
+
+bool
+RenderThread::createContext()
+{
+    mDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (mDisplay == EGL_NO_DISPLAY || eglInitialize(mDisplay, nullptr, nullptr) != EGL_TRUE)
+    {
+        LOG("Error: Failed to initialize the EGL display");
+        mDisplay = EGL_NO_DISPLAY;
+        return false;
+    }
+
+    // The same as the default of GLSurfaceView, RGB_888 with a 16 bit depth buffer, for windows and the pbuffer
+    const EGLint configAttributes[] = { EGL_RENDERABLE_TYPE,
+                                        EGL_OPENGL_ES3_BIT_KHR,
+                                        EGL_SURFACE_TYPE,
+                                        EGL_WINDOW_BIT | EGL_PBUFFER_BIT,
+                                        EGL_RED_SIZE,
+                                        8,
+                                        EGL_GREEN_SIZE,
+                                        8,
+                                        EGL_BLUE_SIZE,
+                                        8,
+                                        EGL_DEPTH_SIZE,
+                                        16,
+                                        EGL_NONE };
+    EGLint configCount = 0;
+    if (eglChooseConfig(mDisplay, configAttributes, &mConfig, 1, &configCount) != EGL_TRUE || configCount == 0)
+    {
+        LOG("Error: No EGL config for OpenGL ES 3");
+        return false;
+    }
+
+    const EGLint contextAttributes[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE };
+    mContext = eglCreateContext(mDisplay, mConfig, EGL_NO_CONTEXT, contextAttributes);
+    if (mContext == EGL_NO_CONTEXT)
+    {
+        LOG("Error: Failed to create the OpenGL ES 3 context, EGL error 0x%x", eglGetError());
+        return false;
+    }
+
+    const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    mPbufferSurface = eglCreatePbufferSurface(mDisplay, mConfig, pbufferAttributes);
+    if (mPbufferSurface == EGL_NO_SURFACE)
+    {
+        LOG("Error: Failed to create the pbuffer surface, EGL error 0x%x", eglGetError());
+        return false;
+    }
+    return makeCurrent();
+}
+
+
+void
+RenderThread::destroyContext()
+{
+    if (mDisplay == EGL_NO_DISPLAY)
+    {
+        return;
+    }
+    eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (mWindowSurface != EGL_NO_SURFACE)
+    {
+        eglDestroySurface(mDisplay, mWindowSurface);
+        mWindowSurface = EGL_NO_SURFACE;
+    }
+    if (mWindow != nullptr)
+    {
+        ANativeWindow_release(mWindow);
+        mWindow = nullptr;
+    }
+    if (mPbufferSurface != EGL_NO_SURFACE)
+    {
+        eglDestroySurface(mDisplay, mPbufferSurface);
+        mPbufferSurface = EGL_NO_SURFACE;
+    }
+    if (mContext != EGL_NO_CONTEXT)
+    {
+        eglDestroyContext(mDisplay, mContext);
+        mContext = EGL_NO_CONTEXT;
+    }
+    eglTerminate(mDisplay);
+    eglReleaseThread();
+    mDisplay = EGL_NO_DISPLAY;
+    mConfig = nullptr;
+}
+
+
+bool
+RenderThread::makeCurrent()
+{
+    EGLSurface surface = mWindowSurface != EGL_NO_SURFACE ? mWindowSurface : mPbufferSurface;
+    if (eglMakeCurrent(mDisplay, surface, surface, mContext) != EGL_TRUE)
+    {
+        LOG("Error: Failed to make the context current, EGL error 0x%x", eglGetError());
+        return false;
+    }
+    // The swap interval belongs to the surface that is current
+    if (surface == mWindowSurface && eglSwapInterval(mDisplay, mSwapInterval) != EGL_TRUE)
+    {
+        LOG("Failed to set the swap interval to %d", mSwapInterval);
+    }
+    return true;
+}
+
+
+void
+RenderThread::run()
+{
+    mCallbacks.init();
+    while (waitForWork())
+    {
+        renderFrame();
+    }
+    // A window the activity did not release yet is still current, the GL resources go first
+    mCallbacks.deinit();
+}
+
+
+bool
+RenderThread::waitForWork()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    for (;;)
+    {
+        while (!mCommands.empty())
+        {
+            std::function<void()> command = std::move(mCommands.front());
+            mCommands.pop_front();
+            lock.unlock();
+            command();
+            lock.lock();
+        }
+        if (mStopRequested)
+        {
+            return false;
+        }
+        if (mWindowSurface != EGL_NO_SURFACE && !mPaused && (!mRenderOnRequest || mFrameRequested))
+        {
+            mFrameRequested = false;
+            return true;
+        }
+        mCondition.wait(lock);
+    }
+}
+
+
+void
+RenderThread::renderFrame()
+{
+    if (mConfigurationPending)
+    {
+        mConfigurationPending = !mCallbacks.configure(mWidth, mHeight, mOrientation, mRotation);
+    }
+
+    if (mCallbacks.render())
+    {
+        if (eglSwapBuffers(mDisplay, mWindowSurface) != EGL_TRUE)
+        {
+            LOG("Error: Failed to swap buffers, EGL error 0x%x", eglGetError());
+        }
+        return;
+    }
+
+    // Nothing to show yet, don't spin until there is
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait_for(lock, IDLE_INTERVAL, [this]() { return !mCommands.empty() || mStopRequested; });
+}
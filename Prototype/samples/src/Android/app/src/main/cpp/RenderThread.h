@@ -0,0 +1,127 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_RENDERTHREAD_H_
+#define _VUFORIA_RENDERTHREAD_H_
+
+#include <EGL/egl.h>
+#include <jni.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+
+struct ANativeWindow;
+
+/// Render loop on a thread of its own, with its own EGL context on an ANativeWindow
+/**
+ * The alternative to rendering from a GLSurfaceView: the activity only passes the Surface of a
+ * SurfaceView and its lifecycle events, everything else happens on this thread without crossing JNI
+ * per frame. Every call from other threads is a command queued for the render thread, which runs
+ * them before the next frame with the context current.
+ * The context lives from start to stop and is kept across the loss of the window, so GL resources
+ * survive the activity going to the background. Without a window it is current on a small pbuffer.
+ * The thread is attached to the JVM, so the callbacks may call into Java.
+ *
+ * Frames are rendered back to back, each swap waiting for the vsync unless the swap interval is 0, or
+ * only when requested with requestFrame once setRenderOnRequest is set, e.g. from frame pacing.
+ */
+class RenderThread
+{
+public:
+    struct Callbacks
+    {
+        /// The context is current for the first time
+        std::function<void()> init;
+        /// The window surface size or display orientation changed, returns false to be called again before the next frame
+        std::function<bool(int width, int height, int orientation, int rotation)> configure;
+        /// Render a frame into the window surface, returns false if nothing was drawn and no swap is needed
+        std::function<bool()> render;
+        /// The context is about to be destroyed
+        std::function<void()> deinit;
+    };
+
+    RenderThread() = default;
+    ~RenderThread();
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    /// Create the context and start the loop, returns false if EGL could not be set up
+    bool start(JavaVM* vm, Callbacks callbacks, int swapInterval);
+
+    /// Run the deinit callback, destroy the context and join the thread
+    void stop();
+
+    bool isRunning() const { return mThread.joinable(); }
+
+    /// Render into window from the next frame, takes over the reference of ANativeWindow_fromSurface
+    void setWindow(ANativeWindow* window);
+
+    /// Stop rendering into the window and release it, returns once the render thread no longer uses it
+    /// Called from SurfaceHolder.Callback.surfaceDestroyed, after which the Surface must not be used.
+    void releaseWindow();
+
+    /// The configure callback is called with these before the next frame
+    void setConfiguration(int width, int height, int orientation, int rotation);
+
+    /// Keep the loop waiting for commands while the activity is paused
+    /// Pausing returns once the frame in progress is finished, so that AR can be stopped afterwards.
+    void setPaused(bool paused);
+
+    /// Only render frames on requestFrame instead of back to back
+    void setRenderOnRequest(bool renderOnRequest);
+
+    /// Render the next frame in render-on-request mode, can be called on any thread
+    void requestFrame();
+
+    /// Run command on the render thread with the context current, before the next frame
+    void post(std::function<void()> command);
+
+private:
+    bool createContext();
+    void destroyContext();
+    /// Make the window surface current, or the pbuffer without a window
+    bool makeCurrent();
+
+    void run();
+    /// Wait for commands or a reason to render, runs the queued commands and returns false once stopped
+    bool waitForWork();
+    void renderFrame();
+
+    JavaVM* mVm = nullptr;
+    Callbacks mCallbacks;
+    int mSwapInterval = 1;
+    std::thread mThread;
+
+    /// Guards everything below up to the render thread state
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<std::function<void()>> mCommands;
+    bool mStopRequested = false;
+    bool mPaused = false;
+    bool mRenderOnRequest = false;
+    bool mFrameRequested = false;
+
+    /// Render thread
+    EGLDisplay mDisplay = EGL_NO_DISPLAY;
+    EGLConfig mConfig = nullptr;
+    EGLContext mContext = EGL_NO_CONTEXT;
+    EGLSurface mPbufferSurface = EGL_NO_SURFACE;
+    EGLSurface mWindowSurface = EGL_NO_SURFACE;
+    ANativeWindow* mWindow = nullptr;
+    bool mConfigurationPending = false;
+    int mWidth = 0;
+    int mHeight = 0;
+    int mOrientation = 0;
+    int mRotation = 0;
+};
+
+#endif // _VUFORIA_RENDERTHREAD_H_
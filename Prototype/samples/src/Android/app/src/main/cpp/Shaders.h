@@ -8,129 +8,263 @@ countries.
 #ifndef _VUFORIA_SHADERS_H_
 #define _VUFORIA_SHADERS_H_
 
+// All shaders are GLSL ES 3.00. The attribute locations are those of GLESUtils::ATTRIBUTE_*,
+// the uniform blocks those of GLESRenderer::FrameUniforms and GLESRenderer::DrawUniforms.
+// Block members are highp in every stage, as blocks shared by both stages must match.
+
+#define SHADER_VERSION_GLSL "#version 300 es\n"
+
+// Fragment shaders sampling model textures discard fragments below half alpha when compiled
+// with ALPHA_TEST defined, see GLESRenderer::BlendMode. Without it they never discard, which keeps
+// early depth testing available to the drivers.
+#define ALPHA_TEST_DEFINE_GLSL "#define ALPHA_TEST\n"
+
+// Model shaders compiled with SHADED defined multiply the texture color by the shade baked into
+// every vertex by VertexShadingBaker, read from GLESUtils::ATTRIBUTE_SHADE. Used for shaded meshes only.
+#define SHADED_DEFINE_GLSL "#define SHADED\n"
+
+// Plain string literals, raw strings cannot span lines in a macro. The blocks are set per frame and projection
+// and bound to GLESRenderer::FRAME_UNIFORMS_BINDING, and written for every draw and bound to DRAW_UNIFORMS_BINDING.
+// modelViewMatrix is applied before projectionMatrix, it is the whole transform for shaders not using FrameUniforms.
+// Shaders using FrameUniforms apply the instanceModelViewMatrix attribute between the two, see GpuMesh::drawInstanced.
+// Plain draws leave it at the identity, instanced draws put the shared part of the transform into modelViewMatrix.
+// texCoordTransform holds scale in xy and offset in zw, dequantizing the texture coordinates of quantized meshes.
+// drawParams holds the pseudo normal parameters, or the texture array layer in x.
+#define FRAME_UNIFORMS_GLSL                        \
+    "layout(std140) uniform FrameUniforms\n"       \
+    "{\n"                                          \
+    "    highp mat4 projectionMatrix;\n"           \
+    "};\n"
+
+#define DRAW_UNIFORMS_GLSL                         \
+    "layout(std140) uniform DrawUniforms\n"        \
+    "{\n"                                          \
+    "    highp mat4 modelViewMatrix;\n"            \
+    "    highp vec4 uniformColor;\n"               \
+    "    highp vec4 texCoordTransform;\n"          \
+    "    highp vec4 drawParams;\n"                 \
+    "};\n"
+
+
 /////////////////////////////////////////////////////////////////////////////////////////
-// texture shader: vertexTexCoord in vertex shader, texture2D sample
+// texture shader: vertexTexCoord in vertex shader, texture sample
+// used for the video background, modelViewMatrix is its whole transform
 /////////////////////////////////////////////////////////////////////////////////////////
-static const char* textureVertexShaderSrc = R"(
-    attribute vec4 vertexPosition;
-    attribute vec2 vertexTextureCoord;
-
-    uniform mat4 modelViewProjectionMatrix;
+static const char* textureVertexShaderSrc = SHADER_VERSION_GLSL DRAW_UNIFORMS_GLSL R"(
+    layout(location = 0) in vec4 vertexPosition;
+    layout(location = 1) in vec2 vertexTextureCoord;
 
-    varying vec2 texCoord;
+    out vec2 texCoord;
 
     void main()
     {
-        gl_Position = modelViewProjectionMatrix * vertexPosition;
+        gl_Position = modelViewMatrix * vertexPosition;
         texCoord = vertexTextureCoord;
     }
 )";
 
 
-static const char* textureFragmentShaderSrc = R"(
+static const char* textureFragmentShaderSrc = SHADER_VERSION_GLSL R"(
     precision mediump float;
 
     uniform sampler2D texSampler2D;
 
-    varying vec2 texCoord;
+    in vec2 texCoord;
+
+    out vec4 fragColor;
 
     void main()
     {
-        gl_FragColor = texture2D(texSampler2D, texCoord);
+        fragColor = texture(texSampler2D, texCoord);
     }
 )";
 
 
 /////////////////////////////////////////////////////////////////////////////////////////
-// texture color shader: vertexTexCoord in vertex shader, uniform color, texture2D sample
+// texture color shader: vertexTexCoord in vertex shader, uniform color, texture sample
 /////////////////////////////////////////////////////////////////////////////////////////
-static const char* textureColorVertexShaderSrc = R"(
-    attribute vec4 vertexPosition;
-    attribute vec2 vertexTextureCoord;
+static const char* textureColorVertexShaderSrc = SHADER_VERSION_GLSL FRAME_UNIFORMS_GLSL DRAW_UNIFORMS_GLSL R"(
+    layout(location = 0) in vec4 vertexPosition;
+    layout(location = 1) in vec2 vertexTextureCoord;
+    layout(location = 3) in mat4 instanceModelViewMatrix;
+    #ifdef SHADED
+    layout(location = 7) in float vertexShade;
 
-    uniform mat4 modelViewProjectionMatrix;
+    out float shade;
+    #endif
 
-    varying vec2 texCoord;
+    out vec2 texCoord;
 
     void main()
     {
-        gl_Position = modelViewProjectionMatrix * vertexPosition;
-        texCoord = vertexTextureCoord;
+        gl_Position = projectionMatrix * (instanceModelViewMatrix * (modelViewMatrix * vertexPosition));
+        texCoord = vertexTextureCoord * texCoordTransform.xy + texCoordTransform.zw;
+    #ifdef SHADED
+        shade = vertexShade;
+    #endif
     }
 )";
 
 
-static const char* textureColorFragmentShaderSrc = R"(
+static const char* textureColorFragmentShaderSrc = SHADER_VERSION_GLSL DRAW_UNIFORMS_GLSL R"(
     precision mediump float;
 
     uniform sampler2D texSampler2D;
 
-    varying vec2 texCoord;
+    in vec2 texCoord;
+    #ifdef SHADED
+    in float shade;
+    #endif
 
-    uniform vec4 uniformColor;
+    out vec4 fragColor;
 
     void main()
     {
-        vec4 texColor = texture2D(texSampler2D, texCoord);
-        gl_FragColor = texColor * uniformColor;
+        vec4 texColor = texture(texSampler2D, texCoord);
+    #ifdef ALPHA_TEST
+        if (texColor.a < 0.5)
+        {
+            discard;
+        }
+    #endif
+        fragColor = texColor * uniformColor;
+    #ifdef SHADED
+        fragColor.rgb *= shade;
+    #endif
     }
 )";
 
 
 /////////////////////////////////////////////////////////////////////////////////////////
-// uniform color shader: uniform color in frag shader
+// texture array shader: texture color shader sampling the layer drawParams.x of a
+// texture array, used with textureColorVertexShaderSrc
 /////////////////////////////////////////////////////////////////////////////////////////
-static const char* uniformColorVertexShaderSrc = R"(
-    attribute vec4 vertexPosition;
+static const char* textureArrayFragmentShaderSrc = SHADER_VERSION_GLSL DRAW_UNIFORMS_GLSL R"(
+    precision mediump float;
+    precision mediump sampler2DArray;
+
+    uniform sampler2DArray texSamplerArray;
+
+    in vec2 texCoord;
+    #ifdef SHADED
+    in float shade;
+    #endif
 
-    uniform mat4 modelViewProjectionMatrix;
+    out vec4 fragColor;
 
     void main()
     {
-        gl_Position = modelViewProjectionMatrix * vertexPosition;
+        vec4 texColor = texture(texSamplerArray, vec3(texCoord, drawParams.x));
+    #ifdef ALPHA_TEST
+        if (texColor.a < 0.5)
+        {
+            discard;
+        }
+    #endif
+        fragColor = texColor * uniformColor;
+    #ifdef SHADED
+        fragColor.rgb *= shade;
+    #endif
     }
 )";
 
 
-static const char* uniformColorFragmentShaderSrc = R"(
+/////////////////////////////////////////////////////////////////////////////////////////
+// pseudo normal shader: texture color shader with the pseudo normal mapping of
+// Py-textures-processor applied per fragment, used with textureColorVertexShaderSrc
+/////////////////////////////////////////////////////////////////////////////////////////
+static const char* pseudoNormalFragmentShaderSrc = SHADER_VERSION_GLSL DRAW_UNIFORMS_GLSL R"(
     precision mediump float;
 
-    uniform vec4 uniformColor;
+    uniform sampler2D texSampler2D;
+    // Luma of the normal map in the red channel, may have a lower resolution than the color
+    uniform sampler2D normalSampler2D;
+
+    in vec2 texCoord;
+    #ifdef SHADED
+    in float shade;
+    #endif
+
+    out vec4 fragColor;
+
+    const vec3 LUMA = vec3(0.299, 0.587, 0.114);
 
     void main()
     {
-        gl_FragColor = uniformColor;
+        // Color weight, HSV value offset and saturation factor in drawParams, see PseudoNormalBaker
+        vec4 texColor = texture(texSampler2D, texCoord);
+        float normalLuma = texture(normalSampler2D, texCoord).r;
+        vec3 color = min(texColor.rgb * drawParams.x + normalLuma, 1.0);
+
+        // Shifting the value keeps hue and saturation, so all channels scale with it
+        float value = max(max(color.r, color.g), color.b);
+        float newValue = clamp(value + drawParams.y, 0.0, 1.0);
+        color = value > 0.0 ? color * (newValue / value) : vec3(newValue);
+
+        float luma = dot(color, LUMA);
+        color = clamp(mix(vec3(luma), color, drawParams.z), 0.0, 1.0);
+        fragColor = vec4(color, texColor.a) * uniformColor;
+    #ifdef SHADED
+        fragColor.rgb *= shade;
+    #endif
     }
 )";
 
 
 /////////////////////////////////////////////////////////////////////////////////////////
-// vertex color shader: attribute color in vertex shader
+// uniform color shader: uniform color in frag shader
 /////////////////////////////////////////////////////////////////////////////////////////
-static const char* vertexColorVertexShaderSrc = R"(
-    attribute vec4 vertexPosition;
-    attribute vec4 vertexColor;
+static const char* uniformColorVertexShaderSrc = SHADER_VERSION_GLSL FRAME_UNIFORMS_GLSL DRAW_UNIFORMS_GLSL R"(
+    layout(location = 0) in vec4 vertexPosition;
+    layout(location = 3) in mat4 instanceModelViewMatrix;
+
+    void main()
+    {
+        gl_Position = projectionMatrix * (instanceModelViewMatrix * (modelViewMatrix * vertexPosition));
+    }
+)";
+
+
+static const char* uniformColorFragmentShaderSrc = SHADER_VERSION_GLSL DRAW_UNIFORMS_GLSL R"(
+    precision mediump float;
+
+    out vec4 fragColor;
+
+    void main()
+    {
+        fragColor = uniformColor;
+    }
+)";
 
-    uniform mat4 modelViewProjectionMatrix;
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// vertex color shader: attribute color in vertex shader
+/////////////////////////////////////////////////////////////////////////////////////////
+static const char* vertexColorVertexShaderSrc = SHADER_VERSION_GLSL FRAME_UNIFORMS_GLSL DRAW_UNIFORMS_GLSL R"(
+    layout(location = 0) in vec4 vertexPosition;
+    layout(location = 2) in vec4 vertexColor;
+    layout(location = 3) in mat4 instanceModelViewMatrix;
 
     // Color to use per vertex, linear interpolated down at fragment shader
-    varying vec4 color;
+    out vec4 color;
 
     void main()
     {
-        gl_Position = modelViewProjectionMatrix * vertexPosition;
+        gl_Position = projectionMatrix * (instanceModelViewMatrix * (modelViewMatrix * vertexPosition));
         color = vertexColor;
     }
 )";
 
-static const char* vertexColorFragmentShaderSrc = R"(
+static const char* vertexColorFragmentShaderSrc = SHADER_VERSION_GLSL R"(
     precision mediump float;
 
-    varying vec4 color;
+    in vec4 color;
+
+    out vec4 fragColor;
 
     void main()
     {
-        gl_FragColor = color;
+        fragColor = color;
     }
 )";
 
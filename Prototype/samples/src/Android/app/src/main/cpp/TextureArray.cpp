@@ -0,0 +1,142 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "TextureArray.h"
+
+#include <algorithm>
+
+
+bool
+TextureArray::create(GLsizei width, GLsizei height, GLsizei layerCount, const TextureOptions& options)
+{
+    destroy();
+
+    GLsizei levels = 1;
+    if (options.mipmaps)
+    {
+        for (GLsizei size = std::max(width, height); size > 1; size /= 2)
+        {
+            ++levels;
+        }
+    }
+
+    glGenTextures(1, &mTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mTexture);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, width, height, layerCount);
+    GLESUtils::applyTextureOptions(options, options.mipmaps, GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    if (glGetError() != GL_NO_ERROR)
+    {
+        LOG("Error: Cannot allocate %dx%d texture array with %d layers", width, height, layerCount);
+        destroy();
+        return false;
+    }
+
+    mWidth = width;
+    mHeight = height;
+    mOptions = options;
+    // Lowest layers first
+    for (int layer = layerCount - 1; layer >= 0; --layer)
+    {
+        mFreeLayers.push_back(layer);
+    }
+
+    LOG("Allocated %dx%d texture array with %d layers", width, height, layerCount);
+    return true;
+}
+
+
+void
+TextureArray::destroy()
+{
+    if (mTexture != 0)
+    {
+        glDeleteTextures(1, &mTexture);
+    }
+    forget();
+}
+
+
+void
+TextureArray::forget()
+{
+    mTexture = 0;
+    mWidth = 0;
+    mHeight = 0;
+    mLayers.clear();
+    mUnused.clear();
+    mFreeLayers.clear();
+}
+
+
+int
+TextureArray::acquire(const std::string& id)
+{
+    auto it = mLayers.find(id);
+    if (it == mLayers.end())
+    {
+        return -1;
+    }
+
+    Layer& layer = it->second;
+    if (layer.referenceCount++ == 0)
+    {
+        mUnused.erase(layer.unusedPosition);
+    }
+    return layer.index;
+}
+
+
+int
+TextureArray::allocate(const std::string& id)
+{
+    if (mLayers.count(id) != 0)
+    {
+        return acquire(id);
+    }
+
+    int index = -1;
+    if (!mFreeLayers.empty())
+    {
+        index = mFreeLayers.back();
+        mFreeLayers.pop_back();
+    }
+    else if (!mUnused.empty())
+    {
+        auto it = mLayers.find(mUnused.back());
+        mUnused.pop_back();
+        LOG("Texture array full, replacing %s in layer %d", it->first.c_str(), it->second.index);
+        index = it->second.index;
+        mLayers.erase(it);
+    }
+    else
+    {
+        return -1;
+    }
+
+    mLayers[id] = Layer{ index, 1, mUnused.end() };
+    return index;
+}
+
+
+void
+TextureArray::release(const std::string& id)
+{
+    auto it = mLayers.find(id);
+    if (it == mLayers.end() || it->second.referenceCount == 0)
+    {
+        return;
+    }
+
+    Layer& layer = it->second;
+    if (--layer.referenceCount == 0)
+    {
+        mUnused.push_front(id);
+        layer.unusedPosition = mUnused.begin();
+    }
+}
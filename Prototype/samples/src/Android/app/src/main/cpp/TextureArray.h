@@ -0,0 +1,92 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_TEXTUREARRAY_H_
+#define _VUFORIA_TEXTUREARRAY_H_
+
+#include "GLESUtils.h"
+
+#include <GLES3/gl31.h>
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+/// Same-sized RGBA8 images packed into the layers of one GL_TEXTURE_2D_ARRAY, keyed by asset name
+/**
+ * Models textured from the array share one texture binding and one program, the layer is a per-draw
+ * uniform, so consecutive draws only change uniforms and can later be batched or instanced.
+ * Layers are reference counted like the textures of TextureCache: a layer nobody refers to keeps its
+ * image until the layer is needed for another one, least recently released first.
+ * The storage is immutable, its layer count is fixed on create.
+ * All methods must be called on the rendering thread with a current GL context.
+ */
+class TextureArray
+{
+public:
+    TextureArray() = default;
+    /// The GL texture is not freed on destruction, call destroy on the rendering thread
+    ~TextureArray() = default;
+
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator=(const TextureArray&) = delete;
+
+    /// Allocate the storage for layerCount images of width x height, any previous storage is deleted
+    bool create(GLsizei width, GLsizei height, GLsizei layerCount, const TextureOptions& options);
+
+    /// Free the GL texture, every layer is dropped
+    void destroy();
+
+    /// Drop the GL texture handle and all layers without deleting them, used after the GL context was lost
+    void forget();
+
+    bool isValid() const { return mTexture != 0; }
+
+    /// Look up the layer holding an image and add a reference to it
+    /// Returns -1 if no layer holds the image.
+    int acquire(const std::string& id);
+
+    /// Reserve a layer for an image, the caller holds the first reference and writes the layer content
+    /*
+     * A free layer is used if there is one, otherwise the least recently released image is dropped.
+     * Returns -1 if every layer is referenced. If a layer is already reserved for the id,
+     * a reference to it is returned instead.
+     */
+    int allocate(const std::string& id);
+
+    /// Drop a reference taken with acquire or allocate
+    void release(const std::string& id);
+
+    GLuint getTexture() const { return mTexture; }
+    GLsizei getWidth() const { return mWidth; }
+    GLsizei getHeight() const { return mHeight; }
+    const TextureOptions& getOptions() const { return mOptions; }
+
+private:
+    struct Layer
+    {
+        int index;
+        int referenceCount;
+        /// Position in mUnused, only valid while referenceCount is 0
+        std::list<std::string>::iterator unusedPosition;
+    };
+
+    GLuint mTexture = 0;
+    GLsizei mWidth = 0;
+    GLsizei mHeight = 0;
+    TextureOptions mOptions;
+
+    std::unordered_map<std::string, Layer> mLayers;
+    /// Ids of the layers that are not referenced, most recently released first
+    std::list<std::string> mUnused;
+    /// Layers never written or whose image was dropped
+    std::vector<int> mFreeLayers;
+};
+
+#endif // _VUFORIA_TEXTUREARRAY_H_
@@ -0,0 +1,131 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "TextureCache.h"
+
+#include "GLESUtils.h"
+
+
+GLuint
+TextureCache::acquire(const std::string& id)
+{
+    auto it = mEntries.find(id);
+    if (it == mEntries.end())
+    {
+        return -1;
+    }
+
+    Entry& entry = it->second;
+    if (entry.referenceCount++ == 0)
+    {
+        mUnused.erase(entry.unusedPosition);
+    }
+    return entry.texture;
+}
+
+
+GLuint
+TextureCache::insert(const std::string& id, GLuint texture, size_t sizeBytes)
+{
+    if (mEntries.count(id) != 0)
+    {
+        GLESUtils::destroyTexture(texture);
+        return acquire(id);
+    }
+
+    mEntries[id] = Entry{ texture, sizeBytes, 1, mUnused.end() };
+    mSizeBytes += sizeBytes;
+    account(id, sizeBytes);
+    trim();
+    return texture;
+}
+
+
+void
+TextureCache::release(const std::string& id)
+{
+    auto it = mEntries.find(id);
+    if (it == mEntries.end() || it->second.referenceCount == 0)
+    {
+        return;
+    }
+
+    Entry& entry = it->second;
+    if (--entry.referenceCount == 0)
+    {
+        mUnused.push_front(id);
+        entry.unusedPosition = mUnused.begin();
+        trim();
+    }
+}
+
+
+void
+TextureCache::setBudget(size_t budgetBytes)
+{
+    mBudgetBytes = budgetBytes;
+    trim();
+}
+
+
+void
+TextureCache::clear()
+{
+    for (const auto& it : mEntries)
+    {
+        GLESUtils::destroyTexture(it.second.texture);
+    }
+    forget();
+}
+
+
+void
+TextureCache::forget()
+{
+    for (const auto& it : mEntries)
+    {
+        account(it.first, 0);
+    }
+    mEntries.clear();
+    mUnused.clear();
+    mSizeBytes = 0;
+}
+
+
+size_t
+TextureCache::estimateSize(int width, int height, int bytesPerPixel, bool mipmaps)
+{
+    size_t baseSize = static_cast<size_t>(width) * height * bytesPerPixel;
+    return mipmaps ? baseSize + baseSize / 3 : baseSize;
+}
+
+
+void
+TextureCache::trim()
+{
+    while (mSizeBytes > mBudgetBytes && !mUnused.empty())
+    {
+        auto it = mEntries.find(mUnused.back());
+        mUnused.pop_back();
+
+        LOG("Texture cache over budget, deleting %s (%zu KB)", it->first.c_str(), it->second.sizeBytes / 1024);
+        GLESUtils::destroyTexture(it->second.texture);
+        mSizeBytes -= it->second.sizeBytes;
+        account(it->first, 0);
+        mEntries.erase(it);
+    }
+}
+
+
+void
+TextureCache::account(const std::string& id, size_t sizeBytes)
+{
+    if (mMemoryAccounting != nullptr)
+    {
+        mMemoryAccounting->set(id, MemoryAccounting::Category::TEXTURE, MemoryAccounting::Pool::GPU, sizeBytes);
+    }
+}
@@ -0,0 +1,99 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_TEXTURECACHE_H_
+#define _VUFORIA_TEXTURECACHE_H_
+
+#include <GLES3/gl31.h>
+
+#include <MemoryAccounting.h>
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+
+/// Registry of the GL textures created from assets, keyed by asset name
+/**
+ * Every texture is reference counted. A texture nobody refers to any more is kept so that it
+ * can be picked up again without reloading, until the total size of all textures exceeds the
+ * budget. The least recently released textures are deleted first, textures still referenced
+ * are never deleted, so the budget can be exceeded while they are all in use.
+ * The GPU memory of each texture is reported to the MemoryAccounting set with setMemoryAccounting.
+ * All methods must be called on the rendering thread.
+ */
+class TextureCache
+{
+public:
+    /// Budget used until setBudget is called
+    static constexpr size_t DEFAULT_BUDGET_BYTES = 64u << 20;
+
+    TextureCache() = default;
+    /// The GL textures are not freed on destruction, call clear on the rendering thread
+    ~TextureCache() = default;
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    /// Look up a texture and add a reference to it
+    /// Returns -1 if there is no texture for the id.
+    GLuint acquire(const std::string& id);
+
+    /// Register a texture created by the caller, the caller holds the first reference
+    /*
+     * The cache takes ownership of the GL texture. If a texture is already registered for the id,
+     * the new one is deleted and a reference to the existing texture is returned instead.
+     * sizeBytes is the GPU memory used by the texture including its mip levels.
+     */
+    GLuint insert(const std::string& id, GLuint texture, size_t sizeBytes);
+
+    /// Drop a reference taken with acquire or insert
+    void release(const std::string& id);
+
+    /// Set the total size of textures to keep, unreferenced textures beyond it are deleted
+    void setBudget(size_t budgetBytes);
+
+    /// Report the textures to accounting from now on, nullptr to stop reporting
+    void setMemoryAccounting(MemoryAccounting* accounting) { mMemoryAccounting = accounting; }
+
+    /// Delete all textures, references still held become invalid
+    void clear();
+
+    /// Drop all textures without deleting them, used after the GL context was lost
+    void forget();
+
+    size_t getSizeBytes() const { return mSizeBytes; }
+
+    /// GPU memory used by an uncompressed texture, a full mip chain adds a third to the base level
+    static size_t estimateSize(int width, int height, int bytesPerPixel, bool mipmaps);
+
+private:
+    struct Entry
+    {
+        GLuint texture;
+        size_t sizeBytes;
+        int referenceCount;
+        /// Position in mUnused, only valid while referenceCount is 0
+        std::list<std::string>::iterator unusedPosition;
+    };
+
+    /// Delete unreferenced textures, least recently released first, until the budget is met
+    void trim();
+
+    void account(const std::string& id, size_t sizeBytes);
+
+    std::unordered_map<std::string, Entry> mEntries;
+    /// Ids of the textures that are not referenced, most recently released first
+    std::list<std::string> mUnused;
+
+    size_t mSizeBytes = 0;
+    size_t mBudgetBytes = DEFAULT_BUDGET_BYTES;
+    MemoryAccounting* mMemoryAccounting = nullptr;
+};
+
+#endif // _VUFORIA_TEXTURECACHE_H_
@@ -0,0 +1,272 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "TextureUploader.h"
+
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+
+namespace
+{
+int
+getBytesPerPixel(GLenum format)
+{
+    return format == GL_LUMINANCE ? 1 : 4;
+}
+
+int
+getLevelCount(int width, int height)
+{
+    int levels = 1;
+    for (int size = std::max(width, height); size > 1; size /= 2)
+    {
+        ++levels;
+    }
+    return levels;
+}
+
+} // anonymous namespace
+
+
+void
+TextureUploader::enqueue(const std::string& id, int width, int height, GLenum format, const TextureOptions& options,
+                         std::vector<unsigned char> pixels)
+{
+    if (isPending(id))
+    {
+        return;
+    }
+    if (width <= 0 || height <= 0 || pixels.size() < static_cast<size_t>(width) * height * getBytesPerPixel(format))
+    {
+        LOG("Error: Cannot upload texture %s, %zu bytes for %dx%d", id.c_str(), pixels.size(), width, height);
+        return;
+    }
+
+    Upload upload;
+    upload.id = id;
+    upload.width = width;
+    upload.height = height;
+    upload.format = format;
+    upload.options = options;
+    upload.pixels = std::move(pixels);
+    mUploads.push_back(std::move(upload));
+}
+
+
+void
+TextureUploader::enqueueLayer(const std::string& id, GLuint textureArray, int layer, int width, int height, bool mipmaps,
+                              std::vector<unsigned char> pixels)
+{
+    if (isPending(id))
+    {
+        return;
+    }
+    if (textureArray == 0 || layer < 0 || pixels.size() < static_cast<size_t>(width) * height * 4)
+    {
+        LOG("Error: Cannot upload texture %s into layer %d", id.c_str(), layer);
+        return;
+    }
+
+    Upload upload;
+    upload.id = id;
+    upload.width = width;
+    upload.height = height;
+    upload.format = GL_RGBA;
+    upload.options.mipmaps = mipmaps;
+    upload.pixels = std::move(pixels);
+    upload.texture = textureArray;
+    upload.layer = layer;
+    mUploads.push_back(std::move(upload));
+}
+
+
+bool
+TextureUploader::isPending(const std::string& id) const
+{
+    return std::any_of(mUploads.begin(), mUploads.end(), [&id](const Upload& upload) { return upload.id == id; });
+}
+
+
+void
+TextureUploader::process(std::vector<Finished>& finished)
+{
+    size_t budget = BYTES_PER_FRAME;
+    for (auto it = mUploads.begin(); it != mUploads.end();)
+    {
+        Upload& upload = *it;
+        if (upload.fence == nullptr && budget > 0)
+        {
+            if (upload.pixelBuffer == 0 && !allocate(upload))
+            {
+                LOG("Error: Cannot allocate texture %s", upload.id.c_str());
+                deleteObjects(upload);
+                it = mUploads.erase(it);
+                continue;
+            }
+
+            budget -= std::min(budget, submitRows(upload, budget));
+
+            if (upload.rowsSubmitted == upload.height)
+            {
+                if (upload.options.mipmaps)
+                {
+                    GLenum target = upload.layer >= 0 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+                    glBindTexture(target, upload.texture);
+                    glGenerateMipmap(target);
+                    glBindTexture(target, 0);
+                }
+                upload.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+                // The driver keeps the pixel buffer alive until the transfers reading it are done
+                glDeleteBuffers(1, &upload.pixelBuffer);
+                upload.pixelBuffer = 0;
+                std::vector<unsigned char>().swap(upload.pixels);
+            }
+        }
+
+        // Poll without waiting, the fence is flushed with the frame
+        if (upload.fence != nullptr)
+        {
+            GLenum status = glClientWaitSync(upload.fence, 0, 0);
+            if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+            {
+                glDeleteSync(upload.fence);
+                size_t sizeBytes = upload.layer >= 0 ? 0
+                                                     : TextureCache::estimateSize(upload.width, upload.height,
+                                                                                  getBytesPerPixel(upload.format), upload.options.mipmaps);
+                finished.push_back({ upload.id, upload.texture, sizeBytes, upload.layer });
+                it = mUploads.erase(it);
+                continue;
+            }
+        }
+        ++it;
+    }
+
+    GLESUtils::checkGlError("Process texture uploads");
+}
+
+
+void
+TextureUploader::destroy()
+{
+    for (auto& upload : mUploads)
+    {
+        deleteObjects(upload);
+    }
+    mUploads.clear();
+}
+
+
+void
+TextureUploader::forget()
+{
+    mUploads.clear();
+}
+
+
+bool
+TextureUploader::allocate(Upload& upload)
+{
+    if (upload.layer < 0)
+    {
+        bool luminance = upload.format == GL_LUMINANCE;
+        GLsizei levels = upload.options.mipmaps ? getLevelCount(upload.width, upload.height) : 1;
+
+        glGenTextures(1, &upload.texture);
+        glBindTexture(GL_TEXTURE_2D, upload.texture);
+        // Immutable storage has no luminance format, the red channel is swizzled into all three
+        glTexStorage2D(GL_TEXTURE_2D, levels, luminance ? GL_R8 : GL_RGBA8, upload.width, upload.height);
+        GLESUtils::applyTextureOptions(upload.options, upload.options.mipmaps);
+        if (luminance)
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    glGenBuffers(1, &upload.pixelBuffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.pixelBuffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(upload.pixels.size()), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+
+size_t
+TextureUploader::submitRows(Upload& upload, size_t budget)
+{
+    size_t rowBytes = static_cast<size_t>(upload.width) * getBytesPerPixel(upload.format);
+    int rows = std::min(upload.height - upload.rowsSubmitted, static_cast<int>(std::max<size_t>(1, budget / rowBytes)));
+    size_t offset = upload.rowsSubmitted * rowBytes;
+    size_t bytes = rows * rowBytes;
+
+    // The range has never been written, there is no transfer to synchronize with
+    const void* pixels = upload.pixels.data() + offset;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.pixelBuffer);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(bytes),
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (mapped != nullptr)
+    {
+        memcpy(mapped, pixels, bytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        // Offset into the bound pixel buffer
+        pixels = reinterpret_cast<const void*>(offset);
+    }
+    else
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (upload.layer >= 0)
+    {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, upload.texture);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, upload.rowsSubmitted, upload.layer, upload.width, rows, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                        pixels);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+    else
+    {
+        glBindTexture(GL_TEXTURE_2D, upload.texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, upload.rowsSubmitted, upload.width, rows, upload.format == GL_LUMINANCE ? GL_RED : GL_RGBA,
+                        GL_UNSIGNED_BYTE, pixels);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    upload.rowsSubmitted += rows;
+    return bytes;
+}
+
+
+void
+TextureUploader::deleteObjects(Upload& upload)
+{
+    // Texture arrays belong to their TextureArray
+    if (upload.texture != 0 && upload.layer < 0)
+    {
+        glDeleteTextures(1, &upload.texture);
+    }
+    upload.texture = 0;
+    if (upload.pixelBuffer != 0)
+    {
+        glDeleteBuffers(1, &upload.pixelBuffer);
+        upload.pixelBuffer = 0;
+    }
+    if (upload.fence != nullptr)
+    {
+        glDeleteSync(upload.fence);
+        upload.fence = nullptr;
+    }
+}
@@ -0,0 +1,121 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_TEXTUREUPLOADER_H_
+#define _VUFORIA_TEXTUREUPLOADER_H_
+
+#include "GLESUtils.h"
+
+#include <GLES3/gl31.h>
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+
+/// Queue streaming decoded images into textures over several frames
+/**
+ * A single glTexImage2D of a multi-megapixel image stalls the rendering thread for tens of
+ * milliseconds. Instead, every frame copies at most BYTES_PER_FRAME of pending pixels into a
+ * pixel buffer object and issues glTexSubImage2D for the rows copied, which returns without waiting
+ * for the transfer. Once all rows are submitted the mip chain is generated and a fence is inserted,
+ * the texture is handed out by process when the fence has signaled, so it is never sampled while
+ * the GPU is still writing it. Callers render with a placeholder until then.
+ * All methods must be called on the rendering thread with a current GL context.
+ */
+class TextureUploader
+{
+public:
+    /// Pixel data copied into pixel buffers per frame, bounds the time the rendering thread spends on uploads
+    static constexpr size_t BYTES_PER_FRAME = 4u << 20;
+
+    /// A texture whose upload the GPU has completed
+    struct Finished
+    {
+        std::string id;
+        GLuint texture;
+        /// GPU memory used by the texture including its mip levels
+        size_t sizeBytes;
+        /// Layer written for enqueueLayer, the texture array stays owned by its TextureArray. -1 for 2D textures.
+        int layer;
+    };
+
+    TextureUploader() = default;
+    /// The GL objects are not freed on destruction, call destroy on the rendering thread
+    ~TextureUploader() = default;
+
+    TextureUploader(const TextureUploader&) = delete;
+    TextureUploader& operator=(const TextureUploader&) = delete;
+
+    /// Queue an image for upload, the pixels are consumed
+    /*
+     * format is GL_RGBA for 4 bytes per pixel or GL_LUMINANCE for 1 byte per pixel, rows are tightly packed.
+     * Luminance images are stored in the red channel and swizzled into green and blue.
+     * Nothing is done if an upload for the id is already pending.
+     */
+    void enqueue(const std::string& id, int width, int height, GLenum format, const TextureOptions& options,
+                 std::vector<unsigned char> pixels);
+
+    /// Queue an RGBA image for upload into a layer of a texture array, the pixels are consumed
+    /*
+     * The image must have the size of the array. With mipmaps the mip chain of the whole array is
+     * generated again once the layer is written. Nothing is done if an upload for the id is already pending.
+     */
+    void enqueueLayer(const std::string& id, GLuint textureArray, int layer, int width, int height, bool mipmaps,
+                      std::vector<unsigned char> pixels);
+
+    /// Check whether an upload for the id is queued or waiting for the GPU
+    bool isPending(const std::string& id) const;
+
+    /// Check whether no upload is queued or waiting for the GPU
+    bool isIdle() const { return mUploads.empty(); }
+
+    /// Advance the pending uploads, call once per frame
+    /// Textures the GPU has finished writing are appended to finished, the caller takes ownership of them.
+    void process(std::vector<Finished>& finished);
+
+    /// Delete the GL objects of all pending uploads and drop them
+    void destroy();
+
+    /// Drop all pending uploads without deleting GL objects, used after the GL context was lost
+    void forget();
+
+private:
+    struct Upload
+    {
+        std::string id;
+        int width;
+        int height;
+        GLenum format;
+        TextureOptions options;
+        /// Freed once every row is in the pixel buffer
+        std::vector<unsigned char> pixels;
+
+        GLuint texture = 0;
+        /// Layer of the texture array in texture, -1 for a 2D texture created by the uploader
+        int layer = -1;
+        GLuint pixelBuffer = 0;
+        /// Rows copied and submitted so far
+        int rowsSubmitted = 0;
+        /// Inserted after the last row, the texture is complete once it signals
+        GLsync fence = nullptr;
+    };
+
+    /// Create the immutable storage and the pixel buffer of an upload, layers only need the pixel buffer
+    static bool allocate(Upload& upload);
+
+    /// Submit up to budget bytes of rows of an upload, returns the number of bytes submitted
+    static size_t submitRows(Upload& upload, size_t budget);
+
+    static void deleteObjects(Upload& upload);
+
+    /// In order of submission, uploads are started one after the other
+    std::deque<Upload> mUploads;
+};
+
+#endif // _VUFORIA_TEXTUREUPLOADER_H_
@@ -0,0 +1,76 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "ThermalMonitor.h"
+
+#include <Log.h>
+
+#include <dlfcn.h>
+
+#include <algorithm>
+
+
+ThermalMonitor::~ThermalMonitor()
+{
+    if (mManager != nullptr)
+    {
+        mReleaseManager(mManager);
+    }
+    if (mLibrary != nullptr)
+    {
+        dlclose(mLibrary);
+    }
+}
+
+
+void
+ThermalMonitor::poll()
+{
+    auto now = std::chrono::steady_clock::now();
+    if (mInitialized && now - mLastPoll < POLL_INTERVAL)
+    {
+        return;
+    }
+    mLastPoll = now;
+
+    if (!mInitialized)
+    {
+        mInitialized = true;
+        mLibrary = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+        auto acquireManager =
+            mLibrary != nullptr ? reinterpret_cast<AcquireManagerFunction>(dlsym(mLibrary, "AThermal_acquireManager")) : nullptr;
+        mReleaseManager = mLibrary != nullptr ? reinterpret_cast<ReleaseManagerFunction>(dlsym(mLibrary, "AThermal_releaseManager")) : nullptr;
+        if (acquireManager == nullptr || mReleaseManager == nullptr)
+        {
+            LOG("No thermal API, the thermal status is unknown");
+            return;
+        }
+        mManager = acquireManager();
+        mGetCurrentThermalStatus =
+            reinterpret_cast<GetCurrentThermalStatusFunction>(dlsym(mLibrary, "AThermal_getCurrentThermalStatus"));
+        // API level 31
+        mGetThermalHeadroom = reinterpret_cast<GetThermalHeadroomFunction>(dlsym(mLibrary, "AThermal_getThermalHeadroom"));
+        LOG("Thermal API available, headroom %s", mGetThermalHeadroom != nullptr ? "available" : "not available");
+    }
+
+    if (mManager == nullptr)
+    {
+        return;
+    }
+
+    if (mGetCurrentThermalStatus != nullptr)
+    {
+        // ATHERMAL_STATUS_ERROR is -1, the levels of status above CRITICAL count as CRITICAL
+        int status = mGetCurrentThermalStatus(mManager);
+        mStatus = status < 0 ? ThermalGovernor::Status::UNKNOWN
+                             : static_cast<ThermalGovernor::Status>(std::min(status, static_cast<int>(ThermalGovernor::Status::CRITICAL)));
+    }
+    if (mGetThermalHeadroom != nullptr)
+    {
+        mHeadroom = mGetThermalHeadroom(mManager, HEADROOM_FORECAST_SECONDS);
+    }
+}
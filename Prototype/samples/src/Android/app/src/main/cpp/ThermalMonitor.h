@@ -0,0 +1,63 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_THERMALMONITOR_H_
+#define _VUFORIA_THERMALMONITOR_H_
+
+#include <ThermalGovernor.h>
+
+#include <chrono>
+#include <limits>
+
+
+struct AThermalManager;
+
+/// Reads the thermal status and headroom of the device with the NDK thermal API
+/**
+ * AThermal_getCurrentThermalStatus needs API level 30 and AThermal_getThermalHeadroom API level 31,
+ * both are looked up at runtime so that the app still runs on older devices, which report
+ * UNKNOWN and a NaN headroom. The platform limits how often the headroom may be queried, so the
+ * values are only read again once POLL_INTERVAL has passed.
+ */
+class ThermalMonitor
+{
+public:
+    static constexpr std::chrono::seconds POLL_INTERVAL{ 1 };
+    /// How far ahead the headroom is forecast
+    static constexpr int HEADROOM_FORECAST_SECONDS = 10;
+
+    ThermalMonitor() = default;
+    ~ThermalMonitor();
+
+    ThermalMonitor(const ThermalMonitor&) = delete;
+    ThermalMonitor& operator=(const ThermalMonitor&) = delete;
+
+    /// Read the thermal state if POLL_INTERVAL has passed since the last read, acquires the thermal manager on first use
+    void poll();
+
+    ThermalGovernor::Status getStatus() const { return mStatus; }
+    float getHeadroom() const { return mHeadroom; }
+
+private:
+    using AcquireManagerFunction = AThermalManager* (*)();
+    using ReleaseManagerFunction = void (*)(AThermalManager*);
+    using GetCurrentThermalStatusFunction = int (*)(AThermalManager*);
+    using GetThermalHeadroomFunction = float (*)(AThermalManager*, int);
+
+    bool mInitialized = false;
+    void* mLibrary = nullptr;
+    AThermalManager* mManager = nullptr;
+    ReleaseManagerFunction mReleaseManager = nullptr;
+    GetCurrentThermalStatusFunction mGetCurrentThermalStatus = nullptr;
+    GetThermalHeadroomFunction mGetThermalHeadroom = nullptr;
+
+    std::chrono::steady_clock::time_point mLastPoll;
+    ThermalGovernor::Status mStatus = ThermalGovernor::Status::UNKNOWN;
+    float mHeadroom = std::numeric_limits<float>::quiet_NaN();
+};
+
+#endif // _VUFORIA_THERMALMONITOR_H_
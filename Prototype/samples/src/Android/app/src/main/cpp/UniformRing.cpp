@@ -0,0 +1,162 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "UniformRing.h"
+
+#include <Log.h>
+
+#include <cstring>
+
+
+namespace
+{
+/// Longest wait for the GPU to release a region before its storage is orphaned instead
+constexpr GLuint64 FENCE_TIMEOUT_NS = 100000000;
+} // anonymous namespace
+
+
+bool
+UniformRing::create(GLsizeiptr frameSizeBytes)
+{
+    destroy();
+
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &mAlignment);
+    mAlignment = mAlignment > 0 ? mAlignment : 256;
+    mFrameSize = (frameSizeBytes + mAlignment - 1) / mAlignment * mAlignment;
+
+    glGenBuffers(1, &mBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, mFrameSize * FRAME_COUNT, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    if (glGetError() != GL_NO_ERROR)
+    {
+        LOG("Error: Cannot allocate %ld bytes of uniform buffer", static_cast<long>(mFrameSize * FRAME_COUNT));
+        destroy();
+        return false;
+    }
+    return true;
+}
+
+
+void
+UniformRing::destroy()
+{
+    for (auto& fence : mFences)
+    {
+        if (fence != nullptr)
+        {
+            glDeleteSync(fence);
+        }
+    }
+    if (mBuffer != 0)
+    {
+        glDeleteBuffers(1, &mBuffer);
+    }
+    forget();
+}
+
+
+void
+UniformRing::forget()
+{
+    mBuffer = 0;
+    for (auto& fence : mFences)
+    {
+        fence = nullptr;
+    }
+    mFrame = 0;
+    mOffset = 0;
+    mFrameStarted = false;
+}
+
+
+void
+UniformRing::beginFrame()
+{
+    if (mBuffer == 0)
+    {
+        return;
+    }
+
+    if (mFrameStarted)
+    {
+        mFences[mFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        mFrame = (mFrame + 1) % FRAME_COUNT;
+    }
+    mFrameStarted = true;
+    mOffset = 0;
+
+    GLsync& fence = mFences[mFrame];
+    if (fence != nullptr)
+    {
+        GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+        glDeleteSync(fence);
+        fence = nullptr;
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        {
+            orphan();
+        }
+    }
+}
+
+
+bool
+UniformRing::bind(GLuint binding, const void* data, GLsizeiptr size)
+{
+    if (mBuffer == 0)
+    {
+        return false;
+    }
+
+    GLsizeiptr alignedSize = (size + mAlignment - 1) / mAlignment * mAlignment;
+    if (alignedSize > mFrameSize)
+    {
+        return false;
+    }
+    if (mOffset + alignedSize > mFrameSize)
+    {
+        LOG("Uniform ring region of %ld bytes full, orphaning the buffer", static_cast<long>(mFrameSize));
+        orphan();
+    }
+
+    // Nothing in flight reads this range, see beginFrame
+    GLintptr offset = mFrame * mFrameSize + mOffset;
+    glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+    void* mapped = glMapBufferRange(GL_UNIFORM_BUFFER, offset, size,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (mapped == nullptr)
+    {
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+    }
+    else
+    {
+        memcpy(mapped, data, static_cast<size_t>(size));
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, mBuffer, offset, size);
+
+    mOffset += alignedSize;
+    return true;
+}
+
+
+void
+UniformRing::orphan()
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, mFrameSize * FRAME_COUNT, nullptr, GL_STREAM_DRAW);
+    for (auto& fence : mFences)
+    {
+        if (fence != nullptr)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    mOffset = 0;
+}
@@ -0,0 +1,69 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef _VUFORIA_UNIFORMRING_H_
+#define _VUFORIA_UNIFORMRING_H_
+
+#include <GLES3/gl31.h>
+
+
+/// Uniform buffer split into one region per frame in flight, uniform blocks are appended to the region of the current frame
+/**
+ * Every block written is bound with glBindBufferRange, so switching the uniforms of a draw costs a
+ * copy into mapped memory and one range bind. The GPU may still read the regions of earlier frames,
+ * a fence per region makes beginFrame wait before a region is written again, which only happens when
+ * the GPU is more than FRAME_COUNT - 1 frames behind. A region running out of space orphans the
+ * whole buffer rather than overwriting blocks still in use.
+ * All methods must be called on the rendering thread with a current GL context.
+ */
+class UniformRing
+{
+public:
+    /// Frames whose uniforms can be in flight at once
+    static constexpr int FRAME_COUNT = 3;
+
+    UniformRing() = default;
+    /// The GL objects are not freed on destruction, call destroy on the rendering thread
+    ~UniformRing() = default;
+
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+    /// Allocate the buffer with frameSizeBytes for the blocks of each frame
+    bool create(GLsizeiptr frameSizeBytes);
+
+    /// Free the GL objects
+    void destroy();
+
+    /// Drop the GL handles without deleting them, used after the GL context was lost
+    void forget();
+
+    bool isValid() const { return mBuffer != 0; }
+
+    /// Fence the region of the previous frame and start writing the next one
+    void beginFrame();
+
+    /// Copy a uniform block into the current region and bind it to a uniform buffer binding point
+    bool bind(GLuint binding, const void* data, GLsizeiptr size);
+
+private:
+    /// Give the buffer new storage, blocks already bound keep the old one until the GPU is done with it
+    void orphan();
+
+    GLuint mBuffer = 0;
+    GLsizeiptr mFrameSize = 0;
+    /// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT of the GPU
+    GLint mAlignment = 256;
+    int mFrame = 0;
+    /// Write position within the region of mFrame
+    GLintptr mOffset = 0;
+    /// Completion of the commands reading each region, null if nothing is pending
+    GLsync mFences[FRAME_COUNT] = {};
+    bool mFrameStarted = false;
+};
+
+#endif // _VUFORIA_UNIFORMRING_H_
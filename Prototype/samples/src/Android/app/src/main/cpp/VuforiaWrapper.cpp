@@ -7,24 +7,90 @@ countries.
 
 #include <jni.h>
 
+#include "ARCoreIntegration.h"
+#include "FramePacing.h"
 #include "GLESRenderer.h"
+#include "ProgramCache.h"
+#include "RenderThread.h"
+#include "ThermalMonitor.h"
+#include <AllocationCounter.h>
 #include <AppController.h>
+#include <FileDriver.h>
 #include <Log.h>
+#include <PixelConvert.h>
+#include <Profiler.h>
+#include <SpscQueue.h>
+#include <StartupOrchestrator.h>
 
 #include <VuforiaEngine/VuforiaEngine.h>
 
+#include <EGL/egl.h>
 #include <GLES3/gl31.h>
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
+#include <android/native_window_jni.h>
+#include <android/trace.h>
+#include <malloc.h>
+#include <unistd.h>
 
 #include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
 #include <vector>
 
-#include <arcore_c_api.h>
-
 // Cross-platform AppController providing high level Vuforia Engine operations
 AppController controller;
 
+namespace
+{
+/// The tasks of the StartupOrchestrator, from the launch to the first frame that can show augmentations
+/// Engine creation and the datasets run on the init thread, the renderer prepares on its thread meanwhile.
+constexpr const char* STARTUP_ENGINE = "engine";
+constexpr const char* STARTUP_OBSERVERS = "observers";
+constexpr const char* STARTUP_START_AR = "startAR";
+constexpr const char* STARTUP_SHADERS = "shaders";
+constexpr const char* STARTUP_ASSETS = "assets";
+constexpr const char* STARTUP_FIRST_FRAME = "firstFrame";
+
+/// What renderFrame does about heap allocations between prepareToRender and finishRender, see AllocationCounter
+enum class AllocationCheck
+{
+    OFF,
+    /// Frames that allocate are logged
+    REPORT,
+    /// The first frame that allocates is logged and aborts the app, to catch the allocating call in a debugger
+    ABORT,
+};
+
+/// A request of the UI thread, run by the rendering thread at the start of the next frame
+/// Calls that must be done when they return, like stopAR, pause the rendering instead, see VuforiaActivity.
+struct RenderCommand
+{
+    /// The values of the RENDER_COMMAND constants of VuforiaActivity
+    enum class Type
+    {
+        PERFORM_AUTO_FOCUS,
+        RESTORE_AUTO_FOCUS,
+        START_AR,
+    };
+    Type type;
+};
+
+/// The result of a RenderCommand, handed back to the UI thread and passed to VuforiaActivity.renderCommandCompleted
+struct RenderCommandCompletion
+{
+    RenderCommand::Type type;
+    bool succeeded;
+};
+
+/// The UI thread also takes the completions before posting, so at most this many are outstanding and none are dropped
+constexpr size_t RENDER_COMMAND_CAPACITY = 16;
+
+/// Frames per second while the frame packets are idle, enough for the camera image to follow a slow pan
+constexpr int IDLE_FRAME_RATE_CAP = 15;
+} // namespace
+
 /// JVM pointer obtained in the JNI_OnLoad method below and consumed in the cross-platform code
 void* javaVM;
 
@@ -36,10 +102,55 @@ struct
     AAssetManager* assetManager = nullptr;
     jmethodID presentErrorMethodID = nullptr;
     jmethodID initDoneMethodID = nullptr;
+    jmethodID requestTextureMethodID = nullptr;
+    jmethodID requestContentMethodID = nullptr;
+    jmethodID requestRenderMethodID = nullptr;
+    jmethodID renderCommandsCompletedMethodID = nullptr;
+    jmethodID renderCommandCompletedMethodID = nullptr;
+    /// The activity of the native render loop, which is started before initAR
+    jobject renderLoopActivity = nullptr;
+    jmethodID firstFrameRenderedMethodID = nullptr;
+    bool firstFrameRendered{ false };
 
     GLESRenderer renderer;
+    FramePacing framePacing;
+    /// Only running in the native render loop mode, where it replaces the GLSurfaceView
+    RenderThread renderThread;
+    Profiler profiler;
+    ThermalMonitor thermalMonitor;
+    /// Only used while Vuforia runs on ARCore
+    ARCoreIntegration arcore;
+    StartupOrchestrator startup;
+    /// Only the first launch of the process is timed from the process start
+    bool launched{ false };
+    /// Set from initRendering, the target the assets are prefetched for
+    int renderTarget{ 0 };
 
     bool usingARCore{ false };
+    /// Set from initAR, the render scale and frame rate cap of the governor level are applied once set
+    bool thermalGovernor{ false };
+    bool thermalLevelApplied{ false };
+    /// Frame rate cap of the governor level, combined with the idle cap by applyFrameRateCap
+    int thermalFrameRateCap{ 0 };
+    /// FramePacket::idle of the last rendered frame
+    bool idle{ false };
+
+    /// Set from configureSession, read by initAR
+    std::string recordingDirectory;
+    int cameraOrientation{ 0 };
+    std::string replayPath;
+    /// Passed to the FileDriver when a recording is replayed, kept until deinitAR
+    std::unique_ptr<FileDriverConfig> replay;
+    /// Rendered frames of a benchmark, counted from the first one
+    int benchmarkFrames{ 0 };
+    std::chrono::steady_clock::time_point benchmarkStart;
+    bool benchmarkReported{ false };
+    /// Set from setAllocationCheck before rendering starts
+    AllocationCheck allocationCheck{ AllocationCheck::OFF };
+
+    /// From the UI thread to the rendering thread and back, see postRenderCommand and runRenderCommands
+    SpscQueue<RenderCommand, RENDER_COMMAND_CAPACITY> renderCommands;
+    SpscQueue<RenderCommandCompletion, RENDER_COMMAND_CAPACITY> renderCommandCompletions;
 } gWrapperData;
 
 
@@ -50,7 +161,19 @@ extern "C"
 #endif
 
 // Local method declarations
-void accessFusionProviderPointers();
+void initRendering(int target, bool dynamicResolution);
+void setProfiler(int mode, bool overlay);
+bool renderFrame();
+void updateThermalGovernor(std::chrono::steady_clock::duration frameTime);
+void applyFrameRateCap();
+void updateBenchmark(bool rendered);
+void updateStartup(bool rendered);
+void checkFrameAllocations();
+void postRenderCommand(JNIEnv* env, jobject activity, RenderCommand::Type type);
+void drainRenderCommandCompletions(JNIEnv* env, jobject activity);
+void runRenderCommands();
+bool startARFromRenderCommand();
+std::string formatProcessMemory();
 
 
 /// Called by JNI binding when the client code loads the library
@@ -80,24 +203,89 @@ JNI_OnLoad(JavaVM* vm, void* reserved)
 }
 
 
-JNIEXPORT void JNICALL
-Java_com_vuforia_engine_native_1sample_VuforiaActivity_initAR(JNIEnv* env, jobject /* this */, jobject activity, jobject assetManager,
-                                                              jint target)
+JNIEXPORT jboolean JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_beginStartup(JNIEnv* env, jobject /* this */, jobject activity,
+                                                                    jobject assetManager, jstring cacheDirectory,
+                                                                    jlong processStartUptime)
 {
     // Store the Java VM pointer so we can get a JNIEnv in callbacks
     if (env->GetJavaVM(&gWrapperData.vm) != 0)
     {
-        return;
+        return JNI_FALSE;
     }
+    // Set before initAR, the rendering thread may already need them
     gWrapperData.activity = env->NewGlobalRef(activity);
     jclass clazz = env->GetObjectClass(activity);
     gWrapperData.presentErrorMethodID = env->GetMethodID(clazz, "presentError", "(Ljava/lang/String;)V");
     gWrapperData.initDoneMethodID = env->GetMethodID(clazz, "initDone", "()V");
+    gWrapperData.requestTextureMethodID = env->GetMethodID(clazz, "requestTexture", "(Ljava/lang/String;)V");
+    gWrapperData.requestContentMethodID = env->GetMethodID(clazz, "requestContent", "(Ljava/lang/String;Z)V");
+    gWrapperData.requestRenderMethodID = env->GetMethodID(clazz, "requestRender", "()V");
+    gWrapperData.renderCommandsCompletedMethodID = env->GetMethodID(clazz, "renderCommandsCompleted", "()V");
+    gWrapperData.renderCommandCompletedMethodID = env->GetMethodID(clazz, "renderCommandCompleted", "(IZ)V");
     env->DeleteLocalRef(clazz);
 
+    // Get a native AAssetManager
+    gWrapperData.assetManager = AAssetManager_fromJava(env, assetManager);
+    if (gWrapperData.assetManager == nullptr)
+    {
+        LOG("Error: Failed to get the asset manager");
+        return JNI_FALSE;
+    }
+
+    // Linked shader programs are kept across GL contexts and app launches
+    const char* cacheDirectoryChars = env->GetStringUTFChars(cacheDirectory, nullptr);
+    std::string cacheDirectoryPath = cacheDirectoryChars;
+    env->ReleaseStringUTFChars(cacheDirectory, cacheDirectoryChars);
+    ProgramCache::setDirectory(cacheDirectoryPath);
+
+    StartupOrchestrator& startup = gWrapperData.startup;
+    startup.reset();
+    startup.addTask(STARTUP_ENGINE, {});
+    startup.addTask(STARTUP_OBSERVERS, { STARTUP_ENGINE });
+    startup.addTask(STARTUP_START_AR, { STARTUP_OBSERVERS });
+    startup.addTask(STARTUP_SHADERS, {});
+    startup.addTask(STARTUP_ASSETS, { STARTUP_SHADERS });
+    startup.addTask(STARTUP_FIRST_FRAME, { STARTUP_START_AR, STARTUP_ASSETS });
+
+    // SystemClock.uptimeMillis and the steady clock both read CLOCK_MONOTONIC, later launches are timed from here
+    auto origin = StartupOrchestrator::Clock::now();
+    if (!gWrapperData.launched && processStartUptime > 0)
+    {
+        origin = StartupOrchestrator::Clock::time_point(std::chrono::milliseconds(processStartUptime));
+    }
+    gWrapperData.launched = true;
+    startup.start(origin, cacheDirectoryPath + "/startup_trace.json");
+    return JNI_TRUE;
+}
+
+
+JNIEXPORT void JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_initAR(JNIEnv* /* env */, jobject /* this */, jobject activity, jint target,
+                                                              jboolean pipelinedTracking, jboolean optimizeCameraSpeed,
+                                                              jboolean poseFiltering, jboolean thermalGovernor, jboolean idlePowerMode,
+                                                              jboolean idleDeactivateObservers)
+{
+
     AppController::InitConfig initConfig;
     initConfig.vbRenderBackend = VuRenderVBBackendType::VU_RENDER_VB_BACKEND_GLES3;
     initConfig.appData = activity;
+    initConfig.pipelinedTracking = pipelinedTracking == JNI_TRUE;
+    if (optimizeCameraSpeed == JNI_TRUE)
+    {
+        initConfig.cameraVideoMode = VU_CAMERA_VIDEO_MODE_PRESET_OPTIMIZE_SPEED;
+    }
+    initConfig.poseFiltering = poseFiltering == JNI_TRUE;
+    initConfig.thermalGovernor = thermalGovernor == JNI_TRUE;
+    gWrapperData.thermalGovernor = initConfig.thermalGovernor;
+    gWrapperData.thermalLevelApplied = false;
+    gWrapperData.thermalFrameRateCap = 0;
+    initConfig.idlePowerMode = idlePowerMode == JNI_TRUE;
+    initConfig.idleDeactivateObservers = idleDeactivateObservers == JNI_TRUE;
+    gWrapperData.idle = false;
+    initConfig.recordingDirectory = gWrapperData.recordingDirectory;
+    initConfig.cameraOrientation = gWrapperData.cameraOrientation;
+    initConfig.replay = gWrapperData.replay.get();
 
     // Setup callbacks
     initConfig.showErrorCallback = [](const char* errorString) {
@@ -119,37 +307,60 @@ Java_com_vuforia_engine_native_1sample_VuforiaActivity_initAR(JNIEnv* env, jobje
         }
     };
 
-    // Get a native AAssetManager
-    gWrapperData.assetManager = AAssetManager_fromJava(env, assetManager);
-    if (gWrapperData.assetManager == nullptr)
+    // Start Vuforia initialization, the rendering thread prepares the shaders and assets meanwhile
+    StartupOrchestrator& startup = gWrapperData.startup;
+    if (startup.run(STARTUP_ENGINE, [&initConfig, target]() { return controller.initEngine(initConfig, target); }) &&
+        startup.run(STARTUP_OBSERVERS, []() { return controller.initObservers(); }))
     {
-        initConfig.showErrorCallback("Error: Failed to get the asset manager");
-        return;
+        initConfig.initDoneCallback();
     }
-
-    // Start Vuforia initialization
-    controller.initAR(initConfig, target);
 }
 
 
-JNIEXPORT jboolean JNICALL
-Java_com_vuforia_engine_native_1sample_VuforiaActivity_startAR(JNIEnv* /* env */, jobject /* this */)
+JNIEXPORT void JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_configureSession(JNIEnv* env, jobject /* this */, jstring recordingDirectory,
+                                                                        jint cameraOrientation, jstring replayPath, jboolean benchmark)
 {
-    // Update usingARCore flag to avoid checking this every frame
-    auto platformController = controller.getPlatformController();
-    assert(platformController);
+    auto toString = [env](jstring string) {
+        std::string result;
+        if (string != nullptr)
+        {
+            const char* chars = env->GetStringUTFChars(string, nullptr);
+            result = chars;
+            env->ReleaseStringUTFChars(string, chars);
+        }
+        return result;
+    };
+    gWrapperData.recordingDirectory = toString(recordingDirectory);
+    gWrapperData.cameraOrientation = cameraOrientation;
+    gWrapperData.replayPath = toString(replayPath);
+
+    gWrapperData.replay.reset();
+    if (!gWrapperData.replayPath.empty())
+    {
+        gWrapperData.replay = std::make_unique<FileDriverConfig>();
+        gWrapperData.replay->path = gWrapperData.replayPath.c_str();
+        gWrapperData.replay->benchmark = benchmark == JNI_TRUE;
+        gWrapperData.replay->loop = benchmark != JNI_TRUE;
+    }
+    gWrapperData.benchmarkFrames = 0;
+    gWrapperData.benchmarkReported = false;
+}
 
-    VuFusionProviderPlatformType fusionProviderPlatformType{ VU_FUSION_PROVIDER_PLATFORM_TYPE_UNKNOWN };
-    vuPlatformControllerGetFusionProviderPlatformType(platformController, &fusionProviderPlatformType);
-    gWrapperData.usingARCore = (fusionProviderPlatformType == VU_FUSION_PROVIDER_PLATFORM_TYPE_ARCORE);
 
-    return controller.startAR() ? JNI_TRUE : JNI_FALSE;
+JNIEXPORT void JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_startAR(JNIEnv* env, jobject thiz)
+{
+    // Started by the rendering thread between two frames, renderFrame reads the state startAR writes
+    postRenderCommand(env, thiz, RenderCommand::Type::START_AR);
 }
 
 
 JNIEXPORT void JNICALL
 Java_com_vuforia_engine_native_1sample_VuforiaActivity_stopAR(JNIEnv* /* env */, jobject /* this */)
 {
+    // The ARCore objects belong to the session Vuforia is about to release
+    gWrapperData.arcore.reset();
     controller.stopAR();
 }
 
@@ -157,7 +368,10 @@ Java_com_vuforia_engine_native_1sample_VuforiaActivity_stopAR(JNIEnv* /* env */,
 JNIEXPORT void JNICALL
 Java_com_vuforia_engine_native_1sample_VuforiaActivity_deinitAR(JNIEnv* env, jobject /* this */)
 {
+    gWrapperData.arcore.reset();
     controller.deinitAR();
+    // The driver is unloaded with the engine
+    gWrapperData.replay.reset();
 
     gWrapperData.assetManager = nullptr;
     env->DeleteGlobalRef(gWrapperData.activity);
@@ -166,53 +380,170 @@ Java_com_vuforia_engine_native_1sample_VuforiaActivity_deinitAR(JNIEnv* env, job
 
 
 JNIEXPORT void JNICALL
-Java_com_vuforia_engine_native_1sample_VuforiaActivity_cameraPerformAutoFocus(JNIEnv* /* env */, jobject /* this */)
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_cameraPerformAutoFocus(JNIEnv* env, jobject thiz)
 {
-    controller.cameraPerformAutoFocus();
+    postRenderCommand(env, thiz, RenderCommand::Type::PERFORM_AUTO_FOCUS);
 }
 
 
 JNIEXPORT void JNICALL
-Java_com_vuforia_engine_native_1sample_VuforiaActivity_cameraRestoreAutoFocus(JNIEnv* /* env */, jobject /* this */)
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_cameraRestoreAutoFocus(JNIEnv* env, jobject thiz)
 {
-    controller.cameraRestoreAutoFocus();
+    postRenderCommand(env, thiz, RenderCommand::Type::RESTORE_AUTO_FOCUS);
 }
 
 
 JNIEXPORT void JNICALL
-Java_com_vuforia_engine_native_1sample_VuforiaActivity_initRendering(JNIEnv* /* env */, jobject /* this */)
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_drainRenderCommands(JNIEnv* env, jobject thiz)
 {
-    // Define clear color
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    drainRenderCommandCompletions(env, thiz);
+}
+
+
+JNIEXPORT void JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_initRendering(JNIEnv* /* env */, jobject /* this */, jint target,
+                                                                     jboolean dynamicResolution)
+{
+    initRendering(target, dynamicResolution == JNI_TRUE);
 
-    if (!gWrapperData.renderer.init(gWrapperData.assetManager))
+    // Benchmarks render as fast as they can instead of waiting for the vsync
+    if (gWrapperData.replay != nullptr && gWrapperData.replay->benchmark && eglSwapInterval(eglGetCurrentDisplay(), 0) != EGL_TRUE)
     {
-        LOG("Error initialising rendering");
+        LOG("Failed to disable the swap interval, the benchmark renders at the display rate");
     }
 }
 
 
 JNIEXPORT void JNICALL
-Java_com_vuforia_engine_native_1sample_VuforiaActivity_setTextures(JNIEnv* env, jobject /* this */, jint astronautWidth,
-                                                                   jint astronautHeight, jobject astronautByteBuffer, jint planeWidth,
-                                                                   jint planeHeight, jobject planeByteBuffer, jint landerWidth,
-                                                                   jint landerHeight, jobject landerByteBuffer)
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_setProfiler(JNIEnv* /* env */, jobject /* this */, jint mode, jboolean overlay)
+{
+    setProfiler(mode, overlay == JNI_TRUE);
+}
+
+
+JNIEXPORT jstring JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_getProfilerStatistics(JNIEnv* env, jobject /* this */)
+{
+    // The frustum culling of the models is counted by the renderer, next to the time it saves
+    std::string statistics = gWrapperData.profiler.formatStatistics();
+    char line[64];
+    snprintf(line, sizeof(line), "%-24s %u since init\n", "culled draws", gWrapperData.renderer.getCulledDrawCount());
+    statistics += line;
+    return env->NewStringUTF(statistics.c_str());
+}
+
+
+JNIEXPORT void JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_setMemoryOptions(JNIEnv* /* env */, jobject /* this */, jlong cpuBudgetBytes,
+                                                                        jboolean releaseMeshCopies)
+{
+    gWrapperData.renderer.getMemoryAccounting().setCpuBudget(static_cast<size_t>(cpuBudgetBytes));
+    gWrapperData.renderer.setReleaseMeshCopies(releaseMeshCopies == JNI_TRUE);
+}
+
+
+JNIEXPORT void JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_setAssetCache(JNIEnv* env, jobject /* this */, jstring directory, jlong budgetBytes)
+{
+    // Called before the renderer loads anything, the loader threads look blobs up from then on
+    const char* directoryChars = env->GetStringUTFChars(directory, nullptr);
+    gWrapperData.renderer.setAssetCacheBudget(static_cast<size_t>(budgetBytes));
+    gWrapperData.renderer.setAssetCacheDirectory(budgetBytes > 0 ? directoryChars : "");
+    env->ReleaseStringUTFChars(directory, directoryChars);
+}
+
+
+JNIEXPORT void JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_setAllocationCheck(JNIEnv* /* env */, jobject /* this */, jint mode)
+{
+    if (mode != 0 && !AllocationCounter::isAvailable())
+    {
+        LOG("Allocation check unavailable, build with the CMake option VUFORIA_COUNT_ALLOCATIONS");
+        return;
+    }
+    gWrapperData.allocationCheck = static_cast<AllocationCheck>(mode);
+}
+
+
+JNIEXPORT jstring JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_getMemoryReport(JNIEnv* env, jobject /* this */)
+{
+    std::string report = gWrapperData.renderer.getMemoryAccounting().formatReport() + formatProcessMemory();
+    return env->NewStringUTF(report.c_str());
+}
+
+
+JNIEXPORT void JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_setTexture(JNIEnv* env, jobject /* this */, jstring textureName, jint width,
+                                                                  jint height, jobject byteBuffer)
 {
     // Textures are loaded using the BitmapFactory which isn't available from the NDK.
     // They are loaded in the Kotlin code and passed to this method to create GLES textures.
-    auto astronautBytes = static_cast<unsigned char*>(env->GetDirectBufferAddress(astronautByteBuffer));
-    gWrapperData.renderer.setAstronautTexture(astronautWidth, astronautHeight, astronautBytes);
-    auto planeBytes = static_cast<unsigned char*>(env->GetDirectBufferAddress(planeByteBuffer));
-    gWrapperData.renderer.setPlaneTexture(planeWidth, planeHeight, planeBytes);
-    auto landerBytes = static_cast<unsigned char*>(env->GetDirectBufferAddress(landerByteBuffer));
-    gWrapperData.renderer.setLanderTexture(landerWidth, landerHeight, landerBytes);
+    // The buffer holds the ARGB colors of Bitmap.getPixels, converted to bottom-up RGBA here.
+    const char* name = env->GetStringUTFChars(textureName, nullptr);
+    auto bytes = static_cast<unsigned char*>(env->GetDirectBufferAddress(byteBuffer));
+    PixelConvert::argbToRgbaFlipRows(bytes, width, height);
+    if (gWrapperData.renderThread.isRunning())
+    {
+        // Called on the decoding thread, the render thread creates the texture from the buffer, which is kept alive until then
+        jobject buffer = env->NewGlobalRef(byteBuffer);
+        gWrapperData.renderThread.post([textureName = std::string(name), width, height, bytes, buffer]() {
+            gWrapperData.renderer.setTexture(textureName.c_str(), width, height, bytes);
+            JNIEnv* renderEnv = nullptr;
+            if (gWrapperData.vm->GetEnv((void**)&renderEnv, JNI_VERSION_1_6) == 0)
+            {
+                renderEnv->DeleteGlobalRef(buffer);
+            }
+        });
+    }
+    else
+    {
+        gWrapperData.renderer.setTexture(name, width, height, bytes);
+    }
+    env->ReleaseStringUTFChars(textureName, name);
 }
 
 
 JNIEXPORT void JNICALL
-Java_com_vuforia_engine_native_1sample_VuforiaActivity_deinitRendering(JNIEnv* /* env */, jobject /* this */)
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_setContent(JNIEnv* env, jobject /* this */, jstring url, jobject byteBuffer)
 {
-    gWrapperData.renderer.deinit();
+    // Called on the download thread with a direct buffer, or null if the download failed
+    const char* urlChars = env->GetStringUTFChars(url, nullptr);
+    std::vector<char> data;
+    if (byteBuffer != nullptr)
+    {
+        auto bytes = static_cast<const char*>(env->GetDirectBufferAddress(byteBuffer));
+        data.assign(bytes, bytes + env->GetDirectBufferCapacity(byteBuffer));
+    }
+    if (gWrapperData.renderThread.isRunning())
+    {
+        gWrapperData.renderThread.post([url = std::string(urlChars), data = std::move(data)]() mutable {
+            gWrapperData.renderer.setContent(url.c_str(), std::move(data));
+        });
+    }
+    else
+    {
+        gWrapperData.renderer.setContent(urlChars, std::move(data));
+    }
+    env->ReleaseStringUTFChars(url, urlChars);
+}
+
+
+JNIEXPORT void JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_setContentManifest(JNIEnv* env, jobject /* this */, jstring text)
+{
+    // Parse errors are logged by the renderer, which keeps its previous manifest then
+    const char* chars = env->GetStringUTFChars(text, nullptr);
+    std::string manifest(chars);
+    env->ReleaseStringUTFChars(text, chars);
+    if (gWrapperData.renderThread.isRunning())
+    {
+        gWrapperData.renderThread.post([manifest]() { gWrapperData.renderer.setContentManifest(manifest.data(), manifest.size()); });
+    }
+    else
+    {
+        gWrapperData.renderer.setContentManifest(manifest.data(), manifest.size());
+    }
 }
 
 
@@ -220,18 +551,249 @@ JNIEXPORT jboolean JNICALL
 Java_com_vuforia_engine_native_1sample_VuforiaActivity_configureRendering(JNIEnv* /* env */, jobject /* this */, jint width, jint height,
                                                                           jint orientation, jint rotation)
 {
-    std::vector<int> androidOrientation{ orientation, rotation };
-    return controller.configureRendering(width, height, androidOrientation.data()) ? JNI_TRUE : JNI_FALSE;
+    int androidOrientation[] = { orientation, rotation };
+    return controller.configureRendering(width, height, androidOrientation) ? JNI_TRUE : JNI_FALSE;
+}
+
+
+JNIEXPORT jboolean JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_startFramePacing(JNIEnv* /* env */, jobject /* this */, jint targetFrameRate,
+                                                                        jlong refreshPeriod)
+{
+    // Called on the main thread, the vsync callbacks arrive there too
+    auto requestRender = []() {
+        if (gWrapperData.renderThread.isRunning())
+        {
+            gWrapperData.renderThread.requestFrame();
+            return;
+        }
+        JNIEnv* env = nullptr;
+        if (gWrapperData.vm->GetEnv((void**)&env, JNI_VERSION_1_6) == 0 && gWrapperData.activity != nullptr)
+        {
+            env->CallVoidMethod(gWrapperData.activity, gWrapperData.requestRenderMethodID);
+        }
+    };
+    if (!gWrapperData.framePacing.start(targetFrameRate, refreshPeriod, requestRender))
+    {
+        return JNI_FALSE;
+    }
+    gWrapperData.renderThread.setRenderOnRequest(true);
+    return JNI_TRUE;
+}
+
+
+JNIEXPORT void JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_stopFramePacing(JNIEnv* /* env */, jobject /* this */)
+{
+    gWrapperData.framePacing.stop();
+    gWrapperData.renderThread.setRenderOnRequest(false);
 }
 
 
 JNIEXPORT jboolean JNICALL
 Java_com_vuforia_engine_native_1sample_VuforiaActivity_renderFrame(JNIEnv* /* env */, jobject /* this */)
 {
-    if (!controller.isARStarted())
+    return renderFrame() ? JNI_TRUE : JNI_FALSE;
+}
+
+
+JNIEXPORT jboolean JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_startRenderLoop(JNIEnv* env, jobject activity, jint target,
+                                                                       jboolean dynamicResolution, jint profilerMode,
+                                                                       jboolean profilerOverlay)
+{
+    if (gWrapperData.renderThread.isRunning())
+    {
+        return JNI_TRUE;
+    }
+    gWrapperData.renderLoopActivity = env->NewGlobalRef(activity);
+    gWrapperData.firstFrameRenderedMethodID = env->GetMethodID(env->GetObjectClass(activity), "firstFrameRendered", "()V");
+    gWrapperData.firstFrameRendered = false;
+
+    RenderThread::Callbacks callbacks;
+    callbacks.init = [target, dynamicResolution, profilerMode, profilerOverlay]() {
+        initRendering(target, dynamicResolution == JNI_TRUE);
+        setProfiler(profilerMode, profilerOverlay == JNI_TRUE);
+    };
+    callbacks.configure = [](int width, int height, int orientation, int rotation) {
+        // Applied once AR is started, like the GLSurfaceView does it
+        if (!controller.isARStarted())
+        {
+            return false;
+        }
+        int androidOrientation[] = { orientation, rotation };
+        controller.configureRendering(width, height, androidOrientation);
+        return true;
+    };
+    callbacks.render = []() {
+        bool rendered = renderFrame();
+        if (rendered && !gWrapperData.firstFrameRendered)
+        {
+            // The only call into Java from the loop besides texture requests, it hides the progress indicator
+            gWrapperData.firstFrameRendered = true;
+            JNIEnv* renderEnv = nullptr;
+            if (gWrapperData.vm->GetEnv((void**)&renderEnv, JNI_VERSION_1_6) == 0)
+            {
+                renderEnv->CallVoidMethod(gWrapperData.renderLoopActivity, gWrapperData.firstFrameRenderedMethodID);
+            }
+        }
+        return rendered;
+    };
+    callbacks.deinit = []() { gWrapperData.renderer.deinit(); };
+
+    // Benchmarks render as fast as they can instead of waiting for the vsync
+    int swapInterval = gWrapperData.replay != nullptr && gWrapperData.replay->benchmark ? 0 : 1;
+    if (!gWrapperData.renderThread.start(gWrapperData.vm, std::move(callbacks), swapInterval))
     {
+        LOG("Error starting the render loop");
+        env->DeleteGlobalRef(gWrapperData.renderLoopActivity);
+        gWrapperData.renderLoopActivity = nullptr;
         return JNI_FALSE;
     }
+    return JNI_TRUE;
+}
+
+
+JNIEXPORT void JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_stopRenderLoop(JNIEnv* env, jobject /* this */)
+{
+    gWrapperData.renderThread.stop();
+    if (gWrapperData.renderLoopActivity != nullptr)
+    {
+        env->DeleteGlobalRef(gWrapperData.renderLoopActivity);
+        gWrapperData.renderLoopActivity = nullptr;
+    }
+}
+
+
+JNIEXPORT void JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_setRenderSurface(JNIEnv* env, jobject /* this */, jobject surface)
+{
+    ANativeWindow* window = ANativeWindow_fromSurface(env, surface);
+    if (window == nullptr)
+    {
+        LOG("Error: No native window for the surface");
+        return;
+    }
+    gWrapperData.renderThread.setWindow(window);
+}
+
+
+JNIEXPORT void JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_configureRenderSurface(JNIEnv* /* env */, jobject /* this */, jint width,
+                                                                              jint height, jint orientation, jint rotation)
+{
+    gWrapperData.renderThread.setConfiguration(width, height, orientation, rotation);
+}
+
+
+JNIEXPORT void JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_releaseRenderSurface(JNIEnv* /* env */, jobject /* this */)
+{
+    gWrapperData.renderThread.releaseWindow();
+}
+
+
+JNIEXPORT void JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_setRenderLoopPaused(JNIEnv* /* env */, jobject /* this */, jboolean paused)
+{
+    gWrapperData.renderThread.setPaused(paused == JNI_TRUE);
+}
+
+
+JNIEXPORT jint JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_00024Companion_getImageTargetId(JNIEnv* /* env */, jobject /* this */)
+{
+    return AppController::IMAGE_TARGET_ID;
+}
+
+
+JNIEXPORT jint JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_00024Companion_getModelTargetId(JNIEnv* /* env */, jobject /* this */)
+{
+    return AppController::MODEL_TARGET_ID;
+}
+
+
+JNIEXPORT jint JNICALL
+Java_com_vuforia_engine_native_1sample_VuforiaActivity_00024Companion_getGalleryTargetId(JNIEnv* /* env */, jobject /* this */)
+{
+    return AppController::GALLERY_TARGET_ID;
+}
+
+
+void
+initRendering(int target, bool dynamicResolution)
+{
+    // Define clear color
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    // Textures are decoded by the Kotlin code on devices without the native image decoder, see setTexture
+    auto requestTexture = [](const char* textureName) {
+        JNIEnv* env = nullptr;
+        if (gWrapperData.vm->GetEnv((void**)&env, JNI_VERSION_1_6) == 0 && gWrapperData.requestTextureMethodID != nullptr)
+        {
+            jstring name = env->NewStringUTF(textureName);
+            env->CallVoidMethod(gWrapperData.activity, gWrapperData.requestTextureMethodID, name);
+            env->DeleteLocalRef(name);
+        }
+    };
+    // Files of remote artworks are downloaded by the Kotlin code too, the NDK has no HTTP client, see setContent
+    auto requestContent = [](const char* url, bool decodeImage) {
+        JNIEnv* env = nullptr;
+        if (gWrapperData.vm->GetEnv((void**)&env, JNI_VERSION_1_6) == 0 && gWrapperData.requestContentMethodID != nullptr)
+        {
+            jstring urlString = env->NewStringUTF(url);
+            env->CallVoidMethod(gWrapperData.activity, gWrapperData.requestContentMethodID, urlString, decodeImage ? JNI_TRUE : JNI_FALSE);
+            env->DeleteLocalRef(urlString);
+        }
+    };
+    bool initialized = gWrapperData.startup.run(STARTUP_SHADERS, [&requestTexture, &requestContent]() {
+        return gWrapperData.renderer.init(gWrapperData.assetManager, requestTexture, requestContent);
+    });
+    if (!initialized)
+    {
+        LOG("Error initialising rendering");
+    }
+    gWrapperData.renderer.setActiveTarget(target);
+    gWrapperData.renderer.setDynamicResolution(dynamicResolution);
+    gWrapperData.renderTarget = target;
+
+    // The models and textures are decoded on the loader threads while the engine starts, instead of on first detection
+    if (gWrapperData.startup.begin(STARTUP_ASSETS))
+    {
+        gWrapperData.renderer.prefetchAssets(target);
+    }
+}
+
+
+void
+setProfiler(int mode, bool overlay)
+{
+    // Markers of TRACE mode show up in systrace and Perfetto captures
+    gWrapperData.profiler.setTraceFunctions(ATrace_beginSection, ATrace_endSection);
+    gWrapperData.profiler.setMode(static_cast<Profiler::Mode>(mode));
+    gWrapperData.renderer.setProfiler(mode != 0 ? &gWrapperData.profiler : nullptr, overlay);
+}
+
+
+bool
+renderFrame()
+{
+    runRenderCommands();
+
+    if (!controller.isARStarted())
+    {
+        // Until AR starts frames only hand over the assets prefetched during startup, so their uploads are done by then
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        gWrapperData.renderer.processLoadedAssets();
+        updateStartup(false);
+        return false;
+    }
+
+    // With frame pacing the camera frame is acquired as late as the deadline of the frame allows
+    gWrapperData.framePacing.beginFrame();
+    auto frameStart = std::chrono::steady_clock::now();
 
     // Clear colour and depth buffers
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -242,124 +804,298 @@ Java_com_vuforia_engine_native_1sample_VuforiaActivity_renderFrame(JNIEnv* /* en
     renderVideoBackgroundData.textureData = nullptr;
     renderVideoBackgroundData.textureUnitData = &vbTextureUnit;
     double viewport[6];
-    if (controller.prepareToRender(viewport, &renderVideoBackgroundData))
+    bool prepared = false;
+    if (gWrapperData.allocationCheck != AllocationCheck::OFF)
+    {
+        AllocationCounter::begin();
+    }
+    {
+        Profiler::Scope scope(&gWrapperData.profiler, "prepareToRender");
+        prepared = controller.prepareToRender(viewport, &renderVideoBackgroundData);
+    }
+    if (prepared)
     {
         // Set viewport for current view
         glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        gWrapperData.renderer.beginFrame();
+        gWrapperData.renderer.setViewport(static_cast<int>(viewport[0]), static_cast<int>(viewport[1]), static_cast<int>(viewport[2]),
+                                          static_cast<int>(viewport[3]));
 
-        auto renderState = controller.getRenderState();
-        gWrapperData.renderer.renderVideoBackground(renderState.vbProjectionMatrix, renderState.vbMesh->pos, renderState.vbMesh->tex,
-                                                    renderState.vbMesh->numFaces, renderState.vbMesh->faceIndices, vbTextureUnit);
+        // Pick up models that finished loading since the last frame
+        gWrapperData.renderer.processLoadedAssets();
 
-        VuMatrix44F worldOriginProjection;
-        VuMatrix44F worldOriginModelView;
-        if (controller.getOrigin(worldOriginProjection, worldOriginModelView))
-        {
-            gWrapperData.renderer.renderWorldOrigin(worldOriginProjection, worldOriginModelView);
-        }
+        auto renderState = controller.getRenderState();
+        gWrapperData.renderer.renderVideoBackground(renderState.vbProjectionMatrix, *renderState.vbMesh, controller.getRenderViewVersion(),
+                                                    vbTextureUnit);
 
-        VuMatrix44F trackableProjection;
-        VuMatrix44F trackableModelView;
-        VuMatrix44F trackableModelViewScaled;
-        VuImageInfo modelTargetGuideViewImage;
-        VuBool guideViewImageHasChanged;
-        if (controller.getImageTargetResult(trackableProjection, trackableModelView, trackableModelViewScaled))
+        // Everything observed this frame, the renderer decides on the order of the draws
+        FramePacket framePacket;
+        controller.getFramePacket(framePacket);
+        if (gWrapperData.usingARCore)
         {
-            gWrapperData.renderer.renderImageTarget(trackableProjection, trackableModelView, trackableModelViewScaled);
+            gWrapperData.arcore.update(controller.getPlatformController(), framePacket);
         }
-        else if (controller.getModelTargetResult(trackableProjection, trackableModelView, trackableModelViewScaled))
+        if (framePacket.idle != gWrapperData.idle)
         {
-            gWrapperData.renderer.renderModelTarget(trackableProjection, trackableModelView, trackableModelViewScaled);
+            gWrapperData.idle = framePacket.idle;
+            applyFrameRateCap();
         }
-        else if (controller.getModelTargetGuideView(trackableProjection, trackableModelView, modelTargetGuideViewImage,
-                                                    guideViewImageHasChanged))
+        // While idle only the camera image and a guide view are drawn, the augmentation pass is left out
+        if (!framePacket.idle || framePacket.guideViewValid)
         {
-            gWrapperData.renderer.renderModelTargetGuideView(trackableProjection, trackableModelView, modelTargetGuideViewImage,
-                                                             guideViewImageHasChanged);
+            framePacket.originValid = framePacket.originValid && !framePacket.idle;
+            gWrapperData.renderer.renderFrame(framePacket, controller.getFrameArena());
         }
+        gWrapperData.renderer.renderProfilerOverlay();
+    }
 
-        if (gWrapperData.usingARCore)
-        {
-            accessFusionProviderPointers();
-        }
+    {
+        Profiler::Scope scope(&gWrapperData.profiler, "finishRender");
+        controller.finishRender();
+    }
+    if (gWrapperData.allocationCheck != AllocationCheck::OFF)
+    {
+        checkFrameAllocations();
     }
 
-    controller.finishRender();
+    if (gWrapperData.thermalGovernor)
+    {
+        updateThermalGovernor(std::chrono::steady_clock::now() - frameStart);
+    }
+    gWrapperData.framePacing.endFrame();
 
-    return JNI_TRUE;
+    if (gWrapperData.replay != nullptr && gWrapperData.replay->benchmark)
+    {
+        updateBenchmark(prepared);
+    }
+    updateStartup(prepared);
+
+    return true;
 }
 
 
-JNIEXPORT jint JNICALL
-Java_com_vuforia_engine_native_1sample_VuforiaActivity_00024Companion_getImageTargetId(JNIEnv* /* env */, jobject /* this */)
+void
+updateThermalGovernor(std::chrono::steady_clock::duration frameTime)
 {
-    return AppController::IMAGE_TARGET_ID;
+    gWrapperData.thermalMonitor.poll();
+    std::chrono::duration<float, std::milli> milliseconds = frameTime;
+    if (controller.updateThermalGovernor(gWrapperData.thermalMonitor.getStatus(), gWrapperData.thermalMonitor.getHeadroom(),
+                                         milliseconds.count()) ||
+        !gWrapperData.thermalLevelApplied)
+    {
+        const ThermalGovernor::Level& level = controller.getThermalLevel();
+        gWrapperData.renderer.setMaxAugmentationScale(level.maxRenderScale);
+        gWrapperData.thermalFrameRateCap = level.frameRateCap;
+        applyFrameRateCap();
+        gWrapperData.thermalLevelApplied = true;
+    }
 }
 
 
-JNIEXPORT jint JNICALL
-Java_com_vuforia_engine_native_1sample_VuforiaActivity_00024Companion_getModelTargetId(JNIEnv* /* env */, jobject /* this */)
+void
+applyFrameRateCap()
 {
-    return AppController::MODEL_TARGET_ID;
+    // The lower of the two caps, 0 is no cap
+    int cap = gWrapperData.thermalFrameRateCap;
+    if (gWrapperData.idle && (cap == 0 || IDLE_FRAME_RATE_CAP < cap))
+    {
+        cap = IDLE_FRAME_RATE_CAP;
+    }
+    gWrapperData.framePacing.setFrameRateCap(cap);
 }
 
 
 void
-accessFusionProviderPointers()
+updateStartup(bool rendered)
 {
-    // This method is only called if Vuforia Engine is using ARCore, see startAR above
-
-    auto platformController = controller.getPlatformController();
-    assert(platformController);
-    VuPlatformARCoreInfo arcoreInfo;
-    if (vuPlatformControllerGetARCoreInfo(platformController, &arcoreInfo) != VU_SUCCESS)
+    StartupOrchestrator& startup = gWrapperData.startup;
+    if (startup.isComplete())
     {
-        LOG("Error getting ARCore info");
         return;
     }
+    // Ignored unless the prefetch is still running
+    if (gWrapperData.renderer.areAssetsReady(gWrapperData.renderTarget))
+    {
+        startup.end(STARTUP_ASSETS);
+    }
+    // The rendering thread only polls, it keeps rendering the video background while waiting
+    if (rendered && startup.isReady(STARTUP_FIRST_FRAME))
+    {
+        startup.run(STARTUP_FIRST_FRAME, []() { return true; });
+    }
+}
 
-    auto arSession = static_cast<ArSession*>(arcoreInfo.arSession);
-    auto arFrame = static_cast<ArFrame*>(arcoreInfo.arFrame);
 
-    ArConfig* config;
-    ArConfig_create((const ArSession*)arSession, &config);
-    ArSession_getConfig(arSession, config);
+void
+postRenderCommand(JNIEnv* env, jobject activity, RenderCommand::Type type)
+{
+    // Only called on the UI thread, the single producer of the commands and consumer of their completions
+    drainRenderCommandCompletions(env, activity);
+    if (!gWrapperData.renderCommands.push(RenderCommand{ type }))
+    {
+        LOG("Render command queue full, command %d dropped", static_cast<int>(type));
+    }
+}
 
-    // Simple demonstration of access to the ARCore objects,
-    // log the focus mode and current tracking state.
-    // This code runs every frame but only generates log messages
-    // every 5 seconds to avoid flooding the log output.
-    static std::chrono::time_point lastLog = std::chrono::steady_clock::now();
-    auto now = std::chrono::steady_clock::now();
-    if ((now - lastLog) > std::chrono::seconds(5))
+
+void
+drainRenderCommandCompletions(JNIEnv* env, jobject activity)
+{
+    // On the UI thread, each result is handed to the activity that posted the command
+    RenderCommandCompletion completion;
+    while (gWrapperData.renderCommandCompletions.pop(completion))
     {
-        lastLog = now;
+        if (!completion.succeeded)
+        {
+            LOG("Render command %d failed", static_cast<int>(completion.type));
+        }
+        env->CallVoidMethod(activity, gWrapperData.renderCommandCompletedMethodID, static_cast<jint>(completion.type),
+                            completion.succeeded ? JNI_TRUE : JNI_FALSE);
+    }
+}
 
-        ArFocusMode focusMode;
-        ArConfig_getFocusMode((const ArSession*)arSession, config, &focusMode);
-        LOG("focusMode is %d", focusMode);
 
-        ArCamera* arCamera;
-        ArFrame_acquireCamera(arSession, arFrame, &arCamera);
-        ArTrackingState trackingState;
-        ArCamera_getTrackingState(arSession, arCamera, &trackingState);
-        switch (trackingState)
+void
+runRenderCommands()
+{
+    // Wait-free, everything the UI thread posted since the last frame
+    RenderCommand command;
+    bool completed = false;
+    while (gWrapperData.renderCommands.pop(command))
+    {
+        bool succeeded = false;
+        switch (command.type)
         {
-            case AR_TRACKING_STATE_STOPPED:
-                LOG("trackingState is stopped");
+            case RenderCommand::Type::PERFORM_AUTO_FOCUS:
+                succeeded = controller.cameraPerformAutoFocus();
+                // Vuforia sets the focus mode through the ARCore session config
+                gWrapperData.arcore.invalidateConfig();
                 break;
-            case AR_TRACKING_STATE_TRACKING:
-                LOG("trackingState is tracking");
+            case RenderCommand::Type::RESTORE_AUTO_FOCUS:
+                succeeded = controller.cameraRestoreAutoFocus();
+                gWrapperData.arcore.invalidateConfig();
                 break;
-            case AR_TRACKING_STATE_PAUSED:
-                LOG("trackingState is paused");
+            case RenderCommand::Type::START_AR:
+                succeeded = startARFromRenderCommand();
                 break;
         }
+        gWrapperData.renderCommandCompletions.push(RenderCommandCompletion{ command.type, succeeded });
+        completed = true;
+    }
+
+    // The activity drains the completions on the UI thread, without waiting for its next command
+    JNIEnv* env = nullptr;
+    if (completed && gWrapperData.activity != nullptr && gWrapperData.vm->GetEnv((void**)&env, JNI_VERSION_1_6) == 0)
+    {
+        env->CallVoidMethod(gWrapperData.activity, gWrapperData.renderCommandsCompletedMethodID);
+    }
+}
+
+
+bool
+startARFromRenderCommand()
+{
+    // A start posted again while running, e.g. by a resume racing the first start, leaves AR running
+    if (controller.isARStarted())
+    {
+        return true;
+    }
+
+    // Update usingARCore flag to avoid checking this every frame
+    auto platformController = controller.getPlatformController();
+    if (platformController == nullptr)
+    {
+        LOG("Failed to start AR, Vuforia is not initialized");
+        return false;
+    }
+    VuFusionProviderPlatformType fusionProviderPlatformType{ VU_FUSION_PROVIDER_PLATFORM_TYPE_UNKNOWN };
+    vuPlatformControllerGetFusionProviderPlatformType(platformController, &fusionProviderPlatformType);
+    gWrapperData.usingARCore = (fusionProviderPlatformType == VU_FUSION_PROVIDER_PLATFORM_TYPE_ARCORE);
+
+    return gWrapperData.startup.run(STARTUP_START_AR, []() { return controller.startAR(); });
+}
+
+
+void
+checkFrameAllocations()
+{
+    AllocationCounter::Counts counts = AllocationCounter::end();
+    if (counts.allocations == 0)
+    {
+        return;
+    }
+    LOG("Frame allocated %zu times, %zu bytes, between prepareToRender and finishRender", counts.allocations, counts.bytes);
+    if (gWrapperData.allocationCheck == AllocationCheck::ABORT)
+    {
+        abort();
+    }
+}
+
+
+void
+updateBenchmark(bool rendered)
+{
+    if (gWrapperData.benchmarkReported)
+    {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (rendered && gWrapperData.benchmarkFrames++ == 0)
+    {
+        gWrapperData.benchmarkStart = now;
+    }
+
+    const FileDriverConfig& replay = *gWrapperData.replay;
+    if (!replay.finished)
+    {
+        return;
+    }
+    gWrapperData.benchmarkReported = true;
+
+    // One key=value record per line, so that runs of different builds can be collected from logcat and compared
+    double trackingSeconds = static_cast<double>(replay.endTime - replay.startTime) * 1.0e-9;
+    double renderSeconds = std::chrono::duration<double>(now - gWrapperData.benchmarkStart).count();
+    int trackedFrames = replay.deliveredFrames;
+    LOG("benchmark recording=%s", replay.path);
+    LOG("benchmark stage=tracking frames=%d seconds=%.3f fps=%.2f p50_ms=%.3f p90_ms=%.3f p99_ms=%.3f", trackedFrames, trackingSeconds,
+        trackingSeconds > 0.0 ? trackedFrames / trackingSeconds : 0.0, replay.trackingP50, replay.trackingP90, replay.trackingP99);
+    LOG("benchmark stage=render frames=%d seconds=%.3f fps=%.2f", gWrapperData.benchmarkFrames, renderSeconds,
+        renderSeconds > 0.0 ? gWrapperData.benchmarkFrames / renderSeconds : 0.0);
+    for (const auto& section : gWrapperData.profiler.getStatistics())
+    {
+        LOG("benchmark stage=%s cpu_p50_ms=%.3f cpu_p90_ms=%.3f cpu_p99_ms=%.3f gpu_samples=%d gpu_p50_ms=%.3f gpu_p90_ms=%.3f "
+            "gpu_p99_ms=%.3f",
+            section.name, section.cpu.p50, section.cpu.p90, section.cpu.p99, section.gpuSamples, section.gpu.p50, section.gpu.p90,
+            section.gpu.p99);
+    }
+    MemoryAccounting::Totals memory = gWrapperData.renderer.getMemoryAccounting().getTotals();
+    LOG("benchmark stage=memory cpu_high_water_bytes=%zu gpu_high_water_bytes=%zu", memory.cpuHighWaterBytes, memory.gpuHighWaterBytes);
+}
+
+
+std::string
+formatProcessMemory()
+{
+    // Most of the native heap beyond the accounted assets is Vuforia Engine state, e.g. its datasets and camera frames
+    long residentPages = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm != nullptr)
+    {
+        if (fscanf(statm, "%*s %ld", &residentPages) != 1)
+        {
+            residentPages = 0;
+        }
+        fclose(statm);
     }
+    struct mallinfo heap = mallinfo();
 
-    ArConfig_destroy(config);
+    char line[160];
+    snprintf(line, sizeof(line), "memory process resident_bytes=%zu native_heap_bytes=%zu\n",
+             static_cast<size_t>(residentPages) * static_cast<size_t>(sysconf(_SC_PAGESIZE)), static_cast<size_t>(heap.uordblks));
+    return line;
 }
 
+
 #ifdef __cplusplus
 }
 #endif
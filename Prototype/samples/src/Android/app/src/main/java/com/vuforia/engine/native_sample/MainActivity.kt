@@ -26,7 +26,7 @@ class MainActivity : AppCompatActivity() {
 
 
     fun goToActivity(view: View) {
-        if (view.id == btn_image_target.id || view.id == btn_model_target.id) {
+        if (view.id == btn_image_target.id || view.id == btn_model_target.id || view.id == btn_gallery.id) {
 
             val intent = Intent(
                 this@MainActivity,
@@ -34,6 +34,8 @@ class MainActivity : AppCompatActivity() {
             )
             if (view.id == btn_image_target.id) {
                 intent.putExtra("Target", VuforiaActivity.getImageTargetId())
+            } else if (view.id == btn_gallery.id) {
+                intent.putExtra("Target", VuforiaActivity.getGalleryTargetId())
             } else {
                 intent.putExtra("Target", VuforiaActivity.getModelTargetId())
             }
@@ -28,7 +28,8 @@ class Texture {
     var height = 0
     /// The number of channels e.g. 4 for RGBA
     var channels = 4
-    /// The pixel data.
+    /// The pixel data, ARGB colors as returned by Bitmap.getPixels with the top row first.
+    /// Native code converts them to bottom-up RGBA in place, see PixelConvert::argbToRgbaFlipRows.
     var data: ByteBuffer? = null
 
 
@@ -65,32 +66,34 @@ class Texture {
         }
 
 
+        /// Decode a downloaded image, name is only used for the log
+        @JvmStatic
+        fun loadTextureFromBytes(bytes: ByteArray, name: String): Texture? {
+            val bitMap = BitmapFactory.decodeByteArray(bytes, 0, bytes.size)
+            if (bitMap == null) {
+                Log.i("Texture", "Failed to decode texture '$name'")
+                return null
+            }
+            val data = IntArray(bitMap.width * bitMap.height)
+            bitMap.getPixels(data, 0, bitMap.width, 0, 0, bitMap.width, bitMap.height)
+            return loadTextureFromIntBuffer(data, bitMap.width, bitMap.height)
+        }
+
+
         @JvmStatic
         private fun loadTextureFromIntBuffer(
             data: IntArray, width: Int,
             height: Int
         ): Texture? {
-            // Convert:
-            val numPixels = width * height
-            val dataBytes = ByteArray(numPixels * 4)
-            for (p in 0 until numPixels) {
-                val colour = data[p]
-                dataBytes[p * 4] = (colour ushr 16).toByte() // R
-                dataBytes[p * 4 + 1] = (colour ushr 8).toByte() // G
-                dataBytes[p * 4 + 2] = colour.toByte() // B
-                dataBytes[p * 4 + 3] = (colour ushr 24).toByte() // A
-            }
+            // The colors are copied as they are, the byte order conversion and the
+            // vertical flip are vectorized in native code
             val texture: Texture = Texture()
             texture.width = width
             texture.height = height
-            texture.data = ByteBuffer.allocateDirect(dataBytes.size).order(
+            texture.data = ByteBuffer.allocateDirect(width * height * texture.channels).order(
                 ByteOrder.nativeOrder()
             )
-            val rowSize: Int = texture.width * texture.channels
-            for (r in 0 until texture.height) texture.data?.put(
-                dataBytes, rowSize * (texture.height - 1 - r),
-                rowSize
-            )
+            texture.data?.asIntBuffer()?.put(data, 0, width * height)
             texture.data?.rewind()
             return texture
         }
@@ -11,9 +11,14 @@ import android.Manifest
 import android.app.Activity
 import android.content.pm.PackageManager
 import android.content.res.AssetManager
+import android.hardware.display.DisplayManager
+import android.hardware.camera2.CameraCharacteristics
+import android.hardware.camera2.CameraManager
+import android.net.http.HttpResponseCache
 import android.opengl.GLSurfaceView
 import android.os.Build
 import android.os.Bundle
+import android.os.Process
 import android.util.Log
 import android.view.*
 import android.view.GestureDetector.SimpleOnGestureListener
@@ -29,11 +34,16 @@ import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.GlobalScope
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
+import java.io.File
+import java.io.IOException
+import java.net.HttpURLConnection
+import java.net.URL
 import java.nio.ByteBuffer
 import java.util.*
+import java.util.concurrent.Executors
 import javax.microedition.khronos.egl.EGLConfig
 import javax.microedition.khronos.opengles.GL10
-import kotlin.concurrent.schedule
+import kotlin.concurrent.scheduleAtFixedRate
 
 /**
  * Activity to demonstrate how to use Vuforia Image Target and Model Target features,
@@ -50,14 +60,39 @@ class VuforiaActivity : AppCompatActivity(), GLSurfaceView.Renderer, SurfaceHold
 
     private var mPermissionsRequested = false;
 
-    private lateinit var mGLView : GLSurfaceView
+    /// The GLSurfaceView, or a plain SurfaceView rendered into by the native render loop
+    private lateinit var mSurfaceView : SurfaceView
+    private var mGLView : GLSurfaceView? = null
 
     private var mTarget = 0
+    private var mDynamicResolution = false
+    private var mPipelinedTracking = false
+    private var mOptimizeCameraSpeed = false
+    private var mPoseFiltering = false
+    private var mTargetFrameRate = 0
+    private var mThermalGovernor = false
+    private var mIdlePowerMode = false
+    private var mIdleDeactivateObservers = false
+    private var mFramePacing = false
+    private var mProfilerMode = 0
+    private var mProfilerOverlay = false
+    private var mProfilerLogTimer: Timer? = null
+    private var mMemoryReport = false
+    private var mMemoryLogTimer: Timer? = null
+    private var mRecordSession = false
+    private var mReplayRecording: String? = null
+    private var mBenchmark = false
+    private var mNativeRenderLoop = false
+    private var mRenderLoopStarted = false
+    /// Downloads the files of remote artworks one at a time, in the order native code requests them
+    private val mContentDownloader = Executors.newSingleThreadExecutor()
     private var mProgressIndicatorLayout: RelativeLayout? = null
 
     private var mWidth = 0
     private var mHeight = 0
 
+    /// Set on the UI thread when the rendering thread reports the start of AR, read by onDrawFrame on the GL thread
+    @Volatile
     private var mVuforiaStarted = false
     private var mSurfaceChanged = false
 
@@ -66,22 +101,44 @@ class VuforiaActivity : AppCompatActivity(), GLSurfaceView.Renderer, SurfaceHold
     private var mGestureDetector : GestureDetectorCompat? = null
 
     // Native methods
-    private external fun initAR(activity: Activity, assetManager: AssetManager, target: Int)
+    private external fun beginStartup(activity: Activity, assetManager: AssetManager, cacheDirectory: String,
+                                      processStartUptime: Long) : Boolean
+    private external fun initAR(activity: Activity, target: Int, pipelinedTracking: Boolean, optimizeCameraSpeed: Boolean,
+                                poseFiltering: Boolean, thermalGovernor: Boolean, idlePowerMode: Boolean,
+                                idleDeactivateObservers: Boolean)
     private external fun deinitAR()
+    private external fun configureSession(recordingDirectory: String?, cameraOrientation: Int, replayPath: String?,
+                                          benchmark: Boolean)
 
-    private external fun startAR() : Boolean
     private external fun stopAR()
 
+    // Queued for the rendering thread, only call these on the UI thread, the single producer of the queue
+    // The results arrive in renderCommandCompleted, on the UI thread as well.
+    private external fun startAR()
     external fun cameraPerformAutoFocus()
     external fun cameraRestoreAutoFocus()
-
-    private external fun initRendering()
-    private external fun setTextures(astronautWidth: Int, astronautHeight: Int, astronautBytes: ByteBuffer,
-                                     planeWidth: Int, planeHeight: Int, planeBytes: ByteBuffer,
-                                     landerWidth: Int, landerHeight: Int, landerBytes: ByteBuffer)
-    private external fun deinitRendering()
+    private external fun drainRenderCommands()
+
+    private external fun initRendering(target: Int, dynamicResolution: Boolean)
+    private external fun setProfiler(mode: Int, overlay: Boolean)
+    private external fun getProfilerStatistics() : String
+    private external fun setMemoryOptions(cpuBudgetBytes: Long, releaseMeshCopies: Boolean)
+    private external fun setAssetCache(directory: String, budgetBytes: Long)
+    private external fun setAllocationCheck(mode: Int)
+    private external fun getMemoryReport() : String
+    private external fun setTexture(name: String, width: Int, height: Int, bytes: ByteBuffer)
+    private external fun setContent(url: String, bytes: ByteBuffer?)
+    private external fun setContentManifest(text: String)
     private external fun configureRendering(width: Int, height: Int, orientation: Int, rotation: Int) : Boolean
     private external fun renderFrame() : Boolean
+    private external fun startFramePacing(targetFrameRate: Int, refreshPeriod: Long) : Boolean
+    private external fun stopFramePacing()
+    private external fun startRenderLoop(target: Int, dynamicResolution: Boolean, profilerMode: Int, profilerOverlay: Boolean) : Boolean
+    private external fun stopRenderLoop()
+    private external fun setRenderSurface(surface: Surface)
+    private external fun configureRenderSurface(width: Int, height: Int, orientation: Int, rotation: Int)
+    private external fun releaseRenderSurface()
+    private external fun setRenderLoopPaused(paused: Boolean)
 
 
     // Activity methods
@@ -93,20 +150,104 @@ class VuforiaActivity : AppCompatActivity(), GLSurfaceView.Renderer, SurfaceHold
         }
 
         mTarget = intent.getIntExtra("Target", 0)
+        // Optional, e.g. adb shell am start ... --ez DynamicResolution true
+        mDynamicResolution = intent.getBooleanExtra("DynamicResolution", false)
+        mPipelinedTracking = intent.getBooleanExtra("PipelinedTracking", false)
+        // Optional, the faster camera mode jitters without pose filtering, which is on with it unless disabled
+        mOptimizeCameraSpeed = intent.getBooleanExtra("OptimizeCameraSpeed", false)
+        mPoseFiltering = intent.getBooleanExtra("PoseFiltering", mOptimizeCameraSpeed)
+        // Optional, 30, 60 or 90, e.g. adb shell am start ... --ei TargetFrameRate 30
+        mTargetFrameRate = intent.getIntExtra("TargetFrameRate", 0)
+        // Optional, adapts camera mode, render scale and frame rate to the device temperature
+        mThermalGovernor = intent.getBooleanExtra("ThermalGovernor", false)
+        // Optional, renders less often and without augmentations while no target is in view and the device is held
+        // still, and with IdleDeactivateObservers also stops searching for targets then, see IdleDetector
+        mIdlePowerMode = intent.getBooleanExtra("IdlePowerMode", false)
+        mIdleDeactivateObservers = mIdlePowerMode && intent.getBooleanExtra("IdleDeactivateObservers", false)
+        // The governor and idle power mode cap the frame rate through frame pacing
+        mFramePacing = mTargetFrameRate > 0 || mThermalGovernor || mIdlePowerMode
+        // Optional, 1 times the frame sections, 2 also emits them as trace markers, see Profiler
+        mProfilerMode = intent.getIntExtra("Profiler", 0)
+        mProfilerOverlay = intent.getBooleanExtra("ProfilerOverlay", false)
+        // Optional, logs the CPU and GPU memory held by the assets, see MemoryAccounting
+        mMemoryReport = intent.getBooleanExtra("MemoryReport", false)
+        // Optional, the CPU memory in MB the asset loaders keep to, and freeing the CPU copy of the meshes once uploaded
+        val assetMemoryBudgetMB = intent.getIntExtra("AssetMemoryBudgetMB", DEFAULT_ASSET_MEMORY_BUDGET_MB)
+        setMemoryOptions(assetMemoryBudgetMB * 1024L * 1024L, intent.getBooleanExtra("ReleaseMeshCopies", false))
+        // Optional, 1 logs frames allocating on the heap and 2 aborts on the first, needs a native build with
+        // VUFORIA_COUNT_ALLOCATIONS, see AllocationCounter
+        setAllocationCheck(intent.getIntExtra("AllocationCheck", 0))
+        // Optional, the disk space in MB of the meshes and textures processed on earlier launches, 0 processes
+        // every asset again, see AssetCache. The downloads of remote content are cached over HTTP alongside.
+        val assetCacheMB = intent.getIntExtra("AssetCacheMB", DEFAULT_ASSET_CACHE_MB)
+        setAssetCache(File(cacheDir, "asset_cache").absolutePath, assetCacheMB * 1024L * 1024L)
+        if (assetCacheMB > 0 && HttpResponseCache.getInstalled() == null) {
+            try {
+                HttpResponseCache.install(File(cacheDir, "http_cache"), DOWNLOAD_CACHE_MB * 1024L * 1024L)
+            } catch (e: IOException) {
+                Log.e("VuforiaSample", "Failed to install the download cache: ${e.message}")
+            }
+        }
+        // Optional, records the session into the "recordings" directory of the external files, see SessionRecorder
+        mRecordSession = intent.getBooleanExtra("RecordSession", false)
+        // Optional, a recording to replay instead of the camera, a name in the "recordings" directory or a full path
+        mReplayRecording = intent.getStringExtra("ReplayRecording")
+        // Optional with ReplayRecording, replays once as fast as possible and logs the timings of each stage
+        mBenchmark = mReplayRecording != null && intent.getBooleanExtra("Benchmark", false)
+        if (mBenchmark) {
+            // Uncapped, frames are timed by the profiler
+            mFramePacing = false
+            mProfilerMode = maxOf(mProfilerMode, 1)
+        }
+        // Optional, renders on a native thread with its own EGL context instead of from a GLSurfaceView,
+        // this activity then only passes the surface and lifecycle events
+        mNativeRenderLoop = intent.getBooleanExtra("NativeRenderLoop", false)
+        // Optional, a content manifest to download replacing the one in the assets, see ContentManifest
+        val contentManifestUrl = intent.getStringExtra("ContentManifestUrl")
+        if (contentManifestUrl != null) {
+            mContentDownloader.execute {
+                val bytes = downloadContent(contentManifestUrl)
+                if (bytes != null) {
+                    val text = String(bytes, Charsets.UTF_8)
+                    queueForRendering { setContentManifest(text) }
+                }
+            }
+        }
         mVuforiaStarted = false
         mSurfaceChanged = true
 
-        // Create an OpenGL ES 3.0 context (also works for 3.1, 3.2)
-        mGLView = GLSurfaceView(this)
-        mGLView.holder.addCallback(this)
-        mGLView.setEGLContextClientVersion(3)
-        mGLView.setRenderer(this)
-        addContentView(mGLView, ViewGroup.LayoutParams(
+        // Engine creation and the rendering setup run concurrently from here on, timed from the process start.
+        // The trace of the launch is logged and written to startup_trace.json in the cache directory.
+        if (!beginStartup(this, assets, cacheDir.absolutePath, Process.getStartUptimeMillis())) {
+            Log.e("VuforiaSample", "Failed to prepare the startup")
+        }
+
+        if (mNativeRenderLoop) {
+            mSurfaceView = SurfaceView(this)
+            mSurfaceView.holder.addCallback(this)
+            // Rotations by 180 degrees don't change the surface, the display reports them
+            (getSystemService(DISPLAY_SERVICE) as DisplayManager).registerDisplayListener(mDisplayListener, null)
+        } else {
+            // Create an OpenGL ES 3.0 context (also works for 3.1, 3.2)
+            val glView = GLSurfaceView(this)
+            glView.holder.addCallback(this)
+            glView.setEGLContextClientVersion(3)
+            // Paused while AR stops, the GL resources are kept
+            glView.preserveEGLContextOnPause = true
+            glView.setRenderer(this)
+            // With frame pacing renders are requested on the vsyncs picked in native code
+            if (mFramePacing) {
+                glView.renderMode = GLSurfaceView.RENDERMODE_WHEN_DIRTY
+            }
+            mGLView = glView
+            mSurfaceView = glView
+        }
+        addContentView(mSurfaceView, ViewGroup.LayoutParams(
             ViewGroup.LayoutParams.MATCH_PARENT,
             ViewGroup.LayoutParams.MATCH_PARENT)
         )
-        // Hide the GLView until we are ready
-        mGLView.visibility = View.GONE
+        // The view is shown from the start, so that its surface exists and the rendering thread compiles
+        // the shaders and loads the assets while Vuforia initializes, the progress indicator covers it
 
         // Prevent screen from dimming
         window.addFlags(WindowManager.LayoutParams.FLAG_KEEP_SCREEN_ON)
@@ -140,21 +281,72 @@ class VuforiaActivity : AppCompatActivity(), GLSurfaceView.Renderer, SurfaceHold
 
 
     override fun onPause() {
+        if (mFramePacing) {
+            stopFramePacing()
+        }
+        mProfilerLogTimer?.cancel()
+        mProfilerLogTimer = null
+        mMemoryLogTimer?.cancel()
+        mMemoryLogTimer = null
+        pauseRendering()
         stopAR()
+        HttpResponseCache.getInstalled()?.flush()
         super.onPause()
     }
 
 
+    override fun onDestroy() {
+        if (mNativeRenderLoop) {
+            (getSystemService(DISPLAY_SERVICE) as DisplayManager).unregisterDisplayListener(mDisplayListener)
+        }
+        if (mRenderLoopStarted) {
+            stopRenderLoop()
+            mRenderLoopStarted = false
+        }
+        mContentDownloader.shutdownNow()
+        super.onDestroy()
+    }
+
+
     override fun onResume() {
         super.onResume()
 
         makeFullScreen()
 
+        if (mFramePacing) {
+            val refreshPeriod = (1.0e9 / windowManager.defaultDisplay.refreshRate).toLong()
+            if (!startFramePacing(mTargetFrameRate, refreshPeriod)) {
+                Log.e("VuforiaSample", "Failed to start frame pacing")
+                mFramePacing = false
+                mGLView?.renderMode = GLSurfaceView.RENDERMODE_CONTINUOUSLY
+            }
+        }
+
+        if (mRenderLoopStarted) {
+            setRenderLoopPaused(false)
+        }
+        mGLView?.onResume()
+
+        if (mProfilerMode > 0) {
+            mProfilerLogTimer = Timer("ProfilerLog", true).apply {
+                scheduleAtFixedRate(PROFILER_LOG_PERIOD_MS, PROFILER_LOG_PERIOD_MS) {
+                    Log.i("VuforiaSample", "Frame sections:\n" + getProfilerStatistics())
+                }
+            }
+        }
+
+        if (mMemoryReport) {
+            mMemoryLogTimer = Timer("MemoryLog", true).apply {
+                scheduleAtFixedRate(MEMORY_LOG_PERIOD_MS, MEMORY_LOG_PERIOD_MS) {
+                    Log.i("VuforiaSample", "Memory:\n" + getMemoryReport())
+                }
+            }
+        }
+
         if (runtimePermissionsGranted()) {
+            // Runs with the first frame after rendering resumed
             if (!mPermissionsRequested && mVuforiaStarted) {
-                GlobalScope.launch(Dispatchers.Unconfined) {
-                    startAR()
-                }
+                startAR()
             }
         } else {
             ActivityCompat.requestPermissions(this, REQUIRED_PERMISSIONS, 0)
@@ -164,10 +356,18 @@ class VuforiaActivity : AppCompatActivity(), GLSurfaceView.Renderer, SurfaceHold
     }
 
 
+    override fun onTrimMemory(level: Int) {
+        super.onTrimMemory(level)
+        // Logged whenever the system asks, which assets were held is what matters when the app gets killed later
+        Log.i("VuforiaSample", "Trim memory level $level:\n" + getMemoryReport())
+    }
+
+
     override fun onBackPressed() {
         // Hide the GLView while we clean up
-        mGLView.visibility = View.INVISIBLE
+        mSurfaceView.visibility = View.INVISIBLE
         // Stop Vuforia Engine and call parent to navigate back
+        pauseRendering()
         stopAR()
         mVuforiaStarted = false
         deinitAR()
@@ -219,15 +419,8 @@ class VuforiaActivity : AppCompatActivity(), GLSurfaceView.Renderer, SurfaceHold
     /// Custom GestureListener to capture single and double tap
     inner class GestureListener : SimpleOnGestureListener() {
         override fun onSingleTapUp(e: MotionEvent): Boolean {
-            // Calls the Autofocus Native Method
+            // Calls the Autofocus Native Method, continuous autofocus is restored once it succeeded
             cameraPerformAutoFocus()
-
-            // After triggering a focus event wait 2 seconds
-            // before restoring continuous autofocus
-            Timer("RestoreAutoFocus", false).schedule(2000) {
-                cameraRestoreAutoFocus()
-            }
-
             return true
         }
 
@@ -245,18 +438,39 @@ class VuforiaActivity : AppCompatActivity(), GLSurfaceView.Renderer, SurfaceHold
                 View.SYSTEM_UI_FLAG_LAYOUT_STABLE or
                 View.SYSTEM_UI_FLAG_IMMERSIVE_STICKY or
                 View.SYSTEM_UI_FLAG_LAYOUT_HIDE_NAVIGATION or
-                View.SYSTEM_UI_FLAG_HIDE_NAVIGATION).also { mGLView.systemUiVisibility = it }
+                View.SYSTEM_UI_FLAG_HIDE_NAVIGATION).also { mSurfaceView.systemUiVisibility = it }
         supportActionBar?.setDisplayHomeAsUpEnabled(true)
     }
 
 
     private suspend fun initializeVuforia() {
         return withContext(Dispatchers.Default) {
-            initAR(this@VuforiaActivity, this@VuforiaActivity.assets, mTarget)
+            val recordingsDirectory = getExternalFilesDir("recordings")
+            recordingsDirectory?.mkdirs()
+            val replayPath = mReplayRecording?.let {
+                if (File(it).isAbsolute) it else File(recordingsDirectory, it).absolutePath
+            }
+            configureSession(if (mRecordSession) recordingsDirectory?.absolutePath else null, getCameraOrientation(),
+                             replayPath, mBenchmark)
+            initAR(this@VuforiaActivity, mTarget, mPipelinedTracking, mOptimizeCameraSpeed, mPoseFiltering, mThermalGovernor,
+                   mIdlePowerMode, mIdleDeactivateObservers)
         }
     }
 
 
+    /// Rotation of the back camera sensor in degrees, stored in recordings for playback
+    private fun getCameraOrientation(): Int {
+        val cameraManager = getSystemService(CAMERA_SERVICE) as CameraManager
+        for (cameraId in cameraManager.cameraIdList) {
+            val characteristics = cameraManager.getCameraCharacteristics(cameraId)
+            if (characteristics.get(CameraCharacteristics.LENS_FACING) == CameraCharacteristics.LENS_FACING_BACK) {
+                return characteristics.get(CameraCharacteristics.SENSOR_ORIENTATION) ?: 0
+            }
+        }
+        return 0
+    }
+
+
     private fun runtimePermissionsGranted(): Boolean {
         var result = true
         for (permission in REQUIRED_PERMISSIONS) {
@@ -276,6 +490,7 @@ class VuforiaActivity : AppCompatActivity(), GLSurfaceView.Renderer, SurfaceHold
         builder.setTitle(R.string.error_dialog_title)
         builder.setPositiveButton(R.string.ok
         ) { _, _ ->
+            pauseRendering()
             stopAR()
             deinitAR()
             this@VuforiaActivity.finish()
@@ -290,42 +505,168 @@ class VuforiaActivity : AppCompatActivity(), GLSurfaceView.Renderer, SurfaceHold
     }
 
 
+    /// Called from native code on the main thread on the vsyncs frame pacing renders at
+    @Suppress("unused")
+    private fun requestRender() {
+        mGLView?.requestRender()
+    }
+
+
+    /// Called from native code on the rendering thread when the assets of a target are first needed
+    /// Only used before Android 11, newer devices decode the textures in native code
+    @Suppress("unused")
+    private fun requestTexture(name: String) {
+        // Decode off the rendering thread, the texture is created on the rendering thread once ready
+        GlobalScope.launch(Dispatchers.IO) {
+            val texture = Texture.loadTextureFromApk(name, assets)
+            if (texture != null) {
+                queueForRendering { setTexture(name, texture.width, texture.height, texture.data!!) }
+            } else {
+                Log.e("VuforiaSample", "Failed to load texture $name")
+            }
+        }
+    }
+
+
+    /// Called from native code on the rendering thread for the files of remote artworks
+    /// With decodeImage the image is decoded here and answered with setTexture, as for requestTexture.
+    /// The files are downloaded in request order, which puts the coarse variants of an artwork first.
+    @Suppress("unused")
+    private fun requestContent(url: String, decodeImage: Boolean) {
+        mContentDownloader.execute {
+            val bytes = downloadContent(url)
+            val texture = if (decodeImage && bytes != null) Texture.loadTextureFromBytes(bytes, url) else null
+            if (texture != null) {
+                queueForRendering { setTexture(url, texture.width, texture.height, texture.data!!) }
+            } else {
+                // A null buffer tells native code the download failed, so that it can be requested again
+                val buffer = if (decodeImage || bytes == null) null else ByteBuffer.allocateDirect(bytes.size).put(bytes)
+                queueForRendering { setContent(url, buffer) }
+            }
+        }
+    }
+
+
+    /// Read a file from a content service, gzip encoded responses are inflated by HttpURLConnection
+    private fun downloadContent(url: String): ByteArray? {
+        return try {
+            val connection = URL(url).openConnection() as HttpURLConnection
+            connection.connectTimeout = CONTENT_TIMEOUT_MS
+            connection.readTimeout = CONTENT_TIMEOUT_MS
+            try {
+                if (connection.responseCode == HttpURLConnection.HTTP_OK) {
+                    connection.inputStream.use { it.readBytes() }
+                } else {
+                    Log.e("VuforiaSample", "Failed to download $url: HTTP ${connection.responseCode}")
+                    null
+                }
+            } finally {
+                connection.disconnect()
+            }
+        } catch (e: IOException) {
+            Log.e("VuforiaSample", "Failed to download $url: ${e.message}")
+            null
+        }
+    }
+
+
+    /// Return once no frame is rendering, so that AR can be stopped without racing renderFrame
+    /// The frames resume in onResume. Requests queued meanwhile, like autofocus or starting AR, run with the next frame.
+    private fun pauseRendering() {
+        if (mRenderLoopStarted) {
+            setRenderLoopPaused(true)
+        } else {
+            // Blocks until the GL thread has paused
+            mGLView?.onPause()
+        }
+    }
+
+
+    /// Run a call into the renderer on the rendering thread
+    /// The native render loop queues the calls for its thread itself.
+    private fun queueForRendering(call: () -> Unit) {
+        if (mNativeRenderLoop) {
+            call()
+        } else {
+            mGLView?.queueEvent { call() }
+        }
+    }
+
+
     @Suppress("unused")
     private fun initDone() {
-        mVuforiaStarted = startAR()
-        if (!mVuforiaStarted) {
-            Log.e("VuforiaSample", "Failed to start AR")
+        // Called on the init thread, the commands are posted from the UI thread only
+        runOnUiThread { startAR() }
+    }
+
+
+    /// Called from native code on the rendering thread once it ran commands, their results are taken on the UI thread
+    @Suppress("unused")
+    private fun renderCommandsCompleted() {
+        runOnUiThread { drainRenderCommands() }
+    }
+
+
+    /// Called from native code on the UI thread with the result of a command queued for the rendering thread
+    @Suppress("unused")
+    private fun renderCommandCompleted(command: Int, succeeded: Boolean) {
+        when (command) {
+            RENDER_COMMAND_START_AR -> {
+                mVuforiaStarted = succeeded
+                if (!succeeded) {
+                    Log.e("VuforiaSample", "Failed to start AR")
+                }
+            }
+            RENDER_COMMAND_PERFORM_AUTO_FOCUS -> {
+                // After triggering a focus event wait 2 seconds before restoring continuous autofocus
+                if (succeeded) {
+                    mSurfaceView.postDelayed({ cameraRestoreAutoFocus() }, AUTO_FOCUS_RESTORE_DELAY_MS)
+                } else {
+                    Log.w("VuforiaSample", "Failed to trigger autofocus")
+                }
+            }
+            RENDER_COMMAND_RESTORE_AUTO_FOCUS -> {
+                if (!succeeded) {
+                    Log.w("VuforiaSample", "Failed to restore continuous autofocus")
+                }
+            }
         }
-        // Show the GLView
+    }
+
+
+    /// Called from native code on the render thread of the native render loop once it showed a frame
+    @Suppress("unused")
+    private fun firstFrameRendered() {
         GlobalScope.launch(Dispatchers.Main) {
-            mGLView.visibility = View.VISIBLE
+            mProgressIndicatorLayout?.visibility = View.GONE
         }
     }
 
 
     // GLSurfaceView.Renderer methods
     override fun onSurfaceCreated(unused: GL10, config: EGLConfig) {
-        initRendering()
+        // The governor lowers the render scale through dynamic resolution
+        initRendering(mTarget, mDynamicResolution || mThermalGovernor)
+        setProfiler(mProfilerMode, mProfilerOverlay)
     }
 
 
     override fun onDrawFrame(unused: GL10) {
-        if (mVuforiaStarted) {
+        if (mVuforiaStarted &&
+            (mSurfaceChanged || mWindowDisplayRotation != windowManager.defaultDisplay.rotation)) {
+            mSurfaceChanged = false
+            mWindowDisplayRotation = windowManager.defaultDisplay.rotation
 
-            if (mSurfaceChanged || mWindowDisplayRotation != windowManager.defaultDisplay.rotation) {
-                mSurfaceChanged = false
-                mWindowDisplayRotation = windowManager.defaultDisplay.rotation
+            // Pass rendering parameters to Vuforia Engine
+            configureRendering(mWidth, mHeight, resources.configuration.orientation, mWindowDisplayRotation)
+        }
 
-                // Pass rendering parameters to Vuforia Engine
-                configureRendering(mWidth, mHeight, resources.configuration.orientation, mWindowDisplayRotation)
-            }
-
-            // OpenGL rendering of Video Background and augmentations is implemented in native code
-            val didRender = renderFrame()
-            if (didRender && mProgressIndicatorLayout?.visibility != View.GONE) {
-                GlobalScope.launch(Dispatchers.Main) {
-                    mProgressIndicatorLayout?.visibility = View.GONE
-                }
+        // OpenGL rendering of Video Background and augmentations is implemented in native code,
+        // until Vuforia started it only clears and uploads the assets loaded during startup
+        val didRender = renderFrame()
+        if (didRender && mProgressIndicatorLayout?.visibility != View.GONE) {
+            GlobalScope.launch(Dispatchers.Main) {
+                mProgressIndicatorLayout?.visibility = View.GONE
             }
         }
     }
@@ -336,39 +677,80 @@ class VuforiaActivity : AppCompatActivity(), GLSurfaceView.Renderer, SurfaceHold
         mWidth = width
         mHeight = height
 
-        // Re-load textures in case they got destroyed
-        val astronautTexture = Texture.loadTextureFromApk("plane.jpg", assets)
-        val planeTexture = Texture.loadTextureFromApk("plane.jpg", assets)
-        val landerTexture = Texture.loadTextureFromApk("VikingLander.jpg", assets)
-        if (astronautTexture != null && planeTexture != null && landerTexture != null) {
-            setTextures(
-                astronautTexture.width, astronautTexture.height, astronautTexture.data!!,
-                planeTexture.width, planeTexture.height, planeTexture.data!!,
-                landerTexture.width, landerTexture.height, landerTexture.data!!
-            )
-        } else {
-            Log.e("VuforiaSample", "Failed to load astronaut or lander texture")
-        }
-
         // Update flag to tell us we need to update Vuforia configuration
         mSurfaceChanged = true
     }
 
 
     // SurfaceHolder.Callback
-    override fun surfaceCreated(var1: SurfaceHolder) {}
+    override fun surfaceCreated(holder: SurfaceHolder) {
+        if (!mNativeRenderLoop) {
+            return
+        }
+        // Started with the first surface, like the GLSurfaceView starts its rendering thread
+        if (!mRenderLoopStarted) {
+            // The governor lowers the render scale through dynamic resolution
+            mRenderLoopStarted = startRenderLoop(mTarget, mDynamicResolution || mThermalGovernor, mProfilerMode, mProfilerOverlay)
+            if (!mRenderLoopStarted) {
+                Log.e("VuforiaSample", "Failed to start the native render loop")
+                return
+            }
+        }
+        setRenderSurface(holder.surface)
+    }
+
+
+    override fun surfaceChanged(holder: SurfaceHolder, format: Int, width: Int, height: Int) {
+        if (mRenderLoopStarted) {
+            mWidth = width
+            mHeight = height
+            mWindowDisplayRotation = windowManager.defaultDisplay.rotation
+            configureRenderSurface(width, height, resources.configuration.orientation, mWindowDisplayRotation)
+        }
+    }
 
 
-    override fun surfaceChanged(var1: SurfaceHolder, var2: Int, var3: Int, var4: Int) {}
+    override fun surfaceDestroyed(holder: SurfaceHolder) {
+        // The surface must not be used once this returns, the context and GL resources are kept
+        if (mRenderLoopStarted) {
+            releaseRenderSurface()
+        }
+        // The GLSurfaceView keeps its EGL context across pause as well and no context is current on this thread,
+        // if the context is lost anyway onSurfaceCreated runs initRendering again, which forgets the old GL objects
+    }
+
+
+    private val mDisplayListener = object : DisplayManager.DisplayListener {
+        override fun onDisplayAdded(displayId: Int) {}
 
+        override fun onDisplayRemoved(displayId: Int) {}
 
-    override fun surfaceDestroyed(var1: SurfaceHolder) {
-        deinitRendering()
+        override fun onDisplayChanged(displayId: Int) {
+            val rotation = windowManager.defaultDisplay.rotation
+            if (mRenderLoopStarted && rotation != mWindowDisplayRotation) {
+                mWindowDisplayRotation = rotation
+                configureRenderSurface(mWidth, mHeight, resources.configuration.orientation, rotation)
+            }
+        }
     }
 
 
     companion object {
+        private const val PROFILER_LOG_PERIOD_MS = 5000L
+        private const val MEMORY_LOG_PERIOD_MS = 5000L
+        // The default CPU budget of MemoryAccounting
+        private const val DEFAULT_ASSET_MEMORY_BUDGET_MB = 64
+        private const val CONTENT_TIMEOUT_MS = 15000
+        private const val AUTO_FOCUS_RESTORE_DELAY_MS = 2000L
+        // The RenderCommand types of the native code
+        private const val RENDER_COMMAND_PERFORM_AUTO_FOCUS = 0
+        private const val RENDER_COMMAND_RESTORE_AUTO_FOCUS = 1
+        private const val RENDER_COMMAND_START_AR = 2
+        private const val DEFAULT_ASSET_CACHE_MB = 128
+        private const val DOWNLOAD_CACHE_MB = 64L
+
         external fun getImageTargetId() : Int
         external fun getModelTargetId() : Int
+        external fun getGalleryTargetId() : Int
     }
 }
@@ -0,0 +1,212 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "AllocationCounter.h"
+
+#ifdef VUFORIA_COUNT_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+#endif
+
+
+namespace
+{
+/// Plain thread locals without constructors, operator new may run before anything else on a thread
+thread_local bool tCounting = false;
+thread_local size_t tAllocations = 0;
+thread_local size_t tBytes = 0;
+
+#ifdef VUFORIA_COUNT_ALLOCATIONS
+void
+count(size_t size)
+{
+    if (tCounting)
+    {
+        ++tAllocations;
+        tBytes += size;
+    }
+}
+
+
+void*
+allocate(size_t size, size_t alignment)
+{
+    count(size);
+    void* memory = nullptr;
+    if (alignment <= alignof(std::max_align_t))
+    {
+        memory = malloc(size == 0 ? 1 : size);
+    }
+    else if (posix_memalign(&memory, alignment, size == 0 ? 1 : size) != 0)
+    {
+        memory = nullptr;
+    }
+    return memory;
+}
+
+
+void*
+allocateOrThrow(size_t size, size_t alignment)
+{
+    void* memory = allocate(size, alignment);
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+#endif
+} // anonymous namespace
+
+
+bool
+AllocationCounter::isAvailable()
+{
+#ifdef VUFORIA_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+void
+AllocationCounter::begin()
+{
+    tAllocations = 0;
+    tBytes = 0;
+    tCounting = true;
+}
+
+
+AllocationCounter::Counts
+AllocationCounter::end()
+{
+    tCounting = false;
+    Counts counts;
+    counts.allocations = tAllocations;
+    counts.bytes = tBytes;
+    return counts;
+}
+
+
+AllocationCounter::Pause::Pause(bool active) : mWasCounting(tCounting)
+{
+    if (active)
+    {
+        tCounting = false;
+    }
+}
+
+
+AllocationCounter::Pause::~Pause()
+{
+    tCounting = mWasCounting;
+}
+
+
+#ifdef VUFORIA_COUNT_ALLOCATIONS
+// The replacements go to malloc like the default ones do on Android, so memory allocated before counting
+// started or in other libraries can still be freed through them.
+
+void*
+operator new(size_t size)
+{
+    return allocateOrThrow(size, 0);
+}
+
+
+void*
+operator new[](size_t size)
+{
+    return allocateOrThrow(size, 0);
+}
+
+
+void*
+operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size, 0);
+}
+
+
+void*
+operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size, 0);
+}
+
+
+void*
+operator new(size_t size, std::align_val_t alignment)
+{
+    return allocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+
+void*
+operator new[](size_t size, std::align_val_t alignment)
+{
+    return allocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+
+void
+operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+
+void
+operator delete[](void* memory) noexcept
+{
+    free(memory);
+}
+
+
+void
+operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+
+void
+operator delete[](void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+
+void
+operator delete(void* memory, std::align_val_t) noexcept
+{
+    free(memory);
+}
+
+
+void
+operator delete[](void* memory, std::align_val_t) noexcept
+{
+    free(memory);
+}
+
+
+void
+operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+    free(memory);
+}
+
+
+void
+operator delete[](void* memory, size_t, std::align_val_t) noexcept
+{
+    free(memory);
+}
+#endif
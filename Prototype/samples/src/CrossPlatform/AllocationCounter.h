@@ -0,0 +1,53 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __ALLOCATIONCOUNTER_H__
+#define __ALLOCATIONCOUNTER_H__
+
+#include <cstddef>
+
+
+/// Counts the heap allocations of a thread between begin and end, to find allocations in the frames
+/**
+ * Counting replaces the global operator new and is only compiled in with VUFORIA_COUNT_ALLOCATIONS
+ * defined, see the CMake option of the same name. Without it isAvailable returns false and nothing is counted.
+ * Only the C++ allocations of the thread that called begin are counted, malloc calls of C code such as the
+ * engine and the GL driver are not, nor are the allocations of other threads like the asset loaders.
+ */
+namespace AllocationCounter
+{
+struct Counts
+{
+    size_t allocations = 0;
+    size_t bytes = 0;
+};
+
+bool isAvailable();
+
+/// Start counting the allocations of the calling thread from zero
+void begin();
+
+/// Stop counting on the calling thread and return the allocations since begin
+Counts end();
+
+/// Leaves the allocations of its lifetime out of the counts, for work that allocates by design
+/// such as handing over loaded assets. Does nothing if active is false.
+class Pause
+{
+public:
+    explicit Pause(bool active = true);
+    ~Pause();
+
+    Pause(const Pause&) = delete;
+    Pause& operator=(const Pause&) = delete;
+
+private:
+    bool mWasCounting;
+};
+} // namespace AllocationCounter
+
+#endif /* __ALLOCATIONCOUNTER_H__ */
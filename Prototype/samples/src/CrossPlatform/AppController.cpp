@@ -7,7 +7,9 @@ countries.
 
 #include "AppController.h"
 
+#include "GalleryTargets.h"
 #include "Log.h"
+#include "MatrixMath.h"
 
 #include <algorithm>
 #include <cassert>
@@ -48,25 +50,49 @@ constexpr float FAR_PLANE = 5.f;
 
 void
 AppController::initAR(const InitConfig& initConfig, int target)
+{
+    if (initEngine(initConfig, target) && initObservers())
+    {
+        mInitDoneCallback();
+    }
+}
+
+
+bool
+AppController::initEngine(const InitConfig& initConfig, int target)
 {
     mVbRenderBackend = initConfig.vbRenderBackend;
     mShowErrorCallback = initConfig.showErrorCallback;
     mInitDoneCallback = initConfig.initDoneCallback;
     mTarget = target;
+    // Gallery observers are switched on the callback thread, where activation does not block
+    mPipelinedTracking = initConfig.pipelinedTracking || target == GALLERY_TARGET_ID;
+    mCameraVideoMode = initConfig.cameraVideoMode;
+    mThermalGovernorEnabled = initConfig.thermalGovernor;
+    if (mThermalGovernorEnabled)
+    {
+        mThermalGovernor.setConfig(initConfig.thermalGovernorConfig);
+        mCameraVideoMode = mThermalGovernor.getLevel().cameraVideoMode;
+    }
+    mPoseFiltering = initConfig.poseFiltering;
+    mIdlePowerMode = initConfig.idlePowerMode;
+    mIdleDeactivateObservers = initConfig.idleDeactivateObservers;
+    mIdleDetector.setConfig(initConfig.idleConfig);
+    mReplay = initConfig.replay;
+    // A replayed session is not recorded again
+    mRecordingDirectory = mReplay == nullptr ? initConfig.recordingDirectory : std::string();
+    mCameraOrientation = initConfig.cameraOrientation;
 
     mGuideViewModelTarget = nullptr;
 
-    if (!initVuforiaInternal(initConfig.appData))
-    {
-        return;
-    }
+    return initVuforiaInternal(initConfig.appData);
+}
 
-    if (!createObservers())
-    {
-        return;
-    }
 
-    mInitDoneCallback();
+bool
+AppController::initObservers()
+{
+    return createObservers();
 }
 
 
@@ -99,6 +125,21 @@ AppController::startAR()
         LOG("Failed to set active video mode %d for camera device", static_cast<int>(mCameraVideoMode));
     }
 
+    // Snapshots are taken of every state from the first camera frame on
+    if (mPipelinedTracking && vuEngineRegisterStateHandler(mEngine, &AppController::onVuforiaState, this) != VU_SUCCESS)
+    {
+        LOG("Failed to register the state handler, tracking is not pipelined");
+        mPipelinedTracking = false;
+    }
+
+    // Every session starts awake, with the observers a previous session left idle active again
+    mIdleDetector.reset();
+    if (mIdleObserversDeactivated)
+    {
+        setTargetObserversActive(true);
+        mIdleObserversDeactivated = false;
+    }
+
     // Start engine
     if (vuEngineStart(mEngine) != VU_SUCCESS)
     {
@@ -108,6 +149,11 @@ AppController::startAR()
 
     mARStarted = true;
 
+    if (!mRecordingDirectory.empty() && !mSessionRecorder.start(mEngine, mRecordingDirectory, mCameraOrientation))
+    {
+        LOG("Failed to start recording the session");
+    }
+
     // Select the camera focus mode to continuous autofocus
     if (vuCameraControllerSetFocusMode(cameraController, VU_CAMERA_FOCUS_MODE_CONTINUOUSAUTO) != VU_SUCCESS)
     {
@@ -140,6 +186,9 @@ AppController::stopAR()
 
     mARStarted = false;
 
+    // Waits for the frames still being written
+    mSessionRecorder.stop();
+
     // Stop engine
     if (vuEngineStop(mEngine) != VU_SUCCESS)
     {
@@ -147,6 +196,12 @@ AppController::stopAR()
         return false;
     }
 
+    // Registered again on start
+    if (mPipelinedTracking && vuEngineRegisterStateHandler(mEngine, nullptr, nullptr) != VU_SUCCESS)
+    {
+        LOG("Failed to unregister the state handler");
+    }
+
     LOG("Successfully stopped Vuforia");
     return true;
 }
@@ -164,6 +219,7 @@ AppController::deinitAR()
 
     stopAR();
 
+    releaseTrackingSnapshots();
     destroyObservers();
 
     // Destroy engine instance
@@ -182,47 +238,51 @@ AppController::deinitAR()
 }
 
 
-void
+bool
 AppController::cameraPerformAutoFocus()
 {
     if (!mARStarted)
     {
-        return;
+        return false;
     }
 
     VuController* cameraController = nullptr;
     if (vuEngineGetCameraController(mEngine, &cameraController) != VU_SUCCESS)
     {
         LOG("Error attempting to perform autofocus, failed to get camera controller");
-        return;
+        return false;
     }
 
     if (vuCameraControllerSetFocusMode(cameraController, VU_CAMERA_FOCUS_MODE_TRIGGERAUTO) != VU_SUCCESS)
     {
         LOG("Error attempting to perform autofocus, failed to set focus mode");
+        return false;
     }
+    return true;
 }
 
 
-void
+bool
 AppController::cameraRestoreAutoFocus()
 {
     if (!mARStarted)
     {
-        return;
+        return false;
     }
 
     VuController* cameraController = nullptr;
     if (vuEngineGetCameraController(mEngine, &cameraController) != VU_SUCCESS)
     {
         LOG("Error attempting to perform autofocus, failed to get camera controller");
-        return;
+        return false;
     }
 
     if (vuCameraControllerSetFocusMode(cameraController, VU_CAMERA_FOCUS_MODE_CONTINUOUSAUTO) != VU_SUCCESS)
     {
         LOG("Error attempting to perform autofocus, failed to set focus mode");
+        return false;
     }
+    return true;
 }
 
 
@@ -259,6 +319,9 @@ AppController::configureRendering(int width, int height, void* orientation)
         LOG("Failed to set render view configuration");
     }
 
+    // The orientation alone may change the video background mesh
+    ++mRenderViewVersion;
+
     return true;
 }
 
@@ -281,21 +344,44 @@ AppController::getVideoBackgroundTextureSize(VuVector2I& textureSize)
 bool
 AppController::prepareToRender(double* viewport, VuRenderVideoBackgroundData* renderData)
 {
-    if (vuEngineAcquireLatestState(mEngine, &mVuforiaState) != VU_SUCCESS)
-    {
-        LOG("Error getting state");
-        return false;
-    }
+    // The state of which the video background texture is updated
+    const VuState* state = nullptr;
 
-    if (vuStateHasCameraFrame(mVuforiaState) != VU_TRUE)
+    if (mPipelinedTracking)
     {
-        return false;
-    }
+        // Keeps the previous snapshot if no newer state arrived since the last frame
+        mTrackingSnapshots.update();
+        const TrackingSnapshot& snapshot = mTrackingSnapshots.getReadBuffer();
+        if (snapshot.state == nullptr)
+        {
+            return false;
+        }
 
-    if (vuStateGetRenderState(mVuforiaState, &mCurrentRenderState) != VU_SUCCESS)
+        state = snapshot.state;
+        mCurrentRenderState = snapshot.renderState;
+        mLatestDevicePoseData = snapshot.devicePoseData;
+        mFramePacket = snapshot.packet;
+    }
+    else
     {
-        LOG("Error getting render state");
-        return false;
+        if (vuEngineAcquireLatestState(mEngine, &mVuforiaState) != VU_SUCCESS)
+        {
+            LOG("Error getting state");
+            return false;
+        }
+
+        if (vuStateHasCameraFrame(mVuforiaState) != VU_TRUE)
+        {
+            return false;
+        }
+
+        if (vuStateGetRenderState(mVuforiaState, &mCurrentRenderState) != VU_SUCCESS)
+        {
+            LOG("Error getting render state");
+            return false;
+        }
+
+        state = mVuforiaState;
     }
 
     if (!mCurrentRenderState.vbMesh)
@@ -310,13 +396,16 @@ AppController::prepareToRender(double* viewport, VuRenderVideoBackgroundData* re
     viewport[4] = 0.0f;
     viewport[5] = 1.0f;
 
-    if (vuRenderControllerUpdateVideoBackgroundTexture(mRenderController, mVuforiaState, renderData) != VU_SUCCESS)
+    if (vuRenderControllerUpdateVideoBackgroundTexture(mRenderController, state, renderData) != VU_SUCCESS)
     {
         LOG("Error updating video background texture");
         return false;
     }
 
-    updateDevicePose();
+    if (!mPipelinedTracking)
+    {
+        extractFrame(mVuforiaState, mCurrentRenderState, mLatestDevicePoseData, mFramePacket);
+    }
 
     return true;
 }
@@ -352,203 +441,357 @@ AppController::finishRender()
         mTimingRelocalizingState = false;
     }
 
-    // Clean up and release the Vuforia state
+    // Clean up and release the Vuforia state, the state of a tracking snapshot is released when the snapshot is reused
     if (mVuforiaState != nullptr && vuStateRelease(mVuforiaState) != VU_SUCCESS)
     {
         LOG("Error releasing the Vuforia state");
     }
     mVuforiaState = nullptr;
+
+    mFrameArena.reset();
+}
+
+
+bool
+AppController::updateThermalGovernor(ThermalGovernor::Status status, float headroom, float frameMilliseconds)
+{
+    if (!mThermalGovernorEnabled)
+    {
+        return false;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (!mThermalGovernor.update(seconds, status, headroom, frameMilliseconds))
+    {
+        return false;
+    }
+
+    const ThermalGovernor::Level& level = mThermalGovernor.getLevel();
+    LOG("Thermal governor level %d for %s (status %d, headroom %.2f, frame %.1f ms): camera mode %d, render scale %.2f, "
+        "frame rate cap %d",
+        mThermalGovernor.getLevelIndex(), mThermalGovernor.getReason(), static_cast<int>(status), headroom, frameMilliseconds,
+        static_cast<int>(level.cameraVideoMode), level.maxRenderScale, level.frameRateCap);
+
+    // The video mode can only be changed while the engine is stopped
+    if (level.cameraVideoMode != mCameraVideoMode && mARStarted)
+    {
+        mCameraVideoMode = level.cameraVideoMode;
+        if (!stopAR() || !startAR())
+        {
+            LOG("Failed to restart Vuforia with camera mode %d", static_cast<int>(mCameraVideoMode));
+        }
+        // A different camera resolution changes the video background mesh
+        ++mRenderViewVersion;
+    }
+
+    return true;
 }
 
 
 bool
 AppController::getOrigin(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix)
 {
-    if (mLatestDevicePoseData.poseStatus != VU_OBSERVATION_POSE_STATUS_NO_POSE)
+    if (!mFramePacket.originValid)
     {
-        projectionMatrix = mCurrentRenderState.projectionMatrix;
-        modelViewMatrix = mCurrentRenderState.viewMatrix;
-        return true;
+        return false;
     }
 
-    return false;
+    projectionMatrix = mFramePacket.projectionMatrix;
+    modelViewMatrix = mFramePacket.originModelViewMatrix;
+    return true;
 }
 
 
 bool
 AppController::getImageTargetResult(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix, VuMatrix44F& scaledModelViewMatrix)
 {
-    bool result = false;
-
-    if (mTarget != IMAGE_TARGET_ID)
+    FramePacket::Target target;
+    if (getImageTargetResults(projectionMatrix, &target, 1) == 0)
     {
         return false;
     }
+    modelViewMatrix = target.modelViewMatrix;
+    scaledModelViewMatrix = target.scaledModelViewMatrix;
+    return true;
+}
 
-    VuObservationList* observationList = nullptr;
-    REQUIRE_SUCCESS(vuObservationListCreate(&observationList));
 
-    if (vuStateGetImageTargetObservations(mVuforiaState, observationList) != VU_SUCCESS)
+int
+AppController::getImageTargetResults(VuMatrix44F& projectionMatrix, FramePacket::Target* targets, int maxTargets)
+{
+    int result = 0;
+    for (int i = 0; i < mFramePacket.targetCount && result < maxTargets; ++i)
     {
-        LOG("Error getting image target observations");
-        REQUIRE_SUCCESS(vuObservationListDestroy(observationList));
-        return false;
+        if (mFramePacket.targets[i].targetId != MODEL_TARGET_ID)
+        {
+            targets[result++] = mFramePacket.targets[i];
+        }
     }
+    if (result > 0)
+    {
+        projectionMatrix = mFramePacket.projectionMatrix;
+    }
+    return result;
+}
 
-    int numObservations = 0;
-    REQUIRE_SUCCESS(vuObservationListGetSize(observationList, &numObservations));
 
-    if (numObservations > 0)
+bool
+AppController::getModelTargetResult(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix, VuMatrix44F& scaledModelViewMatrix)
+{
+    for (int i = 0; i < mFramePacket.targetCount; ++i)
     {
-        VuObservation* observation = nullptr;
-        if (vuObservationListGetElement(observationList, 0, &observation) == VU_SUCCESS)
+        const FramePacket::Target& target = mFramePacket.targets[i];
+        if (target.targetId == MODEL_TARGET_ID)
         {
-            assert(observation);
-            assert(vuObservationIsType(observation, VU_OBSERVATION_IMAGE_TARGET_TYPE) == VU_TRUE);
-            assert(vuObservationHasPoseInfo(observation) == VU_TRUE);
+            projectionMatrix = mFramePacket.projectionMatrix;
+            modelViewMatrix = target.modelViewMatrix;
+            scaledModelViewMatrix = target.scaledModelViewMatrix;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool
+AppController::getModelTargetGuideView(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix, VuImageInfo& guideViewImageInfo,
+                                       VuBool& guideViewImageHasChanged)
+{
+    if (!mFramePacket.guideViewValid)
+    {
+        return false;
+    }
 
-            VuPoseInfo poseInfo;
-            REQUIRE_SUCCESS(vuObservationGetPoseInfo(observation, &poseInfo));
+    projectionMatrix = mFramePacket.guideViewProjectionMatrix;
+    modelViewMatrix = mFramePacket.guideViewModelViewMatrix;
+    guideViewImageInfo = mFramePacket.guideViewImage;
+    guideViewImageHasChanged = mFramePacket.guideViewImageChanged;
+    return true;
+}
 
-            VuImageTargetObservationTargetInfo imageTargetInfo;
-            REQUIRE_SUCCESS(vuImageTargetObservationGetTargetInfo(observation, &imageTargetInfo));
 
-            if (poseInfo.poseStatus != VU_OBSERVATION_POSE_STATUS_NO_POSE)
+void
+AppController::getFramePacket(FramePacket& packet)
+{
+    packet = mFramePacket;
+}
+
+
+/*===============================================================================
+ AppController private methods
+ ===============================================================================*/
+
+void
+AppController::extractFrame(const VuState* state, const VuRenderState& renderState, DevicePoseData& devicePoseData, FramePacket& packet)
+{
+    devicePoseData.pose = MatrixMath::identity();
+    devicePoseData.poseStatus = VU_OBSERVATION_POSE_STATUS_NO_POSE;
+    devicePoseData.poseStatusInfo = VU_DEVICE_POSE_OBSERVATION_STATUS_INFO_NORMAL;
+
+    // The targets and the origin share the projection of the render state
+    packet.projectionMatrix = renderState.projectionMatrix;
+    packet.targetCount = 0;
+    packet.fusionProviderValid = false;
+
+    // A single pass over every observation of the state, the list keeps its storage from frame to frame
+    if (vuStateGetObservationsWithPoseInfo(state, mObservationList) != VU_SUCCESS)
+    {
+        LOG("Error getting observations");
+    }
+    else
+    {
+        int numObservations = 0;
+        REQUIRE_SUCCESS(vuObservationListGetSize(mObservationList, &numObservations));
+
+        for (int i = 0; i < numObservations; ++i)
+        {
+            VuObservation* observation = nullptr;
+            if (vuObservationListGetElement(mObservationList, i, &observation) != VU_SUCCESS)
             {
-                projectionMatrix = mCurrentRenderState.projectionMatrix;
-
-                // Compute model-view matrix
-                auto modelMatrix = poseInfo.pose;
-                modelViewMatrix = vuMatrix44FMultiplyMatrix(mCurrentRenderState.viewMatrix, modelMatrix);
-
-                // Calculate a scaled modelViewMatrix for rendering a unit bounding box
-                // z-dimension will be zero for planar target
-                // set it here to the larger dimension so that
-                // a 3D augmentation can be shown
-                VuVector3F scale;
-                scale.data[0] = imageTargetInfo.size.data[0];
-                scale.data[1] = imageTargetInfo.size.data[1];
-                scale.data[2] = std::max(scale.data[0], scale.data[1]);
-                scaledModelViewMatrix = vuMatrix44FScale(scale, modelViewMatrix);
-
-                result = true;
+                continue;
+            }
+            assert(observation);
+
+            if (vuObservationIsType(observation, VU_OBSERVATION_DEVICE_POSE_TYPE) == VU_TRUE)
+            {
+                extractDevicePose(observation, devicePoseData);
+            }
+            else if (packet.targetCount < FramePacket::MAX_TARGETS)
+            {
+                FramePacket::Target& target = packet.targets[packet.targetCount];
+                if ((vuObservationIsType(observation, VU_OBSERVATION_IMAGE_TARGET_TYPE) == VU_TRUE &&
+                     extractImageTarget(observation, renderState, target)) ||
+                    (vuObservationIsType(observation, VU_OBSERVATION_MODEL_TARGET_TYPE) == VU_TRUE &&
+                     extractModelTarget(observation, renderState, target)))
+                {
+                    ++packet.targetCount;
+                }
             }
         }
     }
 
-    REQUIRE_SUCCESS(vuObservationListDestroy(observationList));
+    packet.originValid = devicePoseData.poseStatus != VU_OBSERVATION_POSE_STATUS_NO_POSE;
+    packet.originModelViewMatrix = renderState.viewMatrix;
 
-    return result;
+    if (mPoseFiltering)
+    {
+        filterPoses(state, packet);
+    }
+
+    // The budget stays as it is while idle switched the gallery observers off
+    if (mTarget == GALLERY_TARGET_ID && !mIdleObserversDeactivated)
+    {
+        updateGalleryObservers(packet);
+    }
+
+    packet.idle = false;
+    if (mIdlePowerMode)
+    {
+        updateIdleMode(devicePoseData, packet);
+    }
+
+    packet.guideViewValid = packet.targetCount == 0 &&
+                            getModelTargetGuideView(state, packet.guideViewProjectionMatrix, packet.guideViewModelViewMatrix,
+                                                    packet.guideViewImage, packet.guideViewImageChanged);
+
+    if (!mRecordingDirectory.empty())
+    {
+        mSessionRecorder.addFrame(state, devicePoseData.pose, devicePoseData.poseStatus);
+    }
 }
 
 
-bool
-AppController::getModelTargetResult(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix, VuMatrix44F& scaledModelViewMatrix)
+void
+AppController::extractDevicePose(const VuObservation* observation, DevicePoseData& devicePoseData)
 {
-    bool result = false;
+    VuPoseInfo poseInfo;
+    REQUIRE_SUCCESS(vuObservationGetPoseInfo(observation, &poseInfo));
 
-    if (mTarget != MODEL_TARGET_ID)
+    if (poseInfo.poseStatus != VU_OBSERVATION_POSE_STATUS_NO_POSE)
     {
-        return false;
+        // Store latest tracked device pose and pose status
+        devicePoseData.pose = poseInfo.pose;
+        devicePoseData.poseStatus = poseInfo.poseStatus;
+
+        // Retrieve device pose-specific status information
+        REQUIRE_SUCCESS(vuDevicePoseObservationGetStatusInfo(observation, &devicePoseData.poseStatusInfo));
     }
+}
 
-    VuObservationList* observationList = nullptr;
-    REQUIRE_SUCCESS(vuObservationListCreate(&observationList));
 
-    if (vuStateGetModelTargetObservations(mVuforiaState, observationList) != VU_SUCCESS)
+bool
+AppController::extractImageTarget(const VuObservation* observation, const VuRenderState& renderState, FramePacket::Target& target)
+{
+    VuPoseInfo poseInfo;
+    REQUIRE_SUCCESS(vuObservationGetPoseInfo(observation, &poseInfo));
+    if (poseInfo.poseStatus == VU_OBSERVATION_POSE_STATUS_NO_POSE)
     {
-        LOG("Error getting model target observations");
-        REQUIRE_SUCCESS(vuObservationListDestroy(observationList));
         return false;
     }
 
-    int numObservations = 0;
-    REQUIRE_SUCCESS(vuObservationListGetSize(observationList, &numObservations));
+    VuImageTargetObservationTargetInfo imageTargetInfo;
+    REQUIRE_SUCCESS(vuImageTargetObservationGetTargetInfo(observation, &imageTargetInfo));
+
+    // Only the observers of the gallery have an index
+    auto observerId = vuObservationGetObserverId(observation);
+    auto galleryObserver = std::find(mGalleryObserverIds.begin(), mGalleryObserverIds.end(), observerId);
+    target.targetId = galleryObserver != mGalleryObserverIds.end() ? GALLERY_TARGET_ID : IMAGE_TARGET_ID;
+    target.galleryIndex =
+        galleryObserver != mGalleryObserverIds.end() ? static_cast<int>(galleryObserver - mGalleryObserverIds.begin()) : -1;
+
+    // Compute model-view matrix
+    auto modelMatrix = poseInfo.pose;
+    target.modelViewMatrix = MatrixMath::multiply(renderState.viewMatrix, modelMatrix);
+
+    // Calculate a scaled modelViewMatrix for rendering a unit bounding box
+    // z-dimension will be zero for planar target
+    // set it here to the larger dimension so that
+    // a 3D augmentation can be shown
+    VuVector3F scale;
+    scale.data[0] = imageTargetInfo.size.data[0];
+    scale.data[1] = imageTargetInfo.size.data[1];
+    scale.data[2] = std::max(scale.data[0], scale.data[1]);
+    target.scaledModelViewMatrix = MatrixMath::scale(scale, target.modelViewMatrix);
 
-    if (numObservations > 0)
+    return true;
+}
+
+
+bool
+AppController::extractModelTarget(const VuObservation* observation, const VuRenderState& renderState, FramePacket::Target& target)
+{
+    VuPoseInfo poseInfo;
+    REQUIRE_SUCCESS(vuObservationGetPoseInfo(observation, &poseInfo));
+
+    if (poseInfo.poseStatus == VU_OBSERVATION_POSE_STATUS_NO_POSE)
     {
-        VuObservation* observation = nullptr;
-        if (vuObservationListGetElement(observationList, 0, &observation) == VU_SUCCESS)
-        {
-            assert(observation);
-            assert(vuObservationIsType(observation, VU_OBSERVATION_MODEL_TARGET_TYPE) == VU_TRUE);
-            assert(vuObservationHasPoseInfo(observation) == VU_TRUE);
+        // Shown until the target is found, resolved when the observer was created
+        mGuideViewModelTarget = mActiveGuideView;
+        return false;
+    }
 
-            VuPoseInfo poseInfo;
-            REQUIRE_SUCCESS(vuObservationGetPoseInfo(observation, &poseInfo));
+    mGuideViewModelTarget = nullptr;
 
-            VuModelTargetObservationTargetInfo modelTargetInfo;
-            REQUIRE_SUCCESS(vuModelTargetObservationGetTargetInfo(observation, &modelTargetInfo));
-            if (poseInfo.poseStatus == VU_OBSERVATION_POSE_STATUS_NO_POSE)
-            {
-                VuGuideViewList* guideViewList;
-                REQUIRE_SUCCESS(vuGuideViewListCreate(&guideViewList));
+    VuModelTargetObservationTargetInfo modelTargetInfo;
+    REQUIRE_SUCCESS(vuModelTargetObservationGetTargetInfo(observation, &modelTargetInfo));
 
-                if (vuModelTargetObserverGetGuideViews(mObjectObserver, guideViewList) != VU_SUCCESS)
-                {
-                    LOG("Error getting list of guide views");
-                }
-                else
-                {
-                    int32_t size;
-                    REQUIRE_SUCCESS(vuGuideViewListGetSize(guideViewList, &size));
-                    mGuideViewModelTarget = [&]() -> VuGuideView* {
-                        for (int i = 0; i < size; ++i)
-                        {
-                            VuGuideView* guideView = nullptr;
-                            REQUIRE_SUCCESS(vuGuideViewListGetElement(guideViewList, i, &guideView));
-                            const char* guideViewName = nullptr;
-                            REQUIRE_SUCCESS(vuGuideViewGetName(guideView, &guideViewName));
-
-                            // Note: We use the activeGuideViewName as we know there is a guide view for our dataset.
-                            //       When using Advanced Model Targets there may not be a guide view and
-                            //       activeGuideViewName will be NULL.
-                            if (strcmp(guideViewName, modelTargetInfo.activeGuideViewName) == 0)
-                            {
-                                return guideView;
-                            }
-                        }
-                        return nullptr;
-                    }();
-                    if (!mGuideViewModelTarget)
-                    {
-                        LOG("Error getting guide view details");
-                    }
-                }
+    target.targetId = MODEL_TARGET_ID;
+    target.galleryIndex = -1;
 
-                REQUIRE_SUCCESS(vuGuideViewListDestroy(guideViewList));
-            }
-            else
-            {
-                mGuideViewModelTarget = nullptr;
+    // Compute model-view matrix
+    auto modelMatrix = poseInfo.pose;
+    target.modelViewMatrix = MatrixMath::multiply(renderState.viewMatrix, modelMatrix);
 
-                projectionMatrix = mCurrentRenderState.projectionMatrix;
+    // Calculate a scaled modelViewMatrix for rendering a unit bounding box
+    VuMatrix44F scaleMatrix = MatrixMath::scaling(modelTargetInfo.size);
+    VuMatrix44F translateMatrix = MatrixMath::translation(modelTargetInfo.bbox.center);
 
-                // Compute model-view matrix
-                auto modelMatrix = poseInfo.pose;
-                modelViewMatrix = vuMatrix44FMultiplyMatrix(mCurrentRenderState.viewMatrix, modelMatrix);
+    target.scaledModelViewMatrix = MatrixMath::multiply(translateMatrix, scaleMatrix);
+    target.scaledModelViewMatrix = MatrixMath::multiply(target.modelViewMatrix, target.scaledModelViewMatrix);
 
-                // Calculate a scaled modelViewMatrix for rendering a unit bounding box
-                VuMatrix44F scaleMatrix = vuMatrix44FScalingMatrix(modelTargetInfo.size);
-                VuMatrix44F translateMatrix = vuMatrix44FTranslationMatrix(modelTargetInfo.bbox.center);
+    return true;
+}
 
-                scaledModelViewMatrix = vuMatrix44FMultiplyMatrix(translateMatrix, scaleMatrix);
-                scaledModelViewMatrix = vuMatrix44FMultiplyMatrix(modelViewMatrix, scaledModelViewMatrix);
 
-                result = true;
-            }
-        }
+void
+AppController::filterPoses(const VuState* state, FramePacket& packet)
+{
+    VuCameraFrame* cameraFrame = nullptr;
+    int64_t timestamp = 0;
+    if (vuStateGetCameraFrame(state, &cameraFrame) != VU_SUCCESS || vuCameraFrameGetTimestamp(cameraFrame, &timestamp) != VU_SUCCESS)
+    {
+        LOG("Error getting the camera frame timestamp, poses are not filtered");
+        return;
     }
+    // Nanoseconds
+    double seconds = static_cast<double>(timestamp) * 1e-9;
 
-    REQUIRE_SUCCESS(vuObservationListDestroy(observationList));
+    if (packet.originValid)
+    {
+        packet.originModelViewMatrix = mOriginPoseFilter.filter(packet.originModelViewMatrix, seconds);
+    }
 
-    return result;
+    for (int i = 0; i < packet.targetCount; ++i)
+    {
+        FramePacket::Target& target = packet.targets[i];
+        int index = target.targetId == GALLERY_TARGET_ID ? GALLERY_TARGET_ID + target.galleryIndex : target.targetId;
+        if (index < 0 || index >= static_cast<int>(mTargetPoseFilters.size()))
+        {
+            continue;
+        }
+
+        // The unit-sized box keeps its scale and offset relative to the filtered pose
+        VuMatrix44F filtered = mTargetPoseFilters[index].filter(target.modelViewMatrix, seconds);
+        VuMatrix44F local = MatrixMath::multiply(MatrixMath::inverseRigid(target.modelViewMatrix), target.scaledModelViewMatrix);
+        target.scaledModelViewMatrix = MatrixMath::multiply(filtered, local);
+        target.modelViewMatrix = filtered;
+    }
 }
 
 
 bool
-AppController::getModelTargetGuideView(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix, VuImageInfo& guideViewImageInfo,
-                                       VuBool& guideViewImageHasChanged)
+AppController::getModelTargetGuideView(const VuState* state, VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix,
+                                       VuImageInfo& guideViewImageInfo, VuBool& guideViewImageHasChanged)
 {
     if (mGuideViewModelTarget == nullptr)
     {
@@ -556,7 +799,7 @@ AppController::getModelTargetGuideView(VuMatrix44F& projectionMatrix, VuMatrix44
     }
 
     VuCameraIntrinsics cameraIntrinsics;
-    if (vuStateGetCameraIntrinsics(mVuforiaState, &cameraIntrinsics) != VU_SUCCESS)
+    if (vuStateGetCameraIntrinsics(state, &cameraIntrinsics) != VU_SUCCESS)
     {
         return false;
     }
@@ -621,19 +864,15 @@ AppController::getModelTargetGuideView(VuMatrix44F& projectionMatrix, VuMatrix44
     // normalize world space plane sizes into view space again
     VuVector2F scale = { 2 * planeWidth / nearPlaneWidth, 2 * planeHeight / nearPlaneHeight };
 
-    projectionMatrix = vuIdentityMatrix44F();
-    modelViewMatrix = vuIdentityMatrix44F();
+    projectionMatrix = MatrixMath::identity();
+    modelViewMatrix = MatrixMath::identity();
 
-    modelViewMatrix = vuMatrix44FScale(VuVector3F{ scale.data[0], scale.data[1], 1.0f }, modelViewMatrix);
+    modelViewMatrix = MatrixMath::scale(VuVector3F{ scale.data[0], scale.data[1], 1.0f }, modelViewMatrix);
 
     return true;
 }
 
 
-/*===============================================================================
- AppController private methods
- ===============================================================================*/
-
 bool
 AppController::initVuforiaInternal(void* appData)
 {
@@ -694,6 +933,23 @@ AppController::initVuforiaInternal(void* appData)
     (void)appData;
 #endif
 
+    // Frames come from the recording instead of the camera
+    if (mReplay != nullptr)
+    {
+        auto driverConfig = vuDriverConfigDefault();
+        driverConfig.driverName = FileDriverConfig::LIBRARY_NAME;
+        driverConfig.userData = mReplay;
+        if (vuEngineConfigSetAddDriverConfig(configSet, &driverConfig) != VU_SUCCESS)
+        {
+            // Clean up before exiting
+            REQUIRE_SUCCESS(vuEngineConfigSetDestroy(configSet));
+
+            LOG("Failed to init Vuforia, could not configure the replay driver");
+            mShowErrorCallback("Vuforia failed to initialize, could not configure the replay driver");
+            return false;
+        }
+    }
+
     // Add rendering-specific engine configuration
     if (vuEngineConfigSetAddRenderConfig(configSet, &renderConfig) != VU_SUCCESS)
     {
@@ -807,6 +1063,14 @@ AppController::initErrorToString(VuErrorCode error)
             errorMessage = "Vuforia failed to initialize because the requested videobackground viewport could not be set.";
             break;
 
+        case VU_ENGINE_CREATION_ERROR_DRIVER_CONFIG_LOAD_ERROR:
+            errorMessage = "Vuforia failed to initialize because the replay driver could not be loaded.";
+            break;
+
+        case VU_ENGINE_CREATION_ERROR_DRIVER_CONFIG_FEATURE_NOT_SUPPORTED:
+            errorMessage = "Vuforia failed to initialize because the license does not support replaying recordings.";
+            break;
+
         case VU_ENGINE_CREATION_ERROR_INITIALIZATION:
         default:
             errorMessage = "Vuforia initialization failed";
@@ -820,6 +1084,16 @@ AppController::initErrorToString(VuErrorCode error)
 bool
 AppController::createObservers()
 {
+    // Reused for every frame instead of being created for each query
+    if (mObservationList == nullptr)
+    {
+        REQUIRE_SUCCESS(vuObservationListCreate(&mObservationList));
+    }
+
+    // Filters restart from the first pose of the session
+    mOriginPoseFilter.reset();
+    mTargetPoseFilters.assign(GALLERY_TARGET_ID + GALLERY_TARGET_COUNT, PoseFilter());
+
     auto devicePoseConfig = vuDevicePoseConfigDefault();
     VuDevicePoseCreationError devicePoseCreationError;
     if (vuEngineCreateDevicePoseObserver(mEngine, &mDevicePoseObserver, &devicePoseConfig, &devicePoseCreationError) != VU_SUCCESS)
@@ -843,6 +1117,14 @@ AppController::createObservers()
             return false;
         }
     }
+    else if (mTarget == GALLERY_TARGET_ID)
+    {
+        if (!createGalleryObservers())
+        {
+            mShowErrorCallback("Error creating gallery image target observers");
+            return false;
+        }
+    }
     else
     {
         auto modelTargetConfig = vuModelTargetConfigDefault();
@@ -858,6 +1140,8 @@ AppController::createObservers()
             mShowErrorCallback("Error creating model target observer");
             return false;
         }
+
+        resolveGuideViews();
     }
 
     return true;
@@ -873,57 +1157,268 @@ AppController::destroyObservers()
     }
     mObjectObserver = nullptr;
 
+    for (VuObserver* observer : mGalleryObservers)
+    {
+        if (vuObserverDestroy(observer) != VU_SUCCESS)
+        {
+            LOG("Error destroying gallery observer");
+        }
+    }
+    mGalleryObservers.clear();
+    mGalleryObserverIds.clear();
+    mIdleObserversDeactivated = false;
+
     if (mDevicePoseObserver != nullptr && vuObserverDestroy(mDevicePoseObserver) != VU_SUCCESS)
     {
         LOG("Error destroying object observer");
     }
     mDevicePoseObserver = nullptr;
+
+    // The list may still reference observations of the destroyed observers
+    if (mObservationList != nullptr)
+    {
+        REQUIRE_SUCCESS(vuObservationListDestroy(mObservationList));
+        mObservationList = nullptr;
+    }
+    // The guide views belong to the Model Target observer
+    mGuideViews.clear();
+    mActiveGuideView = nullptr;
+    mGuideViewModelTarget = nullptr;
 }
 
 
 void
-AppController::updateDevicePose()
+AppController::resolveGuideViews()
 {
-    mLatestDevicePoseData.pose = vuIdentityMatrix44F();
-    mLatestDevicePoseData.poseStatus = VU_OBSERVATION_POSE_STATUS_NO_POSE;
-    mLatestDevicePoseData.poseStatusInfo = VU_DEVICE_POSE_OBSERVATION_STATUS_INFO_NORMAL;
+    mGuideViews.clear();
+    mActiveGuideView = nullptr;
 
-    VuObservationList* observationList = nullptr;
-    REQUIRE_SUCCESS(vuObservationListCreate(&observationList));
+    VuGuideViewList* guideViewList = nullptr;
+    REQUIRE_SUCCESS(vuGuideViewListCreate(&guideViewList));
 
-    if (vuStateGetDevicePoseObservations(mVuforiaState, observationList) == VU_SUCCESS)
+    if (vuModelTargetObserverGetGuideViews(mObjectObserver, guideViewList) != VU_SUCCESS)
     {
-        int numObservations = 0;
-        REQUIRE_SUCCESS(vuObservationListGetSize(observationList, &numObservations));
+        LOG("Error getting list of guide views");
+    }
+    else
+    {
+        int32_t size;
+        REQUIRE_SUCCESS(vuGuideViewListGetSize(guideViewList, &size));
+        for (int i = 0; i < size; ++i)
+        {
+            VuGuideView* guideView = nullptr;
+            REQUIRE_SUCCESS(vuGuideViewListGetElement(guideViewList, i, &guideView));
+            const char* guideViewName = nullptr;
+            REQUIRE_SUCCESS(vuGuideViewGetName(guideView, &guideViewName));
+            mGuideViews[guideViewName] = guideView;
+        }
+    }
+
+    REQUIRE_SUCCESS(vuGuideViewListDestroy(guideViewList));
 
-        if (numObservations > 0)
+    // Note: We use the active guide view name as we know there is a guide view for our dataset.
+    //       When using Advanced Model Targets there may not be a guide view and
+    //       the active guide view name will be NULL.
+    const char* activeGuideViewName = nullptr;
+    if (vuModelTargetObserverGetActiveGuideViewName(mObjectObserver, &activeGuideViewName) == VU_SUCCESS &&
+        activeGuideViewName != nullptr)
+    {
+        auto activeGuideView = mGuideViews.find(activeGuideViewName);
+        mActiveGuideView = activeGuideView != mGuideViews.end() ? activeGuideView->second : nullptr;
+        if (mActiveGuideView == nullptr)
         {
-            VuObservation* observation = nullptr;
-            if (vuObservationListGetElement(observationList, 0, &observation) == VU_SUCCESS)
-            {
-                assert(observation);
-                assert(vuObservationIsType(observation, VU_OBSERVATION_DEVICE_POSE_TYPE) == VU_TRUE);
-                assert(vuObservationHasPoseInfo(observation) == VU_TRUE);
+            LOG("Error getting guide view details");
+        }
+    }
+}
 
-                VuPoseInfo poseInfo;
-                REQUIRE_SUCCESS(vuObservationGetPoseInfo(observation, &poseInfo));
 
-                if (poseInfo.poseStatus != VU_OBSERVATION_POSE_STATUS_NO_POSE)
-                {
-                    // Store latest tracked device pose and pose status
-                    mLatestDevicePoseData.pose = poseInfo.pose;
-                    mLatestDevicePoseData.poseStatus = poseInfo.poseStatus;
+bool
+AppController::createGalleryObservers()
+{
+    ObserverBudget::Config budgetConfig;
+    budgetConfig.budget = GALLERY_ACTIVE_BUDGET;
+    mGalleryBudget.setConfig(budgetConfig);
+    mGalleryBudget.reset(GALLERY_TARGET_COUNT);
 
-                    // Retrieve device pose-specific status information
-                    REQUIRE_SUCCESS(vuDevicePoseObservationGetStatusInfo(observation, &mLatestDevicePoseData.poseStatusInfo));
-                }
+    for (int i = 0; i < GALLERY_TARGET_COUNT; ++i)
+    {
+        const GalleryTarget& galleryTarget = GALLERY_TARGETS[i];
+        auto imageTargetConfig = vuImageTargetFileConfigDefault();
+        imageTargetConfig.path = galleryTarget.imagePath;
+        imageTargetConfig.targetName = galleryTarget.name;
+        imageTargetConfig.targetWidth = galleryTarget.width;
+        imageTargetConfig.activate = mGalleryBudget.isActive(i) ? VU_TRUE : VU_FALSE;
+
+        VuObserver* observer = nullptr;
+        VuImageTargetFileCreationError imageTargetCreationError;
+        if (vuEngineCreateImageTargetObserverFromFileConfig(mEngine, &observer, &imageTargetConfig, &imageTargetCreationError) !=
+            VU_SUCCESS)
+        {
+            LOG("Error creating image target observer for %s: 0x%02x", galleryTarget.imagePath, imageTargetCreationError);
+            return false;
+        }
+        mGalleryObservers.push_back(observer);
+        mGalleryObserverIds.push_back(vuObserverGetId(observer));
+    }
+
+    // Every active observer may be tracked at the same time
+    if (vuEngineSetMaximumSimultaneousTrackedImages(mEngine, GALLERY_ACTIVE_BUDGET) != VU_SUCCESS)
+    {
+        LOG("Failed to set the maximum number of simultaneously tracked images");
+    }
+
+    LOG("Created %d gallery observers, %d active at a time", GALLERY_TARGET_COUNT, GALLERY_ACTIVE_BUDGET);
+    return true;
+}
+
+
+void
+AppController::updateGalleryObservers(const FramePacket& packet)
+{
+    int observed[FramePacket::MAX_TARGETS];
+    int observedCount = 0;
+    for (int i = 0; i < packet.targetCount; ++i)
+    {
+        if (packet.targets[i].galleryIndex >= 0)
+        {
+            observed[observedCount++] = packet.targets[i].galleryIndex;
+        }
+    }
+    if (!mGalleryBudget.update(observed, observedCount))
+    {
+        return;
+    }
+
+    // Deactivate first, so that no more than the budget are ever active
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        bool activate = pass == 1;
+        for (int i = 0; i < static_cast<int>(mGalleryObservers.size()); ++i)
+        {
+            VuObserver* observer = mGalleryObservers[i];
+            bool activated = vuObserverIsActivated(observer) == VU_TRUE;
+            if (mGalleryBudget.isActive(i) != activate || activated == activate)
+            {
+                continue;
+            }
+            VuResult result = activate ? vuObserverActivate(observer) : vuObserverDeactivate(observer);
+            if (result != VU_SUCCESS)
+            {
+                LOG("Failed to %s the gallery observer of %s", activate ? "activate" : "deactivate", GALLERY_TARGETS[i].name);
             }
         }
     }
-    else
+}
+
+
+void
+AppController::updateIdleMode(const DevicePoseData& devicePoseData, FramePacket& packet)
+{
+    bool devicePoseValid = devicePoseData.poseStatus != VU_OBSERVATION_POSE_STATUS_NO_POSE;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (mIdleDetector.update(seconds, packet.targetCount > 0, devicePoseValid ? &devicePoseData.pose : nullptr))
+    {
+        LOG("%s idle power mode: %s", mIdleDetector.isIdle() ? "Entered" : "Left", mIdleDetector.getReason());
+    }
+    packet.idle = mIdleDetector.isIdle();
+
+    // Without the observers only device motion can end idle, so they stay active while there is no device pose
+    bool deactivate = mIdleDeactivateObservers && packet.idle && devicePoseValid;
+    if (deactivate != mIdleObserversDeactivated)
     {
-        LOG("Error getting device pose observations");
+        setTargetObserversActive(!deactivate);
+        mIdleObserversDeactivated = deactivate;
+    }
+}
+
+
+void
+AppController::setTargetObserversActive(bool active)
+{
+    if (mObjectObserver != nullptr && (vuObserverIsActivated(mObjectObserver) == VU_TRUE) != active)
+    {
+        VuResult result = active ? vuObserverActivate(mObjectObserver) : vuObserverDeactivate(mObjectObserver);
+        if (result != VU_SUCCESS)
+        {
+            LOG("Failed to %s the object observer", active ? "activate" : "deactivate");
+        }
     }
 
-    REQUIRE_SUCCESS(vuObservationListDestroy(observationList));
+    for (int i = 0; i < static_cast<int>(mGalleryObservers.size()); ++i)
+    {
+        VuObserver* observer = mGalleryObservers[i];
+        bool activate = active && mGalleryBudget.isActive(i);
+        if ((vuObserverIsActivated(observer) == VU_TRUE) == activate)
+        {
+            continue;
+        }
+        VuResult result = activate ? vuObserverActivate(observer) : vuObserverDeactivate(observer);
+        if (result != VU_SUCCESS)
+        {
+            LOG("Failed to %s the gallery observer of %s", activate ? "activate" : "deactivate", GALLERY_TARGETS[i].name);
+        }
+    }
+}
+
+
+void VU_API_CALL
+AppController::onVuforiaState(const VuState* state, void* clientData)
+{
+    static_cast<AppController*>(clientData)->publishTrackingSnapshot(state);
+}
+
+
+void
+AppController::publishTrackingSnapshot(const VuState* state)
+{
+    if (vuStateHasCameraFrame(state) != VU_TRUE)
+    {
+        return;
+    }
+
+    // Either superseded before the rendering thread picked it up or already rendered from
+    TrackingSnapshot& snapshot = mTrackingSnapshots.getWriteBuffer();
+    if (snapshot.state != nullptr && vuStateRelease(snapshot.state) != VU_SUCCESS)
+    {
+        LOG("Error releasing the Vuforia state of a tracking snapshot");
+    }
+    snapshot.state = nullptr;
+
+    if (vuStateGetRenderState(state, &snapshot.renderState) != VU_SUCCESS)
+    {
+        LOG("Error getting render state");
+        return;
+    }
+    if (!snapshot.renderState.vbMesh)
+    {
+        return;
+    }
+
+    extractFrame(state, snapshot.renderState, snapshot.devicePoseData, snapshot.packet);
+
+    // The state passed to the handler is only valid during the call
+    if (vuStateAcquireReference(state, &snapshot.state) != VU_SUCCESS)
+    {
+        LOG("Error acquiring a reference to the Vuforia state");
+        snapshot.state = nullptr;
+        return;
+    }
+
+    mTrackingSnapshots.publish();
+}
+
+
+void
+AppController::releaseTrackingSnapshots()
+{
+    TrackingSnapshot* snapshots = mTrackingSnapshots.getBuffers();
+    for (int i = 0; i < TripleBuffer<TrackingSnapshot>::BUFFER_COUNT; ++i)
+    {
+        if (snapshots[i].state != nullptr && vuStateRelease(snapshots[i].state) != VU_SUCCESS)
+        {
+            LOG("Error releasing the Vuforia state of a tracking snapshot");
+        }
+        snapshots[i].state = nullptr;
+    }
 }
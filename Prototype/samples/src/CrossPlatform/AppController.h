@@ -8,13 +8,27 @@ countries.
 #ifndef __APPCONTROLLER_H__
 #define __APPCONTROLLER_H__
 
+#include "FileDriver.h"
+#include "FrameArena.h"
+#include "FramePacket.h"
+#include "IdleDetector.h"
+#include "ObserverBudget.h"
+#include "PoseFilter.h"
+#include "SessionRecorder.h"
+#include "ThermalGovernor.h"
+#include "TripleBuffer.h"
+
 #include <VuforiaEngine/VuforiaEngine.h>
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <cstdio>
 #include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 
 /// The AppController provides a platform-independent encapsulation of the Vuforia lifecycle
@@ -26,6 +40,8 @@ public:
     // Constants
     static constexpr int IMAGE_TARGET_ID = 0;
     static constexpr int MODEL_TARGET_ID = 1;
+    /// The image targets of GALLERY_TARGETS, of which at most GALLERY_ACTIVE_BUDGET are searched for at a time
+    static constexpr int GALLERY_TARGET_ID = 2;
 
     // Type definitions
     using ErrorCallback = std::function<void(const char* errorString)>;
@@ -39,6 +55,32 @@ public:
         void* appData{ nullptr };
         ErrorCallback showErrorCallback{};
         InitDoneCallback initDoneCallback{};
+        /// Process each Vuforia State on the Vuforia callback thread instead of the rendering thread
+        /// See prepareToRender for what changes for the caller.
+        /// Always on for GALLERY_TARGET_ID, observers activated on the callback thread switch without waiting for a frame.
+        bool pipelinedTracking{ false };
+        /// E.g. VU_CAMERA_VIDEO_MODE_PRESET_OPTIMIZE_SPEED, which tracks from a lower camera resolution
+        VuCameraVideoModePreset cameraVideoMode{ VU_CAMERA_VIDEO_MODE_PRESET_DEFAULT };
+        /// Smooth the poses of the origin and the targets, see PoseFilter
+        /// Makes up for the jitter of the lower camera resolution of OPTIMIZE_SPEED.
+        bool poseFiltering{ false };
+        /// Adapt the camera video mode, render scale and frame rate to the thermal state, see updateThermalGovernor
+        /// The camera video mode of the start level replaces cameraVideoMode.
+        bool thermalGovernor{ false };
+        ThermalGovernor::Config thermalGovernorConfig{};
+        /// Mark the frame packets idle while no target is observed and the device is held still, see IdleDetector
+        /// The platform throttles rendering while FramePacket::idle is set.
+        bool idlePowerMode{ false };
+        IdleDetector::Config idleConfig{};
+        /// Also deactivate the target observers while idle, only while there is a device pose to wake up on
+        bool idleDeactivateObservers{ false };
+        /// Record every session between startAR and stopAR into this existing directory, see SessionRecorder
+        std::string recordingDirectory{};
+        /// Rotation of the camera sensor in degrees, stored in the recording for playback
+        int cameraOrientation{ 0 };
+        /// Replay a recording through the FileDriver instead of using the camera, nothing is recorded then
+        /// The driver reports its progress in the config, which must outlive deinitAR.
+        FileDriverConfig* replay{ nullptr };
     };
 
 
@@ -47,6 +89,12 @@ public:
     /// On Android the appData pointer should be a pointer to the Activity object.
     void initAR(const InitConfig& initConfig, int target);
 
+    /// The steps of initAR, for callers that schedule them themselves, initDoneCallback is not invoked
+    /// initEngine creates the engine, initObservers then loads the datasets of the target and creates its observers.
+    /// Both return false on failure, like initAR they report errors through showErrorCallback.
+    bool initEngine(const InitConfig& initConfig, int target);
+    bool initObservers();
+
     /// Start the AR session
     /// Call this method when the app resumes from paused.
     bool startAR();
@@ -59,10 +107,12 @@ public:
     void deinitAR();
 
     /// Request that the camera refocuses in the current position
-    void cameraPerformAutoFocus();
+    /// Returns false if AR is not started or the focus mode could not be set.
+    bool cameraPerformAutoFocus();
 
     /// Restore the camera to continuous autofocus mode
-    void cameraRestoreAutoFocus();
+    /// Returns false if AR is not started or the focus mode could not be set.
+    bool cameraRestoreAutoFocus();
 
     /// Configure Vuforia rendering.
     /// This method must be called after initAR and startAR are complete.
@@ -80,24 +130,45 @@ public:
     /// Call this method at the start of Vuforia rendering.
     /// Gets the latest video background texture from Vuforia.
     /// Whatever the result of this call finishRender must be called before rendering completes.
+    /// The observations of the state are extracted here in a single pass, the getters below only look
+    /// up the results until the next call.
+    /// With pipelined tracking the poses and the frame packet are extracted on the Vuforia callback thread
+    /// as each new state arrives, this only picks up the latest of them and updates the video background
+    /// texture, which Vuforia requires to happen on the rendering thread. The frame is then drawn again
+    /// from the same state until a newer one arrives.
     bool prepareToRender(double* viewport, VuRenderVideoBackgroundData* renderData);
 
     /// Call this method when Vuforia rendering is complete, this should be near the end of the
     /// platform render callback.
+    /// Resets the frame arena, nothing allocated from it during the frame may be used afterwards.
     void finishRender();
 
+    /// Arena for the transient data of the frame being rendered, reset by finishRender
+    /// Only to be used on the rendering thread between prepareToRender and finishRender.
+    FrameArena& getFrameArena() { return mFrameArena; }
+
     /// Get the current RenderState
     /// The returned object is only valid after prepareToRender has been called
     const VuRenderState& getRenderState() { return mCurrentRenderState; }
 
+    /// Incremented whenever the render view is reconfigured
+    /// The video background mesh of the render state only changes when this changes, so that renderers
+    /// can keep it in GPU buffers between reconfigurations.
+    unsigned int getRenderViewVersion() const { return mRenderViewVersion; }
+
     /// Get rendering information for the world origin position.
     /// Returns false if the world origin position is not currently available.
     bool getOrigin(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix);
 
     /// Get rendering information for the Image Target.
     /// Returns false if Vuforia isn't currently tracking the Image Target.
+    /// In gallery mode this is the first of the tracked targets, see getImageTargetResults.
     bool getImageTargetResult(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix, VuMatrix44F& scaledModelViewMatrix);
 
+    /// Get rendering information for every tracked Image Target, at most maxTargets of them.
+    /// Returns the number of targets written.
+    int getImageTargetResults(VuMatrix44F& projectionMatrix, FramePacket::Target* targets, int maxTargets);
+
     /// Get rendering information for the Model Target.
     /// Returns false if Vuforia isn't currently tracking the Model Target.
     bool getModelTargetResult(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix, VuMatrix44F& scaledModelViewMatrix);
@@ -107,11 +178,49 @@ public:
     bool getModelTargetGuideView(VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix, VuImageInfo& guideViewImageInfo,
                                  VuBool& guideViewImageHasChanged);
 
+    /// Collect the world origin, the observed targets and the guide view of the current frame
+    /// The packet is only valid between prepareToRender and finishRender, see FramePacket.
+    void getFramePacket(FramePacket& packet);
+
+    /// Feed the thermal governor with the thermal state of the platform and the time the frame took
+    /// Call on the rendering thread after finishRender, where restarting the camera for another video
+    /// mode is safe. Returns true if the level changed, the platform then applies the render scale and
+    /// the frame rate cap of getThermalLevel. Does nothing unless InitConfig::thermalGovernor was set.
+    bool updateThermalGovernor(ThermalGovernor::Status status, float headroom, float frameMilliseconds);
+    const ThermalGovernor::Level& getThermalLevel() const { return mThermalGovernor.getLevel(); }
+
     /// Get the PlatformController handle.
     /// The result is only valid after initAR is called and before deinitAR is called.
     VuController* getPlatformController() { return mPlatformController; }
 
 
+private: // types
+    /// Data structure with information about the last known device pose
+    struct DevicePoseData
+    {
+        /// Device pose
+        VuMatrix44F pose{};
+
+        /// Device pose status
+        VuObservationPoseStatus poseStatus{ VU_OBSERVATION_POSE_STATUS_NO_POSE };
+
+        /// Device pose status info
+        VuDevicePoseObservationStatusInfo poseStatusInfo{ VU_DEVICE_POSE_OBSERVATION_STATUS_INFO_UNKNOWN };
+    };
+
+    /// Everything rendering needs of one Vuforia State, extracted on the Vuforia callback thread
+    struct TrackingSnapshot
+    {
+        /// Reference to the state the snapshot was taken of, held for the video background texture update
+        /// Also keeps the video background mesh of renderState alive. Released when the producer reuses
+        /// the snapshot.
+        VuState* state{ nullptr };
+        VuRenderState renderState{};
+        DevicePoseData devicePoseData{};
+        FramePacket packet{};
+    };
+
+
 private: // methods
     /// Used by initAR to prepare and invoke Vuforia initialization.
     bool initVuforiaInternal(void* appData);
@@ -125,8 +234,46 @@ private: // methods
     /// Clean up Observers created by createObservers
     void destroyObservers();
 
-    /// Called in prepareToRender to update the cached device pose information
-    void updateDevicePose();
+    /// Walk the observations of a state once and collect everything the getters return
+    void extractFrame(const VuState* state, const VuRenderState& renderState, DevicePoseData& devicePoseData, FramePacket& packet);
+
+    /// Read a single observation, the target ones return false if the observation has no pose
+    static void extractDevicePose(const VuObservation* observation, DevicePoseData& devicePoseData);
+    bool extractImageTarget(const VuObservation* observation, const VuRenderState& renderState, FramePacket::Target& target);
+    bool extractModelTarget(const VuObservation* observation, const VuRenderState& renderState, FramePacket::Target& target);
+
+    /// Look up the guide views of the Model Target observer and the active one
+    /// Called once after creating the observer, and must be called again whenever the active guide view is changed.
+    void resolveGuideViews();
+
+    /// Filter the poses of an extracted packet with the filters of the origin and each target
+    void filterPoses(const VuState* state, FramePacket& packet);
+
+    /// Place the guide view picked by extractModelTarget for the camera of a state
+    bool getModelTargetGuideView(const VuState* state, VuMatrix44F& projectionMatrix, VuMatrix44F& modelViewMatrix,
+                                 VuImageInfo& guideViewImageInfo, VuBool& guideViewImageHasChanged);
+
+    /// Create the observers of GALLERY_TARGETS, only the first budget of them activated
+    bool createGalleryObservers();
+
+    /// Activate and deactivate gallery observers for the targets observed in a packet
+    /// Called once per camera frame, on the Vuforia callback thread unless the state handler could not be registered.
+    void updateGalleryObservers(const FramePacket& packet);
+
+    /// Update the idle detector with a packet and mark the packet idle, called by extractFrame
+    void updateIdleMode(const DevicePoseData& devicePoseData, FramePacket& packet);
+
+    /// Deactivate the target observers, or activate them again, gallery observers as picked by the budget
+    void setTargetObserversActive(bool active);
+
+    /// State handler registered with pipelined tracking, called on the Vuforia callback thread
+    static void VU_API_CALL onVuforiaState(const VuState* state, void* clientData);
+
+    /// Extract a snapshot of the state and hand it to the rendering thread
+    void publishTrackingSnapshot(const VuState* state);
+
+    /// Release the state references held by the tracking snapshots, only while no state handler is registered
+    void releaseTrackingSnapshots();
 
 private: // data members
     /// Callback to inform the user of an error
@@ -145,7 +292,7 @@ private: // data members
 
     /// THe rendering backend to use for the Video Background
     VuRenderVBBackendType mVbRenderBackend = VuRenderVBBackendType::VU_RENDER_VB_BACKEND_DEFAULT;
-    /// The target to use, either IMAGE_TARGET_ID or MODEL_TARGET_ID
+    /// The target to use, IMAGE_TARGET_ID, MODEL_TARGET_ID or GALLERY_TARGET_ID
     int mTarget = IMAGE_TARGET_ID;
 
     /// The Vuforia camera video mode to use, either DEFAULT, SPEED or QUALITY.
@@ -157,24 +304,56 @@ private: // data members
     /// Local copy of current RenderState
     VuRenderState mCurrentRenderState;
     /// Remember the display aspect ratio for later configuration of Guide View rendering
-    float mDisplayAspectRatio;
+    /// Also read on the Vuforia callback thread with pipelined tracking.
+    std::atomic<float> mDisplayAspectRatio{ 1.0f };
+    /// See getRenderViewVersion
+    unsigned int mRenderViewVersion = 0;
 
     /// The observer for device poses
     VuObserver* mDevicePoseObserver = nullptr;
 
-    /// Data structure with information about the last known device pose
-    struct DevicePoseData
-    {
-        /// Device pose
-        VuMatrix44F pose{};
+    /// The last known device pose
+    DevicePoseData mLatestDevicePoseData{};
 
-        /// Device pose status
-        VuObservationPoseStatus poseStatus{ VU_OBSERVATION_POSE_STATUS_NO_POSE };
+    /// Everything extracted from the state rendered by the current frame, see prepareToRender
+    FramePacket mFramePacket{};
 
-        /// Device pose status info
-        VuDevicePoseObservationStatusInfo poseStatusInfo{ VU_DEVICE_POSE_OBSERVATION_STATUS_INFO_UNKNOWN };
-    };
-    DevicePoseData mLatestDevicePoseData{};
+    /// See getFrameArena
+    FrameArena mFrameArena;
+
+    /// Created with the observers and refilled by every extractFrame, only used by the thread extracting
+    VuObservationList* mObservationList = nullptr;
+
+    /// Set from InitConfig::pipelinedTracking
+    bool mPipelinedTracking{ false };
+
+    /// Set from InitConfig::recordingDirectory and cameraOrientation
+    std::string mRecordingDirectory;
+    int mCameraOrientation{ 0 };
+    SessionRecorder mSessionRecorder;
+
+    /// Set from InitConfig::replay
+    FileDriverConfig* mReplay{ nullptr };
+
+    /// Set from InitConfig::thermalGovernor
+    bool mThermalGovernorEnabled{ false };
+    ThermalGovernor mThermalGovernor;
+
+    /// Set from InitConfig::idlePowerMode and idleDeactivateObservers, only used on the thread that builds the frame packets
+    bool mIdlePowerMode{ false };
+    bool mIdleDeactivateObservers{ false };
+    IdleDetector mIdleDetector;
+    /// Set while setTargetObserversActive deactivated the target observers for idle
+    bool mIdleObserversDeactivated{ false };
+
+    /// Set from InitConfig::poseFiltering
+    bool mPoseFiltering{ false };
+    /// A filter for the origin and one for every target, targets at GALLERY_TARGET_ID plus their gallery index
+    PoseFilter mOriginPoseFilter;
+    std::vector<PoseFilter> mTargetPoseFilters;
+
+    /// Written by the state handler, read by prepareToRender
+    TripleBuffer<TrackingSnapshot> mTrackingSnapshots;
 
     /// Flag set when the tracker is relocalizing
     bool mTimingRelocalizingState{ false };
@@ -186,12 +365,26 @@ private: // data members
     /// The observer for either the Image or Model target depending on which target was specified
     VuObserver* mObjectObserver = nullptr;
 
+    /// Observers active at once in gallery mode, also the number of targets tracked at once
+    static constexpr int GALLERY_ACTIVE_BUDGET = FramePacket::MAX_TARGETS;
+
+    /// In gallery mode the observers of GALLERY_TARGETS in the same order, and their observer ids
+    std::vector<VuObserver*> mGalleryObservers;
+    std::vector<int32_t> mGalleryObserverIds;
+    /// Picks the active gallery observers, only used on the thread that builds the frame packets
+    ObserverBudget mGalleryBudget;
+
     /// Between calls to prepareToRender and finishRender this holds a copy of the Vuforia state.
     VuState* mVuforiaState = nullptr;
 
     /// If a Model Target Guide View should be displayed this points to the object providing
     /// details of what the App should render.
     VuGuideView* mGuideViewModelTarget = nullptr;
+
+    /// The guide views of the Model Target observer by name, see resolveGuideViews
+    std::unordered_map<std::string, VuGuideView*> mGuideViews;
+    /// The active one of mGuideViews, nullptr if there is none as for Advanced Model Targets
+    VuGuideView* mActiveGuideView = nullptr;
 };
 
 #endif /* __APPCONTROLLER_H__ */
@@ -0,0 +1,173 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "ContentManifest.h"
+
+#include "Log.h"
+
+#include <cstdlib>
+#include <sstream>
+
+
+namespace
+{
+bool
+parseBool(const std::string& value, bool& result)
+{
+    if (value != "0" && value != "1")
+    {
+        return false;
+    }
+    result = value == "1";
+    return true;
+}
+
+
+bool
+parseNumber(const std::string& value, float& result)
+{
+    char* end = nullptr;
+    result = strtof(value.c_str(), &end);
+    return !value.empty() && *end == '\0';
+}
+
+
+std::vector<std::string>
+splitList(const std::string& value)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(value);
+    for (std::string item; std::getline(stream, item, ',');)
+    {
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+} // namespace
+
+
+bool
+ContentManifest::parse(const char* text, size_t size)
+{
+    mArtworks.clear();
+    std::stringstream lines(std::string(text, size));
+    int lineNumber = 0;
+    for (std::string line; std::getline(lines, line);)
+    {
+        ++lineNumber;
+        std::stringstream tokens(line);
+        std::string keyword;
+        if (!(tokens >> keyword) || keyword[0] == '#')
+        {
+            continue;
+        }
+        if (keyword != "artwork")
+        {
+            LOG("Error in content manifest line %d, unknown keyword %s", lineNumber, keyword.c_str());
+            mArtworks.clear();
+            return false;
+        }
+
+        Artwork artwork;
+        for (std::string token; tokens >> token;)
+        {
+            size_t separator = token.find('=');
+            if (separator == std::string::npos ||
+                !parseField(artwork, token.substr(0, separator), token.substr(separator + 1), lineNumber))
+            {
+                LOG("Error in content manifest line %d at %s", lineNumber, token.c_str());
+                mArtworks.clear();
+                return false;
+            }
+        }
+        if (artwork.target.empty() || artwork.model.empty() || artwork.texture.empty())
+        {
+            LOG("Error in content manifest line %d, target, model and texture are required", lineNumber);
+            mArtworks.clear();
+            return false;
+        }
+        mArtworks.push_back(std::move(artwork));
+    }
+    return true;
+}
+
+
+bool
+ContentManifest::parseField(Artwork& artwork, const std::string& key, const std::string& value, int line)
+{
+    float number = 0.0f;
+    if (key.empty() || value.empty())
+    {
+        return false;
+    }
+    if (key == "target")
+    {
+        artwork.target = value;
+    }
+    else if (key == "model")
+    {
+        artwork.model = value;
+    }
+    else if (key == "quantize")
+    {
+        return parseBool(value, artwork.quantize);
+    }
+    else if (key == "texture")
+    {
+        artwork.texture = value;
+    }
+    else if (key == "mipmaps")
+    {
+        return parseBool(value, artwork.mipmaps);
+    }
+    else if (key == "anisotropy")
+    {
+        return parseNumber(value, artwork.anisotropy) && artwork.anisotropy >= 1.0f;
+    }
+    else if (key == "normal_map")
+    {
+        artwork.normalMap = value;
+    }
+    else if (key == "normal_map_downscale")
+    {
+        if (!parseNumber(value, number) || number < 1.0f)
+        {
+            return false;
+        }
+        artwork.normalMapDownscale = static_cast<int>(number);
+    }
+    else if (key == "texture_array")
+    {
+        return parseBool(value, artwork.textureArray);
+    }
+    else if (key == "blend")
+    {
+        artwork.blend = value;
+        return value == "opaque" || value == "alpha_test" || value == "blended";
+    }
+    else if (key == "url")
+    {
+        artwork.url = value;
+    }
+    else if (key == "coarse_model")
+    {
+        artwork.coarseModel = value;
+    }
+    else if (key == "texture_previews")
+    {
+        artwork.texturePreviews = splitList(value);
+    }
+    else
+    {
+        // Newer manifests may carry fields this version does not know
+        LOG("Content manifest line %d: unknown key %s skipped", line, key.c_str());
+    }
+    return true;
+}
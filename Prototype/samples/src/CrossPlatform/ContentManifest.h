@@ -0,0 +1,77 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __CONTENTMANIFEST_H__
+#define __CONTENTMANIFEST_H__
+
+#include <string>
+#include <vector>
+
+
+/// Which content augments which target, read from a text manifest shipped with the app or downloaded
+/**
+ * One artwork per line, the keyword artwork followed by key=value fields without spaces in the values.
+ * Empty lines and lines starting with # are skipped, target, model and texture are required.
+ * The second line is wrapped here only:
+ *
+ *   artwork target=image model=Venus_01 texture=VNUSMRBT.JPG quantize=1 anisotropy=8 normal_map=nmap.png
+ *   artwork target=model model=VikingLander coarse_model=VikingLander.coarse.mesh texture=VikingLander.jpg
+ *           texture_previews=VikingLander.256.jpg,VikingLander.512.jpg url=https://content.example.com/lander/
+ *
+ * Without url the files are assets of the app, model is then the base name of <model>.mesh or <model>.obj.
+ * With url the files are downloaded from url followed by the file name when the target is first needed,
+ * model is a file name then, preferably a .mesh quantized and with levels of detail from MeshConverter; the
+ * service may send the files gzip encoded, the platform downloader inflates them.
+ * Remote artworks refine progressively: coarse_model is shown until model arrives, and each of
+ * texture_previews, coarse to fine, until texture arrives.
+ */
+class ContentManifest
+{
+public:
+    struct Artwork
+    {
+        /// Name of the target augmented, e.g. image or model, mapped to the targets of the app by the renderer
+        std::string target;
+        std::string model;
+        /// Quantize the vertices when the model is parsed from an OBJ file
+        bool quantize = false;
+        std::string texture;
+        bool mipmaps = true;
+        float anisotropy = 1.0f;
+        /// Normal map for pseudo normal shading, empty for plain texturing
+        std::string normalMap;
+        /// The normal map is decoded at 1/normalMapDownscale of its size in each direction
+        int normalMapDownscale = 1;
+        /// Pack the texture into the artwork texture array, ignored for remote artworks
+        bool textureArray = false;
+        /// opaque, alpha_test or blended
+        std::string blend = "opaque";
+
+        /// Base URL of remote artworks, empty for artworks in the app assets
+        std::string url;
+        /// Remote artworks only, empty if there is no coarser variant
+        std::string coarseModel;
+        std::vector<std::string> texturePreviews;
+    };
+
+    /// Replace the artworks with those of a manifest held in memory
+    /// Returns false and keeps no artworks if a line cannot be parsed, unknown keys are logged and skipped.
+    bool parse(const char* text, size_t size);
+
+    const std::vector<Artwork>& getArtworks() const { return mArtworks; }
+
+    /// URL of a file of a remote artwork
+    static std::string getUrl(const Artwork& artwork, const std::string& file) { return artwork.url + file; }
+
+private:
+    /// Set a field of an artwork from a key=value token, returns false for malformed values
+    static bool parseField(Artwork& artwork, const std::string& key, const std::string& value, int line);
+
+    std::vector<Artwork> mArtworks;
+};
+
+#endif /* __CONTENTMANIFEST_H__ */
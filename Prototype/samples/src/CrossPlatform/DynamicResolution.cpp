@@ -0,0 +1,83 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+DynamicResolution::DynamicResolution()
+{
+    setConfig(Config());
+}
+
+
+DynamicResolution::DynamicResolution(const Config& config)
+{
+    setConfig(config);
+}
+
+
+void
+DynamicResolution::setConfig(const Config& config)
+{
+    mConfig = config;
+    mConfig.minScale = std::max(mConfig.minScale, 0.1f);
+    mConfig.maxScale = std::max(mConfig.maxScale, mConfig.minScale);
+    mConfig.windowFrames = std::max(mConfig.windowFrames, 1);
+    reset();
+}
+
+
+void
+DynamicResolution::reset()
+{
+    mScale = mConfig.maxScale;
+    mWindowSum = 0.0f;
+    mWindowCount = 0;
+}
+
+
+bool
+DynamicResolution::addFrameTime(float milliseconds)
+{
+    mWindowSum += milliseconds;
+    if (++mWindowCount < mConfig.windowFrames)
+    {
+        return false;
+    }
+
+    float average = mWindowSum / mWindowCount;
+    mWindowSum = 0.0f;
+    mWindowCount = 0;
+
+    float scale = mScale;
+    if (average > mConfig.targetMilliseconds)
+    {
+        // Jump straight to the pixel count expected to meet the target when far over it
+        float expected = mScale * std::sqrt(mConfig.targetMilliseconds / average);
+        scale = std::min(mScale - mConfig.step, expected);
+    }
+    else
+    {
+        float larger = mScale + mConfig.step;
+        float expectedMilliseconds = average * (larger * larger) / (mScale * mScale);
+        if (expectedMilliseconds < mConfig.targetMilliseconds * (1.0f - mConfig.hysteresis))
+        {
+            scale = larger;
+        }
+    }
+
+    scale = std::min(std::max(scale, mConfig.minScale), mConfig.maxScale);
+    if (scale == mScale)
+    {
+        return false;
+    }
+    mScale = scale;
+    return true;
+}
@@ -0,0 +1,59 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __DYNAMICRESOLUTION_H__
+#define __DYNAMICRESOLUTION_H__
+
+
+/// Picks the resolution scale of a render pass from its measured frame times
+/**
+ * The frame times are averaged over a window of frames, the scale is adjusted at most once per window.
+ * The scale applies to both axes, the cost of the pass is assumed to follow the pixel count.
+ * It steps down as soon as the average exceeds the target, and only steps up when the average
+ * scaled to the larger pixel count still stays below the target by the hysteresis margin, so that
+ * it settles instead of oscillating around the target.
+ */
+class DynamicResolution
+{
+public:
+    struct Config
+    {
+        float minScale = 0.5f;
+        float maxScale = 1.0f;
+        /// Frame time of the pass in milliseconds the scale is adapted to
+        float targetMilliseconds = 8.0f;
+        /// Fraction of the target kept free after stepping up
+        float hysteresis = 0.15f;
+        /// Smallest change of the scale per adjustment
+        float step = 0.05f;
+        /// Frames averaged before each adjustment
+        int windowFrames = 20;
+    };
+
+    DynamicResolution();
+    explicit DynamicResolution(const Config& config);
+
+    /// Replace the configuration, the scale restarts at maxScale
+    void setConfig(const Config& config);
+    const Config& getConfig() const { return mConfig; }
+
+    /// Restart at maxScale with no frame times
+    void reset();
+
+    /// Add the measured frame time of the pass, returns true if the scale changed
+    bool addFrameTime(float milliseconds);
+
+    float getScale() const { return mScale; }
+
+private:
+    Config mConfig;
+    float mScale = 1.0f;
+    float mWindowSum = 0.0f;
+    int mWindowCount = 0;
+};
+
+#endif /* __DYNAMICRESOLUTION_H__ */
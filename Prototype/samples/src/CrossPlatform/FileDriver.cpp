@@ -0,0 +1,459 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+// Vuforia Driver replaying a FrameRecording, built as a library of its own, see FileDriver.h
+
+#include "FileDriver.h"
+#include "FrameRecording.h"
+#include "Log.h"
+
+#include <VuforiaEngine/Driver/Driver.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+constexpr uint32_t DEFAULT_FRAME_RATE = 30;
+
+/// Delivers the frames and poses of the recording on a thread of its own
+/**
+ * Shared by the camera and the positional device tracker, the pose recorded for a frame is delivered
+ * right before the frame with the same timestamp.
+ */
+class Playback
+{
+public:
+    explicit Playback(FileDriverConfig* config) : mConfig(config) {}
+    ~Playback() { stop(); }
+
+    /// Read the camera mode and the camera orientation from the recording
+    bool open()
+    {
+        if (mConfig == nullptr || mConfig->path == nullptr || !mReader.open(mConfig->path) || !mReader.read(mFrame))
+        {
+            LOG("FileDriver: failed to open the recording %s", mConfig != nullptr && mConfig->path != nullptr ? mConfig->path : "");
+            return false;
+        }
+
+        mCameraMode.width = mFrame.width;
+        mCameraMode.height = mFrame.height;
+        mCameraMode.format = static_cast<VuforiaDriver::PixelFormat>(mFrame.format);
+        mCameraMode.fps = DEFAULT_FRAME_RATE;
+        uint64_t firstTimestamp = mFrame.timestamp;
+        if (mReader.read(mFrame) && mFrame.timestamp > firstTimestamp)
+        {
+            mCameraMode.fps = static_cast<uint32_t>(std::max(1.0, 1.0e9 / static_cast<double>(mFrame.timestamp - firstTimestamp) + 0.5));
+        }
+        return mReader.rewind();
+    }
+
+    void close() { mReader.close(); }
+
+    const VuforiaDriver::CameraMode& getCameraMode() const { return mCameraMode; }
+    int getCameraOrientation() const { return mReader.getCameraOrientation(); }
+
+    void setPoseCallback(VuforiaDriver::PoseCallback* callback)
+    {
+        std::lock_guard<std::mutex> lock(mCallbackMutex);
+        mPoseCallback = callback;
+    }
+
+    bool start(VuforiaDriver::CameraCallback* callback)
+    {
+        stop();
+        if (callback == nullptr || !mReader.isOpen())
+        {
+            return false;
+        }
+        mCameraCallback = callback;
+        mStopping = false;
+        mThread = std::thread(&Playback::run, this);
+        return true;
+    }
+
+    void stop()
+    {
+        mStopping = true;
+        if (mThread.joinable())
+        {
+            mThread.join();
+        }
+    }
+
+private:
+    void run()
+    {
+        using Clock = std::chrono::steady_clock;
+
+        std::vector<int64_t> trackingTimes;
+        Clock::time_point playbackStart = Clock::now();
+        uint64_t firstTimestamp = 0;
+        bool first = true;
+        mConfig->startTime = std::chrono::duration_cast<std::chrono::nanoseconds>(playbackStart.time_since_epoch()).count();
+
+        while (!mStopping)
+        {
+            if (!mReader.read(mFrame))
+            {
+                if (!mConfig->benchmark && mConfig->loop && mReader.rewind())
+                {
+                    first = true;
+                    continue;
+                }
+                break;
+            }
+
+            // Recorded times are of the recording device's clock, frames arrive on the clock of this one
+            Clock::time_point deliveryTime = Clock::now();
+            if (first)
+            {
+                playbackStart = deliveryTime;
+                firstTimestamp = mFrame.timestamp;
+                first = false;
+            }
+            else if (!mConfig->benchmark)
+            {
+                deliveryTime = playbackStart + std::chrono::nanoseconds(mFrame.timestamp - firstTimestamp);
+                std::this_thread::sleep_until(deliveryTime);
+            }
+            uint64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(deliveryTime.time_since_epoch()).count();
+
+            deliverPose(timestamp);
+
+            VuforiaDriver::CameraFrame cameraFrame;
+            cameraFrame.timestamp = timestamp;
+            cameraFrame.buffer = mFrame.pixels.data();
+            cameraFrame.bufferSize = static_cast<uint32_t>(mFrame.pixels.size());
+            cameraFrame.index = mFrame.index;
+            cameraFrame.width = mFrame.width;
+            cameraFrame.height = mFrame.height;
+            cameraFrame.stride = mFrame.stride;
+            cameraFrame.format = static_cast<VuforiaDriver::PixelFormat>(mFrame.format);
+            cameraFrame.intrinsics.focalLengthX = mFrame.focalLength[0];
+            cameraFrame.intrinsics.focalLengthY = mFrame.focalLength[1];
+            cameraFrame.intrinsics.principalPointX = mFrame.principalPoint[0];
+            cameraFrame.intrinsics.principalPointY = mFrame.principalPoint[1];
+            memcpy(cameraFrame.intrinsics.distortionCoefficients, mFrame.distortion, sizeof(mFrame.distortion));
+
+            // Vuforia tracks the frame before the callback returns
+            Clock::time_point callbackStart = Clock::now();
+            mCameraCallback->onNewCameraFrame(&cameraFrame);
+            trackingTimes.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - callbackStart).count());
+            ++mConfig->deliveredFrames;
+        }
+
+        // A playback stopped before its end reports nothing
+        if (!mStopping)
+        {
+            mConfig->endTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+            if (!trackingTimes.empty())
+            {
+                std::sort(trackingTimes.begin(), trackingTimes.end());
+                auto at = [&](float fraction) {
+                    size_t index = std::min(trackingTimes.size() - 1, static_cast<size_t>(fraction * trackingTimes.size()));
+                    return static_cast<float>(trackingTimes[index]) * 1.0e-6f;
+                };
+                mConfig->trackingP50 = at(0.5f);
+                mConfig->trackingP90 = at(0.9f);
+                mConfig->trackingP99 = at(0.99f);
+            }
+            mConfig->finished = true;
+        }
+    }
+
+    void deliverPose(uint64_t timestamp)
+    {
+        std::lock_guard<std::mutex> lock(mCallbackMutex);
+        if (mPoseCallback == nullptr)
+        {
+            return;
+        }
+
+        VuforiaDriver::Pose pose;
+        pose.timestamp = timestamp;
+        pose.coordinateSystem = VuforiaDriver::PoseCoordSystem::CAMERA;
+        switch (mFrame.poseStatus)
+        {
+            case FrameRecording::PoseStatus::TRACKED:
+                pose.reason = VuforiaDriver::PoseReason::VALID;
+                pose.validity = VuforiaDriver::PoseValidity::VALID;
+                break;
+            case FrameRecording::PoseStatus::LIMITED:
+                pose.reason = VuforiaDriver::PoseReason::VALID;
+                pose.validity = VuforiaDriver::PoseValidity::UNRELIABLE;
+                break;
+            default:
+                pose.reason = VuforiaDriver::PoseReason::INITIALIZING;
+                pose.validity = VuforiaDriver::PoseValidity::UNRELIABLE;
+                break;
+        }
+
+        // The recorded pose has the GL camera axes (y up, looking down -z), the driver pose the camera
+        // axes of Vuforia's camera coordinate system (y down, looking down +z): the y and z columns flip.
+        // The rotation is passed row by row.
+        const float* matrix = mFrame.pose;
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 3; ++column)
+            {
+                float value = matrix[column * 4 + row];
+                pose.rotationData[row * 3 + column] = column == 0 ? value : -value;
+            }
+            pose.translationData[row] = matrix[12 + row];
+        }
+        mPoseCallback->onNewPose(&pose);
+    }
+
+    FileDriverConfig* mConfig;
+    FrameRecording::Reader mReader;
+    FrameRecording::Frame mFrame;
+    VuforiaDriver::CameraMode mCameraMode;
+
+    VuforiaDriver::CameraCallback* mCameraCallback = nullptr;
+    /// Guards the pose callback, set on a Vuforia thread while frames are delivered
+    std::mutex mCallbackMutex;
+    VuforiaDriver::PoseCallback* mPoseCallback = nullptr;
+
+    std::thread mThread;
+    std::atomic<bool> mStopping{ false };
+};
+
+
+class FileCamera : public VuforiaDriver::ExternalCamera
+{
+public:
+    explicit FileCamera(Playback& playback) : mPlayback(playback) {}
+
+    bool VUFORIA_DRIVER_CALLING_CONVENTION open() override { return mPlayback.open(); }
+
+    bool VUFORIA_DRIVER_CALLING_CONVENTION close() override
+    {
+        mPlayback.stop();
+        mPlayback.close();
+        return true;
+    }
+
+    bool VUFORIA_DRIVER_CALLING_CONVENTION start(VuforiaDriver::CameraMode cameraMode, VuforiaDriver::CameraCallback* cb) override
+    {
+        (void)cameraMode;
+        return mPlayback.start(cb);
+    }
+
+    bool VUFORIA_DRIVER_CALLING_CONVENTION stop() override
+    {
+        mPlayback.stop();
+        return true;
+    }
+
+    uint32_t VUFORIA_DRIVER_CALLING_CONVENTION getNumSupportedCameraModes() override { return 1; }
+
+    bool VUFORIA_DRIVER_CALLING_CONVENTION getSupportedCameraMode(uint32_t index, VuforiaDriver::CameraMode* cameraMode) override
+    {
+        if (index != 0 || cameraMode == nullptr)
+        {
+            return false;
+        }
+        *cameraMode = mPlayback.getCameraMode();
+        return true;
+    }
+
+    // The recording has fixed exposure and focus
+    bool VUFORIA_DRIVER_CALLING_CONVENTION supportsExposureMode(VuforiaDriver::ExposureMode exposureMode) override
+    {
+        (void)exposureMode;
+        return false;
+    }
+    VuforiaDriver::ExposureMode VUFORIA_DRIVER_CALLING_CONVENTION getExposureMode() override
+    {
+        return VuforiaDriver::ExposureMode::UNKNOWN;
+    }
+    bool VUFORIA_DRIVER_CALLING_CONVENTION setExposureMode(VuforiaDriver::ExposureMode exposureMode) override
+    {
+        (void)exposureMode;
+        return false;
+    }
+    bool VUFORIA_DRIVER_CALLING_CONVENTION supportsExposureValue() override { return false; }
+    uint64_t VUFORIA_DRIVER_CALLING_CONVENTION getExposureValueMin() override { return 0; }
+    uint64_t VUFORIA_DRIVER_CALLING_CONVENTION getExposureValueMax() override { return 0; }
+    uint64_t VUFORIA_DRIVER_CALLING_CONVENTION getExposureValue() override { return 0; }
+    bool VUFORIA_DRIVER_CALLING_CONVENTION setExposureValue(uint64_t exposureTime) override
+    {
+        (void)exposureTime;
+        return false;
+    }
+
+    bool VUFORIA_DRIVER_CALLING_CONVENTION supportsFocusMode(VuforiaDriver::FocusMode focusMode) override
+    {
+        return focusMode == VuforiaDriver::FocusMode::FIXED;
+    }
+    VuforiaDriver::FocusMode VUFORIA_DRIVER_CALLING_CONVENTION getFocusMode() override { return VuforiaDriver::FocusMode::FIXED; }
+    bool VUFORIA_DRIVER_CALLING_CONVENTION setFocusMode(VuforiaDriver::FocusMode focusMode) override
+    {
+        return focusMode == VuforiaDriver::FocusMode::FIXED;
+    }
+    bool VUFORIA_DRIVER_CALLING_CONVENTION supportsFocusValue() override { return false; }
+    float VUFORIA_DRIVER_CALLING_CONVENTION getFocusValueMin() override { return 0.0f; }
+    float VUFORIA_DRIVER_CALLING_CONVENTION getFocusValueMax() override { return 0.0f; }
+    float VUFORIA_DRIVER_CALLING_CONVENTION getFocusValue() override { return 0.0f; }
+    bool VUFORIA_DRIVER_CALLING_CONVENTION setFocusValue(float focusValue) override
+    {
+        (void)focusValue;
+        return false;
+    }
+
+private:
+    Playback& mPlayback;
+};
+
+
+class FilePoseTracker : public VuforiaDriver::ExternalPositionalDeviceTracker
+{
+public:
+    explicit FilePoseTracker(Playback& playback) : mPlayback(playback) {}
+
+    bool VUFORIA_DRIVER_CALLING_CONVENTION open() override { return true; }
+    bool VUFORIA_DRIVER_CALLING_CONVENTION close() override { return true; }
+
+    bool VUFORIA_DRIVER_CALLING_CONVENTION start(VuforiaDriver::PoseCallback* cb, VuforiaDriver::AnchorCallback* anchorCb) override
+    {
+        (void)anchorCb;
+        mPlayback.setPoseCallback(cb);
+        return true;
+    }
+
+    bool VUFORIA_DRIVER_CALLING_CONVENTION stop() override
+    {
+        mPlayback.setPoseCallback(nullptr);
+        return true;
+    }
+
+    // The recorded poses cannot be reset
+    bool VUFORIA_DRIVER_CALLING_CONVENTION resetTracking() override { return false; }
+
+private:
+    Playback& mPlayback;
+};
+
+
+class FileDriver final : public VuforiaDriver::Driver
+{
+public:
+    explicit FileDriver(FileDriverConfig* config) : mPlayback(config) {}
+
+    VuforiaDriver::ExternalCamera* VUFORIA_DRIVER_CALLING_CONVENTION createExternalCamera() override
+    {
+        if (mCamera != nullptr)
+        {
+            return nullptr;
+        }
+        mCamera = std::make_unique<FileCamera>(mPlayback);
+        return mCamera.get();
+    }
+
+    void VUFORIA_DRIVER_CALLING_CONVENTION destroyExternalCamera(VuforiaDriver::ExternalCamera* instance) override
+    {
+        if (instance == mCamera.get())
+        {
+            mCamera.reset();
+        }
+    }
+
+    VuforiaDriver::ExternalPositionalDeviceTracker* VUFORIA_DRIVER_CALLING_CONVENTION createExternalPositionalDeviceTracker() override
+    {
+        if (mPoseTracker != nullptr)
+        {
+            return nullptr;
+        }
+        mPoseTracker = std::make_unique<FilePoseTracker>(mPlayback);
+        return mPoseTracker.get();
+    }
+
+    void VUFORIA_DRIVER_CALLING_CONVENTION
+    destroyExternalPositionalDeviceTracker(VuforiaDriver::ExternalPositionalDeviceTracker* instance) override
+    {
+        if (instance == mPoseTracker.get())
+        {
+            mPoseTracker.reset();
+        }
+    }
+
+    uint32_t VUFORIA_DRIVER_CALLING_CONVENTION getCapabilities() override
+    {
+        return static_cast<uint32_t>(VuforiaDriver::Capability::CAMERA_IMAGE | VuforiaDriver::Capability::CAMERA_POSE);
+    }
+
+    uint32_t VUFORIA_DRIVER_CALLING_CONVENTION getCameraOrientation(uint32_t deviceOrientationInDegrees) override
+    {
+        (void)deviceOrientationInDegrees;
+        return static_cast<uint32_t>(mPlayback.getCameraOrientation());
+    }
+
+private:
+    /// Destroyed after the camera and the tracker using it
+    Playback mPlayback;
+    std::unique_ptr<FileCamera> mCamera;
+    std::unique_ptr<FilePoseTracker> mPoseTracker;
+};
+
+FileDriver* gDriver = nullptr;
+} // namespace
+
+
+extern "C"
+{
+VUFORIA_DRIVER_API_EXPORT uint32_t VUFORIA_DRIVER_CALLING_CONVENTION
+vuforiaDriver_getAPIVersion()
+{
+    return VuforiaDriver::VUFORIA_DRIVER_API_VERSION;
+}
+
+
+VUFORIA_DRIVER_API_EXPORT uint32_t VUFORIA_DRIVER_CALLING_CONVENTION
+vuforiaDriver_getLibraryVersion(char* versionString, const uint32_t maxLen)
+{
+    const char* version = "FileDriver-1";
+    if (maxLen == 0)
+    {
+        return 0;
+    }
+    uint32_t length = std::min(static_cast<uint32_t>(strlen(version)), maxLen - 1);
+    memcpy(versionString, version, length);
+    versionString[length] = '\0';
+    return length;
+}
+
+
+VUFORIA_DRIVER_API_EXPORT VuforiaDriver::Driver* VUFORIA_DRIVER_CALLING_CONVENTION
+vuforiaDriver_init(VuforiaDriver::PlatformData* platformData, void* userData)
+{
+    (void)platformData;
+    if (gDriver != nullptr)
+    {
+        return nullptr;
+    }
+    gDriver = new FileDriver(static_cast<FileDriverConfig*>(userData));
+    return gDriver;
+}
+
+
+VUFORIA_DRIVER_API_EXPORT void VUFORIA_DRIVER_CALLING_CONVENTION
+vuforiaDriver_deinit(VuforiaDriver::Driver* instance)
+{
+    if (instance == gDriver)
+    {
+        delete gDriver;
+        gDriver = nullptr;
+    }
+}
+}
@@ -0,0 +1,48 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __FILEDRIVER_H__
+#define __FILEDRIVER_H__
+
+#include <atomic>
+
+
+/// Settings and progress shared with the FileDriver, a Vuforia Driver replaying a FrameRecording
+/**
+ * The driver is a library of its own that Vuforia loads into the app process by name. The app passes
+ * a FileDriverConfig as VuDriverConfig::userData and keeps it alive as long as the engine exists,
+ * the driver reports its progress in the same object.
+ * Frames are delivered with the device pose recorded for them, on a thread of the driver. Vuforia processes
+ * each frame in the camera callback, so in benchmark mode, where the next frame follows as soon as the
+ * callback returns, every frame is tracked and the time the callback took is the tracking time of the frame.
+ */
+struct FileDriverConfig
+{
+    /// Name of the driver library for VuDriverConfig::driverName
+    static constexpr const char* LIBRARY_NAME = "libFileDriver.so";
+
+    /// The FrameRecording to replay, must outlive the engine
+    const char* path = nullptr;
+    /// Deliver frames as fast as Vuforia processes them instead of at the recorded frame rate, and only once
+    bool benchmark = false;
+    /// Start over from the first frame at the end of the recording, ignored for benchmarks
+    bool loop = false;
+
+    /// Written by the driver
+    std::atomic<int> deliveredFrames{ 0 };
+    /// Set once the last frame was delivered, the tracking times are valid then
+    std::atomic<bool> finished{ false };
+    /// Nanoseconds of the steady clock at the first and after the last frame
+    std::atomic<long long> startTime{ 0 };
+    std::atomic<long long> endTime{ 0 };
+    /// Percentiles of the time Vuforia took to process a frame, in milliseconds
+    float trackingP50 = 0.0f;
+    float trackingP90 = 0.0f;
+    float trackingP99 = 0.0f;
+};
+
+#endif /* __FILEDRIVER_H__ */
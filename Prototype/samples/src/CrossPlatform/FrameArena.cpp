@@ -0,0 +1,56 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "FrameArena.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstdint>
+
+
+FrameArena::FrameArena(size_t capacityBytes) : mBlock(new unsigned char[capacityBytes]), mCapacity(capacityBytes) {}
+
+
+void*
+FrameArena::allocate(size_t size, size_t alignment)
+{
+    auto base = reinterpret_cast<uintptr_t>(mBlock.get());
+    size_t offset = ((base + mUsedBytes + alignment - 1) & ~(alignment - 1)) - base;
+    if (offset + size <= mCapacity)
+    {
+        mUsedBytes = offset + size;
+        return mBlock.get() + offset;
+    }
+
+    // new[] aligns to max_align_t, larger alignments get padded
+    size_t padded = size + (alignment > alignof(std::max_align_t) ? alignment : 0);
+    mOverflow.emplace_back(new unsigned char[padded]);
+    mOverflowBytes += padded;
+    auto overflow = reinterpret_cast<uintptr_t>(mOverflow.back().get());
+    return reinterpret_cast<void*>((overflow + alignment - 1) & ~(alignment - 1));
+}
+
+
+void
+FrameArena::reset()
+{
+    size_t frameBytes = mUsedBytes + mOverflowBytes;
+    mPeakBytes = std::max(mPeakBytes, frameBytes);
+    if (!mOverflow.empty())
+    {
+        // Room for the frame that overflowed and some more, so that growing stays rare
+        size_t capacity = std::max(mCapacity * 2, frameBytes + frameBytes / 2);
+        LOG("Frame arena overflowed by %zu bytes, grown to %zu bytes", mOverflowBytes, capacity);
+        mOverflow.clear();
+        mOverflowBytes = 0;
+        mBlock.reset();
+        mBlock.reset(new unsigned char[capacity]);
+        mCapacity = capacity;
+    }
+    mUsedBytes = 0;
+}
@@ -0,0 +1,66 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __FRAMEARENA_H__
+#define __FRAMEARENA_H__
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+
+/// Bump allocator for the data that only lives for one frame, reset when the frame is finished
+/**
+ * Allocations take the next bytes of a block allocated up front and are all released at once by reset,
+ * so that the frames do not go through the heap. Only trivially destructible types can be allocated,
+ * nothing is destroyed. A frame needing more than the block gets overflow blocks from the heap, the
+ * next reset then grows the block to the peak of that frame, so the heap is only hit until the block
+ * fits the largest frame.
+ * The arena is used on the rendering thread only.
+ */
+class FrameArena
+{
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+    explicit FrameArena(size_t capacityBytes = DEFAULT_CAPACITY);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    /// Uninitialized memory valid until the next reset, alignment must be a power of two
+    void* allocate(size_t size, size_t alignment);
+
+    /// Uninitialized array of count elements valid until the next reset
+    template <typename T>
+    T* allocateArray(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "frame arena allocations are never destroyed");
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    /// Release every allocation, growing the block if the frame overflowed it
+    void reset();
+
+    size_t getCapacity() const { return mCapacity; }
+
+    /// Largest number of bytes a frame has used since the arena was created
+    size_t getPeakBytes() const { return mPeakBytes; }
+
+private:
+    std::unique_ptr<unsigned char[]> mBlock;
+    size_t mCapacity = 0;
+    size_t mUsedBytes = 0;
+
+    /// Allocations that did not fit the block this frame, freed by reset
+    std::vector<std::unique_ptr<unsigned char[]>> mOverflow;
+    size_t mOverflowBytes = 0;
+    size_t mPeakBytes = 0;
+};
+
+#endif /* __FRAMEARENA_H__ */
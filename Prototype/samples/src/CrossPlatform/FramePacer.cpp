@@ -0,0 +1,76 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+
+int
+FramePacer::getSwapInterval() const
+{
+    int framesPerSecond = mTargetFrameRate;
+    if (framesPerSecond <= 0)
+    {
+        return 1;
+    }
+
+    double targetPeriod = 1.0e9 / framesPerSecond;
+    return std::max(1, static_cast<int>(std::lround(targetPeriod / mRefreshPeriod)));
+}
+
+
+void
+FramePacer::reset()
+{
+    mLastVsync = 0;
+    mDeadline = 0;
+}
+
+
+bool
+FramePacer::onVsync(int64_t vsyncTime)
+{
+    int64_t refreshPeriod = mRefreshPeriod;
+    int64_t interval = getSwapInterval() * refreshPeriod;
+
+    // Measured from the last accepted vsync rather than counted, vsync callbacks may be missed
+    // when the thread receiving them is busy
+    if (mLastVsync != 0 && vsyncTime - mLastVsync < interval - refreshPeriod / 2)
+    {
+        return false;
+    }
+
+    mLastVsync = vsyncTime;
+    mDeadline = vsyncTime + interval;
+    return true;
+}
+
+
+int64_t
+FramePacer::getFrameStartTime() const
+{
+    int64_t deadline = mDeadline;
+    if (deadline == 0)
+    {
+        return 0;
+    }
+
+    int64_t longestDuration = *std::max_element(std::begin(mDurations), std::end(mDurations));
+    int64_t vsyncTime = deadline - getSwapInterval() * mRefreshPeriod;
+    return std::max(vsyncTime, deadline - longestDuration - DEADLINE_MARGIN_NANOSECONDS);
+}
+
+
+void
+FramePacer::addFrameDuration(int64_t nanoseconds)
+{
+    mDurations[mNextDuration] = nanoseconds;
+    mNextDuration = (mNextDuration + 1) % DURATION_WINDOW;
+}
@@ -0,0 +1,72 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __FRAMEPACER_H__
+#define __FRAMEPACER_H__
+
+#include <atomic>
+#include <cstdint>
+
+
+/// Decides on which display vsyncs to render and how late a frame can start
+/**
+ * With a target frame rate below the refresh rate a frame is rendered every swap interval vsyncs
+ * and presented at the vsync the interval ends with, its deadline. So that the camera frame is as
+ * recent as possible when it is shown, the frame does not start at the vsync but as late as the
+ * longest of the recent frame durations allows while still meeting the deadline.
+ * Times are nanoseconds of the monotonic clock the vsync timestamps use, std::chrono::steady_clock
+ * on Android. onVsync is called on the thread receiving the vsyncs, the frame methods on the
+ * rendering thread.
+ */
+class FramePacer
+{
+public:
+    /// Frames whose durations are considered for the start time
+    static constexpr int DURATION_WINDOW = 30;
+    /// Kept free before the deadline for the GPU work still running after submission
+    static constexpr int64_t DEADLINE_MARGIN_NANOSECONDS = 2000000;
+
+    /// Target frame rate in Hz, e.g. 30, 60 or 90, 0 renders on every vsync
+    void setTargetFrameRate(int framesPerSecond) { mTargetFrameRate = framesPerSecond; }
+
+    /// Refresh period of the display, needed before the first vsync
+    void setRefreshPeriod(int64_t nanoseconds) { mRefreshPeriod = nanoseconds; }
+    int64_t getRefreshPeriod() const { return mRefreshPeriod; }
+
+    /// Vsyncs per frame for the target frame rate, the refresh rate limits the frame rate
+    int getSwapInterval() const;
+
+    /// Forget the last vsync, e.g. after the app was paused, called on the vsync thread
+    void reset();
+
+    /// Called on each vsync, returns true if a frame should be rendered for it
+    bool onVsync(int64_t vsyncTime);
+
+    /// Vsync the frame of the last accepted vsync should be presented at, 0 before the first one
+    int64_t getDeadline() const { return mDeadline; }
+
+    /// Time at which the frame for the last accepted vsync should start
+    int64_t getFrameStartTime() const;
+
+    /// Add the time a frame took from its start to the end of its submission
+    void addFrameDuration(int64_t nanoseconds);
+
+private:
+    std::atomic<int> mTargetFrameRate{ 0 };
+    std::atomic<int64_t> mRefreshPeriod{ 16666667 };
+
+    /// Vsync thread
+    int64_t mLastVsync = 0;
+    /// Set on the vsync thread, read on the rendering thread
+    std::atomic<int64_t> mDeadline{ 0 };
+
+    /// Rendering thread
+    int64_t mDurations[DURATION_WINDOW] = {};
+    int mNextDuration = 0;
+};
+
+#endif /* __FRAMEPACER_H__ */
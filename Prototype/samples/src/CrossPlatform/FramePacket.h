@@ -0,0 +1,87 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __FRAMEPACKET_H__
+#define __FRAMEPACKET_H__
+
+#include <VuforiaEngine/VuforiaEngine.h>
+
+#include <cstdint>
+
+
+/// Everything observed in one frame that the renderer draws, filled by AppController::getFramePacket
+/**
+ * Plain data only, so that a packet can be copied as a whole and handed to a renderer running on
+ * another thread. The renderer decides how each item is drawn and in which order.
+ * The pixels of guideViewImage belong to the Vuforia state and are only valid until finishRender.
+ */
+struct FramePacket
+{
+    /// Most targets observed at once, further observations are dropped
+    static constexpr int MAX_TARGETS = 4;
+
+    /// An observed target with a pose
+    struct Target
+    {
+        /// AppController::IMAGE_TARGET_ID, AppController::MODEL_TARGET_ID or AppController::GALLERY_TARGET_ID
+        int targetId;
+        /// Index in GALLERY_TARGETS for GALLERY_TARGET_ID, -1 otherwise
+        int galleryIndex;
+        VuMatrix44F modelViewMatrix;
+        /// modelViewMatrix scaled to the size of the target, for unit-sized augmentations
+        VuMatrix44F scaledModelViewMatrix;
+    };
+
+    /// Frame data of the platform fusion provider Vuforia runs on, filled by the platform code that can reach it, e.g. for ARCore
+    struct FusionProviderFrame
+    {
+        enum class TrackingState
+        {
+            STOPPED,
+            PAUSED,
+            TRACKING,
+        };
+
+        /// Timestamp of the camera image in nanoseconds, in the time base of the fusion provider
+        int64_t cameraTimestamp;
+        TrackingState trackingState;
+        /// Set if the ambient light estimate is valid for this frame
+        bool lightEstimateValid;
+        /// Average intensity of the camera image 0..1, in gamma space
+        float pixelIntensity;
+        /// Scales for the red, green and blue channels, and pixelIntensity normalized to middle gray
+        float colorCorrection[4];
+    };
+
+    /// Projection of the world origin and the targets
+    VuMatrix44F projectionMatrix;
+
+    /// Set if the world origin is known, originModelViewMatrix is the view matrix then
+    bool originValid;
+    VuMatrix44F originModelViewMatrix;
+
+    int targetCount;
+    Target targets[MAX_TARGETS];
+
+    /// Set if the Model Target guide view should be shown, only ever while no target is observed
+    /// The guide view is drawn in screen space with a projection of its own
+    bool guideViewValid;
+    VuMatrix44F guideViewProjectionMatrix;
+    VuMatrix44F guideViewModelViewMatrix;
+    VuImageInfo guideViewImage;
+    VuBool guideViewImageChanged;
+
+    /// Set while no target has been observed and the device has not moved for a while, see InitConfig::idlePowerMode
+    /// The platform can then render less often and leave out the augmentations.
+    bool idle;
+
+    /// Set if fusionProvider was filled, AppController leaves it unset
+    bool fusionProviderValid;
+    FusionProviderFrame fusionProvider;
+};
+
+#endif /* __FRAMEPACKET_H__ */
@@ -0,0 +1,177 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "FrameRecording.h"
+
+#include <cstring>
+
+
+namespace
+{
+constexpr char MAGIC[4] = { 'V', 'U', 'F', 'R' };
+
+struct FileHeader
+{
+    char magic[4];
+    uint32_t version;
+    int32_t cameraOrientation;
+    uint32_t reserved;
+};
+static_assert(sizeof(FileHeader) == 16, "The file header is written as is");
+
+struct FrameHeader
+{
+    uint64_t timestamp;
+    uint32_t index;
+    int32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t pixelBytes;
+    float focalLength[2];
+    float principalPoint[2];
+    float distortion[8];
+    int32_t poseStatus;
+    float pose[16];
+    uint32_t reserved;
+};
+static_assert(sizeof(FrameHeader) == 152, "The frame header is written as is");
+
+/// Frames larger than this are taken for a corrupt file
+constexpr uint32_t MAX_PIXEL_BYTES = 64 * 1024 * 1024;
+} // namespace
+
+
+bool
+FrameRecording::Writer::open(const std::string& path, int cameraOrientation)
+{
+    close();
+    mFile = fopen(path.c_str(), "wb");
+    if (mFile == nullptr)
+    {
+        return false;
+    }
+
+    FileHeader header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.cameraOrientation = cameraOrientation;
+    if (fwrite(&header, sizeof(header), 1, mFile) != 1)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+
+bool
+FrameRecording::Writer::write(const Frame& frame)
+{
+    if (mFile == nullptr)
+    {
+        return false;
+    }
+
+    FrameHeader header{};
+    header.timestamp = frame.timestamp;
+    header.index = frame.index;
+    header.format = static_cast<int32_t>(frame.format);
+    header.width = frame.width;
+    header.height = frame.height;
+    header.stride = frame.stride;
+    header.pixelBytes = static_cast<uint32_t>(frame.pixels.size());
+    memcpy(header.focalLength, frame.focalLength, sizeof(header.focalLength));
+    memcpy(header.principalPoint, frame.principalPoint, sizeof(header.principalPoint));
+    memcpy(header.distortion, frame.distortion, sizeof(header.distortion));
+    header.poseStatus = static_cast<int32_t>(frame.poseStatus);
+    memcpy(header.pose, frame.pose, sizeof(header.pose));
+
+    return fwrite(&header, sizeof(header), 1, mFile) == 1 &&
+           (frame.pixels.empty() || fwrite(frame.pixels.data(), frame.pixels.size(), 1, mFile) == 1);
+}
+
+
+void
+FrameRecording::Writer::close()
+{
+    if (mFile != nullptr)
+    {
+        fclose(mFile);
+        mFile = nullptr;
+    }
+}
+
+
+bool
+FrameRecording::Reader::open(const std::string& path)
+{
+    close();
+    mFile = fopen(path.c_str(), "rb");
+    if (mFile == nullptr)
+    {
+        return false;
+    }
+
+    FileHeader header{};
+    if (fread(&header, sizeof(header), 1, mFile) != 1 || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION)
+    {
+        close();
+        return false;
+    }
+    mCameraOrientation = header.cameraOrientation;
+    return true;
+}
+
+
+bool
+FrameRecording::Reader::read(Frame& frame)
+{
+    if (mFile == nullptr)
+    {
+        return false;
+    }
+
+    FrameHeader header{};
+    if (fread(&header, sizeof(header), 1, mFile) != 1 || header.pixelBytes > MAX_PIXEL_BYTES)
+    {
+        return false;
+    }
+
+    frame.timestamp = header.timestamp;
+    frame.index = header.index;
+    frame.format = static_cast<PixelFormat>(header.format);
+    frame.width = header.width;
+    frame.height = header.height;
+    frame.stride = header.stride;
+    memcpy(frame.focalLength, header.focalLength, sizeof(frame.focalLength));
+    memcpy(frame.principalPoint, header.principalPoint, sizeof(frame.principalPoint));
+    memcpy(frame.distortion, header.distortion, sizeof(frame.distortion));
+    frame.poseStatus = static_cast<PoseStatus>(header.poseStatus);
+    memcpy(frame.pose, header.pose, sizeof(frame.pose));
+
+    frame.pixels.resize(header.pixelBytes);
+    return header.pixelBytes == 0 || fread(frame.pixels.data(), header.pixelBytes, 1, mFile) == 1;
+}
+
+
+bool
+FrameRecording::Reader::rewind()
+{
+    return mFile != nullptr && fseek(mFile, sizeof(FileHeader), SEEK_SET) == 0;
+}
+
+
+void
+FrameRecording::Reader::close()
+{
+    if (mFile != nullptr)
+    {
+        fclose(mFile);
+        mFile = nullptr;
+    }
+}
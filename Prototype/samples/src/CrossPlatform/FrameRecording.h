@@ -0,0 +1,124 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __FRAMERECORDING_H__
+#define __FRAMERECORDING_H__
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+/// File format of the camera frames recorded by SessionRecorder and played back by the FileDriver
+/**
+ * A recording is a small file header followed by one record per camera frame: the frame layout, the
+ * camera intrinsics, the device pose measured for the frame and the uncompressed pixels.
+ * Nothing is compressed, so that playback costs no more than reading the file and frames replay
+ * bit for bit. Values are stored little-endian, as on every Android ABI.
+ */
+class FrameRecording
+{
+public:
+    static constexpr uint32_t VERSION = 1;
+    /// File name extension of recordings
+    static constexpr const char* EXTENSION = ".vufr";
+
+    /// Pixel layouts, numbered as VuforiaDriver::PixelFormat so that frames are delivered as recorded
+    enum class PixelFormat : int32_t
+    {
+        UNKNOWN = 0,
+        YUYV = 1,
+        NV12 = 2,
+        NV21 = 3,
+        RGB888 = 4,
+        RGBA8888 = 5,
+        YUV420P = 6,
+        YV12 = 7,
+    };
+
+    enum class PoseStatus : int32_t
+    {
+        NONE = 0,
+        LIMITED = 1,
+        TRACKED = 2,
+    };
+
+    struct Frame
+    {
+        /// Nanoseconds of the recording device's monotonic clock
+        uint64_t timestamp = 0;
+        uint32_t index = 0;
+        PixelFormat format = PixelFormat::UNKNOWN;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        /// Bytes per row of the first plane, the planes follow each other without padding rows
+        uint32_t stride = 0;
+
+        /// Pinhole intrinsics in pixels, distortion in the order [r0, r1, t0, t1, r2, r3, r4, r5]
+        float focalLength[2] = {};
+        float principalPoint[2] = {};
+        float distortion[8] = {};
+
+        /// Pose of the device in the world, a column-major matrix in the GL convention of VuMatrix44F
+        PoseStatus poseStatus = PoseStatus::NONE;
+        float pose[16] = {};
+
+        std::vector<uint8_t> pixels;
+    };
+
+    class Writer
+    {
+    public:
+        Writer() = default;
+        ~Writer() { close(); }
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        /// Create a recording, cameraOrientation is the rotation of the camera sensor in degrees, see
+        /// VuforiaDriver::Driver::getCameraOrientation
+        bool open(const std::string& path, int cameraOrientation);
+        bool isOpen() const { return mFile != nullptr; }
+
+        bool write(const Frame& frame);
+
+        void close();
+
+    private:
+        FILE* mFile = nullptr;
+    };
+
+    class Reader
+    {
+    public:
+        Reader() = default;
+        ~Reader() { close(); }
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        bool open(const std::string& path);
+        bool isOpen() const { return mFile != nullptr; }
+
+        int getCameraOrientation() const { return mCameraOrientation; }
+
+        /// Read the next frame into frame, its pixel storage is reused. Returns false at the end of the recording.
+        bool read(Frame& frame);
+
+        /// Continue reading from the first frame
+        bool rewind();
+
+        void close();
+
+    private:
+        FILE* mFile = nullptr;
+        int mCameraOrientation = 0;
+    };
+};
+
+#endif /* __FRAMERECORDING_H__ */
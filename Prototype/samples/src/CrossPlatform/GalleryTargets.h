@@ -0,0 +1,45 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __GALLERYTARGETS_H__
+#define __GALLERYTARGETS_H__
+
+#include "AppController.h"
+
+#include <iterator>
+
+
+/// An image target of the gallery and the augmentation it shows
+struct GalleryTarget
+{
+    const char* name;
+    /// Image the target is created from, a jpg or png in the app assets
+    const char* imagePath;
+    /// Width of the printed image in meters
+    float width;
+    /// The augmentation, the target whose assets the renderer draws, IMAGE_TARGET_ID or MODEL_TARGET_ID
+    int assetTarget;
+};
+
+
+/// The images in Resources/Markers, created as image targets when the app runs in gallery mode
+/// The order is the gallery index of FramePacket::Target.
+inline constexpr GalleryTarget GALLERY_TARGETS[] = {
+    { "venera", "venera_ar.jpg", 0.2f, AppController::IMAGE_TARGET_ID },
+    { "bethoven", "bethoven_ar.jpg", 0.2f, AppController::IMAGE_TARGET_ID },
+    { "pangea", "pangea_ar.jpg", 0.2f, AppController::MODEL_TARGET_ID },
+    { "pit", "pit_ar.jpg", 0.2f, AppController::MODEL_TARGET_ID },
+    { "screem", "screem_ar.jpg", 0.2f, AppController::IMAGE_TARGET_ID },
+    { "ar_marker", "ar_marker.jpg", 0.2f, AppController::MODEL_TARGET_ID },
+    { "ar_marker_1", "ar_marker (1).jpg", 0.2f, AppController::IMAGE_TARGET_ID },
+    { "ar_marker_2", "ar_marker (2).jpg", 0.2f, AppController::MODEL_TARGET_ID },
+    { "ar_marker_3", "ar_marker (3).jpg", 0.2f, AppController::IMAGE_TARGET_ID },
+};
+
+inline constexpr int GALLERY_TARGET_COUNT = static_cast<int>(std::size(GALLERY_TARGETS));
+
+#endif /* __GALLERYTARGETS_H__ */
@@ -0,0 +1,98 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "IdleDetector.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+IdleDetector::IdleDetector(const Config& config)
+{
+    setConfig(config);
+}
+
+
+void
+IdleDetector::setConfig(const Config& config)
+{
+    mConfig = config;
+    mConfig.idleAfterSeconds = std::max(mConfig.idleAfterSeconds, 0.0f);
+    reset();
+}
+
+
+void
+IdleDetector::reset()
+{
+    mIdle = false;
+    mActiveSince = -1.0;
+    mAnchorValid = false;
+    mReason = "";
+}
+
+
+bool
+IdleDetector::update(double seconds, bool targetObserved, const VuMatrix44F* devicePose)
+{
+    const char* activity = targetObserved ? "target observed" : nullptr;
+    if (devicePose != nullptr)
+    {
+        if (!mAnchorValid || hasMoved(*devicePose))
+        {
+            // The first pose after tracking was lost counts as motion, the device could have moved meanwhile
+            activity = activity != nullptr ? activity : "device moved";
+            mAnchorPose = *devicePose;
+            mAnchorValid = true;
+        }
+    }
+    else
+    {
+        mAnchorValid = false;
+    }
+
+    if (activity != nullptr || mActiveSince < 0.0)
+    {
+        mActiveSince = seconds;
+    }
+
+    bool idle = seconds - mActiveSince >= mConfig.idleAfterSeconds;
+    if (idle == mIdle)
+    {
+        return false;
+    }
+    mIdle = idle;
+    mReason = idle ? "no target and no motion" : activity;
+    return true;
+}
+
+
+bool
+IdleDetector::hasMoved(const VuMatrix44F& pose) const
+{
+    // Column-major, the translation is in the last column
+    float dx = pose.data[12] - mAnchorPose.data[12];
+    float dy = pose.data[13] - mAnchorPose.data[13];
+    float dz = pose.data[14] - mAnchorPose.data[14];
+    if (dx * dx + dy * dy + dz * dz > mConfig.wakeTranslation * mConfig.wakeTranslation)
+    {
+        return true;
+    }
+
+    // The trace of the relative rotation is the sum of the products of the two rotations, entry by entry
+    float trace = 0.0f;
+    for (int column = 0; column < 3; ++column)
+    {
+        for (int row = 0; row < 3; ++row)
+        {
+            trace += pose.data[column * 4 + row] * mAnchorPose.data[column * 4 + row];
+        }
+    }
+    float cosAngle = std::min(std::max((trace - 1.0f) * 0.5f, -1.0f), 1.0f);
+    constexpr float DEGREES_PER_RADIAN = 57.2957795f;
+    return std::acos(cosAngle) * DEGREES_PER_RADIAN > mConfig.wakeRotationDegrees;
+}
@@ -0,0 +1,65 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __IDLEDETECTOR_H__
+#define __IDLEDETECTOR_H__
+
+#include <VuforiaEngine/VuforiaEngine.h>
+
+
+/// Decides when the app is idle, no target observed and the device held still, so that it can save power
+/**
+ * The app turns idle once no target has been observed and the device has not moved for idleAfterSeconds.
+ * It wakes up on the first frame with an observed target or with the device moved by more than the
+ * wake thresholds from where it rested. Motion is measured from an anchor pose taken when the device
+ * last moved, so that a slow drift adds up instead of passing unnoticed frame by frame.
+ * Without a device pose only a detection wakes the app.
+ */
+class IdleDetector
+{
+public:
+    struct Config
+    {
+        float idleAfterSeconds = 10.0f;
+        /// Device motion in meters and degrees that counts as activity
+        float wakeTranslation = 0.05f;
+        float wakeRotationDegrees = 10.0f;
+    };
+
+    IdleDetector() = default;
+    explicit IdleDetector(const Config& config);
+
+    /// Replace the configuration, the detector starts over awake
+    void setConfig(const Config& config);
+    const Config& getConfig() const { return mConfig; }
+
+    /// Start over awake, the next update starts the wait for idle
+    void reset();
+
+    /// Add a frame, returns true if the app turned idle or woke up
+    /// devicePose is the pose of the device in the world, nullptr if there is none. Times are seconds of a monotonic clock.
+    bool update(double seconds, bool targetObserved, const VuMatrix44F* devicePose);
+
+    bool isIdle() const { return mIdle; }
+
+    /// Why the last change happened, for logging
+    const char* getReason() const { return mReason; }
+
+private:
+    /// True if pose is further from mAnchorPose than the wake thresholds
+    bool hasMoved(const VuMatrix44F& pose) const;
+
+    Config mConfig;
+    bool mIdle = false;
+    /// Time of the last observation or motion, negative before the first update
+    double mActiveSince = -1.0;
+    bool mAnchorValid = false;
+    VuMatrix44F mAnchorPose{};
+    const char* mReason = "";
+};
+
+#endif /* __IDLEDETECTOR_H__ */
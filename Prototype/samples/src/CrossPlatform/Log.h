@@ -23,7 +23,7 @@ countries.
 // Use logging method implemented in UWP/Log.cpp
 void LOG(const char* message, ...);
 
-#elif defined(__APPLE__) // iOS
+#else // iOS and desktop tools
 #define LOG(...)             \
     do                       \
     {                        \
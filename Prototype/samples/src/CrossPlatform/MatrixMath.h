@@ -0,0 +1,260 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __MATRIXMATH_H__
+#define __MATRIXMATH_H__
+
+#include <VuforiaEngine/VuforiaEngine.h>
+
+#include <cstddef>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MATRIXMATH_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MATRIXMATH_SSE 1
+#endif
+
+
+/// Inline 4x4 matrix math on VuMatrix44F for the per-frame pose math of the app and the renderer
+/**
+ * The functions replace the vuMatrix44F functions on the paths that run for every target and draw: those
+ * are calls into the engine library taking and returning matrices by value, these inline into the caller
+ * and use NEON on ARM and SSE on x86, with the scalar code for other targets. Matrices are column-major
+ * as in VuMatrix44F and the operations match their vuMatrix44F counterparts.
+ * The builders and the functions in MatrixMath::Scalar are constexpr, for constants and as the reference
+ * of the vectorized paths, Tools/MatrixMathBench checks them against each other and measures them.
+ */
+namespace MatrixMath
+{
+constexpr VuMatrix44F
+identity()
+{
+    return VuMatrix44F{ { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f } };
+}
+
+
+/// vuMatrix44FTranslationMatrix
+constexpr VuMatrix44F
+translation(const VuVector3F& t)
+{
+    return VuMatrix44F{ { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, t.data[0], t.data[1], t.data[2], 1.0f } };
+}
+
+
+/// vuMatrix44FScalingMatrix
+constexpr VuMatrix44F
+scaling(const VuVector3F& s)
+{
+    return VuMatrix44F{ { s.data[0], 0.0f, 0.0f, 0.0f, 0.0f, s.data[1], 0.0f, 0.0f, 0.0f, 0.0f, s.data[2], 0.0f, 0.0f, 0.0f, 0.0f, 1.0f } };
+}
+
+
+/// Scalar implementations, usable in constant expressions
+namespace Scalar
+{
+/// a * b
+constexpr VuMatrix44F
+multiply(const VuMatrix44F& a, const VuMatrix44F& b)
+{
+    VuMatrix44F result{};
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            result.data[column * 4 + row] = a.data[row] * b.data[column * 4] + a.data[4 + row] * b.data[column * 4 + 1] +
+                                            a.data[8 + row] * b.data[column * 4 + 2] + a.data[12 + row] * b.data[column * 4 + 3];
+        }
+    }
+    return result;
+}
+
+
+/// m * scaling(s), the first three columns scaled
+constexpr VuMatrix44F
+scale(const VuVector3F& s, const VuMatrix44F& m)
+{
+    VuMatrix44F result = m;
+    for (int column = 0; column < 3; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            result.data[column * 4 + row] *= s.data[column];
+        }
+    }
+    return result;
+}
+
+
+/// Inverse of a rotation and translation, the rotation is transposed
+constexpr VuMatrix44F
+inverseRigid(const VuMatrix44F& m)
+{
+    VuMatrix44F result{};
+    for (int column = 0; column < 3; ++column)
+    {
+        for (int row = 0; row < 3; ++row)
+        {
+            result.data[column * 4 + row] = m.data[row * 4 + column];
+        }
+        result.data[12 + column] =
+            -(m.data[column * 4] * m.data[12] + m.data[column * 4 + 1] * m.data[13] + m.data[column * 4 + 2] * m.data[14]);
+    }
+    result.data[15] = 1.0f;
+    return result;
+}
+} // namespace Scalar
+
+
+#if MATRIXMATH_NEON
+namespace Detail
+{
+/// a * b with the columns of a loaded, every column of b is read before the column of result is written
+inline void
+multiply(const float32x4_t a[4], const float* b, float* result)
+{
+    for (int column = 0; column < 4; ++column)
+    {
+        float32x4_t sum = vmulq_n_f32(a[0], b[column * 4]);
+        sum = vmlaq_n_f32(sum, a[1], b[column * 4 + 1]);
+        sum = vmlaq_n_f32(sum, a[2], b[column * 4 + 2]);
+        sum = vmlaq_n_f32(sum, a[3], b[column * 4 + 3]);
+        vst1q_f32(result + column * 4, sum);
+    }
+}
+} // namespace Detail
+#elif MATRIXMATH_SSE
+namespace Detail
+{
+inline void
+multiply(const __m128 a[4], const float* b, float* result)
+{
+    for (int column = 0; column < 4; ++column)
+    {
+        __m128 sum = _mm_mul_ps(a[0], _mm_set1_ps(b[column * 4]));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a[1], _mm_set1_ps(b[column * 4 + 1])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a[2], _mm_set1_ps(b[column * 4 + 2])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a[3], _mm_set1_ps(b[column * 4 + 3])));
+        _mm_storeu_ps(result + column * 4, sum);
+    }
+}
+} // namespace Detail
+#endif
+
+
+/// a * b, vuMatrix44FMultiplyMatrix
+inline VuMatrix44F
+multiply(const VuMatrix44F& a, const VuMatrix44F& b)
+{
+#if MATRIXMATH_NEON
+    const float32x4_t columns[4] = { vld1q_f32(a.data), vld1q_f32(a.data + 4), vld1q_f32(a.data + 8), vld1q_f32(a.data + 12) };
+    VuMatrix44F result;
+    Detail::multiply(columns, b.data, result.data);
+    return result;
+#elif MATRIXMATH_SSE
+    const __m128 columns[4] = { _mm_loadu_ps(a.data), _mm_loadu_ps(a.data + 4), _mm_loadu_ps(a.data + 8), _mm_loadu_ps(a.data + 12) };
+    VuMatrix44F result;
+    Detail::multiply(columns, b.data, result.data);
+    return result;
+#else
+    return Scalar::multiply(a, b);
+#endif
+}
+
+
+/// a * b[i] into result[i] for count matrices, a is loaded once and b may be the same array as result
+inline void
+multiplyBatch(const VuMatrix44F& a, const VuMatrix44F* b, size_t count, VuMatrix44F* result)
+{
+#if MATRIXMATH_NEON
+    const float32x4_t columns[4] = { vld1q_f32(a.data), vld1q_f32(a.data + 4), vld1q_f32(a.data + 8), vld1q_f32(a.data + 12) };
+    for (size_t i = 0; i < count; ++i)
+    {
+        Detail::multiply(columns, b[i].data, result[i].data);
+    }
+#elif MATRIXMATH_SSE
+    const __m128 columns[4] = { _mm_loadu_ps(a.data), _mm_loadu_ps(a.data + 4), _mm_loadu_ps(a.data + 8), _mm_loadu_ps(a.data + 12) };
+    for (size_t i = 0; i < count; ++i)
+    {
+        Detail::multiply(columns, b[i].data, result[i].data);
+    }
+#else
+    for (size_t i = 0; i < count; ++i)
+    {
+        result[i] = Scalar::multiply(a, b[i]);
+    }
+#endif
+}
+
+
+/// m * scaling(s), vuMatrix44FScale
+inline VuMatrix44F
+scale(const VuVector3F& s, const VuMatrix44F& m)
+{
+#if MATRIXMATH_NEON
+    VuMatrix44F result;
+    vst1q_f32(result.data, vmulq_n_f32(vld1q_f32(m.data), s.data[0]));
+    vst1q_f32(result.data + 4, vmulq_n_f32(vld1q_f32(m.data + 4), s.data[1]));
+    vst1q_f32(result.data + 8, vmulq_n_f32(vld1q_f32(m.data + 8), s.data[2]));
+    vst1q_f32(result.data + 12, vld1q_f32(m.data + 12));
+    return result;
+#elif MATRIXMATH_SSE
+    VuMatrix44F result;
+    _mm_storeu_ps(result.data, _mm_mul_ps(_mm_loadu_ps(m.data), _mm_set1_ps(s.data[0])));
+    _mm_storeu_ps(result.data + 4, _mm_mul_ps(_mm_loadu_ps(m.data + 4), _mm_set1_ps(s.data[1])));
+    _mm_storeu_ps(result.data + 8, _mm_mul_ps(_mm_loadu_ps(m.data + 8), _mm_set1_ps(s.data[2])));
+    _mm_storeu_ps(result.data + 12, _mm_loadu_ps(m.data + 12));
+    return result;
+#else
+    return Scalar::scale(s, m);
+#endif
+}
+
+
+/// Inverse of a matrix that only rotates and translates, such as a pose or model-view matrix
+/// Much cheaper than vuMatrix44FInverse, which inverts any matrix. Scaled matrices need vuMatrix44FInverse.
+inline VuMatrix44F
+inverseRigid(const VuMatrix44F& m)
+{
+#if MATRIXMATH_NEON
+    // The rows of m are the columns of the transposed rotation, their last lanes the translation
+    float32x4x4_t rows = vld4q_f32(m.data);
+    float32x4_t translation = vmulq_n_f32(rows.val[0], vgetq_lane_f32(rows.val[0], 3));
+    translation = vmlaq_n_f32(translation, rows.val[1], vgetq_lane_f32(rows.val[1], 3));
+    translation = vmlaq_n_f32(translation, rows.val[2], vgetq_lane_f32(rows.val[2], 3));
+    VuMatrix44F result;
+    vst1q_f32(result.data, vsetq_lane_f32(0.0f, rows.val[0], 3));
+    vst1q_f32(result.data + 4, vsetq_lane_f32(0.0f, rows.val[1], 3));
+    vst1q_f32(result.data + 8, vsetq_lane_f32(0.0f, rows.val[2], 3));
+    vst1q_f32(result.data + 12, vsetq_lane_f32(1.0f, vnegq_f32(translation), 3));
+    return result;
+#elif MATRIXMATH_SSE
+    // The columns of m transposed into its rows
+    __m128 row0 = _mm_loadu_ps(m.data);
+    __m128 row1 = _mm_loadu_ps(m.data + 4);
+    __m128 row2 = _mm_loadu_ps(m.data + 8);
+    __m128 row3 = _mm_loadu_ps(m.data + 12);
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+    // Lane 3 of the first three rows is the translation, and the last lane of the result columns is 0 0 0 1
+    __m128 translation = _mm_mul_ps(row0, _mm_shuffle_ps(row0, row0, _MM_SHUFFLE(3, 3, 3, 3)));
+    translation = _mm_add_ps(translation, _mm_mul_ps(row1, _mm_shuffle_ps(row1, row1, _MM_SHUFFLE(3, 3, 3, 3))));
+    translation = _mm_add_ps(translation, _mm_mul_ps(row2, _mm_shuffle_ps(row2, row2, _MM_SHUFFLE(3, 3, 3, 3))));
+    const __m128 rotationMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    VuMatrix44F result;
+    _mm_storeu_ps(result.data, _mm_and_ps(row0, rotationMask));
+    _mm_storeu_ps(result.data + 4, _mm_and_ps(row1, rotationMask));
+    _mm_storeu_ps(result.data + 8, _mm_and_ps(row2, rotationMask));
+    _mm_storeu_ps(result.data + 12, _mm_sub_ps(_mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f), _mm_and_ps(translation, rotationMask)));
+    return result;
+#else
+    return Scalar::inverseRigid(m);
+#endif
+}
+} // namespace MatrixMath
+
+#endif /* __MATRIXMATH_H__ */
@@ -0,0 +1,168 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "MemoryAccounting.h"
+
+#include <algorithm>
+#include <cstdio>
+
+
+void
+MemoryAccounting::set(const std::string& asset, Category category, Pool pool, size_t bytes)
+{
+    bool released = false;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto entry = mEntries.find(asset);
+        if (entry == mEntries.end())
+        {
+            if (bytes == 0)
+            {
+                return;
+            }
+            entry = mEntries.emplace(asset, Entry()).first;
+        }
+
+        Entry& accounted = entry->second;
+        size_t& current = accounted.bytes[static_cast<int>(pool)];
+        released = bytes < current;
+        apply(pool, current, bytes);
+        current = bytes;
+        accounted.category = category;
+        size_t cpuBytes = accounted.bytes[static_cast<int>(Pool::CPU)] + accounted.bytes[static_cast<int>(Pool::PENDING)];
+        accounted.cpuPeakBytes = std::max(accounted.cpuPeakBytes, cpuBytes);
+        accounted.gpuPeakBytes = std::max(accounted.gpuPeakBytes, accounted.bytes[static_cast<int>(Pool::GPU)]);
+    }
+    if (released)
+    {
+        mCondition.notify_all();
+    }
+}
+
+
+void
+MemoryAccounting::remove(const std::string& asset)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto entry = mEntries.find(asset);
+        if (entry == mEntries.end())
+        {
+            return;
+        }
+        for (int pool = 0; pool < POOL_COUNT; ++pool)
+        {
+            apply(static_cast<Pool>(pool), entry->second.bytes[pool], 0);
+            entry->second.bytes[pool] = 0;
+        }
+    }
+    mCondition.notify_all();
+}
+
+
+void
+MemoryAccounting::clear(Pool pool)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto& entry : mEntries)
+        {
+            size_t& current = entry.second.bytes[static_cast<int>(pool)];
+            apply(pool, current, 0);
+            current = 0;
+        }
+    }
+    mCondition.notify_all();
+}
+
+
+MemoryAccounting::Totals
+MemoryAccounting::getTotals() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mTotals;
+}
+
+
+void
+MemoryAccounting::setCpuBudget(size_t budgetBytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCpuBudgetBytes = budgetBytes;
+    }
+    mCondition.notify_all();
+}
+
+
+bool
+MemoryAccounting::waitForCpuBudget()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    return mCondition.wait_for(lock, BUDGET_WAIT_TIMEOUT, [this]() { return isWithinBudget(); });
+}
+
+
+std::string
+MemoryAccounting::formatReport() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::string text;
+    char line[256];
+    for (const auto& entry : mEntries)
+    {
+        const Entry& accounted = entry.second;
+        snprintf(line, sizeof(line),
+                 "memory asset=%s category=%s cpu_bytes=%zu pending_bytes=%zu gpu_bytes=%zu cpu_peak_bytes=%zu gpu_peak_bytes=%zu\n",
+                 entry.first.c_str(), toString(accounted.category), accounted.bytes[static_cast<int>(Pool::CPU)],
+                 accounted.bytes[static_cast<int>(Pool::PENDING)], accounted.bytes[static_cast<int>(Pool::GPU)], accounted.cpuPeakBytes,
+                 accounted.gpuPeakBytes);
+        text += line;
+    }
+    snprintf(line, sizeof(line),
+             "memory total cpu_bytes=%zu pending_bytes=%zu gpu_bytes=%zu cpu_high_water_bytes=%zu gpu_high_water_bytes=%zu "
+             "cpu_budget_bytes=%zu\n",
+             mTotals.cpuBytes, mTotals.pendingBytes, mTotals.gpuBytes, mTotals.cpuHighWaterBytes, mTotals.gpuHighWaterBytes,
+             mCpuBudgetBytes);
+    text += line;
+    return text;
+}
+
+
+const char*
+MemoryAccounting::toString(Category category)
+{
+    switch (category)
+    {
+        case Category::MESH:
+            return "mesh";
+        case Category::TEXTURE:
+            return "texture";
+        case Category::GUIDE_VIEW:
+            return "guide_view";
+        case Category::RENDER_TARGET:
+            return "render_target";
+    }
+    return "unknown";
+}
+
+
+bool
+MemoryAccounting::isWithinBudget() const
+{
+    return mCpuBudgetBytes == 0 || mTotals.pendingBytes == 0 || mTotals.cpuBytes + mTotals.pendingBytes <= mCpuBudgetBytes;
+}
+
+
+void
+MemoryAccounting::apply(Pool pool, size_t oldBytes, size_t newBytes)
+{
+    size_t* total = pool == Pool::CPU ? &mTotals.cpuBytes : pool == Pool::PENDING ? &mTotals.pendingBytes : &mTotals.gpuBytes;
+    *total = *total - oldBytes + newBytes;
+    mTotals.cpuHighWaterBytes = std::max(mTotals.cpuHighWaterBytes, mTotals.cpuBytes + mTotals.pendingBytes);
+    mTotals.gpuHighWaterBytes = std::max(mTotals.gpuHighWaterBytes, mTotals.gpuBytes);
+}
@@ -0,0 +1,115 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __MEMORYACCOUNTING_H__
+#define __MEMORYACCOUNTING_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+
+
+/// Bytes of CPU and GPU memory held per asset, with totals, high-water marks and a CPU budget for the loaders
+/**
+ * The owners of the memory report what they hold with set whenever it changes, keyed by asset name,
+ * e.g. the renderer for the geometry of a model and the texture cache for its textures. CPU memory is
+ * split into memory kept for the lifetime of an asset and PENDING memory that only lives until it is
+ * uploaded, like decoded pixels waiting in the texture uploader.
+ *
+ * Loader threads call waitForCpuBudget before decoding the next asset. While the CPU bytes exceed the
+ * budget and part of them is pending, the loaders wait for the uploads to free it, which bounds the peak
+ * when many assets are requested at once. Memory that is kept does not hold the loaders back, so the
+ * budget can be exceeded by it, and a loader never waits longer than BUDGET_WAIT_TIMEOUT.
+ * All methods can be called on any thread.
+ */
+class MemoryAccounting
+{
+public:
+    /// CPU budget used until setCpuBudget is called
+    static constexpr size_t DEFAULT_CPU_BUDGET_BYTES = 64u << 20;
+    /// Longest a loader waits for pending memory to be freed, e.g. while rendering is paused
+    static constexpr std::chrono::milliseconds BUDGET_WAIT_TIMEOUT{ 2000 };
+
+    enum class Category
+    {
+        MESH,
+        TEXTURE,
+        GUIDE_VIEW,
+        RENDER_TARGET,
+    };
+
+    enum class Pool
+    {
+        /// CPU memory kept while the asset is loaded, e.g. the geometry of a model after upload
+        CPU,
+        /// CPU memory freed once it is uploaded
+        PENDING,
+        GPU,
+    };
+
+    struct Totals
+    {
+        size_t cpuBytes = 0;
+        size_t pendingBytes = 0;
+        size_t gpuBytes = 0;
+        /// Highest CPU bytes including the pending ones, and highest GPU bytes, since construction
+        size_t cpuHighWaterBytes = 0;
+        size_t gpuHighWaterBytes = 0;
+    };
+
+    /// Set the bytes an asset holds in a pool, 0 once it released them
+    void set(const std::string& asset, Category category, Pool pool, size_t bytes);
+
+    /// Set the bytes of an asset in every pool to 0
+    void remove(const std::string& asset);
+
+    /// Set the bytes of every asset in a pool to 0, e.g. the GPU pool after the GL context was lost
+    void clear(Pool pool);
+
+    Totals getTotals() const;
+
+    /// Set the CPU bytes above which the loaders wait for pending memory, 0 for no budget
+    void setCpuBudget(size_t budgetBytes);
+
+    /// Wait until the CPU bytes are within the budget or nothing is pending
+    /// Returns false if the wait timed out.
+    bool waitForCpuBudget();
+
+    /// One key=value line per asset and one with the totals
+    /// Assets that hold nothing any more are listed with their peaks.
+    std::string formatReport() const;
+
+    static const char* toString(Category category);
+
+private:
+    static constexpr int POOL_COUNT = 3;
+
+    struct Entry
+    {
+        Category category = Category::MESH;
+        size_t bytes[POOL_COUNT] = {};
+        /// Highest CPU bytes including the pending ones, and highest GPU bytes
+        size_t cpuPeakBytes = 0;
+        size_t gpuPeakBytes = 0;
+    };
+
+    bool isWithinBudget() const;
+    /// Update mTotals after the bytes of an asset in a pool changed
+    void apply(Pool pool, size_t oldBytes, size_t newBytes);
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    /// Ordered by name so that reports of runs line up
+    std::map<std::string, Entry> mEntries;
+    Totals mTotals;
+    size_t mCpuBudgetBytes = DEFAULT_CPU_BUDGET_BYTES;
+};
+
+#endif /* __MEMORYACCOUNTING_H__ */
@@ -0,0 +1,132 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __MESHFORMAT_H__
+#define __MESHFORMAT_H__
+
+#include <cstdint>
+
+
+/// Layout of the pre-baked binary mesh files produced by the MeshConverter tool.
+/**
+ * A file starts with a Header followed by the vertex and index blobs it references.
+ * Every blob starts on a BLOB_ALIGNMENT boundary so that a memory mapped file can be
+ * handed straight to GL without copying. All values are stored little-endian.
+ */
+namespace MeshFormat
+{
+/// File identifier, the characters "VMSH"
+constexpr uint32_t MAGIC = 0x48534D56;
+
+/// Bump this whenever the layout of the file changes, older files are then rejected
+constexpr uint32_t VERSION = 4;
+
+/// Alignment of every blob relative to the start of the file
+constexpr uint32_t BLOB_ALIGNMENT = 16;
+
+/// Header flag: the vertices are stored in the vertices blob as QuantizedVertex
+constexpr uint32_t FLAG_QUANTIZED = 1u << 0;
+
+/// Header flag: every vertex carries a baked shade, see VertexShadingBaker
+/// In QuantizedVertex::shade for quantized meshes, in the shades blob otherwise.
+constexpr uint32_t FLAG_SHADED = 1u << 1;
+
+/// Location of a blob within the file
+struct Blob
+{
+    uint32_t offset;
+    uint32_t size;
+};
+
+/// Interleaved vertex of a quantized mesh, 12 bytes instead of 20 for float positions and texture coordinates
+/**
+ * Both attributes are unsigned normalized 16-bit values covering the ranges given by the Quantization.
+ * The layout is uploaded to a vertex buffer as is.
+ */
+struct QuantizedVertex
+{
+    uint16_t position[3];
+    /// Unsigned normalized baked shade of shaded meshes, 0 otherwise, fills what was padding before
+    uint8_t shade;
+    /// Keeps the texture coordinate 4-byte aligned
+    uint8_t padding;
+    uint16_t texCoord[2];
+};
+static_assert(sizeof(QuantizedVertex) == 12, "QuantizedVertex must be tightly packed");
+
+/// Dequantization of a QuantizedVertex: value = min + scale * normalized, with normalized in [0;1]
+struct Quantization
+{
+    float positionMin[3];
+    float positionScale[3];
+    float texCoordMin[2];
+    float texCoordScale[2];
+};
+
+/// Axis aligned bounding box and bounding sphere of the positions in model space
+struct Bounds
+{
+    float min[3];
+    float max[3];
+    float center[3];
+    float radius;
+};
+
+/// One level of detail, a range of the index buffer drawing the mesh with fewer triangles
+/**
+ * All levels share the vertices, level 0 is the full resolution mesh.
+ */
+struct Lod
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    /// Largest distance in model space a vertex of this level moved from the full resolution surface
+    float error;
+};
+
+struct Header
+{
+    uint32_t magic;
+    uint32_t version;
+    /// Combination of the FLAG_ values
+    uint32_t flags;
+
+    uint32_t vertexCount;
+    /// Number of indices, 0 if the mesh is drawn without an index buffer
+    uint32_t indexCount;
+    /// Bytes per index: 2 or 4, 0 when indexCount is 0
+    uint32_t indexSize;
+
+    /// vertexCount * float[3], empty for quantized meshes
+    Blob positions;
+    /// vertexCount * float[2], empty for quantized meshes
+    Blob texCoords;
+    /// vertexCount * uint8_t for shaded float meshes, empty otherwise
+    Blob shades;
+    /// vertexCount * QuantizedVertex for quantized meshes, empty otherwise
+    Blob vertices;
+    /// indexCount * indexSize bytes, holds the indices of every level of detail
+    Blob indices;
+    /// lodCount * Lod, empty when the mesh has a single level
+    uint32_t lodCount;
+    Blob lods;
+
+    Bounds bounds;
+
+    /// Only meaningful for quantized meshes
+    Quantization quantization;
+};
+
+/// Round a file offset up to the next blob boundary
+constexpr uint32_t
+alignOffset(uint32_t offset)
+{
+    return (offset + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+}
+} // namespace MeshFormat
+
+#endif // __MESHFORMAT_H__
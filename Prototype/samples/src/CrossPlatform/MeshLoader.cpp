@@ -0,0 +1,1107 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "MeshLoader.h"
+
+#include "Log.h"
+#include "MemoryStream.h"
+#include "MeshFormat.h"
+
+#include <tiny_obj_loader.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+
+namespace
+{
+/// Check that a blob lies within the file and is correctly aligned
+bool
+isBlobValid(const MeshFormat::Blob& blob, uint64_t expectedSize, size_t fileSize)
+{
+    if (blob.size != expectedSize)
+    {
+        return false;
+    }
+    if (blob.size == 0)
+    {
+        return true;
+    }
+    return (blob.offset % MeshFormat::BLOB_ALIGNMENT) == 0 && blob.offset <= fileSize && blob.size <= fileSize - blob.offset;
+}
+
+
+/// True if every one of count indices of type T refers to one of vertexCount vertices
+template <typename T>
+bool
+areIndicesInRange(const void* indices, uint32_t count, uint32_t vertexCount)
+{
+    auto typed = static_cast<const T*>(indices);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (typed[i] >= vertexCount)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/// Size of the simulated post-transform vertex cache used by optimizeVertexCache
+constexpr int VERTEX_CACHE_SIZE = 32;
+
+
+/// Vertex score of the Forsyth vertex cache optimization
+/*
+ * Vertices used by the last triangle get a fixed score, other cached vertices score
+ * higher the more recently they were used, and vertices with few remaining triangles
+ * get a boost so that they are finished off rather than left behind.
+ */
+float
+vertexCacheScore(int cachePosition, uint32_t remainingTriangles)
+{
+    if (remainingTriangles == 0)
+    {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        if (cachePosition < 3)
+        {
+            score = 0.75f;
+        }
+        else
+        {
+            const float scaler = 1.0f / (VERTEX_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, 1.5f);
+        }
+    }
+    return score + 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+}
+
+
+/// Reorder the triangles of an index buffer for post-transform vertex cache locality, the vertices are not touched
+std::vector<uint32_t>
+optimizeTriangleOrder(const std::vector<uint32_t>& triangleIndices, size_t vertexCount)
+{
+    // Tom Forsyth's linear-speed vertex cache optimization: greedily emit the triangle with the
+    // highest score, where the score favours vertices that are still in a simulated LRU cache.
+    const size_t triangleCount = triangleIndices.size() / 3;
+    const uint32_t* indices = triangleIndices.data();
+
+    // Triangles adjacent to each vertex, the first remaining[v] entries are not emitted yet
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+    {
+        ++remaining[indices[i]];
+    }
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remaining[v];
+    }
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; ++i)
+        {
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        vertexScore[v] = vertexCacheScore(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    size_t bestTriangle = 0;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        triangleScore[t] = vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+        if (triangleScore[t] > triangleScore[bestTriangle])
+        {
+            bestTriangle = t;
+        }
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+    uint32_t cache[VERTEX_CACHE_SIZE + 3];
+    int cacheSize = 0;
+    size_t scanPosition = 0;
+
+    while (output.size() < triangleCount * 3)
+    {
+        if (bestTriangle == triangleCount)
+        {
+            // No candidate left in the cache, continue with the next triangle not emitted yet
+            while (emitted[scanPosition])
+            {
+                ++scanPosition;
+            }
+            bestTriangle = scanPosition;
+        }
+
+        const uint32_t* triangle = &indices[3 * bestTriangle];
+        emitted[bestTriangle] = true;
+
+        uint32_t newCache[VERTEX_CACHE_SIZE + 3];
+        int newCacheSize = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            uint32_t v = triangle[i];
+            output.push_back(v);
+            newCache[newCacheSize++] = v;
+
+            // Remove the triangle from the remaining adjacency of the vertex
+            uint32_t* begin = &adjacency[adjacencyOffsets[v]];
+            uint32_t* last = begin + remaining[v] - 1;
+            for (uint32_t* it = begin; it <= last; ++it)
+            {
+                if (*it == bestTriangle)
+                {
+                    std::swap(*it, *last);
+                    break;
+                }
+            }
+            --remaining[v];
+        }
+        for (int i = 0; i < cacheSize; ++i)
+        {
+            uint32_t v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+            {
+                newCache[newCacheSize++] = v;
+            }
+        }
+
+        // Update the scores of every vertex whose cache position changed, including evicted ones
+        for (int i = 0; i < newCacheSize; ++i)
+        {
+            uint32_t v = newCache[i];
+            cachePosition[v] = i < VERTEX_CACHE_SIZE ? i : -1;
+            vertexScore[v] = vertexCacheScore(cachePosition[v], remaining[v]);
+        }
+
+        // The next candidate is the best triangle touching any of those vertices
+        bestTriangle = triangleCount;
+        float bestScore = -1.0f;
+        for (int i = 0; i < newCacheSize; ++i)
+        {
+            uint32_t v = newCache[i];
+            for (uint32_t a = 0; a < remaining[v]; ++a)
+            {
+                uint32_t t = adjacency[adjacencyOffsets[v] + a];
+                const uint32_t* candidate = &indices[3 * t];
+                triangleScore[t] = vertexScore[candidate[0]] + vertexScore[candidate[1]] + vertexScore[candidate[2]];
+                if (triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        cacheSize = std::min(newCacheSize, VERTEX_CACHE_SIZE);
+        std::copy(newCache, newCache + cacheSize, cache);
+    }
+    return output;
+}
+
+
+/// Texture coordinate grid cells per unit used to keep texture seams apart while clustering
+constexpr float LOD_TEXCOORD_CELLS = 64.0f;
+
+/// Levels of detail are not generated below this many triangles
+constexpr size_t MIN_LOD_TRIANGLES = 256;
+
+
+/// Snap the vertices of a mesh to their grid cluster and return the triangles that still have an area
+std::vector<uint32_t>
+clusterTriangles(const MeshData& mesh, const std::vector<uint32_t>& indices, float cellSize, const float texCoordMin[2])
+{
+    const size_t vertexCount = static_cast<size_t>(mesh.vertexCount);
+    const float* boundsMin = mesh.bounds.min;
+
+    // Cell key: 14 bits per position axis and 11 bits per texture coordinate axis
+    auto cell = [](float value, float cellSize, uint64_t maxCell) {
+        return std::min(static_cast<uint64_t>(std::max(value / cellSize, 0.0f)), maxCell);
+    };
+    std::unordered_map<uint64_t, uint32_t> clusterIds;
+    clusterIds.reserve(vertexCount / 4);
+    std::vector<uint32_t> vertexCluster(vertexCount);
+    std::vector<float> centroids;
+    std::vector<uint32_t> clusterSizes;
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        const float* position = &mesh.positions[3 * v];
+        const float* texCoord = &mesh.texCoords[2 * v];
+        uint64_t key = cell(position[0] - boundsMin[0], cellSize, 0x3FFF);
+        key = (key << 14) | cell(position[1] - boundsMin[1], cellSize, 0x3FFF);
+        key = (key << 14) | cell(position[2] - boundsMin[2], cellSize, 0x3FFF);
+        key = (key << 11) | cell(texCoord[0] - texCoordMin[0], 1.0f / LOD_TEXCOORD_CELLS, 0x7FF);
+        key = (key << 11) | cell(texCoord[1] - texCoordMin[1], 1.0f / LOD_TEXCOORD_CELLS, 0x7FF);
+
+        auto inserted = clusterIds.emplace(key, static_cast<uint32_t>(clusterSizes.size()));
+        if (inserted.second)
+        {
+            centroids.insert(centroids.end(), 3, 0.0f);
+            clusterSizes.push_back(0);
+        }
+        uint32_t cluster = inserted.first->second;
+        vertexCluster[v] = cluster;
+        centroids[3 * cluster] += position[0];
+        centroids[3 * cluster + 1] += position[1];
+        centroids[3 * cluster + 2] += position[2];
+        ++clusterSizes[cluster];
+    }
+
+    // Every cluster is represented by its vertex closest to the centroid
+    const size_t clusterCount = clusterSizes.size();
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        float scale = 1.0f / static_cast<float>(clusterSizes[c]);
+        centroids[3 * c] *= scale;
+        centroids[3 * c + 1] *= scale;
+        centroids[3 * c + 2] *= scale;
+    }
+    std::vector<uint32_t> representative(clusterCount, 0);
+    std::vector<float> representativeDistance(clusterCount, INFINITY);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        uint32_t c = vertexCluster[v];
+        float dx = mesh.positions[3 * v] - centroids[3 * c];
+        float dy = mesh.positions[3 * v + 1] - centroids[3 * c + 1];
+        float dz = mesh.positions[3 * v + 2] - centroids[3 * c + 2];
+        float distance = dx * dx + dy * dy + dz * dz;
+        if (distance < representativeDistance[c])
+        {
+            representativeDistance[c] = distance;
+            representative[c] = static_cast<uint32_t>(v);
+        }
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size() / 2);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        uint32_t a = representative[vertexCluster[indices[i]]];
+        uint32_t b = representative[vertexCluster[indices[i + 1]]];
+        uint32_t c = representative[vertexCluster[indices[i + 2]]];
+        if (a != b && b != c && a != c)
+        {
+            result.push_back(a);
+            result.push_back(b);
+            result.push_back(c);
+        }
+    }
+    return result;
+}
+
+
+/// Fill shortIndices from indices if every index fits in 16 bits
+void
+compactIndices(MeshData& mesh)
+{
+    mesh.shortIndices.clear();
+    if (mesh.vertexCount > 0xFFFF + 1)
+    {
+        return;
+    }
+    mesh.shortIndices.assign(mesh.indices.begin(), mesh.indices.end());
+    mesh.indices.clear();
+    mesh.indices.shrink_to_fit();
+}
+
+
+/// Append a blob at the next aligned offset and record its location
+void
+appendBlob(std::vector<char>& output, const void* data, size_t size, MeshFormat::Blob& blob)
+{
+    blob.offset = MeshFormat::alignOffset(static_cast<uint32_t>(output.size()));
+    blob.size = static_cast<uint32_t>(size);
+    output.resize(blob.offset + size, 0);
+    if (size > 0)
+    {
+        memcpy(output.data() + blob.offset, data, size);
+    }
+}
+
+/// Number of lines of each kind in an OBJ file, used to reserve the loader buffers
+struct ObjLineCounts
+{
+    size_t positions{ 0 };
+    size_t texCoords{ 0 };
+    size_t faces{ 0 };
+};
+
+
+ObjLineCounts
+countObjLines(const char* data, size_t size)
+{
+    ObjLineCounts counts;
+    const char* end = data + size;
+    const char* line = data;
+    while (line < end)
+    {
+        while (line < end && (*line == ' ' || *line == '\t'))
+        {
+            ++line;
+        }
+        if (end - line >= 2)
+        {
+            bool separator = line[1] == ' ' || line[1] == '\t';
+            if (line[0] == 'v' && separator)
+            {
+                ++counts.positions;
+            }
+            else if (line[0] == 'v' && line[1] == 't')
+            {
+                ++counts.texCoords;
+            }
+            else if (line[0] == 'f' && separator)
+            {
+                ++counts.faces;
+            }
+        }
+        auto next = static_cast<const char*>(memchr(line, '\n', static_cast<size_t>(end - line)));
+        line = next != nullptr ? next + 1 : end;
+    }
+    return counts;
+}
+
+
+/// State shared by the tinyobj callbacks of MeshLoader::loadObjStreaming
+struct StreamingObjState
+{
+    MeshData* mesh;
+    /// Raw OBJ attributes, faces may refer to any attribute declared before them
+    std::vector<float> positions;
+    std::vector<float> texCoords;
+    /// A vertex is unique per (position, texture coordinate) pair, the key packs both indices
+    std::unordered_map<uint64_t, uint32_t> uniqueVertices;
+    bool invalidIndex{ false };
+};
+
+
+/// Convert a raw OBJ index (1-based, negative relative to the end, 0 when absent) into a 0-based index or -1
+int
+resolveObjIndex(int index, size_t count)
+{
+    if (index > 0)
+    {
+        return index - 1;
+    }
+    if (index < 0)
+    {
+        return static_cast<int>(count) + index;
+    }
+    return -1;
+}
+
+
+/// Get the output vertex for a face corner, appending it to the mesh on first use
+bool
+addObjCorner(StreamingObjState& state, const tinyobj::index_t& corner, uint32_t& vertex)
+{
+    const size_t positionCount = state.positions.size() / 3;
+    const size_t texCoordCount = state.texCoords.size() / 2;
+    int positionIndex = resolveObjIndex(corner.vertex_index, positionCount);
+    int texCoordIndex = resolveObjIndex(corner.texcoord_index, texCoordCount);
+    if (positionIndex < 0 || static_cast<size_t>(positionIndex) >= positionCount || texCoordIndex >= static_cast<int>(texCoordCount))
+    {
+        return false;
+    }
+
+    MeshData& mesh = *state.mesh;
+    uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(positionIndex)) << 32) | static_cast<uint32_t>(texCoordIndex);
+    auto inserted = state.uniqueVertices.emplace(key, static_cast<uint32_t>(mesh.vertexCount));
+    if (inserted.second)
+    {
+        const float* position = &state.positions[3 * positionIndex];
+        mesh.positions.insert(mesh.positions.end(), position, position + 3);
+        if (texCoordIndex < 0)
+        {
+            mesh.texCoords.push_back(0.f);
+            mesh.texCoords.push_back(0.f);
+        }
+        else
+        {
+            const float* texCoord = &state.texCoords[2 * texCoordIndex];
+            mesh.texCoords.insert(mesh.texCoords.end(), texCoord, texCoord + 2);
+        }
+        ++mesh.vertexCount;
+    }
+    vertex = inserted.first->second;
+    return true;
+}
+} // namespace
+
+
+bool
+MeshLoader::loadObj(const char* data, size_t size, MeshData& mesh)
+{
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+
+    std::string warn;
+    std::string err;
+
+    MemoryInputStream aFileDataStream(data, size);
+    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &aFileDataStream);
+    if (!ret || !err.empty())
+    {
+        LOG("Error loading model (%s)", err.c_str());
+        return false;
+    }
+    if (!warn.empty())
+    {
+        LOG("Warning loading model (%s)", warn.c_str());
+    }
+
+    size_t numCorners = 0;
+    for (const auto& shape : shapes)
+    {
+        numCorners += shape.mesh.indices.size();
+    }
+
+    mesh = MeshData();
+    mesh.indices.reserve(numCorners);
+    // A vertex is unique per (position, texture coordinate) pair, the key packs both indices
+    std::unordered_map<uint64_t, uint32_t> uniqueVertices;
+    uniqueVertices.reserve(attrib.vertices.size() / 3);
+
+    // Loop over shapes
+    // f is the index of the current face
+    // v is the index of the current vertex
+    for (const auto& shape : shapes)
+    {
+        // Loop over faces(polygon), LoadObj triangulates so every face has 3 vertices
+        size_t index_offset = 0;
+        for (size_t f = 0; f < shape.mesh.num_face_vertices.size(); ++f)
+        {
+            int fv = shape.mesh.num_face_vertices[f];
+
+            // Loop over vertices in the face.
+            for (int v = 0; v < fv; ++v)
+            {
+                // access to vertex
+                tinyobj::index_t idx = shape.mesh.indices[index_offset + v];
+
+                uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(idx.vertex_index)) << 32) |
+                               static_cast<uint32_t>(idx.texcoord_index);
+                auto inserted = uniqueVertices.emplace(key, static_cast<uint32_t>(mesh.vertexCount));
+                if (inserted.second)
+                {
+                    mesh.positions.push_back(attrib.vertices[3 * idx.vertex_index + 0]);
+                    mesh.positions.push_back(attrib.vertices[3 * idx.vertex_index + 1]);
+                    mesh.positions.push_back(attrib.vertices[3 * idx.vertex_index + 2]);
+
+                    if (idx.texcoord_index < 0)
+                    {
+                        mesh.texCoords.push_back(0.f);
+                        mesh.texCoords.push_back(0.f);
+                    }
+                    else
+                    {
+                        mesh.texCoords.push_back(attrib.texcoords[2 * idx.texcoord_index + 0]);
+                        mesh.texCoords.push_back(attrib.texcoords[2 * idx.texcoord_index + 1]);
+                    }
+                    ++mesh.vertexCount;
+                }
+                mesh.indices.push_back(inserted.first->second);
+            }
+            index_offset += fv;
+        }
+    }
+
+    optimizeVertexCache(mesh);
+    computeBounds(mesh);
+    compactIndices(mesh);
+    return true;
+}
+
+
+bool
+MeshLoader::loadObjStreaming(const char* data, size_t size, MeshData& mesh)
+{
+    mesh = MeshData();
+
+    ObjLineCounts counts = countObjLines(data, size);
+    StreamingObjState state;
+    state.mesh = &mesh;
+    state.positions.reserve(counts.positions * 3);
+    state.texCoords.reserve(counts.texCoords * 2);
+    state.uniqueVertices.reserve(counts.positions);
+    // Most vertices of a textured mesh are unique, seams and quads only add a few more
+    mesh.positions.reserve(counts.positions * 3);
+    mesh.texCoords.reserve(counts.positions * 2);
+    mesh.indices.reserve(counts.faces * 3);
+
+    tinyobj::callback_t callbacks;
+    callbacks.vertex_cb = [](void* userData, tinyobj::real_t x, tinyobj::real_t y, tinyobj::real_t z, tinyobj::real_t /*w*/) {
+        auto& positions = static_cast<StreamingObjState*>(userData)->positions;
+        positions.push_back(static_cast<float>(x));
+        positions.push_back(static_cast<float>(y));
+        positions.push_back(static_cast<float>(z));
+    };
+    callbacks.texcoord_cb = [](void* userData, tinyobj::real_t x, tinyobj::real_t y, tinyobj::real_t /*z*/) {
+        auto& texCoords = static_cast<StreamingObjState*>(userData)->texCoords;
+        texCoords.push_back(static_cast<float>(x));
+        texCoords.push_back(static_cast<float>(y));
+    };
+    callbacks.index_cb = [](void* userData, tinyobj::index_t* indices, int numIndices) {
+        auto& state = *static_cast<StreamingObjState*>(userData);
+        if (state.invalidIndex || numIndices < 3)
+        {
+            return;
+        }
+
+        // Triangulate the polygon as a fan around its first corner
+        uint32_t first = 0;
+        uint32_t previous = 0;
+        if (!addObjCorner(state, indices[0], first) || !addObjCorner(state, indices[1], previous))
+        {
+            state.invalidIndex = true;
+            return;
+        }
+        for (int i = 2; i < numIndices; ++i)
+        {
+            uint32_t current = 0;
+            if (!addObjCorner(state, indices[i], current))
+            {
+                state.invalidIndex = true;
+                return;
+            }
+            // Triangles without area are kept, like loadObj keeps them
+            state.mesh->indices.push_back(first);
+            state.mesh->indices.push_back(previous);
+            state.mesh->indices.push_back(current);
+            previous = current;
+        }
+    };
+
+    std::string warn;
+    std::string err;
+
+    MemoryInputStream aFileDataStream(data, size);
+    bool ret = tinyobj::LoadObjWithCallback(aFileDataStream, callbacks, &state, nullptr, &warn, &err);
+    if (!ret || !err.empty())
+    {
+        LOG("Error loading model (%s)", err.c_str());
+        return false;
+    }
+    if (state.invalidIndex)
+    {
+        LOG("Error loading model, a face refers to a vertex that does not exist");
+        return false;
+    }
+    if (!warn.empty())
+    {
+        LOG("Warning loading model (%s)", warn.c_str());
+    }
+
+    // Free the raw attributes before the optimization makes its own copies
+    state = StreamingObjState();
+
+    optimizeVertexCache(mesh);
+    computeBounds(mesh);
+    compactIndices(mesh);
+    return true;
+}
+
+
+void
+MeshLoader::optimizeVertexCache(MeshData& mesh)
+{
+    const size_t vertexCount = static_cast<size_t>(mesh.vertexCount);
+    if (mesh.indices.size() < 3)
+    {
+        return;
+    }
+    std::vector<uint32_t> output = optimizeTriangleOrder(mesh.indices, vertexCount);
+
+    // Renumber the vertices in the order they are first referenced so vertex fetches are sequential too
+    constexpr uint32_t UNASSIGNED = 0xFFFFFFFF;
+    std::vector<uint32_t> remap(vertexCount, UNASSIGNED);
+    std::vector<float> positions(mesh.positions.size());
+    std::vector<float> texCoords(mesh.texCoords.size());
+    std::vector<uint8_t> shades(mesh.shades.size());
+    uint32_t nextVertex = 0;
+    for (auto& index : output)
+    {
+        if (remap[index] == UNASSIGNED)
+        {
+            memcpy(&positions[3 * nextVertex], &mesh.positions[3 * index], 3 * sizeof(float));
+            memcpy(&texCoords[2 * nextVertex], &mesh.texCoords[2 * index], 2 * sizeof(float));
+            if (!shades.empty())
+            {
+                shades[nextVertex] = mesh.shades[index];
+            }
+            remap[index] = nextVertex++;
+        }
+        index = remap[index];
+    }
+
+    // Vertices that no triangle references are dropped
+    positions.resize(3 * nextVertex);
+    texCoords.resize(2 * nextVertex);
+    shades.resize(shades.empty() ? 0 : nextVertex);
+    mesh.vertexCount = static_cast<int>(nextVertex);
+    mesh.positions.swap(positions);
+    mesh.texCoords.swap(texCoords);
+    mesh.shades.swap(shades);
+    mesh.indices.swap(output);
+}
+
+
+bool
+MeshLoader::parseBinary(const void* data, size_t size, MeshView& view)
+{
+    if (data == nullptr || size < sizeof(MeshFormat::Header))
+    {
+        LOG("Error loading binary mesh, file is too small");
+        return false;
+    }
+
+    MeshFormat::Header header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != MeshFormat::MAGIC)
+    {
+        LOG("Error loading binary mesh, not a mesh file");
+        return false;
+    }
+    if (header.version != MeshFormat::VERSION)
+    {
+        LOG("Error loading binary mesh, unsupported version %u (expected %u)", header.version, MeshFormat::VERSION);
+        return false;
+    }
+
+    // MeshView holds the counts as int
+    if (header.vertexCount > INT_MAX || header.indexCount > INT_MAX || header.lodCount > INT_MAX)
+    {
+        LOG("Error loading binary mesh, counts are out of range");
+        return false;
+    }
+
+    // The sizes are computed in 64 bits, a crafted count must not wrap a 32-bit size_t around to the size of the blob
+    uint64_t vertexCount = header.vertexCount;
+    bool quantized = (header.flags & MeshFormat::FLAG_QUANTIZED) != 0;
+    bool shaded = (header.flags & MeshFormat::FLAG_SHADED) != 0;
+    uint64_t floatVertexCount = quantized ? 0 : vertexCount;
+    uint64_t quantizedVertexCount = quantized ? vertexCount : 0;
+    if (!isBlobValid(header.positions, floatVertexCount * 3 * sizeof(float), size) ||
+        !isBlobValid(header.texCoords, floatVertexCount * 2 * sizeof(float), size) ||
+        !isBlobValid(header.shades, shaded ? floatVertexCount : 0, size) ||
+        !isBlobValid(header.vertices, quantizedVertexCount * sizeof(MeshFormat::QuantizedVertex), size))
+    {
+        LOG("Error loading binary mesh, vertex data is corrupt");
+        return false;
+    }
+    if ((header.indexCount > 0 && header.indexSize != 2 && header.indexSize != 4) ||
+        !isBlobValid(header.indices, static_cast<uint64_t>(header.indexCount) * header.indexSize, size))
+    {
+        LOG("Error loading binary mesh, index data is corrupt");
+        return false;
+    }
+    // Meshes also come from downloads and the disk cache, an index past the vertices would be read out of bounds when drawn
+    const void* indices = static_cast<const char*>(data) + header.indices.offset;
+    if (header.indexCount > 0 && !(header.indexSize == 2 ? areIndicesInRange<uint16_t>(indices, header.indexCount, header.vertexCount)
+                                                         : areIndicesInRange<uint32_t>(indices, header.indexCount, header.vertexCount)))
+    {
+        LOG("Error loading binary mesh, an index is out of range");
+        return false;
+    }
+    if (!isBlobValid(header.lods, static_cast<uint64_t>(header.lodCount) * sizeof(MeshFormat::Lod), size))
+    {
+        LOG("Error loading binary mesh, level of detail data is corrupt");
+        return false;
+    }
+    auto lods = reinterpret_cast<const MeshFormat::Lod*>(static_cast<const char*>(data) + header.lods.offset);
+    for (uint32_t i = 0; i < header.lodCount; ++i)
+    {
+        if (lods[i].firstIndex > header.indexCount || lods[i].indexCount > header.indexCount - lods[i].firstIndex)
+        {
+            LOG("Error loading binary mesh, level of detail %u is out of range", i);
+            return false;
+        }
+    }
+
+    auto base = static_cast<const char*>(data);
+    view = MeshView();
+    view.vertexCount = static_cast<int>(header.vertexCount);
+    if (quantized)
+    {
+        view.quantizedVertices = reinterpret_cast<const MeshFormat::QuantizedVertex*>(base + header.vertices.offset);
+        view.quantization = header.quantization;
+    }
+    else
+    {
+        view.positions = reinterpret_cast<const float*>(base + header.positions.offset);
+        view.texCoords = reinterpret_cast<const float*>(base + header.texCoords.offset);
+        view.shades = shaded ? reinterpret_cast<const uint8_t*>(base + header.shades.offset) : nullptr;
+    }
+    view.shaded = shaded;
+    view.indexCount = static_cast<int>(header.indexCount);
+    view.indexSize = header.indexCount > 0 ? static_cast<int>(header.indexSize) : 0;
+    view.indices = header.indexCount > 0 ? base + header.indices.offset : nullptr;
+    view.lodCount = static_cast<int>(header.lodCount);
+    view.lods = header.lodCount > 0 ? lods : nullptr;
+    view.bounds = header.bounds;
+    return true;
+}
+
+
+bool
+MeshLoader::writeBinary(const MeshView& mesh, std::vector<char>& output)
+{
+    bool quantized = mesh.quantizedVertices != nullptr;
+    if (mesh.vertexCount <= 0 || (!quantized && (mesh.positions == nullptr || mesh.texCoords == nullptr)))
+    {
+        LOG("Error writing binary mesh, the mesh is empty");
+        return false;
+    }
+    if (mesh.shaded && !quantized && mesh.shades == nullptr)
+    {
+        LOG("Error writing binary mesh, the shades are missing");
+        return false;
+    }
+
+    MeshFormat::Header header{};
+    header.magic = MeshFormat::MAGIC;
+    header.version = MeshFormat::VERSION;
+    header.vertexCount = static_cast<uint32_t>(mesh.vertexCount);
+    header.indexCount = static_cast<uint32_t>(mesh.indexCount);
+    header.indexSize = mesh.indexCount > 0 ? static_cast<uint32_t>(mesh.indexSize) : 0;
+
+    output.assign(sizeof(header), 0);
+    if (mesh.shaded)
+    {
+        header.flags |= MeshFormat::FLAG_SHADED;
+    }
+    if (quantized)
+    {
+        header.flags |= MeshFormat::FLAG_QUANTIZED;
+        header.quantization = mesh.quantization;
+        appendBlob(output, mesh.quantizedVertices, mesh.vertexCount * sizeof(MeshFormat::QuantizedVertex), header.vertices);
+    }
+    else
+    {
+        appendBlob(output, mesh.positions, mesh.vertexCount * 3 * sizeof(float), header.positions);
+        appendBlob(output, mesh.texCoords, mesh.vertexCount * 2 * sizeof(float), header.texCoords);
+        appendBlob(output, mesh.shades, mesh.shaded ? mesh.vertexCount : 0, header.shades);
+    }
+    appendBlob(output, mesh.indices, static_cast<size_t>(mesh.indexCount) * header.indexSize, header.indices);
+    header.lodCount = static_cast<uint32_t>(mesh.lodCount);
+    appendBlob(output, mesh.lods, mesh.lodCount * sizeof(MeshFormat::Lod), header.lods);
+    header.bounds = mesh.bounds;
+
+    memcpy(output.data(), &header, sizeof(header));
+    return true;
+}
+
+
+MeshView
+MeshLoader::view(const MeshData& mesh)
+{
+    MeshView result;
+    result.vertexCount = mesh.vertexCount;
+    if (!mesh.quantizedVertices.empty())
+    {
+        result.quantizedVertices = mesh.quantizedVertices.data();
+        result.quantization = mesh.quantization;
+    }
+    else
+    {
+        result.positions = mesh.positions.data();
+        result.texCoords = mesh.texCoords.data();
+        result.shades = mesh.shades.empty() ? nullptr : mesh.shades.data();
+    }
+    result.shaded = !mesh.shades.empty();
+    if (!mesh.shortIndices.empty())
+    {
+        result.indexCount = static_cast<int>(mesh.shortIndices.size());
+        result.indexSize = sizeof(uint16_t);
+        result.indices = mesh.shortIndices.data();
+    }
+    else if (!mesh.indices.empty())
+    {
+        result.indexCount = static_cast<int>(mesh.indices.size());
+        result.indexSize = sizeof(uint32_t);
+        result.indices = mesh.indices.data();
+    }
+    result.lodCount = static_cast<int>(mesh.lods.size());
+    result.lods = mesh.lods.empty() ? nullptr : mesh.lods.data();
+    result.bounds = mesh.bounds;
+    return result;
+}
+
+
+void
+MeshLoader::interleave(const MeshView& mesh, std::vector<float>& vertices)
+{
+    if (mesh.quantizedVertices != nullptr)
+    {
+        vertices.clear();
+        return;
+    }
+
+    const bool shaded = mesh.shades != nullptr;
+    vertices.resize(static_cast<size_t>(mesh.vertexCount) * getInterleavedStride(mesh));
+    float* out = vertices.data();
+    for (int i = 0; i < mesh.vertexCount; ++i)
+    {
+        *out++ = mesh.positions[i * 3];
+        *out++ = mesh.positions[i * 3 + 1];
+        *out++ = mesh.positions[i * 3 + 2];
+        *out++ = mesh.texCoords[i * 2];
+        *out++ = mesh.texCoords[i * 2 + 1];
+        if (shaded)
+        {
+            *out++ = mesh.shades[i] * (1.0f / 255.0f);
+        }
+    }
+}
+
+
+void
+MeshLoader::computeBounds(MeshData& mesh)
+{
+    MeshFormat::Bounds& bounds = mesh.bounds;
+    bounds = MeshFormat::Bounds();
+    const size_t vertexCount = static_cast<size_t>(mesh.vertexCount);
+    if (vertexCount == 0 || mesh.positions.size() < vertexCount * 3)
+    {
+        return;
+    }
+
+    for (int c = 0; c < 3; ++c)
+    {
+        bounds.min[c] = bounds.max[c] = mesh.positions[c];
+    }
+    for (size_t v = 1; v < vertexCount; ++v)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            bounds.min[c] = std::min(bounds.min[c], mesh.positions[3 * v + c]);
+            bounds.max[c] = std::max(bounds.max[c], mesh.positions[3 * v + c]);
+        }
+    }
+
+    // The sphere is centered on the box, its radius reaches the farthest vertex
+    float radiusSquared = 0.0f;
+    for (int c = 0; c < 3; ++c)
+    {
+        bounds.center[c] = 0.5f * (bounds.min[c] + bounds.max[c]);
+    }
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        float dx = mesh.positions[3 * v] - bounds.center[0];
+        float dy = mesh.positions[3 * v + 1] - bounds.center[1];
+        float dz = mesh.positions[3 * v + 2] - bounds.center[2];
+        radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+    }
+    bounds.radius = std::sqrt(radiusSquared);
+}
+
+
+void
+MeshLoader::generateLods(MeshData& mesh, int levelCount)
+{
+    const size_t vertexCount = static_cast<size_t>(mesh.vertexCount);
+    if (vertexCount == 0 || mesh.positions.empty())
+    {
+        LOG("Levels of detail can only be generated for meshes with float vertices");
+        return;
+    }
+
+    // Work on 32-bit indices of the full resolution level, they are compacted again at the end
+    if (!mesh.shortIndices.empty())
+    {
+        mesh.indices.assign(mesh.shortIndices.begin(), mesh.shortIndices.end());
+        mesh.shortIndices.clear();
+    }
+    if (!mesh.lods.empty())
+    {
+        mesh.indices.resize(mesh.lods[0].indexCount);
+    }
+    mesh.lods.clear();
+    const std::vector<uint32_t> baseIndices = mesh.indices;
+    mesh.lods.push_back({ 0, static_cast<uint32_t>(baseIndices.size()), 0.0f });
+
+    float texCoordMin[2] = { INFINITY, INFINITY };
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        texCoordMin[0] = std::min(texCoordMin[0], mesh.texCoords[2 * v]);
+        texCoordMin[1] = std::min(texCoordMin[1], mesh.texCoords[2 * v + 1]);
+    }
+
+    const MeshFormat::Bounds& bounds = mesh.bounds;
+    float extent = std::max({ bounds.max[0] - bounds.min[0], bounds.max[1] - bounds.min[1], bounds.max[2] - bounds.min[2] });
+    // 14 bits of cell index per axis leave room for this many cells across the mesh
+    float minCellSize = extent / 8192.0f;
+    size_t previousTriangles = baseIndices.size() / 3;
+
+    for (int level = 1; level < levelCount && extent > 0.0f; ++level)
+    {
+        size_t targetTriangles = previousTriangles / 2;
+        if (targetTriangles < MIN_LOD_TRIANGLES)
+        {
+            break;
+        }
+
+        // Binary search the cell size on a log scale for the finest grid that reaches the target
+        std::vector<uint32_t> best;
+        float bestCellSize = 0.0f;
+        float low = minCellSize;
+        float high = extent;
+        for (int iteration = 0; iteration < 16; ++iteration)
+        {
+            float cellSize = std::sqrt(low * high);
+            std::vector<uint32_t> triangles = clusterTriangles(mesh, baseIndices, cellSize, texCoordMin);
+            if (triangles.size() / 3 > targetTriangles)
+            {
+                low = cellSize;
+            }
+            else
+            {
+                high = cellSize;
+                best.swap(triangles);
+                bestCellSize = cellSize;
+            }
+        }
+
+        // Stop when the texture seams keep the mesh from simplifying any further
+        if (best.empty() || best.size() / 3 > previousTriangles * 4 / 5)
+        {
+            break;
+        }
+
+        best = optimizeTriangleOrder(best, vertexCount);
+        // A vertex moves at most by the diagonal of its cell
+        mesh.lods.push_back({ static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(best.size()), bestCellSize * std::sqrt(3.0f) });
+        mesh.indices.insert(mesh.indices.end(), best.begin(), best.end());
+        previousTriangles = best.size() / 3;
+        minCellSize = bestCellSize;
+    }
+
+    if (mesh.lods.size() == 1)
+    {
+        mesh.lods.clear();
+    }
+    compactIndices(mesh);
+}
+
+
+void
+MeshLoader::extractLod(MeshData& mesh, int level)
+{
+    if (mesh.lods.empty() || mesh.positions.empty())
+    {
+        LOG("Levels of detail can only be extracted from meshes with float vertices and levels");
+        return;
+    }
+
+    const MeshFormat::Lod lod = mesh.lods[std::min(static_cast<size_t>(std::max(level, 0)), mesh.lods.size() - 1)];
+    std::vector<uint32_t> indices(lod.indexCount);
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        size_t index = lod.firstIndex + i;
+        indices[i] = mesh.shortIndices.empty() ? mesh.indices[index] : mesh.shortIndices[index];
+    }
+    mesh.indices.swap(indices);
+    mesh.shortIndices.clear();
+    mesh.lods.clear();
+
+    // Renumbering the vertices in the order of the triangles drops the unused ones
+    optimizeVertexCache(mesh);
+    computeBounds(mesh);
+    compactIndices(mesh);
+}
+
+
+void
+MeshLoader::quantize(MeshData& mesh)
+{
+    if (mesh.vertexCount <= 0 || !mesh.quantizedVertices.empty())
+    {
+        return;
+    }
+
+    // Ranges of both attributes, degenerate extents get a unit scale so that dequantization stays finite
+    const size_t vertexCount = static_cast<size_t>(mesh.vertexCount);
+    float positionMin[3] = { mesh.positions[0], mesh.positions[1], mesh.positions[2] };
+    float positionMax[3] = { mesh.positions[0], mesh.positions[1], mesh.positions[2] };
+    float texCoordMin[2] = { mesh.texCoords[0], mesh.texCoords[1] };
+    float texCoordMax[2] = { mesh.texCoords[0], mesh.texCoords[1] };
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            positionMin[c] = std::min(positionMin[c], mesh.positions[3 * v + c]);
+            positionMax[c] = std::max(positionMax[c], mesh.positions[3 * v + c]);
+        }
+        for (int c = 0; c < 2; ++c)
+        {
+            texCoordMin[c] = std::min(texCoordMin[c], mesh.texCoords[2 * v + c]);
+            texCoordMax[c] = std::max(texCoordMax[c], mesh.texCoords[2 * v + c]);
+        }
+    }
+
+    constexpr float QUANTIZED_MAX = 65535.0f;
+    MeshFormat::Quantization& quantization = mesh.quantization;
+    float positionFactor[3];
+    float texCoordFactor[2];
+    for (int c = 0; c < 3; ++c)
+    {
+        float extent = positionMax[c] - positionMin[c];
+        quantization.positionMin[c] = positionMin[c];
+        quantization.positionScale[c] = extent > 0.0f ? extent : 1.0f;
+        positionFactor[c] = extent > 0.0f ? QUANTIZED_MAX / extent : 0.0f;
+    }
+    for (int c = 0; c < 2; ++c)
+    {
+        float extent = texCoordMax[c] - texCoordMin[c];
+        quantization.texCoordMin[c] = texCoordMin[c];
+        quantization.texCoordScale[c] = extent > 0.0f ? extent : 1.0f;
+        texCoordFactor[c] = extent > 0.0f ? QUANTIZED_MAX / extent : 0.0f;
+    }
+
+    mesh.quantizedVertices.resize(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        MeshFormat::QuantizedVertex& vertex = mesh.quantizedVertices[v];
+        for (int c = 0; c < 3; ++c)
+        {
+            float value = (mesh.positions[3 * v + c] - positionMin[c]) * positionFactor[c];
+            vertex.position[c] = static_cast<uint16_t>(std::min(std::lround(value), 65535L));
+        }
+        vertex.shade = mesh.shades.empty() ? 0 : mesh.shades[v];
+        vertex.padding = 0;
+        for (int c = 0; c < 2; ++c)
+        {
+            float value = (mesh.texCoords[2 * v + c] - texCoordMin[c]) * texCoordFactor[c];
+            vertex.texCoord[c] = static_cast<uint16_t>(std::min(std::lround(value), 65535L));
+        }
+    }
+
+    std::vector<float>().swap(mesh.positions);
+    std::vector<float>().swap(mesh.texCoords);
+}
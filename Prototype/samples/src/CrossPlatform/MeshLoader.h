@@ -0,0 +1,150 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __MESHLOADER_H__
+#define __MESHLOADER_H__
+
+#include "MeshFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/// CPU-side geometry of a model, owned by the caller
+struct MeshData
+{
+    int vertexCount{ 0 };
+    /// 3 floats per unique vertex
+    std::vector<float> positions;
+    /// 2 floats per unique vertex
+    std::vector<float> texCoords;
+    /// Triangle list indices, only one of indices and shortIndices is filled.
+    /// shortIndices is used when every index fits in 16 bits.
+    std::vector<uint32_t> indices;
+    std::vector<uint16_t> shortIndices;
+    /// Baked shade per unique vertex from VertexShadingBaker, 255 is fully lit, empty for unshaded meshes
+    /// Kept by quantize, which copies it into the vertices.
+    std::vector<uint8_t> shades;
+    /// Filled instead of positions and texCoords once the mesh is quantized
+    std::vector<MeshFormat::QuantizedVertex> quantizedVertices;
+    MeshFormat::Quantization quantization{};
+    /// Levels of detail within the index buffer, empty when the whole index buffer is the only level
+    std::vector<MeshFormat::Lod> lods;
+    MeshFormat::Bounds bounds{};
+};
+
+
+/// Non-owning view of mesh geometry
+/**
+ * The pointers either refer to a MeshData or directly into a mapped binary mesh file,
+ * in which case the view is only valid while the file stays mapped.
+ */
+struct MeshView
+{
+    int vertexCount{ 0 };
+    /// Float vertex attributes, null for quantized meshes
+    const float* positions{ nullptr };
+    const float* texCoords{ nullptr };
+    /// Baked shades of float meshes, null for quantized meshes, which hold them in their vertices
+    const uint8_t* shades{ nullptr };
+    /// Every vertex carries a baked shade
+    bool shaded{ false };
+    /// Quantized vertices, null unless the mesh is quantized
+    const MeshFormat::QuantizedVertex* quantizedVertices{ nullptr };
+    MeshFormat::Quantization quantization{};
+    /// Levels of detail, lodCount is 0 when the mesh has a single level
+    int lodCount{ 0 };
+    const MeshFormat::Lod* lods{ nullptr };
+    MeshFormat::Bounds bounds{};
+    /// Number of indices, 0 if the mesh is a plain triangle list
+    int indexCount{ 0 };
+    /// Bytes per index, 2 or 4
+    int indexSize{ 0 };
+    const void* indices{ nullptr };
+};
+
+
+/// Platform-independent loading of model geometry, shared by the app and the MeshConverter tool
+class MeshLoader
+{
+public:
+    /// Parse an OBJ file held in memory into an indexed triangle list
+    /*
+     * Face corners sharing the same position and texture coordinate are merged into
+     * a single vertex and the triangles are reordered for post-transform vertex cache
+     * locality. Missing texture coordinates are set to 0,0 which may not be suitable
+     * for rendering some OBJ model files.
+     */
+    static bool loadObj(const char* data, size_t size, MeshData& mesh);
+
+    /// Parse an OBJ file held in memory in a single streaming pass
+    /*
+     * Vertices and faces are written straight into the output as tinyobj reports them instead of
+     * building the complete tinyobj attribute and shape structures first, which lowers the peak
+     * memory use to little more than the raw OBJ attributes plus the output mesh.
+     * The buffers are reserved from a quick count of the v, vt and f lines.
+     * Polygons are triangulated as fans, so the result only differs from loadObj where its ear clipping
+     * splits a polygon of more than three corners differently. Triangles without area are kept, as loadObj keeps them.
+     * Normals, groups and materials are ignored.
+     */
+    static bool loadObjStreaming(const char* data, size_t size, MeshData& mesh);
+
+    /// Reorder the triangles of an index buffer for post-transform vertex cache locality,
+    /// then renumber the vertices in the order they are first used
+    static void optimizeVertexCache(MeshData& mesh);
+
+    /// Validate a binary mesh file held in memory and point the view at its blobs
+    /*
+     * No data is copied, the view refers to the memory passed in.
+     */
+    static bool parseBinary(const void* data, size_t size, MeshView& view);
+
+    /// Serialize a mesh into the binary mesh format described in MeshFormat.h
+    static bool writeBinary(const MeshView& mesh, std::vector<char>& output);
+
+    /// Get a view of a mesh, valid as long as the mesh is not modified
+    static MeshView view(const MeshData& mesh);
+
+    /// Interleave positions and texture coordinates into 5 floats per vertex, ready for a vertex buffer upload
+    /// The shade in [0;1] follows as a 6th float for shaded meshes, see getInterleavedStride.
+    /// Quantized meshes are already interleaved, vertices is left empty for them.
+    static void interleave(const MeshView& mesh, std::vector<float>& vertices);
+
+    /// Floats per vertex written by interleave
+    static int getInterleavedStride(const MeshView& mesh) { return mesh.shaded ? 6 : 5; }
+
+    /// Compute the bounds of the float positions of a mesh, both OBJ loaders do this already
+    static void computeBounds(MeshData& mesh);
+
+    /// Append simplified levels of detail to the index buffer of a mesh
+    /*
+     * Each level is built by clustering the vertices on a grid and snapping every cluster to the
+     * vertex closest to its centroid, so all levels share the vertices of the full resolution mesh.
+     * The grid is sized for every level to keep about half the triangles of the previous one,
+     * levels are added up to levelCount in total or until the mesh does not simplify any further.
+     * Texture seams are kept by clustering on the texture coordinates as well.
+     * Must be called before quantize, replaces any levels the mesh already has.
+     */
+    static void generateLods(MeshData& mesh, int levelCount);
+
+    /// Keep only one level of detail of a mesh, e.g. for a coarse variant sent ahead of the full mesh
+    /*
+     * The vertices the level does not use are dropped and the bounds are recomputed, the result is a mesh
+     * with a single level. Must be called before quantize, the level is clamped to the coarsest one.
+     */
+    static void extractLod(MeshData& mesh, int level);
+
+    /// Convert the float vertex attributes of a mesh into the quantized layout
+    /*
+     * Positions are quantized to 16 bits over the bounding box of the mesh and texture coordinates
+     * over their range, the float attributes are released.
+     */
+    static void quantize(MeshData& mesh);
+};
+
+#endif // __MESHLOADER_H__
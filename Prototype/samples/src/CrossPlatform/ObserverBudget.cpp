@@ -0,0 +1,120 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "ObserverBudget.h"
+
+#include <algorithm>
+
+
+ObserverBudget::ObserverBudget()
+{
+    setConfig(Config());
+}
+
+
+ObserverBudget::ObserverBudget(const Config& config)
+{
+    setConfig(config);
+}
+
+
+void
+ObserverBudget::setConfig(const Config& config)
+{
+    mConfig = config;
+    mConfig.budget = std::max(mConfig.budget, 1);
+    mConfig.scanSlots = std::min(std::max(mConfig.scanSlots, 0), mConfig.budget);
+    mConfig.dwellFrames = std::max(mConfig.dwellFrames, 1);
+    reset(getTargetCount());
+}
+
+
+void
+ObserverBudget::reset(int targetCount)
+{
+    mFrame = 0;
+    mLastRotation = 0;
+    mScanCursor = 0;
+    mLastObserved.assign(std::max(targetCount, 0), -1);
+    mActive.assign(mLastObserved.size(), false);
+    plan();
+}
+
+
+bool
+ObserverBudget::update(const int* observed, int observedCount)
+{
+    ++mFrame;
+    int targetCount = getTargetCount();
+    for (int i = 0; i < observedCount; ++i)
+    {
+        if (observed[i] >= 0 && observed[i] < targetCount)
+        {
+            mLastObserved[observed[i]] = mFrame;
+        }
+    }
+    if (mFrame - mLastRotation >= mConfig.dwellFrames)
+    {
+        mLastRotation = mFrame;
+        mScanCursor = targetCount > 0 ? (mScanCursor + std::max(mConfig.scanSlots, 1)) % targetCount : 0;
+    }
+
+    std::vector<bool> previous = mActive;
+    plan();
+    return mActive != previous;
+}
+
+
+void
+ObserverBudget::plan()
+{
+    int targetCount = getTargetCount();
+    if (targetCount <= mConfig.budget)
+    {
+        mActive.assign(targetCount, true);
+        return;
+    }
+
+    // Targets observed now first, then the others by how recently they were observed
+    std::vector<int> candidates;
+    int observedNow = 0;
+    for (int i = 0; i < targetCount; ++i)
+    {
+        if (mLastObserved[i] >= 0 && mFrame - mLastObserved[i] <= mConfig.recentFrames)
+        {
+            candidates.push_back(i);
+            observedNow += mLastObserved[i] == mFrame ? 1 : 0;
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [&](int a, int b) { return mLastObserved[a] > mLastObserved[b]; });
+
+    int scanSlots = std::min(mConfig.scanSlots, std::max(mConfig.budget - observedNow, 0));
+    int recentSlots = std::max(mConfig.budget - scanSlots, observedNow);
+
+    mActive.assign(targetCount, false);
+    int activeCount = 0;
+    for (int target : candidates)
+    {
+        if (activeCount == recentSlots)
+        {
+            break;
+        }
+        mActive[target] = true;
+        ++activeCount;
+    }
+
+    // Whatever is left of the budget rotates through the remaining targets from the cursor on
+    for (int i = 0; i < targetCount && activeCount < mConfig.budget; ++i)
+    {
+        int target = (mScanCursor + i) % targetCount;
+        if (!mActive[target])
+        {
+            mActive[target] = true;
+            ++activeCount;
+        }
+    }
+}
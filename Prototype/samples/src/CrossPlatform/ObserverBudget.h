@@ -0,0 +1,68 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __OBSERVERBUDGET_H__
+#define __OBSERVERBUDGET_H__
+
+#include <cstdint>
+#include <vector>
+
+
+/// Picks which of a collection of targets have an active observer when only a few may be active
+/**
+ * The cost of tracking grows with the number of active observers, so of a large collection only
+ * budget observers are active at a time. Targets observed in the current frame always keep their
+ * observer. The remaining slots go to the targets observed most recently, except for scanSlots
+ * slots that rotate through all other targets, dwellFrames frames per step, so that every target
+ * is eventually searched for. The active set is planned again on every frame but only changes when
+ * something was observed or the rotation steps, observers are not toggled needlessly.
+ */
+class ObserverBudget
+{
+public:
+    struct Config
+    {
+        /// Observers active at the same time
+        int budget = 4;
+        /// Slots out of the budget that rotate through the targets not seen recently
+        int scanSlots = 1;
+        /// Frames a rotating slot stays with a target, long enough for a detection attempt
+        int dwellFrames = 30;
+        /// Frames after which a target no longer has priority from its last observation
+        int recentFrames = 300;
+    };
+
+    ObserverBudget();
+    explicit ObserverBudget(const Config& config);
+
+    /// Replace the configuration, the targets are reset
+    void setConfig(const Config& config);
+    const Config& getConfig() const { return mConfig; }
+
+    /// Forget all observations of a collection of targetCount targets and plan the first active set
+    void reset(int targetCount);
+
+    /// Called once per camera frame with the indices of the targets observed in it
+    /// Returns true if the active set changed.
+    bool update(const int* observed, int observedCount);
+
+    int getTargetCount() const { return static_cast<int>(mActive.size()); }
+    bool isActive(int target) const { return mActive[target]; }
+
+private:
+    void plan();
+
+    Config mConfig;
+    int64_t mFrame = 0;
+    int64_t mLastRotation = 0;
+    int mScanCursor = 0;
+    /// Frame each target was last observed in, -1 if never
+    std::vector<int64_t> mLastObserved;
+    std::vector<bool> mActive;
+};
+
+#endif /* __OBSERVERBUDGET_H__ */
@@ -0,0 +1,285 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "PixelConvert.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PIXELCONVERT_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PIXELCONVERT_SSE2 1
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define PIXELCONVERT_SSSE3 1
+#endif
+#endif
+
+
+namespace
+{
+/// Multiply a color channel by alpha, rounded to nearest, exact for all 8-bit inputs
+inline uint8_t
+multiplyAlpha(uint32_t color, uint32_t alpha)
+{
+    uint32_t product = color * alpha + 128;
+    return static_cast<uint8_t>((product + (product >> 8)) >> 8);
+}
+
+inline uint8_t
+expandBits(uint32_t value, int bits)
+{
+    return static_cast<uint8_t>((value << (8 - bits)) | (value >> (2 * bits - 8)));
+}
+
+/// Lookup tables between sRGB encoded bytes and 12-bit linear light
+struct SrgbTables
+{
+    uint16_t toLinear[256];
+    uint8_t toSrgb[4096];
+};
+
+const SrgbTables&
+getSrgbTables()
+{
+    static const SrgbTables tables = []() {
+        SrgbTables result;
+        for (int i = 0; i < 256; ++i)
+        {
+            float c = i / 255.0f;
+            float linear = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            result.toLinear[i] = static_cast<uint16_t>(std::lround(linear * 4095.0f));
+        }
+        for (int i = 0; i < 4096; ++i)
+        {
+            float linear = i / 4095.0f;
+            float c = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+            result.toSrgb[i] = static_cast<uint8_t>(std::lround(c * 255.0f));
+        }
+        return result;
+    }();
+    return tables;
+}
+
+} // anonymous namespace
+
+
+void
+PixelConvert::argbToRgba(const uint32_t* argb, uint8_t* rgba, size_t pixelCount)
+{
+    // Little-endian ARGB words are B, G, R, A in memory, only red and blue swap places
+    const uint8_t* bgra = reinterpret_cast<const uint8_t*>(argb);
+    size_t i = 0;
+#if PIXELCONVERT_NEON
+    for (; i + 16 <= pixelCount; i += 16)
+    {
+        uint8x16x4_t pixels = vld4q_u8(bgra + i * 4);
+        uint8x16_t blue = pixels.val[0];
+        pixels.val[0] = pixels.val[2];
+        pixels.val[2] = blue;
+        vst4q_u8(rgba + i * 4, pixels);
+    }
+#elif PIXELCONVERT_SSE2
+    const __m128i greenAlphaMask = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+    const __m128i lowMask = _mm_set1_epi32(0xFF);
+    for (; i + 4 <= pixelCount; i += 4)
+    {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bgra + i * 4));
+        __m128i greenAlpha = _mm_and_si128(pixels, greenAlphaMask);
+        __m128i red = _mm_and_si128(_mm_srli_epi32(pixels, 16), lowMask);
+        __m128i blue = _mm_slli_epi32(_mm_and_si128(pixels, lowMask), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4), _mm_or_si128(greenAlpha, _mm_or_si128(red, blue)));
+    }
+#endif
+    for (; i < pixelCount; ++i)
+    {
+        uint8_t blue = bgra[i * 4];
+        rgba[i * 4] = bgra[i * 4 + 2];
+        rgba[i * 4 + 1] = bgra[i * 4 + 1];
+        rgba[i * 4 + 2] = blue;
+        rgba[i * 4 + 3] = bgra[i * 4 + 3];
+    }
+}
+
+
+void
+PixelConvert::argbToRgbaFlipRows(uint8_t* pixels, int width, int height)
+{
+    size_t rowBytes = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> row(rowBytes);
+
+    int top = 0;
+    int bottom = height - 1;
+    for (; top < bottom; ++top, --bottom)
+    {
+        uint8_t* topRow = pixels + top * rowBytes;
+        uint8_t* bottomRow = pixels + bottom * rowBytes;
+        argbToRgba(reinterpret_cast<const uint32_t*>(topRow), row.data(), width);
+        argbToRgba(reinterpret_cast<const uint32_t*>(bottomRow), topRow, width);
+        memcpy(bottomRow, row.data(), rowBytes);
+    }
+    if (top == bottom)
+    {
+        uint8_t* middleRow = pixels + top * rowBytes;
+        argbToRgba(reinterpret_cast<const uint32_t*>(middleRow), middleRow, width);
+    }
+}
+
+
+void
+PixelConvert::rgbToRgba(const uint8_t* rgb, uint8_t* rgba, size_t pixelCount)
+{
+    size_t i = 0;
+#if PIXELCONVERT_NEON
+    for (; i + 16 <= pixelCount; i += 16)
+    {
+        uint8x16x3_t pixels = vld3q_u8(rgb + i * 3);
+        uint8x16x4_t result;
+        result.val[0] = pixels.val[0];
+        result.val[1] = pixels.val[1];
+        result.val[2] = pixels.val[2];
+        result.val[3] = vdupq_n_u8(255);
+        vst4q_u8(rgba + i * 4, result);
+    }
+#elif PIXELCONVERT_SSSE3
+    // Each load reads 16 bytes for 4 pixels, stop while 6 pixels are left so that it stays within the input
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+    for (; i + 6 <= pixelCount; i += 4)
+    {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + i * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+    }
+#endif
+    for (; i < pixelCount; ++i)
+    {
+        rgba[i * 4] = rgb[i * 3];
+        rgba[i * 4 + 1] = rgb[i * 3 + 1];
+        rgba[i * 4 + 2] = rgb[i * 3 + 2];
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+
+void
+PixelConvert::rgb565ToRgba(const uint16_t* rgb565, uint8_t* rgba, size_t pixelCount)
+{
+    size_t i = 0;
+#if PIXELCONVERT_NEON
+    // The channels are masked out of bytes narrowed from different shifts, then their high bits are replicated
+    for (; i + 8 <= pixelCount; i += 8)
+    {
+        uint16x8_t pixels = vld1q_u16(rgb565 + i);
+        uint8x8_t red = vand_u8(vshrn_n_u16(pixels, 8), vdup_n_u8(0xF8));
+        uint8x8_t green = vand_u8(vshrn_n_u16(pixels, 3), vdup_n_u8(0xFC));
+        uint8x8_t blue = vshl_n_u8(vmovn_u16(pixels), 3);
+        uint8x8x4_t result;
+        result.val[0] = vorr_u8(red, vshr_n_u8(red, 5));
+        result.val[1] = vorr_u8(green, vshr_n_u8(green, 6));
+        result.val[2] = vorr_u8(blue, vshr_n_u8(blue, 5));
+        result.val[3] = vdup_n_u8(255);
+        vst4_u8(rgba + i * 4, result);
+    }
+#elif PIXELCONVERT_SSE2
+    const __m128i redMask = _mm_set1_epi16(0xF8);
+    const __m128i greenMask = _mm_set1_epi16(0xFC);
+    const __m128i alpha = _mm_set1_epi16(static_cast<short>(0xFF00));
+    for (; i + 8 <= pixelCount; i += 8)
+    {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb565 + i));
+        __m128i red = _mm_and_si128(_mm_srli_epi16(pixels, 8), redMask);
+        __m128i green = _mm_and_si128(_mm_srli_epi16(pixels, 3), greenMask);
+        __m128i blue = _mm_and_si128(_mm_slli_epi16(pixels, 3), redMask);
+        red = _mm_or_si128(red, _mm_srli_epi16(red, 5));
+        green = _mm_or_si128(green, _mm_srli_epi16(green, 6));
+        blue = _mm_or_si128(blue, _mm_srli_epi16(blue, 5));
+
+        // Red and green in the low byte pairs, blue and alpha in the high ones, interleaved into pixels
+        __m128i redGreen = _mm_or_si128(red, _mm_slli_epi16(green, 8));
+        __m128i blueAlpha = _mm_or_si128(blue, alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4), _mm_unpacklo_epi16(redGreen, blueAlpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4 + 16), _mm_unpackhi_epi16(redGreen, blueAlpha));
+    }
+#endif
+    for (; i < pixelCount; ++i)
+    {
+        uint32_t pixel = rgb565[i];
+        rgba[i * 4] = expandBits(pixel >> 11, 5);
+        rgba[i * 4 + 1] = expandBits((pixel >> 5) & 0x3F, 6);
+        rgba[i * 4 + 2] = expandBits(pixel & 0x1F, 5);
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+
+void
+PixelConvert::premultiplyAlpha(uint8_t* rgba, size_t pixelCount, bool srgb)
+{
+    if (srgb)
+    {
+        const SrgbTables& tables = getSrgbTables();
+        for (size_t i = 0; i < pixelCount; ++i)
+        {
+            uint8_t* pixel = rgba + i * 4;
+            uint32_t alpha = pixel[3];
+            if (alpha == 255)
+            {
+                continue;
+            }
+            for (int channel = 0; channel < 3; ++channel)
+            {
+                uint32_t linear = (tables.toLinear[pixel[channel]] * alpha + 127) / 255;
+                pixel[channel] = tables.toSrgb[linear];
+            }
+        }
+        return;
+    }
+
+    size_t i = 0;
+#if PIXELCONVERT_NEON
+    for (; i + 8 <= pixelCount; i += 8)
+    {
+        uint8x8x4_t pixels = vld4_u8(rgba + i * 4);
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            // (p + ((p + 128) >> 8) + 128) >> 8, the same rounding as multiplyAlpha
+            uint16x8_t product = vmull_u8(pixels.val[channel], pixels.val[3]);
+            pixels.val[channel] = vrshrn_n_u16(vrsraq_n_u16(product, product, 8), 8);
+        }
+        vst4_u8(rgba + i * 4, pixels);
+    }
+#elif PIXELCONVERT_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi16(128);
+    // The alpha lanes of two pixels widened to 16 bits
+    const __m128i alphaMask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    auto multiply = [&](__m128i pixels) {
+        __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, 0xFF), 0xFF);
+        __m128i product = _mm_add_epi16(_mm_mullo_epi16(pixels, alpha), half);
+        product = _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+        return _mm_or_si128(_mm_and_si128(alphaMask, pixels), _mm_andnot_si128(alphaMask, product));
+    };
+    for (; i + 4 <= pixelCount; i += 4)
+    {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i * 4));
+        __m128i low = multiply(_mm_unpacklo_epi8(pixels, zero));
+        __m128i high = multiply(_mm_unpackhi_epi8(pixels, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4), _mm_packus_epi16(low, high));
+    }
+#endif
+    for (; i < pixelCount; ++i)
+    {
+        uint8_t* pixel = rgba + i * 4;
+        pixel[0] = multiplyAlpha(pixel[0], pixel[3]);
+        pixel[1] = multiplyAlpha(pixel[1], pixel[3]);
+        pixel[2] = multiplyAlpha(pixel[2], pixel[3]);
+    }
+}
@@ -0,0 +1,46 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __PIXELCONVERT_H__
+#define __PIXELCONVERT_H__
+
+#include <cstddef>
+#include <cstdint>
+
+
+/// Pixel format conversions into the RGBA8 byte order GL textures are uploaded in
+/**
+ * The kernels are vectorized with NEON on ARM and SSE2 (SSSE3 where available) on x86, with scalar
+ * code for the remaining pixels and other targets. All of them give the same result on every path,
+ * Tools/PixelConvertBench checks this and measures the throughput.
+ * Pixels are assumed to be stored little-endian, as on every Android ABI.
+ */
+class PixelConvert
+{
+public:
+    /// Convert Android ARGB_8888 colors, as returned by Bitmap.getPixels, to RGBA bytes
+    /// argb and rgba may point to the same memory.
+    static void argbToRgba(const uint32_t* argb, uint8_t* rgba, size_t pixelCount);
+
+    /// Convert an image of Android ARGB colors with the top row first to RGBA bytes with the bottom row first, in place
+    static void argbToRgbaFlipRows(uint8_t* pixels, int width, int height);
+
+    /// Expand tightly packed RGB bytes to RGBA with opaque alpha
+    static void rgbToRgba(const uint8_t* rgb, uint8_t* rgba, size_t pixelCount);
+
+    /// Expand RGB565 pixels to RGBA with opaque alpha, the low bits of each channel replicate the high bits
+    static void rgb565ToRgba(const uint16_t* rgb565, uint8_t* rgba, size_t pixelCount);
+
+    /// Multiply the color channels of RGBA pixels by their alpha in place, rounded to nearest
+    /*
+     * With srgb the colors are treated as sRGB encoded, as sampled from GL_SRGB8_ALPHA8 textures:
+     * they are multiplied in linear light and encoded again. That path is scalar, it goes through lookup tables.
+     */
+    static void premultiplyAlpha(uint8_t* rgba, size_t pixelCount, bool srgb = false);
+};
+
+#endif // __PIXELCONVERT_H__
@@ -0,0 +1,282 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "PoseFilter.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace
+{
+struct Quaternion
+{
+    float w, x, y, z;
+};
+
+
+/// Element of row and column of a column-major matrix
+float&
+at(VuMatrix44F& m, int row, int column)
+{
+    return m.data[column * 4 + row];
+}
+
+
+float
+at(const VuMatrix44F& m, int row, int column)
+{
+    return m.data[column * 4 + row];
+}
+
+
+void
+store(const Quaternion& q, float* wxyz)
+{
+    wxyz[0] = q.w;
+    wxyz[1] = q.x;
+    wxyz[2] = q.y;
+    wxyz[3] = q.z;
+}
+
+
+Quaternion
+multiply(const Quaternion& a, const Quaternion& b)
+{
+    return { a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z, a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+             a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x, a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w };
+}
+
+
+Quaternion
+conjugate(const Quaternion& q)
+{
+    return { q.w, -q.x, -q.y, -q.z };
+}
+
+
+Quaternion
+normalize(const Quaternion& q)
+{
+    float length = std::sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+    return length > 0.0f ? Quaternion{ q.w / length, q.x / length, q.y / length, q.z / length } : Quaternion{ 1.0f, 0.0f, 0.0f, 0.0f };
+}
+
+
+float
+dot(const Quaternion& a, const Quaternion& b)
+{
+    return a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+
+Quaternion
+fromMatrix(const VuMatrix44F& m)
+{
+    // Shepperd's method, picks the largest of the diagonal terms for precision
+    float trace = at(m, 0, 0) + at(m, 1, 1) + at(m, 2, 2);
+    Quaternion q;
+    if (trace > 0.0f)
+    {
+        float s = 2.0f * std::sqrt(trace + 1.0f);
+        q = { 0.25f * s, (at(m, 2, 1) - at(m, 1, 2)) / s, (at(m, 0, 2) - at(m, 2, 0)) / s, (at(m, 1, 0) - at(m, 0, 1)) / s };
+    }
+    else if (at(m, 0, 0) > at(m, 1, 1) && at(m, 0, 0) > at(m, 2, 2))
+    {
+        float s = 2.0f * std::sqrt(1.0f + at(m, 0, 0) - at(m, 1, 1) - at(m, 2, 2));
+        q = { (at(m, 2, 1) - at(m, 1, 2)) / s, 0.25f * s, (at(m, 0, 1) + at(m, 1, 0)) / s, (at(m, 0, 2) + at(m, 2, 0)) / s };
+    }
+    else if (at(m, 1, 1) > at(m, 2, 2))
+    {
+        float s = 2.0f * std::sqrt(1.0f + at(m, 1, 1) - at(m, 0, 0) - at(m, 2, 2));
+        q = { (at(m, 0, 2) - at(m, 2, 0)) / s, (at(m, 0, 1) + at(m, 1, 0)) / s, 0.25f * s, (at(m, 1, 2) + at(m, 2, 1)) / s };
+    }
+    else
+    {
+        float s = 2.0f * std::sqrt(1.0f + at(m, 2, 2) - at(m, 0, 0) - at(m, 1, 1));
+        q = { (at(m, 1, 0) - at(m, 0, 1)) / s, (at(m, 0, 2) + at(m, 2, 0)) / s, (at(m, 1, 2) + at(m, 2, 1)) / s, 0.25f * s };
+    }
+    return normalize(q);
+}
+
+
+VuMatrix44F
+toMatrix(const Quaternion& q, const float* position)
+{
+    VuMatrix44F m{};
+    at(m, 0, 0) = 1.0f - 2.0f * (q.y * q.y + q.z * q.z);
+    at(m, 0, 1) = 2.0f * (q.x * q.y - q.w * q.z);
+    at(m, 0, 2) = 2.0f * (q.x * q.z + q.w * q.y);
+    at(m, 1, 0) = 2.0f * (q.x * q.y + q.w * q.z);
+    at(m, 1, 1) = 1.0f - 2.0f * (q.x * q.x + q.z * q.z);
+    at(m, 1, 2) = 2.0f * (q.y * q.z - q.w * q.x);
+    at(m, 2, 0) = 2.0f * (q.x * q.z - q.w * q.y);
+    at(m, 2, 1) = 2.0f * (q.y * q.z + q.w * q.x);
+    at(m, 2, 2) = 1.0f - 2.0f * (q.x * q.x + q.y * q.y);
+    at(m, 0, 3) = position[0];
+    at(m, 1, 3) = position[1];
+    at(m, 2, 3) = position[2];
+    at(m, 3, 3) = 1.0f;
+    return m;
+}
+
+
+/// Rotation vector, axis times angle, of a unit quaternion
+void
+toRotationVector(Quaternion q, float* vector)
+{
+    if (q.w < 0.0f)
+    {
+        q = { -q.w, -q.x, -q.y, -q.z };
+    }
+    float sine = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z);
+    float scale = sine > 1e-6f ? 2.0f * std::atan2(sine, q.w) / sine : 2.0f;
+    vector[0] = q.x * scale;
+    vector[1] = q.y * scale;
+    vector[2] = q.z * scale;
+}
+
+
+Quaternion
+fromRotationVector(const float* vector)
+{
+    float angle = std::sqrt(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+    if (angle < 1e-6f)
+    {
+        return normalize({ 1.0f, 0.5f * vector[0], 0.5f * vector[1], 0.5f * vector[2] });
+    }
+    float scale = std::sin(0.5f * angle) / angle;
+    return { std::cos(0.5f * angle), vector[0] * scale, vector[1] * scale, vector[2] * scale };
+}
+
+
+Quaternion
+slerp(const Quaternion& a, Quaternion b, float t)
+{
+    float cosine = dot(a, b);
+    if (cosine < 0.0f)
+    {
+        b = { -b.w, -b.x, -b.y, -b.z };
+        cosine = -cosine;
+    }
+    if (cosine > 0.9995f)
+    {
+        return normalize({ a.w + t * (b.w - a.w), a.x + t * (b.x - a.x), a.y + t * (b.y - a.y), a.z + t * (b.z - a.z) });
+    }
+    float angle = std::acos(cosine);
+    float sine = std::sin(angle);
+    float wa = std::sin((1.0f - t) * angle) / sine;
+    float wb = std::sin(t * angle) / sine;
+    return { wa * a.w + wb * b.w, wa * a.x + wb * b.x, wa * a.y + wb * b.y, wa * a.z + wb * b.z };
+}
+
+
+/// Smoothing factor of an exponential low-pass filter with a cutoff frequency
+float
+smoothingFactor(float cutoff, float dt)
+{
+    constexpr float PI = 3.14159265f;
+    float tau = 1.0f / (2.0f * PI * cutoff);
+    return 1.0f / (1.0f + tau / dt);
+}
+
+
+float
+length(const float* vector)
+{
+    return std::sqrt(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+}
+
+} // anonymous namespace
+
+
+PoseFilter::PoseFilter()
+{
+    setConfig(Config());
+}
+
+
+PoseFilter::PoseFilter(const Config& config)
+{
+    setConfig(config);
+}
+
+
+void
+PoseFilter::setConfig(const Config& config)
+{
+    mConfig = config;
+    mConfig.minCutoff = std::max(mConfig.minCutoff, 0.01f);
+    mConfig.rotationMinCutoff = std::max(mConfig.rotationMinCutoff, 0.01f);
+    mConfig.derivativeCutoff = std::max(mConfig.derivativeCutoff, 0.01f);
+    reset();
+}
+
+
+VuMatrix44F
+PoseFilter::filter(const VuMatrix44F& pose, double timestamp)
+{
+    const float position[3] = { at(pose, 0, 3), at(pose, 1, 3), at(pose, 2, 3) };
+    Quaternion measured = fromMatrix(pose);
+    Quaternion rotation{ mRotation[0], mRotation[1], mRotation[2], mRotation[3] };
+
+    double elapsed = timestamp - mLastTimestamp;
+    if (mInitialized && elapsed == 0.0)
+    {
+        return mOutput;
+    }
+
+    if (!mInitialized || elapsed < 0.0 || elapsed > mConfig.resetSeconds)
+    {
+        mInitialized = true;
+        mLastTimestamp = timestamp;
+        std::copy(position, position + 3, mPosition);
+        std::fill(mVelocity, mVelocity + 3, 0.0f);
+        std::fill(mAngularVelocity, mAngularVelocity + 3, 0.0f);
+        store(measured, mRotation);
+        mOutput = pose;
+        return mOutput;
+    }
+
+    float dt = static_cast<float>(elapsed);
+    mLastTimestamp = timestamp;
+    float derivativeFactor = smoothingFactor(mConfig.derivativeCutoff, dt);
+
+    // Translation, the velocity is taken relative to the previous filtered position
+    for (int i = 0; i < 3; ++i)
+    {
+        float velocity = (position[i] - mPosition[i]) / dt;
+        mVelocity[i] += derivativeFactor * (velocity - mVelocity[i]);
+    }
+    float factor = smoothingFactor(mConfig.minCutoff + mConfig.beta * length(mVelocity), dt);
+    for (int i = 0; i < 3; ++i)
+    {
+        mPosition[i] += factor * (position[i] - mPosition[i]);
+    }
+
+    // Rotation, the same on the rotation from the previous filtered rotation to the measured one
+    float delta[3];
+    toRotationVector(multiply(measured, conjugate(rotation)), delta);
+    for (int i = 0; i < 3; ++i)
+    {
+        mAngularVelocity[i] += derivativeFactor * (delta[i] / dt - mAngularVelocity[i]);
+    }
+    float rotationFactor = smoothingFactor(mConfig.rotationMinCutoff + mConfig.rotationBeta * length(mAngularVelocity), dt);
+    rotation = slerp(rotation, measured, rotationFactor);
+    store(rotation, mRotation);
+
+    // Extrapolate by the smoothed velocities
+    float predictedPosition[3];
+    float predictedDelta[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        predictedPosition[i] = mPosition[i] + mVelocity[i] * mConfig.predictionSeconds;
+        predictedDelta[i] = mAngularVelocity[i] * mConfig.predictionSeconds;
+    }
+    mOutput = toMatrix(normalize(multiply(fromRotationVector(predictedDelta), rotation)), predictedPosition);
+    return mOutput;
+}
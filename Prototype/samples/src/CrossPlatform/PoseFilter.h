@@ -0,0 +1,71 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __POSEFILTER_H__
+#define __POSEFILTER_H__
+
+#include <VuforiaEngine/VuforiaEngine.h>
+
+
+/// Smooths the jitter of a rigid pose with a One-Euro filter and predicts it forward by its velocity
+/**
+ * Translation and rotation are filtered separately. Each is low-pass filtered with a cutoff
+ * frequency that rises with its smoothed speed, so a pose at rest is smoothed strongly while
+ * a moving pose follows with little lag. The lag that remains is made up for by extrapolating
+ * the filtered pose with the smoothed velocities by predictionSeconds.
+ * Poses are 4x4 rigid transforms in the column-major layout of VuMatrix44F, timestamps are seconds.
+ * The filter starts over with the next pose after a gap of resetSeconds, e.g. when a target was lost.
+ */
+class PoseFilter
+{
+public:
+    struct Config
+    {
+        /// Cutoff in Hz at rest and its increase per m/s of translation
+        float minCutoff = 1.0f;
+        float beta = 10.0f;
+        /// Cutoff in Hz at rest and its increase per rad/s of rotation
+        float rotationMinCutoff = 1.0f;
+        float rotationBeta = 2.0f;
+        /// Cutoff in Hz of the velocities that drive the cutoffs and the prediction
+        float derivativeCutoff = 1.0f;
+        /// How far the filtered pose is extrapolated
+        float predictionSeconds = 0.016f;
+        /// Longest gap between two poses that is filtered across
+        float resetSeconds = 0.25f;
+    };
+
+    PoseFilter();
+    explicit PoseFilter(const Config& config);
+
+    /// Replace the configuration, the filter starts over
+    void setConfig(const Config& config);
+    const Config& getConfig() const { return mConfig; }
+
+    /// Start over with the next pose
+    void reset() { mInitialized = false; }
+
+    /// Add a pose measured at a timestamp and return the filtered and predicted pose
+    /// A pose with the timestamp of the previous one returns the previous result.
+    VuMatrix44F filter(const VuMatrix44F& pose, double timestamp);
+
+private:
+    Config mConfig;
+    bool mInitialized = false;
+    double mLastTimestamp = 0.0;
+
+    float mPosition[3]{};
+    float mVelocity[3]{};
+    /// Unit quaternion w, x, y, z
+    float mRotation[4]{ 1.0f, 0.0f, 0.0f, 0.0f };
+    /// Rotation vector per second, applied on the left of mRotation
+    float mAngularVelocity[3]{};
+
+    VuMatrix44F mOutput{};
+};
+
+#endif /* __POSEFILTER_H__ */
@@ -0,0 +1,216 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+
+Profiler::Scope::Scope(Profiler* profiler, const char* name) : mProfiler(nullptr), mSection(-1)
+{
+    if (profiler != nullptr && profiler->isEnabled())
+    {
+        mSection = profiler->getSection(name);
+        if (mSection >= 0)
+        {
+            mProfiler = profiler;
+            mProfiler->begin(mSection);
+        }
+    }
+}
+
+
+Profiler::Scope::~Scope()
+{
+    if (mProfiler != nullptr)
+    {
+        mProfiler->end(mSection);
+    }
+}
+
+
+void
+Profiler::setTraceFunctions(TraceBeginFunction begin, TraceEndFunction end)
+{
+    mTraceBegin = begin;
+    mTraceEnd = end;
+}
+
+
+int
+Profiler::getSection(const char* name)
+{
+    // Names are usually the same literal, compare the pointers before the strings
+    int count = mSectionCount;
+    for (int i = 0; i < count; ++i)
+    {
+        if (mSections[i].name == name)
+        {
+            return i;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    count = mSectionCount;
+    for (int i = 0; i < count; ++i)
+    {
+        if (strcmp(mSections[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+    if (count == MAX_SECTIONS)
+    {
+        return -1;
+    }
+    mSections[count].name = name;
+    mSectionCount = count + 1;
+    return count;
+}
+
+
+const char*
+Profiler::getSectionName(int section) const
+{
+    return section >= 0 && section < mSectionCount ? mSections[section].name : nullptr;
+}
+
+
+void
+Profiler::begin(int section)
+{
+    Section& data = mSections[section];
+    if (mMode == Mode::TRACE && mTraceBegin != nullptr)
+    {
+        mTraceBegin(data.name);
+    }
+    if (mGpuRanges != nullptr)
+    {
+        mGpuRanges->begin(section);
+    }
+    data.start = std::chrono::steady_clock::now();
+}
+
+
+void
+Profiler::end(int section)
+{
+    Section& data = mSections[section];
+    std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - data.start;
+    if (mGpuRanges != nullptr)
+    {
+        mGpuRanges->end(section);
+    }
+    if (mMode == Mode::TRACE && mTraceEnd != nullptr)
+    {
+        mTraceEnd();
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    data.cpu.add(duration.count());
+}
+
+
+void
+Profiler::addGpuTime(int section, float milliseconds)
+{
+    if (section < 0 || section >= mSectionCount)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSections[section].gpu.add(milliseconds);
+}
+
+
+std::vector<Profiler::SectionStatistics>
+Profiler::getStatistics() const
+{
+    std::vector<SectionStatistics> statistics;
+    getStatistics(statistics);
+    return statistics;
+}
+
+
+void
+Profiler::getStatistics(std::vector<SectionStatistics>& statistics) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    statistics.clear();
+    int count = mSectionCount;
+    statistics.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        const Section& section = mSections[i];
+        statistics.push_back({ section.name, section.cpu.count, section.cpu.getPercentiles(), section.gpu.count,
+                               section.gpu.getPercentiles() });
+    }
+}
+
+
+std::string
+Profiler::formatStatistics() const
+{
+    std::string text;
+    char line[160];
+    for (const auto& section : getStatistics())
+    {
+        int length = snprintf(line, sizeof(line), "%-24s cpu p50 %6.2f p90 %6.2f p99 %6.2f ms", section.name, section.cpu.p50,
+                              section.cpu.p90, section.cpu.p99);
+        if (section.gpuSamples > 0 && length > 0 && length < static_cast<int>(sizeof(line)))
+        {
+            snprintf(line + length, sizeof(line) - length, "  gpu p50 %6.2f p90 %6.2f p99 %6.2f ms", section.gpu.p50, section.gpu.p90,
+                     section.gpu.p99);
+        }
+        text += line;
+        text += '\n';
+    }
+    return text;
+}
+
+
+void
+Profiler::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& section : mSections)
+    {
+        section.cpu.count = section.cpu.next = 0;
+        section.gpu.count = section.gpu.next = 0;
+    }
+}
+
+
+void
+Profiler::Samples::add(float value)
+{
+    values[next] = value;
+    next = (next + 1) % WINDOW_SAMPLES;
+    count = std::min(count + 1, WINDOW_SAMPLES);
+}
+
+
+Profiler::Percentiles
+Profiler::Samples::getPercentiles() const
+{
+    Percentiles percentiles;
+    if (count == 0)
+    {
+        return percentiles;
+    }
+
+    float sorted[WINDOW_SAMPLES];
+    std::copy(values, values + count, sorted);
+    std::sort(sorted, sorted + count);
+    auto at = [&](float fraction) { return sorted[std::min(count - 1, static_cast<int>(fraction * count))]; };
+    percentiles.p50 = at(0.5f);
+    percentiles.p90 = at(0.9f);
+    percentiles.p99 = at(0.99f);
+    return percentiles;
+}
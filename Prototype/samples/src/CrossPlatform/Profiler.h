@@ -0,0 +1,150 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+/// Times named sections of a frame on the CPU and, through GpuRanges, on the GPU
+/**
+ * Sections are identified by their name, which must be a string literal or otherwise outlive the
+ * profiler. The last WINDOW_SAMPLES times of each section are kept for rolling percentiles.
+ * Sections may nest but a section must not be entered again before it was left. Sections are
+ * timed on the rendering thread, the statistics can be read on any thread.
+ * In TRACE mode every section is also emitted as a trace marker, e.g. ATrace on Android, so that it
+ * shows up in systrace and Perfetto captures.
+ */
+class Profiler
+{
+public:
+    static constexpr int MAX_SECTIONS = 16;
+    static constexpr int WINDOW_SAMPLES = 240;
+
+    enum class Mode
+    {
+        OFF,
+        /// Sections are timed
+        STATISTICS,
+        /// Sections are timed and emitted as trace markers
+        TRACE,
+    };
+
+    /// Times sections on the GPU, implemented by the renderer of the platform
+    /// The results arrive later and are passed to addGpuTime.
+    class GpuRanges
+    {
+    public:
+        virtual ~GpuRanges() = default;
+        virtual void begin(int section) = 0;
+        virtual void end(int section) = 0;
+    };
+
+    using TraceBeginFunction = void (*)(const char* name);
+    using TraceEndFunction = void (*)();
+
+    struct Percentiles
+    {
+        float p50 = 0.0f;
+        float p90 = 0.0f;
+        float p99 = 0.0f;
+    };
+
+    struct SectionStatistics
+    {
+        const char* name;
+        /// Milliseconds, only valid when the sample count is not 0
+        int cpuSamples;
+        Percentiles cpu;
+        int gpuSamples;
+        Percentiles gpu;
+    };
+
+    /// Times a section for the lifetime of the scope, does nothing if the profiler is null or OFF
+    class Scope
+    {
+    public:
+        Scope(Profiler* profiler, const char* name);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Profiler* mProfiler;
+        int mSection;
+    };
+
+    void setMode(Mode mode) { mMode = mode; }
+    Mode getMode() const { return mMode; }
+    bool isEnabled() const { return mMode != Mode::OFF; }
+
+    /// Functions emitting the markers of TRACE mode, nullptr if the platform has no tracing
+    void setTraceFunctions(TraceBeginFunction begin, TraceEndFunction end);
+
+    /// Set by the renderer once it can time sections on the GPU, nullptr to time on the CPU only
+    void setGpuRanges(GpuRanges* gpuRanges) { mGpuRanges = gpuRanges; }
+
+    /// Index of the section of a name, registered on first use, -1 once MAX_SECTIONS are registered
+    int getSection(const char* name);
+    const char* getSectionName(int section) const;
+
+    /// Enter and leave a section, prefer Scope
+    void begin(int section);
+    void end(int section);
+
+    /// Add a GPU time reported by the GpuRanges
+    void addGpuTime(int section, float milliseconds);
+
+    /// Percentiles of the sections in the order they were registered
+    std::vector<SectionStatistics> getStatistics() const;
+    /// Same into a vector whose storage is reused, no allocation once it has room for MAX_SECTIONS
+    void getStatistics(std::vector<SectionStatistics>& statistics) const;
+
+    /// The statistics as lines of text, one per section
+    std::string formatStatistics() const;
+
+    /// Forget the times of all sections, the sections stay registered
+    void clear();
+
+private:
+    /// Times of a section, a ring of the last WINDOW_SAMPLES
+    struct Samples
+    {
+        float values[WINDOW_SAMPLES];
+        int count = 0;
+        int next = 0;
+
+        void add(float value);
+        Percentiles getPercentiles() const;
+    };
+
+    struct Section
+    {
+        const char* name = nullptr;
+        std::chrono::steady_clock::time_point start;
+        Samples cpu;
+        Samples gpu;
+    };
+
+    std::atomic<Mode> mMode{ Mode::OFF };
+    TraceBeginFunction mTraceBegin = nullptr;
+    TraceEndFunction mTraceEnd = nullptr;
+    GpuRanges* mGpuRanges = nullptr;
+
+    /// Guards the registration and the samples of the sections
+    mutable std::mutex mMutex;
+    Section mSections[MAX_SECTIONS];
+    std::atomic<int> mSectionCount{ 0 };
+};
+
+#endif /* __PROFILER_H__ */
@@ -0,0 +1,314 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "PseudoNormalBaker.h"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PSEUDONORMAL_NEON 1
+#endif
+
+
+namespace
+{
+/// ITU-R 601 luma weights in 8.8 fixed point, they add up to 256
+constexpr uint32_t LUMA_R = 77;
+constexpr uint32_t LUMA_G = 150;
+constexpr uint32_t LUMA_B = 29;
+
+/// PseudoNormalBaker::COLOR_WEIGHT in 8.8 fixed point
+constexpr uint32_t COLOR_WEIGHT_FIXED = 236;
+
+/// Float luma weights for the saturation step, the same as the fixed point ones
+constexpr float LUMA_R_FLOAT = LUMA_R / 256.0f;
+constexpr float LUMA_G_FLOAT = LUMA_G / 256.0f;
+constexpr float LUMA_B_FLOAT = LUMA_B / 256.0f;
+
+/// Pixels summed in 32 bits before adding to the 64-bit total
+constexpr size_t SUM_BLOCK_PIXELS = 4096;
+
+inline uint32_t
+lumaOf(uint32_t r, uint32_t g, uint32_t b)
+{
+    return (r * LUMA_R + g * LUMA_G + b * LUMA_B + 128) >> 8;
+}
+
+/// Luma of a run of pixels, returns the sum of the luma values
+uint64_t
+lumaRun(const uint8_t* rgba, size_t count, uint8_t* luma)
+{
+    uint64_t sum = 0;
+    size_t i = 0;
+#if PSEUDONORMAL_NEON
+    uint32x4_t blockSum = vdupq_n_u32(0);
+    for (; i + 8 <= count; i += 8)
+    {
+        uint8x8x4_t pixels = vld4_u8(rgba + i * 4);
+        uint16x8_t weighted = vmull_u8(pixels.val[0], vdup_n_u8(LUMA_R));
+        weighted = vmlal_u8(weighted, pixels.val[1], vdup_n_u8(LUMA_G));
+        weighted = vmlal_u8(weighted, pixels.val[2], vdup_n_u8(LUMA_B));
+        uint8x8_t result = vrshrn_n_u16(weighted, 8);
+        if (luma != nullptr)
+        {
+            vst1_u8(luma + i, result);
+        }
+        blockSum = vpadalq_u16(blockSum, vmovl_u8(result));
+        if ((i + 8) % SUM_BLOCK_PIXELS == 0)
+        {
+            sum += static_cast<uint64_t>(vgetq_lane_u32(blockSum, 0)) + vgetq_lane_u32(blockSum, 1) + vgetq_lane_u32(blockSum, 2) +
+                   vgetq_lane_u32(blockSum, 3);
+            blockSum = vdupq_n_u32(0);
+        }
+    }
+    sum += static_cast<uint64_t>(vgetq_lane_u32(blockSum, 0)) + vgetq_lane_u32(blockSum, 1) + vgetq_lane_u32(blockSum, 2) +
+           vgetq_lane_u32(blockSum, 3);
+#endif
+    for (; i < count; ++i)
+    {
+        uint32_t value = lumaOf(rgba[i * 4], rgba[i * 4 + 1], rgba[i * 4 + 2]);
+        if (luma != nullptr)
+        {
+            luma[i] = static_cast<uint8_t>(value);
+        }
+        sum += value;
+    }
+    return sum;
+}
+
+/// color = min(color * COLOR_WEIGHT + normal, 255) for one row, returns the sum of the luma of the result
+uint64_t
+combineRow(uint8_t* rgba, const uint8_t* normal, int width)
+{
+    uint64_t sum = 0;
+    int x = 0;
+#if PSEUDONORMAL_NEON
+    uint32x4_t rowSum = vdupq_n_u32(0);
+    const uint8x8_t weight = vdup_n_u8(COLOR_WEIGHT_FIXED);
+    for (; x + 8 <= width; x += 8)
+    {
+        uint8x8x4_t pixels = vld4_u8(rgba + x * 4);
+        uint8x8_t n = vld1_u8(normal + x);
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            // Saturating add clips to 255 like cv2.addWeighted
+            pixels.val[channel] = vqadd_u8(vrshrn_n_u16(vmull_u8(pixels.val[channel], weight), 8), n);
+        }
+        vst4_u8(rgba + x * 4, pixels);
+
+        uint16x8_t weighted = vmull_u8(pixels.val[0], vdup_n_u8(LUMA_R));
+        weighted = vmlal_u8(weighted, pixels.val[1], vdup_n_u8(LUMA_G));
+        weighted = vmlal_u8(weighted, pixels.val[2], vdup_n_u8(LUMA_B));
+        rowSum = vpadalq_u16(rowSum, vmovl_u8(vrshrn_n_u16(weighted, 8)));
+    }
+    sum += static_cast<uint64_t>(vgetq_lane_u32(rowSum, 0)) + vgetq_lane_u32(rowSum, 1) + vgetq_lane_u32(rowSum, 2) +
+           vgetq_lane_u32(rowSum, 3);
+#endif
+    for (; x < width; ++x)
+    {
+        uint8_t* pixel = rgba + x * 4;
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            uint32_t value = ((pixel[channel] * COLOR_WEIGHT_FIXED + 128) >> 8) + normal[x];
+            pixel[channel] = static_cast<uint8_t>(std::min(value, 255u));
+        }
+        sum += lumaOf(pixel[0], pixel[1], pixel[2]);
+    }
+    return sum;
+}
+
+#if PSEUDONORMAL_NEON
+/// NEON version of adjustPixel for 4 pixels
+inline void
+adjustPixels(float32x4_t& r, float32x4_t& g, float32x4_t& b, float32x4_t valueOffset)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t max = vdupq_n_f32(255.0f);
+
+    float32x4_t value = vmaxq_f32(vmaxq_f32(r, g), b);
+    float32x4_t newValue = vminq_f32(vmaxq_f32(vaddq_f32(value, valueOffset), zero), max);
+
+    // newValue / value with the reciprocal estimate refined twice, black pixels become gray
+    float32x4_t divisor = vmaxq_f32(value, one);
+    float32x4_t reciprocal = vrecpeq_f32(divisor);
+    reciprocal = vmulq_f32(vrecpsq_f32(divisor, reciprocal), reciprocal);
+    reciprocal = vmulq_f32(vrecpsq_f32(divisor, reciprocal), reciprocal);
+    float32x4_t scale = vmulq_f32(newValue, reciprocal);
+    uint32x4_t black = vceqq_f32(value, zero);
+    r = vbslq_f32(black, newValue, vmulq_f32(r, scale));
+    g = vbslq_f32(black, newValue, vmulq_f32(g, scale));
+    b = vbslq_f32(black, newValue, vmulq_f32(b, scale));
+
+    float32x4_t luma = vaddq_f32(vaddq_f32(vmulq_f32(r, vdupq_n_f32(LUMA_R_FLOAT)), vmulq_f32(g, vdupq_n_f32(LUMA_G_FLOAT))),
+                                 vmulq_f32(b, vdupq_n_f32(LUMA_B_FLOAT)));
+    const float32x4_t saturation = vdupq_n_f32(PseudoNormalBaker::SATURATION);
+    r = vminq_f32(vmaxq_f32(vaddq_f32(luma, vmulq_f32(vsubq_f32(r, luma), saturation)), zero), max);
+    g = vminq_f32(vmaxq_f32(vaddq_f32(luma, vmulq_f32(vsubq_f32(g, luma), saturation)), zero), max);
+    b = vminq_f32(vmaxq_f32(vaddq_f32(luma, vmulq_f32(vsubq_f32(b, luma), saturation)), zero), max);
+}
+
+inline float32x4_t
+toFloat(uint16x4_t values)
+{
+    return vcvtq_f32_u32(vmovl_u16(values));
+}
+
+inline uint8x8_t
+toBytes(float32x4_t low, float32x4_t high)
+{
+    // Round to nearest, the values are already clamped to [0;255]
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    uint16x4_t lowWords = vmovn_u32(vcvtq_u32_f32(vaddq_f32(low, half)));
+    uint16x4_t highWords = vmovn_u32(vcvtq_u32_f32(vaddq_f32(high, half)));
+    return vmovn_u16(vcombine_u16(lowWords, highWords));
+}
+#endif
+
+/// Shift the HSV value by valueOffset keeping hue and saturation, then raise the saturation
+inline void
+adjustPixel(uint8_t* pixel, float valueOffset)
+{
+    float r = pixel[0];
+    float g = pixel[1];
+    float b = pixel[2];
+
+    float value = std::max(std::max(r, g), b);
+    float newValue = std::min(std::max(value + valueOffset, 0.0f), 255.0f);
+    if (value > 0.0f)
+    {
+        float scale = newValue / value;
+        r *= scale;
+        g *= scale;
+        b *= scale;
+    }
+    else
+    {
+        r = g = b = newValue;
+    }
+
+    float luma = r * LUMA_R_FLOAT + g * LUMA_G_FLOAT + b * LUMA_B_FLOAT;
+    auto saturate = [luma](float channel) {
+        float result = luma + (channel - luma) * PseudoNormalBaker::SATURATION;
+        return static_cast<uint8_t>(std::min(std::max(result, 0.0f), 255.0f) + 0.5f);
+    };
+    pixel[0] = saturate(r);
+    pixel[1] = saturate(g);
+    pixel[2] = saturate(b);
+}
+
+/// adjustPixel for one row, valueOffset is in 8-bit units
+void
+adjustRow(uint8_t* rgba, int width, float valueOffset)
+{
+    int x = 0;
+#if PSEUDONORMAL_NEON
+    const float32x4_t offset = vdupq_n_f32(valueOffset);
+    for (; x + 8 <= width; x += 8)
+    {
+        uint8x8x4_t pixels = vld4_u8(rgba + x * 4);
+        uint16x8_t r = vmovl_u8(pixels.val[0]);
+        uint16x8_t g = vmovl_u8(pixels.val[1]);
+        uint16x8_t b = vmovl_u8(pixels.val[2]);
+
+        float32x4_t rLow = toFloat(vget_low_u16(r));
+        float32x4_t gLow = toFloat(vget_low_u16(g));
+        float32x4_t bLow = toFloat(vget_low_u16(b));
+        float32x4_t rHigh = toFloat(vget_high_u16(r));
+        float32x4_t gHigh = toFloat(vget_high_u16(g));
+        float32x4_t bHigh = toFloat(vget_high_u16(b));
+        adjustPixels(rLow, gLow, bLow, offset);
+        adjustPixels(rHigh, gHigh, bHigh, offset);
+
+        pixels.val[0] = toBytes(rLow, rHigh);
+        pixels.val[1] = toBytes(gLow, gHigh);
+        pixels.val[2] = toBytes(bLow, bHigh);
+        vst4_u8(rgba + x * 4, pixels);
+    }
+#endif
+    for (; x < width; ++x)
+    {
+        adjustPixel(rgba + x * 4, valueOffset);
+    }
+}
+
+} // anonymous namespace
+
+
+float
+PseudoNormalBaker::computeLuma(const uint8_t* rgba, size_t pixelCount, uint8_t* luma)
+{
+    if (pixelCount == 0)
+    {
+        return 0.0f;
+    }
+    return static_cast<float>(static_cast<double>(lumaRun(rgba, pixelCount, luma)) / (255.0 * pixelCount));
+}
+
+
+float
+PseudoNormalBaker::computeMeanLuma(const uint8_t* rgba, size_t pixelCount)
+{
+    return computeLuma(rgba, pixelCount, nullptr);
+}
+
+
+float
+PseudoNormalBaker::estimateValueOffset(float colorMeanLuma, float normalMeanLuma)
+{
+    // mean(COLOR_WEIGHT * color + normal) - mean(color), negated to bring the brightness back
+    return -(normalMeanLuma - (1.0f - COLOR_WEIGHT) * colorMeanLuma);
+}
+
+
+void
+PseudoNormalBaker::bake(uint8_t* rgba, int width, int height, const uint8_t* normalLuma, int normalWidth, int normalHeight)
+{
+    if (width <= 0 || height <= 0 || normalWidth <= 0 || normalHeight <= 0)
+    {
+        return;
+    }
+
+    const size_t rowSize = static_cast<size_t>(width) * 4;
+    uint64_t originalLumaSum = lumaRun(rgba, static_cast<size_t>(width) * height, nullptr);
+
+    // The normal map row matching each color row, resampled to the width of the color image
+    std::vector<uint8_t> normalRow(static_cast<size_t>(width));
+    std::vector<int> columns(static_cast<size_t>(width));
+    for (int x = 0; x < width; ++x)
+    {
+        columns[x] = static_cast<int>(static_cast<int64_t>(x) * normalWidth / width);
+    }
+
+    uint64_t combinedLumaSum = 0;
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* source = normalLuma + static_cast<size_t>(static_cast<int64_t>(y) * normalHeight / height) * normalWidth;
+        if (normalWidth == width)
+        {
+            std::copy(source, source + width, normalRow.begin());
+        }
+        else
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                normalRow[x] = source[columns[x]];
+            }
+        }
+        combinedLumaSum += combineRow(rgba + y * rowSize, normalRow.data(), width);
+    }
+
+    // Shift the value by the brightness the normal map added on average
+    double pixelCount = static_cast<double>(width) * height;
+    float valueOffset = static_cast<float>((static_cast<double>(originalLumaSum) - static_cast<double>(combinedLumaSum)) / pixelCount);
+    for (int y = 0; y < height; ++y)
+    {
+        adjustRow(rgba + y * rowSize, width, valueOffset);
+    }
+}
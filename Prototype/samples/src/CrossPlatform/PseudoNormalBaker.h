@@ -0,0 +1,52 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __PSEUDONORMALBAKER_H__
+#define __PSEUDONORMALBAKER_H__
+
+#include <cstddef>
+#include <cstdint>
+
+
+/// Pseudo normal mapping of a color texture, as done offline by generate_pseudonormal in Py-textures-processor
+/**
+ * The luma of the normal map is added to the weighted color, the HSV value of the result is shifted so that
+ * the mean brightness matches the original color again and the saturation is raised. The app normally
+ * applies this per fragment, see pseudoNormalFragmentShaderSrc, bake is the fallback for when that shader
+ * is not available. All images are RGBA8, the loops are vectorized with NEON on ARM.
+ */
+class PseudoNormalBaker
+{
+public:
+    /// Weight of the color when the normal map luma is added
+    static constexpr float COLOR_WEIGHT = 0.92f;
+    /// Factor applied to the saturation of the result
+    static constexpr float SATURATION = 3.0f;
+
+    /// Convert pixels to 8-bit luma with the ITU-R 601 weights used by the Python tool
+    /// Returns the mean luma in [0;1].
+    static float computeLuma(const uint8_t* rgba, size_t pixelCount, uint8_t* luma);
+
+    /// Mean luma of pixels in [0;1]
+    static float computeMeanLuma(const uint8_t* rgba, size_t pixelCount);
+
+    /// Shift of the HSV value in [-1;1] restoring the mean brightness of the color
+    /*
+     * Estimated from the mean lumas alone, ignoring pixels clipped when the normal map is added,
+     * bake computes the exact value instead.
+     */
+    static float estimateValueOffset(float colorMeanLuma, float normalMeanLuma);
+
+    /// Apply the pseudo normal mapping to a color image in place
+    /*
+     * normalLuma is the luma of the normal map from computeLuma. It may have a lower resolution
+     * than the color image, in which case it is sampled with the nearest pixel.
+     */
+    static void bake(uint8_t* rgba, int width, int height, const uint8_t* normalLuma, int normalWidth, int normalHeight);
+};
+
+#endif // __PSEUDONORMALBAKER_H__
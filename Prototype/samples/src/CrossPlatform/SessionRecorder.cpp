@@ -0,0 +1,306 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "SessionRecorder.h"
+
+#include "Log.h"
+
+#include <cstring>
+#include <ctime>
+
+
+SessionRecorder::~SessionRecorder()
+{
+    stop();
+    if (mImageList != nullptr)
+    {
+        vuImageListDestroy(mImageList);
+    }
+}
+
+
+bool
+SessionRecorder::start(VuEngine* engine, const std::string& directory, int cameraOrientation)
+{
+    stop();
+
+    char name[64];
+    time_t now = time(nullptr);
+    strftime(name, sizeof(name), "/session-%Y%m%d-%H%M%S", localtime(&now));
+    std::string path = directory + name + FrameRecording::EXTENSION;
+    if (!mWriter.open(path, cameraOrientation))
+    {
+        LOG("Failed to create the frame recording %s", path.c_str());
+        return false;
+    }
+
+    // The frame recording is all playback needs, the Vuforia recording is kept for Vuforia's tools
+    if (vuEngineGetSessionRecorderController(engine, &mController) == VU_SUCCESS)
+    {
+        auto config = vuRecordingConfigDefault();
+        if (vuSessionRecorderControllerGetDefaultRecordingDataFlags(mController, &config.dataFlags) != VU_SUCCESS)
+        {
+            config.dataFlags = VU_RECORDING_DATA_VIDEO_BIT | VU_RECORDING_DATA_CAMERA_METADATA_BIT;
+        }
+        config.outputDirectory = directory.c_str();
+        config.start = VU_TRUE;
+        VuRecordingCreationError creationError = VU_RECORDING_CREATION_ERROR_NONE;
+        if (vuSessionRecorderControllerCreateRecording(mController, &config, &mRecording, &creationError) != VU_SUCCESS)
+        {
+            LOG("Failed to start the Vuforia session recording: 0x%02x", creationError);
+            mRecording = nullptr;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mWriterThread = std::make_unique<WorkerPool>(1, "FrameRecorder");
+        mLastFrameIndex = -1;
+        mDroppedFrames = 0;
+        mWrittenFrames = 0;
+    }
+
+    LOG("Recording the session to %s", path.c_str());
+    return true;
+}
+
+
+void
+SessionRecorder::stop()
+{
+    std::unique_ptr<WorkerPool> writerThread;
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (mWriterThread == nullptr)
+        {
+            return;
+        }
+        mWritten.wait(lock, [this] { return mPendingFrames == 0; });
+        writerThread = std::move(mWriterThread);
+    }
+    writerThread.reset();
+    mWriter.close();
+
+    if (mRecording != nullptr)
+    {
+        const char* recordingPath = nullptr;
+        if (vuRecordingStop(mRecording) == VU_SUCCESS && vuRecordingGetPath(mRecording, &recordingPath) == VU_SUCCESS)
+        {
+            LOG("Vuforia session recording written to %s", recordingPath);
+        }
+        // The recording stays on disk, only the handle is released
+        vuRecordingDestroy(mRecording, VU_FALSE);
+        mRecording = nullptr;
+    }
+
+    LOG("Session recording stopped, %d frames written, %d dropped", mWrittenFrames, mDroppedFrames);
+}
+
+
+bool
+SessionRecorder::isRecording() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mWriterThread != nullptr;
+}
+
+
+void
+SessionRecorder::addFrame(const VuState* state, const VuMatrix44F& devicePose, VuObservationPoseStatus devicePoseStatus)
+{
+    VuCameraFrame* cameraFrame = nullptr;
+    int64_t frameIndex = 0;
+    int64_t timestamp = 0;
+    if (vuStateGetCameraFrame(state, &cameraFrame) != VU_SUCCESS || vuCameraFrameGetIndex(cameraFrame, &frameIndex) != VU_SUCCESS ||
+        vuCameraFrameGetTimestamp(cameraFrame, &timestamp) != VU_SUCCESS)
+    {
+        return;
+    }
+
+    std::unique_ptr<FrameRecording::Frame> frame;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mWriterThread == nullptr || frameIndex == mLastFrameIndex)
+        {
+            return;
+        }
+        mLastFrameIndex = frameIndex;
+        if (mPendingFrames == MAX_PENDING_FRAMES)
+        {
+            ++mDroppedFrames;
+            return;
+        }
+        if (mFreeFrames.empty())
+        {
+            frame = std::make_unique<FrameRecording::Frame>();
+        }
+        else
+        {
+            frame = std::move(mFreeFrames.back());
+            mFreeFrames.pop_back();
+        }
+    }
+
+    // The first image the driver can deliver as is, a camera frame may come in several formats
+    bool packed = false;
+    if (mImageList != nullptr || vuImageListCreate(&mImageList) == VU_SUCCESS)
+    {
+        int32_t imageCount = 0;
+        if (vuCameraFrameGetImages(cameraFrame, mImageList) == VU_SUCCESS && vuImageListGetSize(mImageList, &imageCount) == VU_SUCCESS)
+        {
+            for (int32_t i = 0; i < imageCount && !packed; ++i)
+            {
+                VuImage* image = nullptr;
+                VuImageInfo imageInfo;
+                packed = vuImageListGetElement(mImageList, i, &image) == VU_SUCCESS &&
+                         vuImageGetImageInfo(image, &imageInfo) == VU_SUCCESS && packImage(imageInfo, *frame);
+            }
+        }
+    }
+
+    VuCameraIntrinsics intrinsics;
+    if (packed && vuStateGetCameraIntrinsics(state, &intrinsics) == VU_SUCCESS)
+    {
+        frame->timestamp = static_cast<uint64_t>(timestamp);
+        frame->index = static_cast<uint32_t>(frameIndex);
+        memcpy(frame->focalLength, intrinsics.focalLength.data, sizeof(frame->focalLength));
+        memcpy(frame->principalPoint, intrinsics.principalPoint.data, sizeof(frame->principalPoint));
+        memcpy(frame->distortion, intrinsics.distortionParameters.data, sizeof(frame->distortion));
+        switch (devicePoseStatus)
+        {
+            case VU_OBSERVATION_POSE_STATUS_TRACKED:
+                frame->poseStatus = FrameRecording::PoseStatus::TRACKED;
+                break;
+            case VU_OBSERVATION_POSE_STATUS_EXTENDED_TRACKED:
+            case VU_OBSERVATION_POSE_STATUS_LIMITED:
+                frame->poseStatus = FrameRecording::PoseStatus::LIMITED;
+                break;
+            default:
+                frame->poseStatus = FrameRecording::PoseStatus::NONE;
+                break;
+        }
+        memcpy(frame->pose, devicePose.data, sizeof(frame->pose));
+    }
+    else
+    {
+        packed = false;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!packed || mWriterThread == nullptr)
+    {
+        mFreeFrames.push_back(std::move(frame));
+        return;
+    }
+    ++mPendingFrames;
+    // WorkerPool jobs must be copyable, the frame is owned by the job until writeFrame returns it
+    FrameRecording::Frame* pending = frame.release();
+    mWriterThread->submit([this, pending] { writeFrame(pending); });
+}
+
+
+bool
+SessionRecorder::packImage(const VuImageInfo& image, FrameRecording::Frame& frame)
+{
+    using PixelFormat = FrameRecording::PixelFormat;
+
+    PixelFormat format = PixelFormat::UNKNOWN;
+    switch (image.format)
+    {
+        case VU_IMAGE_PIXEL_FORMAT_NV21:
+            format = PixelFormat::NV21;
+            break;
+        case VU_IMAGE_PIXEL_FORMAT_NV12:
+            format = PixelFormat::NV12;
+            break;
+        case VU_IMAGE_PIXEL_FORMAT_YUV420P:
+            format = PixelFormat::YUV420P;
+            break;
+        case VU_IMAGE_PIXEL_FORMAT_YV12:
+            format = PixelFormat::YV12;
+            break;
+        case VU_IMAGE_PIXEL_FORMAT_YUYV:
+            format = PixelFormat::YUYV;
+            break;
+        case VU_IMAGE_PIXEL_FORMAT_RGB888:
+            format = PixelFormat::RGB888;
+            break;
+        case VU_IMAGE_PIXEL_FORMAT_RGBA8888:
+            format = PixelFormat::RGBA8888;
+            break;
+        default:
+            return false;
+    }
+    if (image.buffer == nullptr || image.width <= 0 || image.height <= 0 || image.bufferHeight < image.height)
+    {
+        return false;
+    }
+
+    // Planes after the first start after bufferHeight rows, the driver expects them right after height rows
+    const auto* source = static_cast<const uint8_t*>(image.buffer);
+    size_t stride = static_cast<size_t>(image.stride);
+    size_t height = static_cast<size_t>(image.height);
+    size_t lumaBytes = stride * height;
+    size_t sourceLumaBytes = stride * static_cast<size_t>(image.bufferHeight);
+    bool semiPlanar = format == PixelFormat::NV21 || format == PixelFormat::NV12;
+    bool planar = format == PixelFormat::YUV420P || format == PixelFormat::YV12;
+    size_t packedBytes = semiPlanar || planar ? lumaBytes + lumaBytes / 2 : lumaBytes;
+    size_t sourceBytes = lumaBytes;
+    if (semiPlanar)
+    {
+        sourceBytes = sourceLumaBytes + lumaBytes / 2;
+    }
+    else if (planar)
+    {
+        sourceBytes = sourceLumaBytes + sourceLumaBytes / 4 + lumaBytes / 4;
+    }
+    if (sourceBytes > static_cast<size_t>(image.bufferSize))
+    {
+        return false;
+    }
+
+    frame.pixels.resize(packedBytes);
+    uint8_t* target = frame.pixels.data();
+    memcpy(target, source, lumaBytes);
+    if (semiPlanar)
+    {
+        memcpy(target + lumaBytes, source + sourceLumaBytes, lumaBytes / 2);
+    }
+    else if (planar)
+    {
+        size_t chromaBytes = lumaBytes / 4;
+        size_t sourceChromaBytes = sourceLumaBytes / 4;
+        memcpy(target + lumaBytes, source + sourceLumaBytes, chromaBytes);
+        memcpy(target + lumaBytes + chromaBytes, source + sourceLumaBytes + sourceChromaBytes, chromaBytes);
+    }
+
+    frame.format = format;
+    frame.width = static_cast<uint32_t>(image.width);
+    frame.height = static_cast<uint32_t>(image.height);
+    frame.stride = static_cast<uint32_t>(image.stride);
+    return true;
+}
+
+
+void
+SessionRecorder::writeFrame(FrameRecording::Frame* frame)
+{
+    bool written = mWriter.write(*frame);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (written)
+    {
+        ++mWrittenFrames;
+    }
+    else
+    {
+        ++mDroppedFrames;
+    }
+    mFreeFrames.emplace_back(frame);
+    --mPendingFrames;
+    mWritten.notify_all();
+}
@@ -0,0 +1,81 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __SESSIONRECORDER_H__
+#define __SESSIONRECORDER_H__
+
+#include "FrameRecording.h"
+#include "WorkerPool.h"
+
+#include <VuforiaEngine/VuforiaEngine.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+/// Records an AR session for replaying it through the FileDriver
+/**
+ * Two recordings are made side by side in the output directory: a Vuforia session recording through
+ * the SessionRecorderController, the H.264 video with sensor data that Vuforia's own tools play back,
+ * and a FrameRecording of the uncompressed camera frames with their intrinsics and device poses, which
+ * is what the FileDriver replays. The frames are written on a thread of their own, a frame arriving
+ * while MAX_PENDING_FRAMES are still waiting to be written is dropped and counted.
+ */
+class SessionRecorder
+{
+public:
+    static constexpr int MAX_PENDING_FRAMES = 8;
+
+    SessionRecorder() = default;
+    ~SessionRecorder();
+
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+    /// Start recording into a directory that exists, the engine must be running
+    /// cameraOrientation is stored for playback, see FrameRecording::Writer::open.
+    bool start(VuEngine* engine, const std::string& directory, int cameraOrientation);
+
+    /// Stop both recordings, waits for the queued frames to be written
+    void stop();
+
+    bool isRecording() const;
+
+    /// Queue the camera frame of a state with the device pose extracted from it
+    /// Called for every state, a camera frame already recorded is skipped.
+    void addFrame(const VuState* state, const VuMatrix44F& devicePose, VuObservationPoseStatus devicePoseStatus);
+
+private:
+    /// Copy the planes of a camera image without padding rows, false for formats the driver cannot deliver
+    static bool packImage(const VuImageInfo& image, FrameRecording::Frame& frame);
+
+    /// Writer thread, takes the frame back to mFreeFrames once written
+    void writeFrame(FrameRecording::Frame* frame);
+
+    VuController* mController = nullptr;
+    VuRecording* mRecording = nullptr;
+
+    FrameRecording::Writer mWriter;
+    std::unique_ptr<WorkerPool> mWriterThread;
+    VuImageList* mImageList = nullptr;
+    int64_t mLastFrameIndex = -1;
+
+    /// Guards the frames between addFrame and the writer thread
+    mutable std::mutex mMutex;
+    std::condition_variable mWritten;
+    int mPendingFrames = 0;
+    int mDroppedFrames = 0;
+    int mWrittenFrames = 0;
+    /// Frames written before, reused for their pixel storage
+    std::vector<std::unique_ptr<FrameRecording::Frame>> mFreeFrames;
+};
+
+#endif /* __SESSIONRECORDER_H__ */
@@ -0,0 +1,71 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __SPSCQUEUE_H__
+#define __SPSCQUEUE_H__
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+
+/// Bounded lock-free queue from one producer thread to one consumer thread
+/**
+ * A ring of CAPACITY slots, CAPACITY must be a power of two. Both sides are wait-free: push fails
+ * when the ring is full instead of waiting for the consumer, pop fails when it is empty. The slots are
+ * default constructed once and assigned to, so nothing is allocated after construction.
+ * Each index is written by one side only, the other side reads it with acquire ordering, which makes
+ * the slot contents visible with it. The indices sit on separate cache lines so that the two sides do
+ * not invalidate each other's line on every call.
+ */
+template <typename T, size_t CAPACITY>
+class SpscQueue
+{
+public:
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "the capacity must be a power of two");
+
+    /// Producer side, returns false and drops value if the queue is full
+    bool push(T value)
+    {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHead.load(std::memory_order_acquire) == CAPACITY)
+        {
+            return false;
+        }
+        mSlots[tail & MASK] = std::move(value);
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer side, returns false if the queue is empty
+    bool pop(T& value)
+    {
+        size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        value = std::move(mSlots[head & MASK]);
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Either side, only a snapshot while the other side runs
+    bool isEmpty() const { return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire); }
+
+private:
+    static constexpr size_t MASK = CAPACITY - 1;
+    static constexpr size_t CACHE_LINE = 64;
+
+    /// Next slot to pop, written by the consumer
+    alignas(CACHE_LINE) std::atomic<size_t> mHead{ 0 };
+    /// Next slot to push, written by the producer
+    alignas(CACHE_LINE) std::atomic<size_t> mTail{ 0 };
+    alignas(CACHE_LINE) T mSlots[CAPACITY];
+};
+
+#endif /* __SPSCQUEUE_H__ */
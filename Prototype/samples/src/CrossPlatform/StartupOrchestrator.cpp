@@ -0,0 +1,306 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "StartupOrchestrator.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstdio>
+
+
+namespace
+{
+double
+toMilliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+
+double
+toMicroseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+
+const char*
+toString(bool succeeded)
+{
+    return succeeded ? "succeeded" : "failed";
+}
+} // namespace
+
+
+void
+StartupOrchestrator::reset()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTasks.clear();
+    mThreads.clear();
+    mTracePath.clear();
+    mStarted = false;
+    mComplete = false;
+}
+
+
+void
+StartupOrchestrator::addTask(const std::string& name, std::vector<std::string> dependencies)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    Task task;
+    task.name = name;
+    for (const auto& dependency : dependencies)
+    {
+        const Task* declared = find(dependency);
+        if (declared != nullptr)
+        {
+            task.dependencies.push_back(static_cast<size_t>(declared - mTasks.data()));
+        }
+    }
+    mTasks.push_back(std::move(task));
+}
+
+
+void
+StartupOrchestrator::start(Clock::time_point origin, std::string tracePath)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mOrigin = origin;
+        mTracePath = std::move(tracePath);
+        mStarted = true;
+    }
+    mCondition.notify_all();
+}
+
+
+bool
+StartupOrchestrator::run(const std::string& name, const std::function<bool()>& function)
+{
+    if (isFinished(name))
+    {
+        return function();
+    }
+    if (!begin(name))
+    {
+        return false;
+    }
+    bool succeeded = function();
+    end(name, succeeded);
+    return succeeded;
+}
+
+
+bool
+StartupOrchestrator::begin(const std::string& name)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    Task* task = find(name);
+    if (task == nullptr)
+    {
+        return false;
+    }
+
+    mCondition.wait(lock, [this, task]() {
+        return mStarted &&
+               std::all_of(task->dependencies.begin(), task->dependencies.end(), [this](size_t dependency) {
+                   return mTasks[dependency].state == State::SUCCEEDED || mTasks[dependency].state == State::FAILED;
+               });
+    });
+    if (task->state != State::PENDING)
+    {
+        return false;
+    }
+    if (!dependenciesSucceeded(*task))
+    {
+        LOG("Startup task %s skipped, a dependency failed", task->name.c_str());
+        task->startTime = Clock::now();
+        finish(*task, false);
+        return false;
+    }
+
+    auto thread = std::find(mThreads.begin(), mThreads.end(), std::this_thread::get_id());
+    if (thread == mThreads.end())
+    {
+        thread = mThreads.insert(thread, std::this_thread::get_id());
+    }
+    task->thread = static_cast<int>(thread - mThreads.begin());
+    task->state = State::RUNNING;
+    task->startTime = Clock::now();
+    return true;
+}
+
+
+void
+StartupOrchestrator::end(const std::string& name, bool succeeded)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        Task* task = find(name);
+        if (task == nullptr || task->state != State::RUNNING)
+        {
+            return;
+        }
+        finish(*task, succeeded);
+    }
+    mCondition.notify_all();
+}
+
+
+bool
+StartupOrchestrator::isReady(const std::string& name) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const Task* task = find(name);
+    return mStarted && task != nullptr && dependenciesSucceeded(*task);
+}
+
+
+bool
+StartupOrchestrator::isFinished(const std::string& name) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const Task* task = find(name);
+    return task != nullptr && (task->state == State::SUCCEEDED || task->state == State::FAILED);
+}
+
+
+bool
+StartupOrchestrator::isComplete() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mComplete;
+}
+
+
+StartupOrchestrator::Task*
+StartupOrchestrator::find(const std::string& name)
+{
+    auto task = std::find_if(mTasks.begin(), mTasks.end(), [&name](const Task& candidate) { return candidate.name == name; });
+    if (task == mTasks.end())
+    {
+        LOG("Unknown startup task %s", name.c_str());
+        return nullptr;
+    }
+    return &*task;
+}
+
+
+const StartupOrchestrator::Task*
+StartupOrchestrator::find(const std::string& name) const
+{
+    return const_cast<StartupOrchestrator*>(this)->find(name);
+}
+
+
+bool
+StartupOrchestrator::dependenciesSucceeded(const Task& task) const
+{
+    return std::all_of(task.dependencies.begin(), task.dependencies.end(),
+                       [this](size_t dependency) { return mTasks[dependency].state == State::SUCCEEDED; });
+}
+
+
+void
+StartupOrchestrator::finish(Task& task, bool succeeded)
+{
+    task.state = succeeded ? State::SUCCEEDED : State::FAILED;
+    task.endTime = Clock::now();
+
+    mComplete = std::all_of(mTasks.begin(), mTasks.end(),
+                            [](const Task& candidate) { return candidate.state == State::SUCCEEDED || candidate.state == State::FAILED; });
+    if (mComplete)
+    {
+        report();
+    }
+}
+
+
+void
+StartupOrchestrator::report() const
+{
+    // Walk back from the task that finished last through the dependency that finished last
+    auto last = std::max_element(mTasks.begin(), mTasks.end(), [](const Task& a, const Task& b) { return a.endTime < b.endTime; });
+    std::vector<size_t> criticalPath;
+    for (size_t index = static_cast<size_t>(last - mTasks.begin());;)
+    {
+        criticalPath.push_back(index);
+        const Task& task = mTasks[index];
+        if (task.dependencies.empty())
+        {
+            break;
+        }
+        index = *std::max_element(task.dependencies.begin(), task.dependencies.end(),
+                                  [this](size_t a, size_t b) { return mTasks[a].endTime < mTasks[b].endTime; });
+    }
+    std::reverse(criticalPath.begin(), criticalPath.end());
+
+    // One key=value record per line like the benchmark output, so that launches can be collected from logcat and compared
+    for (const auto& task : mTasks)
+    {
+        LOG("startup task=%s thread=%d start_ms=%.3f end_ms=%.3f duration_ms=%.3f state=%s", task.name.c_str(), task.thread,
+            toMilliseconds(task.startTime - mOrigin), toMilliseconds(task.endTime - mOrigin), toMilliseconds(task.endTime - task.startTime),
+            toString(task.state == State::SUCCEEDED));
+    }
+    std::string path;
+    Clock::time_point previousEnd = mOrigin;
+    for (size_t index : criticalPath)
+    {
+        const Task& task = mTasks[index];
+        LOG("startup critical task=%s wait_ms=%.3f duration_ms=%.3f", task.name.c_str(), toMilliseconds(task.startTime - previousEnd),
+            toMilliseconds(task.endTime - task.startTime));
+        previousEnd = task.endTime;
+        path += path.empty() ? task.name : ">" + task.name;
+    }
+    LOG("startup critical_path=%s total_ms=%.3f", path.c_str(), toMilliseconds(last->endTime - mOrigin));
+
+    if (!mTracePath.empty())
+    {
+        writeTrace(criticalPath);
+    }
+}
+
+
+void
+StartupOrchestrator::writeTrace(const std::vector<size_t>& criticalPath) const
+{
+    FILE* file = fopen(mTracePath.c_str(), "w");
+    if (file == nullptr)
+    {
+        LOG("Error writing startup trace %s", mTracePath.c_str());
+        return;
+    }
+
+    // Chrome trace event format, complete events in microseconds, the critical path in a category of its own
+    // Task names are identifiers chosen by the app and are written without escaping
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (size_t thread = 0; thread < mThreads.size(); ++thread)
+    {
+        fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"startup thread %zu\"}},\n", thread,
+                thread);
+    }
+    for (size_t index = 0; index < mTasks.size(); ++index)
+    {
+        const Task& task = mTasks[index];
+        bool critical = std::find(criticalPath.begin(), criticalPath.end(), index) != criticalPath.end();
+        fprintf(file,
+                "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.1f,\"dur\":%.1f,\"pid\":1,\"tid\":%d,"
+                "\"args\":{\"state\":\"%s\",\"critical\":%s}}%s\n",
+                task.name.c_str(), critical ? "critical" : "startup", toMicroseconds(task.startTime - mOrigin),
+                toMicroseconds(task.endTime - task.startTime), task.thread, toString(task.state == State::SUCCEEDED),
+                critical ? "true" : "false", index + 1 < mTasks.size() ? "," : "");
+    }
+    fprintf(file, "]}\n");
+    if (fclose(file) != 0)
+    {
+        LOG("Error writing startup trace %s", mTracePath.c_str());
+        return;
+    }
+    LOG("Startup trace written to %s", mTracePath.c_str());
+}
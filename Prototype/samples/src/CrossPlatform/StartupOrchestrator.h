@@ -0,0 +1,109 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __STARTUPORCHESTRATOR_H__
+#define __STARTUPORCHESTRATOR_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/// Runs the startup work of the app as named tasks with explicit dependencies and traces them
+/**
+ * The tasks are declared up front with addTask, then run by the threads the work belongs on:
+ * engine creation on the init thread, shader programs on the rendering thread and so on, so that
+ * independent work overlaps instead of running one after the other. run waits for the dependencies
+ * of a task, tasks finishing asynchronously are bracketed by begin and end instead. A task fails
+ * when its function returns false, the tasks depending on it then fail without running.
+ * Running a finished task again, e.g. after the app resumed, only calls its function.
+ *
+ * Times are relative to the origin passed to start, e.g. the process start. Once every task has
+ * finished the tasks and the critical path leading to the one that finished last are logged, and
+ * if a trace path is set written as a Chrome trace event file that Perfetto and chrome://tracing load.
+ * Reading from the log: the critical path lists the tasks that determined the total time, the wait
+ * before a task is time neither it nor its dependencies ran, e.g. its thread was busy elsewhere.
+ */
+class StartupOrchestrator
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Forget the tasks of an earlier startup, none of them may still be running or waited for
+    void reset();
+
+    /// Declare a task, the dependencies must have been declared before
+    void addTask(const std::string& name, std::vector<std::string> dependencies);
+
+    /// Start timing from origin, the tasks can run from now on
+    void start(Clock::time_point origin, std::string tracePath = std::string());
+
+    /// Wait for the dependencies and run function on the calling thread, returns false if it or a dependency failed
+    bool run(const std::string& name, const std::function<bool()>& function);
+
+    /// Wait for the dependencies and mark the task running, returns false if a dependency failed or it already ran
+    bool begin(const std::string& name);
+
+    /// Mark a task started with begin finished, ignored for tasks that are not running
+    void end(const std::string& name, bool succeeded = true);
+
+    /// True if every dependency of the task succeeded, can be polled by threads that must not wait
+    bool isReady(const std::string& name) const;
+
+    bool isFinished(const std::string& name) const;
+
+    /// True once every task has finished and the trace was reported
+    bool isComplete() const;
+
+private:
+    enum class State
+    {
+        PENDING,
+        RUNNING,
+        SUCCEEDED,
+        FAILED,
+    };
+
+    struct Task
+    {
+        std::string name;
+        std::vector<size_t> dependencies;
+        State state = State::PENDING;
+        Clock::time_point startTime;
+        Clock::time_point endTime;
+        /// Index of the thread the task ran on, in the order the threads first ran a task
+        int thread = 0;
+    };
+
+    /// The task called name, nullptr for unknown names, which are logged
+    Task* find(const std::string& name);
+    const Task* find(const std::string& name) const;
+
+    /// Every dependency finished, false if one failed
+    bool dependenciesSucceeded(const Task& task) const;
+
+    void finish(Task& task, bool succeeded);
+
+    /// Log the tasks and the critical path and write the trace file
+    void report() const;
+    void writeTrace(const std::vector<size_t>& criticalPath) const;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::vector<Task> mTasks;
+    std::vector<std::thread::id> mThreads;
+    Clock::time_point mOrigin;
+    std::string mTracePath;
+    bool mStarted = false;
+    bool mComplete = false;
+};
+
+#endif /* __STARTUPORCHESTRATOR_H__ */
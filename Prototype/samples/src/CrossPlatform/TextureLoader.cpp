@@ -0,0 +1,177 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "TextureLoader.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace
+{
+/// The 12 byte identifier every KTX 1.1 file starts with
+constexpr uint8_t KTX_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+/// Value of the endianness field when the file was written little-endian
+constexpr uint32_t KTX_ENDIANNESS = 0x04030201;
+
+/// Header following the identifier, see the KTX 1.1 specification
+struct KtxHeader
+{
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+static_assert(sizeof(KtxHeader) == 13 * sizeof(uint32_t), "KtxHeader must be tightly packed");
+
+/// Block size of the compressed formats the app can upload
+/*
+ * The GL enum values are spelled out so that this file does not depend on the GL headers,
+ * it is shared with the desktop tools.
+ */
+bool
+getBlockSize(uint32_t internalFormat, uint32_t& blockWidth, uint32_t& blockHeight, uint32_t& blockBytes)
+{
+    // ETC2 and EAC, core in OpenGL ES 3.0
+    switch (internalFormat)
+    {
+        case 0x9274: // GL_COMPRESSED_RGB8_ETC2
+        case 0x9275: // GL_COMPRESSED_SRGB8_ETC2
+        case 0x9276: // GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2
+        case 0x9277: // GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2
+            blockWidth = 4;
+            blockHeight = 4;
+            blockBytes = 8;
+            return true;
+        case 0x9278: // GL_COMPRESSED_RGBA8_ETC2_EAC
+        case 0x9279: // GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC
+            blockWidth = 4;
+            blockHeight = 4;
+            blockBytes = 16;
+            return true;
+        default:
+            break;
+    }
+
+    // ASTC LDR, GL_COMPRESSED_RGBA_ASTC_4x4_KHR to 12x12 and the matching sRGB formats
+    static const uint8_t ASTC_BLOCKS[14][2] = { { 4, 4 },  { 5, 4 },  { 5, 5 },  { 6, 5 },   { 6, 6 },   { 8, 5 },   { 8, 6 },
+                                                { 8, 8 },  { 10, 5 }, { 10, 6 }, { 10, 8 }, { 10, 10 }, { 12, 10 }, { 12, 12 } };
+    for (uint32_t first : { 0x93B0u, 0x93D0u })
+    {
+        if (internalFormat >= first && internalFormat < first + 14)
+        {
+            blockWidth = ASTC_BLOCKS[internalFormat - first][0];
+            blockHeight = ASTC_BLOCKS[internalFormat - first][1];
+            blockBytes = 16;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // anonymous namespace
+
+
+bool
+TextureLoader::parseKtx(const void* data, size_t size, CompressedTextureView& texture)
+{
+    if (data == nullptr || size < sizeof(KTX_IDENTIFIER) + sizeof(KtxHeader) ||
+        memcmp(data, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0)
+    {
+        LOG("Error loading compressed texture, not a KTX 1.1 file");
+        return false;
+    }
+
+    auto base = static_cast<const uint8_t*>(data);
+    KtxHeader header;
+    memcpy(&header, base + sizeof(KTX_IDENTIFIER), sizeof(header));
+    if (header.endianness != KTX_ENDIANNESS)
+    {
+        LOG("Error loading compressed texture, big-endian files are not supported");
+        return false;
+    }
+    if (header.glType != 0 || header.glFormat != 0)
+    {
+        LOG("Error loading compressed texture, the image is not compressed");
+        return false;
+    }
+    if (header.pixelDepth > 1 || header.numberOfArrayElements > 0 || header.numberOfFaces != 1)
+    {
+        LOG("Error loading compressed texture, only 2D textures are supported");
+        return false;
+    }
+    uint32_t blockWidth = 0;
+    uint32_t blockHeight = 0;
+    uint32_t blockBytes = 0;
+    if (!getBlockSize(header.glInternalFormat, blockWidth, blockHeight, blockBytes))
+    {
+        LOG("Error loading compressed texture, unsupported format 0x%x", header.glInternalFormat);
+        return false;
+    }
+    if (header.pixelWidth == 0 || header.pixelHeight == 0)
+    {
+        LOG("Error loading compressed texture, the image is empty");
+        return false;
+    }
+
+    size_t offset = sizeof(KTX_IDENTIFIER) + sizeof(KtxHeader);
+    if (header.bytesOfKeyValueData > size - offset)
+    {
+        LOG("Error loading compressed texture, key value data is corrupt");
+        return false;
+    }
+    offset += header.bytesOfKeyValueData;
+
+    // A level count of 0 asks for the chain to be generated at load time, which compressed data cannot do
+    uint32_t levelCount = std::max(header.numberOfMipmapLevels, 1u);
+
+    texture = CompressedTextureView();
+    texture.internalFormat = header.glInternalFormat;
+    texture.width = header.pixelWidth;
+    texture.height = header.pixelHeight;
+    texture.levels.reserve(levelCount);
+
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        uint32_t width = std::max(header.pixelWidth >> level, 1u);
+        uint32_t height = std::max(header.pixelHeight >> level, 1u);
+        size_t expectedSize =
+            static_cast<size_t>((width + blockWidth - 1) / blockWidth) * ((height + blockHeight - 1) / blockHeight) * blockBytes;
+
+        uint32_t imageSize = 0;
+        if (size - offset < sizeof(imageSize))
+        {
+            LOG("Error loading compressed texture, level %u is missing", level);
+            return false;
+        }
+        memcpy(&imageSize, base + offset, sizeof(imageSize));
+        offset += sizeof(imageSize);
+        if (imageSize != expectedSize || imageSize > size - offset)
+        {
+            LOG("Error loading compressed texture, level %u is corrupt", level);
+            return false;
+        }
+
+        texture.levels.push_back({ width, height, base + offset, imageSize });
+        // Every level is padded to 4 bytes
+        offset += (static_cast<size_t>(imageSize) + 3) & ~size_t(3);
+        offset = std::min(offset, size);
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __TEXTURELOADER_H__
+#define __TEXTURELOADER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/// Non-owning view of a block compressed texture
+/**
+ * The level pointers refer directly into the parsed file, the view is only valid
+ * while the file stays in memory.
+ */
+struct CompressedTextureView
+{
+    /// GL internal format of the compressed blocks, for example GL_COMPRESSED_RGB8_ETC2
+    uint32_t internalFormat{ 0 };
+    /// Size of the base level in pixels
+    uint32_t width{ 0 };
+    uint32_t height{ 0 };
+
+    /// One mip level, level 0 is the base level
+    struct Level
+    {
+        uint32_t width;
+        uint32_t height;
+        const void* data;
+        uint32_t size;
+    };
+    std::vector<Level> levels;
+};
+
+
+/// Platform-independent loading of pre-compressed textures
+class TextureLoader
+{
+public:
+    /// Parse a KTX 1.1 file held in memory
+    /*
+     * Only the subset written by Tools/TextureCompressor is accepted: a single compressed 2D
+     * image without array elements or cube faces, stored little-endian. The rows are expected
+     * bottom-up as GL wants them, the compressor flips the source image before encoding.
+     */
+    static bool parseKtx(const void* data, size_t size, CompressedTextureView& texture);
+};
+
+#endif // __TEXTURELOADER_H__
@@ -0,0 +1,100 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "ThermalGovernor.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+ThermalGovernor::ThermalGovernor()
+{
+    setConfig(Config());
+}
+
+
+ThermalGovernor::ThermalGovernor(const Config& config)
+{
+    setConfig(config);
+}
+
+
+void
+ThermalGovernor::setConfig(const Config& config)
+{
+    mConfig = config;
+    if (mConfig.levels.empty())
+    {
+        mConfig.levels.push_back({ VU_CAMERA_VIDEO_MODE_PRESET_DEFAULT, 1.0f, 0 });
+    }
+    mConfig.startLevel = std::min(std::max(mConfig.startLevel, 0), static_cast<int>(mConfig.levels.size()) - 1);
+    mConfig.frameTimeSmoothing = std::min(std::max(mConfig.frameTimeSmoothing, 0.001f), 1.0f);
+    reset();
+}
+
+
+void
+ThermalGovernor::reset()
+{
+    mLevel = mConfig.startLevel;
+    mAverageFrameMilliseconds = 0.0f;
+    mHotSince = -1.0;
+    mCoolSince = -1.0;
+    mReason = "";
+}
+
+
+bool
+ThermalGovernor::update(double seconds, Status status, float headroom, float frameMilliseconds)
+{
+    mAverageFrameMilliseconds += mConfig.frameTimeSmoothing * (frameMilliseconds - mAverageFrameMilliseconds);
+
+    const Level& level = getLevel();
+    float budget = level.frameRateCap > 0 ? 1000.0f / level.frameRateCap : mConfig.frameBudgetMilliseconds;
+    bool hasHeadroom = !std::isnan(headroom);
+
+    const char* hotReason = nullptr;
+    if (status != Status::UNKNOWN && status >= mConfig.throttleStatus)
+    {
+        hotReason = "thermal status";
+    }
+    else if (hasHeadroom && headroom >= mConfig.throttleHeadroom)
+    {
+        hotReason = "thermal headroom";
+    }
+    else if (mAverageFrameMilliseconds > budget)
+    {
+        hotReason = "frame time over budget";
+    }
+    bool cool = hotReason == nullptr && (status == Status::UNKNOWN || status <= mConfig.recoverStatus) &&
+                (!hasHeadroom || headroom <= mConfig.recoverHeadroom) &&
+                mAverageFrameMilliseconds < budget * mConfig.recoverBudgetFraction;
+
+    mHotSince = hotReason != nullptr ? (mHotSince < 0.0 ? seconds : mHotSince) : -1.0;
+    mCoolSince = cool ? (mCoolSince < 0.0 ? seconds : mCoolSince) : -1.0;
+
+    int lastLevel = static_cast<int>(mConfig.levels.size()) - 1;
+    if (mHotSince >= 0.0 && seconds - mHotSince >= mConfig.throttleHoldSeconds && mLevel < lastLevel)
+    {
+        ++mLevel;
+        mReason = hotReason;
+    }
+    else if (mCoolSince >= 0.0 && seconds - mCoolSince >= mConfig.recoverHoldSeconds && mLevel > 0)
+    {
+        --mLevel;
+        mReason = "cooled down";
+    }
+    else
+    {
+        return false;
+    }
+
+    // Each level is held for at least the hold time before the next step
+    mHotSince = -1.0;
+    mCoolSince = -1.0;
+    return true;
+}
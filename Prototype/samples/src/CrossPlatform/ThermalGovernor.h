@@ -0,0 +1,105 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __THERMALGOVERNOR_H__
+#define __THERMALGOVERNOR_H__
+
+#include <VuforiaEngine/VuforiaEngine.h>
+
+#include <vector>
+
+
+/// Steps through levels of lower power use as the device heats up or misses its frame budget
+/**
+ * Each level pairs a camera video mode with a cap on the augmentation render scale and on the frame
+ * rate, from level 0, which costs the most, to the last level, which costs the least. The governor
+ * throttles by one level once the device has been hot for throttleHoldSeconds, hot meaning the thermal
+ * status or the thermal headroom reached their thresholds or the average frame time exceeds the frame
+ * budget. It recovers by one level once everything has been below the lower thresholds for the longer
+ * recoverHoldSeconds, so that it does not oscillate between two levels as the device cools.
+ */
+class ThermalGovernor
+{
+public:
+    /// Thermal status of the platform, the levels of AThermalStatus on Android up to CRITICAL
+    enum class Status
+    {
+        UNKNOWN = -1,
+        NONE,
+        LIGHT,
+        MODERATE,
+        SEVERE,
+        CRITICAL,
+    };
+
+    struct Level
+    {
+        VuCameraVideoModePreset cameraVideoMode;
+        /// Largest resolution scale of the augmentations, see DynamicResolution
+        float maxRenderScale;
+        /// Frames per second, 0 for no cap
+        int frameRateCap;
+    };
+
+    struct Config
+    {
+        std::vector<Level> levels{
+            { VU_CAMERA_VIDEO_MODE_PRESET_OPTIMIZE_QUALITY, 1.0f, 0 }, { VU_CAMERA_VIDEO_MODE_PRESET_DEFAULT, 1.0f, 0 },
+            { VU_CAMERA_VIDEO_MODE_PRESET_DEFAULT, 0.75f, 0 },         { VU_CAMERA_VIDEO_MODE_PRESET_OPTIMIZE_SPEED, 0.75f, 30 },
+            { VU_CAMERA_VIDEO_MODE_PRESET_OPTIMIZE_SPEED, 0.5f, 30 },
+        };
+        int startLevel = 1;
+
+        /// Hot at or above the status or the headroom, a headroom of 1 is where the platform starts to throttle
+        Status throttleStatus = Status::MODERATE;
+        float throttleHeadroom = 0.9f;
+        /// Cool at or below these
+        Status recoverStatus = Status::NONE;
+        float recoverHeadroom = 0.7f;
+
+        /// Frame time of an uncapped level, a capped level has the period of its cap
+        float frameBudgetMilliseconds = 16.7f;
+        /// Fraction of the frame budget the average must stay below to count as cool
+        float recoverBudgetFraction = 0.75f;
+        /// Smoothing factor of the frame time average per frame
+        float frameTimeSmoothing = 0.05f;
+
+        float throttleHoldSeconds = 5.0f;
+        float recoverHoldSeconds = 60.0f;
+    };
+
+    ThermalGovernor();
+    explicit ThermalGovernor(const Config& config);
+
+    /// Replace the configuration, the governor restarts at startLevel
+    void setConfig(const Config& config);
+    const Config& getConfig() const { return mConfig; }
+
+    /// Return to startLevel
+    void reset();
+
+    /// Add the thermal state and the time of a frame, returns true if the level changed
+    /// The headroom is NaN where the platform does not report it. Times are seconds of a monotonic clock.
+    bool update(double seconds, Status status, float headroom, float frameMilliseconds);
+
+    int getLevelIndex() const { return mLevel; }
+    const Level& getLevel() const { return mConfig.levels[mLevel]; }
+
+    /// Why the last change of level happened, for logging
+    const char* getReason() const { return mReason; }
+
+private:
+    Config mConfig;
+    int mLevel = 0;
+    float mAverageFrameMilliseconds = 0.0f;
+    /// Start of the current hot or cool period, negative if there is none
+    double mHotSince = -1.0;
+    double mCoolSince = -1.0;
+    const char* mReason = "";
+};
+
+#endif /* __THERMALGOVERNOR_H__ */
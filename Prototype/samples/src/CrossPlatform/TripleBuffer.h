@@ -0,0 +1,70 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __TRIPLEBUFFER_H__
+#define __TRIPLEBUFFER_H__
+
+#include <atomic>
+
+
+/// Lock-free hand-over of the latest value from one producer thread to one consumer thread
+/**
+ * The producer fills the write buffer and publishes it, the consumer picks up the most recently
+ * published buffer. Neither side ever waits: the buffer between them is swapped with a single atomic
+ * exchange, a value published again before the consumer picked it up replaces it.
+ * The buffers are reused, so a buffer returned by getWriteBuffer still holds an older value,
+ * either one the consumer has finished with or one it never picked up.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+    static constexpr int BUFFER_COUNT = 3;
+
+    /// Producer side, the buffer to fill before calling publish
+    T& getWriteBuffer() { return mBuffers[mWriteIndex]; }
+
+    /// Producer side, hand the write buffer to the consumer and get another one to write
+    void publish()
+    {
+        int previous = mMiddle.exchange(mWriteIndex | FRESH_BIT, std::memory_order_acq_rel);
+        mWriteIndex = previous & INDEX_MASK;
+    }
+
+    /// Consumer side, switch to the most recently published buffer
+    /// Returns false and keeps the current read buffer if nothing was published since the last call.
+    bool update()
+    {
+        if ((mMiddle.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+        {
+            return false;
+        }
+        int previous = mMiddle.exchange(mReadIndex, std::memory_order_acq_rel);
+        mReadIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    /// Consumer side, the buffer picked up by the last successful update
+    T& getReadBuffer() { return mBuffers[mReadIndex]; }
+    const T& getReadBuffer() const { return mBuffers[mReadIndex]; }
+
+    /// All buffers, only to be used while neither side is running
+    T* getBuffers() { return mBuffers; }
+
+private:
+    static constexpr int INDEX_MASK = 0x3;
+    static constexpr int FRESH_BIT = 0x4;
+
+    T mBuffers[BUFFER_COUNT]{};
+    /// Index of the buffer between producer and consumer, with FRESH_BIT set if it was published
+    /// and not picked up yet
+    std::atomic<int> mMiddle{ 1 };
+    int mWriteIndex = 0;
+    int mReadIndex = 2;
+};
+
+#endif /* __TRIPLEBUFFER_H__ */
@@ -0,0 +1,471 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "VertexShadingBaker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+/// Triangles per leaf of the bounding volume hierarchy
+constexpr int LEAF_TRIANGLES = 4;
+/// Deepest the hierarchy gets with median splits of any mesh the app can hold
+constexpr int MAX_DEPTH = 64;
+/// Vertices a worker bakes before taking the next batch
+constexpr int BATCH_VERTICES = 256;
+/// Offset of ray origins along the normal, as a fraction of the bounding radius, so that rays miss their own triangles
+constexpr float ORIGIN_OFFSET = 1e-4f;
+constexpr float PI = 3.14159265358979f;
+
+struct Vec3
+{
+    float x, y, z;
+};
+
+inline Vec3
+operator-(const Vec3& a, const Vec3& b)
+{
+    return { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+inline Vec3
+operator+(const Vec3& a, const Vec3& b)
+{
+    return { a.x + b.x, a.y + b.y, a.z + b.z };
+}
+
+inline Vec3
+operator*(const Vec3& a, float s)
+{
+    return { a.x * s, a.y * s, a.z * s };
+}
+
+inline float
+dot(const Vec3& a, const Vec3& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline Vec3
+cross(const Vec3& a, const Vec3& b)
+{
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+inline float
+component(const Vec3& v, int axis)
+{
+    return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+}
+
+struct Triangle
+{
+    Vec3 v0;
+    Vec3 edge1;
+    Vec3 edge2;
+};
+
+struct Node
+{
+    Vec3 min;
+    Vec3 max;
+    /// Index of the first child for inner nodes, the second one follows it, or of the first triangle for leaves
+    uint32_t first;
+    /// Triangles of a leaf, 0 for inner nodes
+    uint32_t count;
+};
+
+/// Bounding volume hierarchy over the triangles, split at the median centroid along the longest axis
+class Bvh
+{
+public:
+    explicit Bvh(std::vector<Triangle> triangles) : mTriangles(std::move(triangles))
+    {
+        std::vector<uint32_t> order(mTriangles.size());
+        std::vector<Vec3> centroids(mTriangles.size());
+        for (size_t i = 0; i < mTriangles.size(); ++i)
+        {
+            order[i] = static_cast<uint32_t>(i);
+            const Triangle& t = mTriangles[i];
+            centroids[i] = t.v0 + (t.edge1 + t.edge2) * (1.0f / 3.0f);
+        }
+        mNodes.reserve(2 * mTriangles.size() / LEAF_TRIANGLES + 1);
+        mNodes.push_back(Node());
+        build(0, order, centroids, 0, static_cast<uint32_t>(order.size()), 0);
+
+        // Store the triangles in leaf order
+        std::vector<Triangle> sorted(mTriangles.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            sorted[i] = mTriangles[order[i]];
+        }
+        mTriangles.swap(sorted);
+    }
+
+    /// True if the ray hits any triangle closer than maxDistance
+    bool isOccluded(const Vec3& origin, const Vec3& direction, float maxDistance) const
+    {
+        Vec3 inverse = { 1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z };
+        uint32_t stack[MAX_DEPTH];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node& node = mNodes[stack[--top]];
+            if (!hitsBox(node, origin, inverse, maxDistance))
+            {
+                continue;
+            }
+            if (node.count == 0)
+            {
+                stack[top++] = node.first;
+                stack[top++] = node.first + 1;
+                continue;
+            }
+            for (uint32_t i = node.first; i < node.first + node.count; ++i)
+            {
+                if (hitsTriangle(mTriangles[i], origin, direction, maxDistance))
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+private:
+    void build(uint32_t nodeIndex, std::vector<uint32_t>& order, const std::vector<Vec3>& centroids, uint32_t begin, uint32_t end,
+               int depth)
+    {
+        Node node;
+        node.min = node.max = mTriangles[order[begin]].v0;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const Triangle& t = mTriangles[order[i]];
+            for (const Vec3& p : { t.v0, t.v0 + t.edge1, t.v0 + t.edge2 })
+            {
+                node.min = { std::min(node.min.x, p.x), std::min(node.min.y, p.y), std::min(node.min.z, p.z) };
+                node.max = { std::max(node.max.x, p.x), std::max(node.max.y, p.y), std::max(node.max.z, p.z) };
+            }
+        }
+
+        // The stack of isOccluded holds at most one pending sibling per level
+        if (end - begin <= LEAF_TRIANGLES || depth >= MAX_DEPTH - 2)
+        {
+            node.first = begin;
+            node.count = end - begin;
+            mNodes[nodeIndex] = node;
+            return;
+        }
+
+        Vec3 extent = node.max - node.min;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        uint32_t middle = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                         [&centroids, axis](uint32_t a, uint32_t b) { return component(centroids[a], axis) < component(centroids[b], axis); });
+
+        node.first = static_cast<uint32_t>(mNodes.size());
+        node.count = 0;
+        mNodes[nodeIndex] = node;
+        mNodes.push_back(Node());
+        mNodes.push_back(Node());
+        build(node.first, order, centroids, begin, middle, depth + 1);
+        build(node.first + 1, order, centroids, middle, end, depth + 1);
+    }
+
+    static bool hitsBox(const Node& node, const Vec3& origin, const Vec3& inverse, float maxDistance)
+    {
+        float entry = 0.0f;
+        float exit = maxDistance;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float o = component(origin, axis);
+            float d = component(inverse, axis);
+            float t0 = (component(node.min, axis) - o) * d;
+            float t1 = (component(node.max, axis) - o) * d;
+            if (t0 > t1)
+            {
+                std::swap(t0, t1);
+            }
+            entry = std::max(entry, t0);
+            exit = std::min(exit, t1);
+        }
+        return entry <= exit;
+    }
+
+    /// Moeller-Trumbore ray triangle intersection, both faces count
+    static bool hitsTriangle(const Triangle& triangle, const Vec3& origin, const Vec3& direction, float maxDistance)
+    {
+        Vec3 p = cross(direction, triangle.edge2);
+        float determinant = dot(triangle.edge1, p);
+        if (std::fabs(determinant) < 1e-12f)
+        {
+            return false;
+        }
+        float inverse = 1.0f / determinant;
+        Vec3 s = origin - triangle.v0;
+        float u = dot(s, p) * inverse;
+        if (u < 0.0f || u > 1.0f)
+        {
+            return false;
+        }
+        Vec3 q = cross(s, triangle.edge1);
+        float v = dot(direction, q) * inverse;
+        if (v < 0.0f || u + v > 1.0f)
+        {
+            return false;
+        }
+        float t = dot(triangle.edge2, q) * inverse;
+        return t > 0.0f && t < maxDistance;
+    }
+
+    std::vector<Triangle> mTriangles;
+    std::vector<Node> mNodes;
+};
+
+
+/// Full resolution triangles of a mesh as vertex indices, the first level of detail if the mesh has any
+std::vector<uint32_t>
+getTriangleIndices(const MeshData& mesh)
+{
+    size_t total = mesh.shortIndices.empty() ? mesh.indices.size() : mesh.shortIndices.size();
+    size_t first = 0;
+    size_t count = total;
+    if (total == 0)
+    {
+        count = static_cast<size_t>(mesh.vertexCount);
+    }
+    else if (!mesh.lods.empty())
+    {
+        first = mesh.lods[0].firstIndex;
+        count = std::min<size_t>(mesh.lods[0].indexCount, total - std::min(first, total));
+    }
+
+    std::vector<uint32_t> result(count - count % 3);
+    for (size_t i = 0; i < result.size(); ++i)
+    {
+        size_t index = first + i;
+        result[i] = total == 0 ? static_cast<uint32_t>(index)
+                               : mesh.shortIndices.empty() ? mesh.indices[index] : mesh.shortIndices[index];
+    }
+    return result;
+}
+
+
+/// Index of the first vertex with the same position for every vertex
+std::vector<uint32_t>
+getPositionGroups(const MeshData& mesh)
+{
+    std::vector<uint32_t> order(static_cast<size_t>(mesh.vertexCount));
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    const float* positions = mesh.positions.data();
+    auto less = [positions](uint32_t a, uint32_t b) {
+        return std::lexicographical_compare(positions + 3 * a, positions + 3 * a + 3, positions + 3 * b, positions + 3 * b + 3);
+    };
+    std::sort(order.begin(), order.end(), less);
+
+    std::vector<uint32_t> groups(order.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        bool same = i > 0 && memcmp(positions + 3 * order[i], positions + 3 * order[i - 1], 3 * sizeof(float)) == 0;
+        groups[order[i]] = same ? groups[order[i - 1]] : order[i];
+    }
+    return groups;
+}
+
+
+/// Radical inverse in base 2, the second coordinate of the Hammersley points
+inline float
+radicalInverse(uint32_t bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return bits * 2.3283064365386963e-10f;
+}
+
+
+/// Hash of a vertex index into [0;1), decorrelates the sample points of neighbouring vertices
+inline float
+hashToUnit(uint32_t value)
+{
+    value ^= value >> 16u;
+    value *= 0x7FEB352Du;
+    value ^= value >> 15u;
+    value *= 0x846CA68Bu;
+    value ^= value >> 16u;
+    return (value >> 8u) * (1.0f / 16777216.0f);
+}
+
+
+/// Fraction of the cosine-weighted hemisphere around normal that is open within maxDistance
+float
+computeOpenness(const Bvh& bvh, const Vec3& position, const Vec3& normal, uint32_t seed, const VertexShadingBaker::Options& options,
+                float maxDistance, float offset)
+{
+    // Orthonormal basis around the normal, Frisvad's construction
+    Vec3 tangent;
+    Vec3 bitangent;
+    if (normal.z < -0.9999999f)
+    {
+        tangent = { 0.0f, -1.0f, 0.0f };
+        bitangent = { -1.0f, 0.0f, 0.0f };
+    }
+    else
+    {
+        float a = 1.0f / (1.0f + normal.z);
+        float b = -normal.x * normal.y * a;
+        tangent = { 1.0f - normal.x * normal.x * a, b, -normal.x };
+        bitangent = { b, 1.0f - normal.y * normal.y * a, -normal.y };
+    }
+
+    // Hammersley points rotated per vertex, stratified over the hemisphere without a shared pattern between vertices
+    float shiftU = hashToUnit(seed * 2u);
+    float shiftV = hashToUnit(seed * 2u + 1u);
+    Vec3 origin = position + normal * offset;
+    int open = 0;
+    for (int ray = 0; ray < options.rayCount; ++ray)
+    {
+        float u = (ray + 0.5f) / options.rayCount + shiftU;
+        float v = radicalInverse(static_cast<uint32_t>(ray)) + shiftV;
+        u -= std::floor(u);
+        v -= std::floor(v);
+        float r = std::sqrt(u);
+        float phi = 2.0f * PI * v;
+        Vec3 direction = tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + normal * std::sqrt(std::max(0.0f, 1.0f - u));
+        if (!bvh.isOccluded(origin, direction, maxDistance))
+        {
+            ++open;
+        }
+    }
+    return static_cast<float>(open) / options.rayCount;
+}
+} // namespace
+
+
+bool
+VertexShadingBaker::bake(MeshData& mesh, const Options& options, int threadCount)
+{
+    if (mesh.vertexCount <= 0 || mesh.positions.size() < static_cast<size_t>(mesh.vertexCount) * 3)
+    {
+        return false;
+    }
+    std::vector<uint32_t> indices = getTriangleIndices(mesh);
+    if (indices.empty())
+    {
+        return false;
+    }
+
+    auto position = [&mesh](uint32_t vertex) {
+        const float* p = &mesh.positions[3 * static_cast<size_t>(vertex)];
+        return Vec3{ p[0], p[1], p[2] };
+    };
+
+    // Face normals weighted by the angle of each corner and summed per position, so that neither the tessellation
+    // nor seams show in the shading
+    std::vector<uint32_t> groups = getPositionGroups(mesh);
+    std::vector<Vec3> normals(static_cast<size_t>(mesh.vertexCount), Vec3{ 0.0f, 0.0f, 0.0f });
+    std::vector<Triangle> triangles;
+    triangles.reserve(indices.size() / 3);
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        Vec3 corners[3] = { position(indices[i]), position(indices[i + 1]), position(indices[i + 2]) };
+        Vec3 edge1 = corners[1] - corners[0];
+        Vec3 edge2 = corners[2] - corners[0];
+        Vec3 faceNormal = cross(edge1, edge2);
+        float area = std::sqrt(dot(faceNormal, faceNormal));
+        if (area == 0.0f)
+        {
+            continue;
+        }
+        faceNormal = faceNormal * (1.0f / area);
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            Vec3 a = corners[(corner + 1) % 3] - corners[corner];
+            Vec3 b = corners[(corner + 2) % 3] - corners[corner];
+            float angle = std::atan2(std::sqrt(dot(cross(a, b), cross(a, b))), dot(a, b));
+            Vec3& normal = normals[groups[indices[i + corner]]];
+            normal = normal + faceNormal * angle;
+        }
+        triangles.push_back({ corners[0], edge1, edge2 });
+    }
+    if (triangles.empty())
+    {
+        return false;
+    }
+    Bvh bvh(std::move(triangles));
+
+    Vec3 light = { options.lightDirection[0], options.lightDirection[1], options.lightDirection[2] };
+    float lightLength = std::sqrt(dot(light, light));
+    light = lightLength > 0.0f ? light * (1.0f / lightLength) : Vec3{ 0.0f, 1.0f, 0.0f };
+    float ambient = std::min(std::max(options.ambient, 0.0f), 1.0f);
+
+    if (mesh.bounds.radius <= 0.0f)
+    {
+        MeshLoader::computeBounds(mesh);
+    }
+    float maxDistance = options.radiusFraction * mesh.bounds.radius;
+    float offset = ORIGIN_OFFSET * mesh.bounds.radius;
+
+    mesh.shades.assign(static_cast<size_t>(mesh.vertexCount), 255);
+    std::atomic<int> nextBatch{ 0 };
+    auto worker = [&]() {
+        for (;;)
+        {
+            int begin = nextBatch.fetch_add(BATCH_VERTICES);
+            if (begin >= mesh.vertexCount)
+            {
+                return;
+            }
+            int end = std::min(begin + BATCH_VERTICES, mesh.vertexCount);
+            for (int vertex = begin; vertex < end; ++vertex)
+            {
+                Vec3 normal = normals[groups[vertex]];
+                float length = std::sqrt(dot(normal, normal));
+                if (length == 0.0f)
+                {
+                    // Not part of any triangle, left fully lit
+                    continue;
+                }
+                normal = normal * (1.0f / length);
+                // Vertices at the same position share the seed as well, so that they get the same shade
+                float openness = options.rayCount > 0 ? computeOpenness(bvh, position(static_cast<uint32_t>(vertex)), normal, groups[vertex],
+                                                                        options, maxDistance, offset)
+                                                      : 1.0f;
+                float lighting = ambient + (1.0f - ambient) * std::max(dot(normal, light), 0.0f);
+                mesh.shades[vertex] = static_cast<uint8_t>(std::lround(std::min(openness * lighting, 1.0f) * 255.0f));
+            }
+        }
+    };
+
+    if (threadCount <= 0)
+    {
+        threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; ++i)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    return true;
+}
@@ -0,0 +1,45 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __VERTEXSHADINGBAKER_H__
+#define __VERTEXSHADINGBAKER_H__
+
+#include "MeshLoader.h"
+
+
+/// Offline baking of ambient occlusion and a directional lighting term into one byte per vertex
+/**
+ * Run by the MeshConverter tool on the float positions of a mesh, before generateLods and quantize.
+ * The occlusion of a vertex is the fraction of cosine-weighted rays over the hemisphere of its normal
+ * that leave the mesh within radius, the light term is a Lambert term towards lightDirection on top of
+ * the ambient level. Both are multiplied into MeshData::shades, which the shaded shader variants
+ * multiply with the texture color instead of evaluating any lighting per fragment.
+ *
+ * Normals are averaged per position rather than per vertex so that vertices split along texture seams
+ * get the same shade, and rays are traced against a bounding volume hierarchy of the triangles on
+ * threadCount threads, 0 uses one per hardware thread.
+ */
+class VertexShadingBaker
+{
+public:
+    struct Options
+    {
+        /// Occlusion rays per vertex
+        int rayCount = 64;
+        /// Longest ray as a fraction of the bounding radius of the mesh, occluders further away are ignored
+        float radiusFraction = 0.25f;
+        /// Direction towards the light in model space, normalized by bake
+        float lightDirection[3] = { 0.3f, 1.0f, 0.5f };
+        /// Light reaching surfaces facing away from the light, 1 bakes the occlusion alone
+        float ambient = 0.4f;
+    };
+
+    /// Fill mesh.shades, returns false if the mesh has no float positions or no triangles
+    static bool bake(MeshData& mesh, const Options& options, int threadCount = 0);
+};
+
+#endif // __VERTEXSHADINGBAKER_H__
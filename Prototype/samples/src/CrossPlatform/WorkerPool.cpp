@@ -0,0 +1,89 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <string>
+
+#if defined(__ANDROID__) || defined(__linux__)
+#include <pthread.h>
+#endif
+
+
+WorkerPool::WorkerPool(int threadCount, const char* name)
+{
+    threadCount = std::max(threadCount, 1);
+    mThreads.reserve(threadCount);
+    for (int i = 0; i < threadCount; ++i)
+    {
+        mThreads.emplace_back(&WorkerPool::run, this);
+#if defined(__ANDROID__) || defined(__linux__)
+        // Thread names are limited to 15 characters
+        std::string threadName = std::string(name).substr(0, 12) + "-" + std::to_string(i);
+        pthread_setname_np(mThreads.back().native_handle(), threadName.c_str());
+#else
+        (void)name;
+#endif
+    }
+}
+
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+        mJobs.clear();
+    }
+    mCondition.notify_all();
+    for (auto& thread : mThreads)
+    {
+        thread.join();
+    }
+}
+
+
+void
+WorkerPool::submit(Job job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJobs.push_back(std::move(job));
+    }
+    mCondition.notify_one();
+}
+
+
+int
+WorkerPool::defaultThreadCount()
+{
+    // Leave room for the UI, rendering and Vuforia tracking threads
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    return std::max(1, std::min(cores - 2, 3));
+}
+
+
+void
+WorkerPool::run()
+{
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mStopping || !mJobs.empty(); });
+            if (mStopping)
+            {
+                return;
+            }
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+        }
+        job();
+    }
+}
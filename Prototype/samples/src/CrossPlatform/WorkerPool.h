@@ -0,0 +1,52 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+#ifndef __WORKERPOOL_H__
+#define __WORKERPOOL_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/// A small fixed-size pool of threads executing jobs in submission order
+/**
+ * Used to move asset parsing and decoding off the rendering thread.
+ * Jobs still queued when the pool is destroyed are discarded, running jobs are completed.
+ */
+class WorkerPool
+{
+public:
+    using Job = std::function<void()>;
+
+    /// Start threadCount worker threads, name is used for the threads to ease profiling
+    WorkerPool(int threadCount, const char* name);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /// Queue a job for execution on one of the worker threads
+    void submit(Job job);
+
+    /// Number of threads to use for a pool sharing the device with the rendering and tracking threads
+    static int defaultThreadCount();
+
+private:
+    void run();
+
+    std::vector<std::thread> mThreads;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<Job> mJobs;
+    bool mStopping = false;
+};
+
+#endif // __WORKERPOOL_H__
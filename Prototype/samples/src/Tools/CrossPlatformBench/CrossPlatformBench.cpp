@@ -0,0 +1,469 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+// Headless micro-benchmarks of the CrossPlatform code the app runs at load time and every frame
+//
+// Usage: CrossPlatformBench [--assets <dir>] [--filter <text>] [--runs <count>] [--output <file>]
+//
+// --assets  directory holding the ImageTargets and ModelTargets models, the Assets directory of the source tree by default
+// --filter  only run the benchmarks whose name or input contains text, e.g. --filter loadObj or --filter plane.obj
+// --runs    runs of every benchmark, the best and median times are reported (default 5)
+// --output  file the results are written to instead of stdout, MeshLoader logs its warnings to stdout
+//
+// Every model in MODELS is measured unless --filter leaves it out, including the largest ones, plane.obj and piper_pa18.obj.
+// The exit code is 1 if a model was not found or could not be loaded.
+//
+// Every result is one JSON object per line with the keys benchmark, input, runs, best_ms, median_ms, items, unit
+// and per_second, the rate of items at the best time, so runs can be compared by a script.
+// Benchmarks covered:
+//   obj.*    parsing the bundled OBJ models: tinyobj alone, the corner merge, MeshLoader::loadObj and loadObjStreaming
+//   mesh.*   the steps after parsing: vertex cache optimization, levels of detail, quantization,
+//            interleaving for the vertex buffer upload and the binary mesh format round trip
+//   pixel.*  the PixelConvert kernels, see PixelConvertBench for their comparison against scalar loops
+//   frame.*  the per-target matrix math of a frame in AppController and PoseFilter
+// The frame math goes through MatrixMath as in the app, see MatrixMathBench for its comparison against the vuMatrix44F functions.
+
+#include <MatrixMath.h>
+#include <MemoryStream.h>
+#include <MeshLoader.h>
+#include <PixelConvert.h>
+#include <PoseFilter.h>
+#include <tiny_obj_loader.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifndef DEFAULT_ASSETS_DIR
+#define DEFAULT_ASSETS_DIR "Assets"
+#endif
+
+
+namespace
+{
+/// Models bundled with the app, relative to the assets directory
+const char* const MODELS[] = {
+    "ImageTargets/untitled.obj",   "ImageTargets/Astronaut.obj",    "ModelTargets/VikingLander.obj",
+    "ImageTargets/Venus_01.obj",   "ImageTargets/Venus.obj",        "ImageTargets/venera_mis.obj",
+    "ImageTargets/venera.obj",     "ImageTargets/plane.obj",        "ImageTargets/piper_pa18.obj",
+};
+
+/// Benchmarks run on every model
+const char* const MODEL_BENCHMARKS[] = {
+    "obj.parse",      "obj.mergeCorners",  "obj.loadObj",      "obj.loadObjStreaming", "mesh.optimizeVertexCache",
+    "mesh.generateLods", "mesh.quantize", "mesh.interleave", "mesh.writeBinary",     "mesh.parseBinary",
+};
+
+/// Size of the images the pixel kernels convert, a large texture
+constexpr int IMAGE_SIZE = 2048;
+
+/// Frames simulated per run of the frame math and the number of targets tracked in them
+constexpr int FRAMES = 10000;
+const int TARGET_COUNTS[] = { 1, 4, 16 };
+
+struct Options
+{
+    std::string assets = DEFAULT_ASSETS_DIR;
+    std::string filter;
+    int runs = 5;
+    FILE* output = stdout;
+};
+
+
+bool
+readFile(const std::string& path, std::vector<char>& data)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+
+bool
+isSelected(const Options& options, const char* benchmark, const std::string& input)
+{
+    return options.filter.empty() || strstr(benchmark, options.filter.c_str()) != nullptr ||
+           input.find(options.filter) != std::string::npos;
+}
+
+
+/// Run a benchmark options.runs times and write its result line
+/// prepare runs untimed before every run, e.g. to restore state the benchmark modifies in place.
+void
+measure(const Options& options, const char* benchmark, const std::string& input, double items, const char* unit,
+        const std::function<void()>& run, const std::function<void()>& prepare = nullptr)
+{
+    if (!isSelected(options, benchmark, input))
+    {
+        return;
+    }
+
+    std::vector<double> times;
+    times.reserve(options.runs);
+    for (int i = 0; i < options.runs; ++i)
+    {
+        if (prepare)
+        {
+            prepare();
+        }
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        times.push_back(elapsed.count());
+    }
+    std::sort(times.begin(), times.end());
+    double best = times.front();
+    double median = times.size() % 2 ? times[times.size() / 2] : 0.5 * (times[times.size() / 2 - 1] + times[times.size() / 2]);
+
+    fprintf(options.output,
+            "{\"benchmark\":\"%s\",\"input\":\"%s\",\"runs\":%d,\"best_ms\":%.6f,\"median_ms\":%.6f,\"items\":%.6g,"
+            "\"unit\":\"%s\",\"per_second\":%.1f}\n",
+            benchmark, input.c_str(), options.runs, best, median, items, unit, best > 0.0 ? items / (best * 1e-3) : 0.0);
+    fflush(options.output);
+}
+
+
+/// Merge the face corners of a parsed OBJ into unique vertices, the same way MeshLoader::loadObj does
+size_t
+mergeCorners(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes, std::vector<float>& positions,
+             std::vector<float>& texCoords, std::vector<uint32_t>& indices)
+{
+    positions.clear();
+    texCoords.clear();
+    indices.clear();
+    std::unordered_map<uint64_t, uint32_t> uniqueVertices;
+    uniqueVertices.reserve(attrib.vertices.size() / 3);
+
+    uint32_t vertexCount = 0;
+    for (const auto& shape : shapes)
+    {
+        for (const auto& corner : shape.mesh.indices)
+        {
+            uint64_t key =
+                (static_cast<uint64_t>(static_cast<uint32_t>(corner.vertex_index)) << 32) | static_cast<uint32_t>(corner.texcoord_index);
+            auto inserted = uniqueVertices.emplace(key, vertexCount);
+            if (inserted.second)
+            {
+                positions.insert(positions.end(), &attrib.vertices[3 * corner.vertex_index], &attrib.vertices[3 * corner.vertex_index + 3]);
+                if (corner.texcoord_index < 0)
+                {
+                    texCoords.push_back(0.f);
+                    texCoords.push_back(0.f);
+                }
+                else
+                {
+                    texCoords.insert(texCoords.end(), &attrib.texcoords[2 * corner.texcoord_index],
+                                     &attrib.texcoords[2 * corner.texcoord_index + 2]);
+                }
+                ++vertexCount;
+            }
+            indices.push_back(inserted.first->second);
+        }
+    }
+    return indices.size();
+}
+
+
+size_t
+triangleCount(const MeshData& mesh)
+{
+    return (mesh.indices.empty() ? mesh.shortIndices.size() : mesh.indices.size()) / 3;
+}
+
+
+/// Returns false if MeshLoader could not load the model, only the tinyobj benchmarks are run then
+bool
+benchmarkModel(const Options& options, const std::string& name, const std::vector<char>& obj)
+{
+    double megabytes = obj.size() / (1024.0 * 1024.0);
+
+    measure(options, "obj.parse", name, megabytes, "MiB", [&]() {
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warn;
+        std::string err;
+        MemoryInputStream stream(obj.data(), obj.size());
+        tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &stream);
+    });
+
+    // The corner merge alone on the parsed model
+    if (isSelected(options, "obj.mergeCorners", name))
+    {
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warn;
+        std::string err;
+        MemoryInputStream stream(obj.data(), obj.size());
+        if (tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &stream))
+        {
+            std::vector<float> positions;
+            std::vector<float> texCoords;
+            std::vector<uint32_t> indices;
+            double corners = static_cast<double>(mergeCorners(attrib, shapes, positions, texCoords, indices));
+            measure(options, "obj.mergeCorners", name, corners, "corners",
+                    [&]() { mergeCorners(attrib, shapes, positions, texCoords, indices); });
+        }
+    }
+
+    MeshData loaded;
+    if (!MeshLoader::loadObj(obj.data(), obj.size(), loaded))
+    {
+        fprintf(stderr, "%s could not be loaded, skipping it\n", name.c_str());
+        return false;
+    }
+    double triangles = static_cast<double>(triangleCount(loaded));
+    double vertices = static_cast<double>(loaded.vertexCount);
+
+    measure(options, "obj.loadObj", name, megabytes, "MiB", [&]() {
+        MeshData mesh;
+        MeshLoader::loadObj(obj.data(), obj.size(), mesh);
+    });
+    measure(options, "obj.loadObjStreaming", name, megabytes, "MiB", [&]() {
+        MeshData mesh;
+        MeshLoader::loadObjStreaming(obj.data(), obj.size(), mesh);
+    });
+
+    // The steps working in place start from a copy of the loaded mesh every run
+    MeshData mesh;
+    auto restore = [&]() { mesh = loaded; };
+    // optimizeVertexCache works on 32-bit indices, loadObj leaves 16-bit ones where they fit
+    auto restoreWide = [&]() {
+        mesh = loaded;
+        if (!mesh.shortIndices.empty())
+        {
+            mesh.indices.assign(mesh.shortIndices.begin(), mesh.shortIndices.end());
+            mesh.shortIndices.clear();
+        }
+    };
+    measure(options, "mesh.optimizeVertexCache", name, triangles, "triangles", [&]() { MeshLoader::optimizeVertexCache(mesh); },
+            restoreWide);
+    measure(options, "mesh.generateLods", name, triangles, "triangles", [&]() { MeshLoader::generateLods(mesh, 4); }, restore);
+    measure(options, "mesh.quantize", name, vertices, "vertices", [&]() { MeshLoader::quantize(mesh); }, restore);
+
+    std::vector<float> interleaved;
+    MeshView view = MeshLoader::view(loaded);
+    measure(options, "mesh.interleave", name, vertices, "vertices", [&]() { MeshLoader::interleave(view, interleaved); });
+
+    std::vector<char> binary;
+    measure(options, "mesh.writeBinary", name, vertices, "vertices", [&]() { MeshLoader::writeBinary(view, binary); });
+    MeshView parsed;
+    measure(options, "mesh.parseBinary", name, vertices, "vertices",
+            [&]() { MeshLoader::parseBinary(binary.data(), binary.size(), parsed); });
+    return true;
+}
+
+
+void
+benchmarkPixels(const Options& options)
+{
+    const size_t pixelCount = static_cast<size_t>(IMAGE_SIZE) * IMAGE_SIZE;
+    const double megapixels = pixelCount * 1e-6;
+    const std::string input = std::to_string(IMAGE_SIZE) + "x" + std::to_string(IMAGE_SIZE);
+
+    std::mt19937 random(42);
+    std::vector<uint32_t> argb(pixelCount);
+    std::vector<uint8_t> rgb(pixelCount * 3);
+    std::vector<uint16_t> rgb565(pixelCount);
+    std::generate(argb.begin(), argb.end(), [&]() { return static_cast<uint32_t>(random()); });
+    std::generate(rgb.begin(), rgb.end(), [&]() { return static_cast<uint8_t>(random()); });
+    std::generate(rgb565.begin(), rgb565.end(), [&]() { return static_cast<uint16_t>(random()); });
+    std::vector<uint8_t> rgba(pixelCount * 4);
+
+    measure(options, "pixel.argbToRgba", input, megapixels, "Mpixel",
+            [&]() { PixelConvert::argbToRgba(argb.data(), rgba.data(), pixelCount); });
+    measure(options, "pixel.rgbToRgba", input, megapixels, "Mpixel",
+            [&]() { PixelConvert::rgbToRgba(rgb.data(), rgba.data(), pixelCount); });
+    measure(options, "pixel.rgb565ToRgba", input, megapixels, "Mpixel",
+            [&]() { PixelConvert::rgb565ToRgba(rgb565.data(), rgba.data(), pixelCount); });
+
+    // The in place kernels start from the same pixels every run
+    auto restore = [&]() { memcpy(rgba.data(), argb.data(), rgba.size()); };
+    measure(options, "pixel.argbToRgbaFlipRows", input, megapixels, "Mpixel",
+            [&]() { PixelConvert::argbToRgbaFlipRows(rgba.data(), IMAGE_SIZE, IMAGE_SIZE); }, restore);
+    measure(options, "pixel.premultiplyAlpha", input, megapixels, "Mpixel",
+            [&]() { PixelConvert::premultiplyAlpha(rgba.data(), pixelCount); }, restore);
+    measure(options, "pixel.premultiplyAlphaSrgb", input, megapixels, "Mpixel",
+            [&]() { PixelConvert::premultiplyAlpha(rgba.data(), pixelCount, true); }, restore);
+}
+
+
+/// Rigid pose rotated by angle around the axis x = y = z and translated
+VuMatrix44F
+makePose(float angle, const VuVector3F& translation)
+{
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    float t = (1.0f - c) / 3.0f;
+    float a = s / std::sqrt(3.0f);
+    VuMatrix44F pose = MatrixMath::translation(translation);
+    pose.data[0] = pose.data[5] = pose.data[10] = c + t;
+    pose.data[1] = pose.data[6] = pose.data[8] = t + a;
+    pose.data[2] = pose.data[4] = pose.data[9] = t - a;
+    return pose;
+}
+
+
+/// The per-target math of a frame: model-view and box matrices as extracted, filtered and turned into MVPs
+void
+benchmarkFrameMath(const Options& options)
+{
+    VuMatrix44F projection{};
+    projection.data[0] = 1.8f;
+    projection.data[5] = 3.2f;
+    projection.data[10] = -1.0f;
+    projection.data[11] = -1.0f;
+    projection.data[14] = -0.02f;
+    VuMatrix44F view = makePose(0.3f, { 0.01f, -0.02f, 0.0f });
+    const VuVector3F size{ 0.2f, 0.15f, 0.1f };
+    const VuVector3F center{ 0.0f, 0.0f, 0.05f };
+
+    for (int targetCount : TARGET_COUNTS)
+    {
+        std::string input = std::to_string(targetCount) + (targetCount == 1 ? " target" : " targets");
+        std::vector<PoseFilter> filters(targetCount);
+        std::vector<VuMatrix44F> mvps(targetCount);
+        double frameTime = 0.0;
+
+        // Targets moving slowly with jitter, as the filter sees them
+        auto run = [&]() {
+            for (int frame = 0; frame < FRAMES; ++frame)
+            {
+                frameTime += 1.0 / 60.0;
+                for (int i = 0; i < targetCount; ++i)
+                {
+                    float jitter = 0.001f * static_cast<float>((frame * 7 + i * 13) % 5);
+                    VuMatrix44F model = makePose(0.01f * frame + i, { 0.1f * i, jitter, -0.5f });
+
+                    VuMatrix44F modelView = MatrixMath::multiply(view, model);
+                    VuMatrix44F box =
+                        MatrixMath::multiply(modelView, MatrixMath::multiply(MatrixMath::translation(center), MatrixMath::scaling(size)));
+                    VuMatrix44F filtered = filters[i].filter(modelView, frameTime);
+                    VuMatrix44F local = MatrixMath::multiply(MatrixMath::inverseRigid(modelView), box);
+                    mvps[i] = MatrixMath::multiply(projection, MatrixMath::multiply(filtered, local));
+                }
+            }
+        };
+        measure(options, "frame.targetMath", input, static_cast<double>(FRAMES), "frames", run);
+
+        // The pose filter alone
+        measure(options, "frame.poseFilter", input, static_cast<double>(FRAMES), "frames", [&]() {
+            for (int frame = 0; frame < FRAMES; ++frame)
+            {
+                frameTime += 1.0 / 60.0;
+                for (int i = 0; i < targetCount; ++i)
+                {
+                    mvps[i] = filters[i].filter(mvps[i], frameTime);
+                }
+            }
+        });
+    }
+}
+
+
+bool
+parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--assets") == 0 && hasValue)
+        {
+            options.assets = argv[++i];
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && hasValue)
+        {
+            options.filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--runs") == 0 && hasValue)
+        {
+            options.runs = atoi(argv[++i]);
+            if (options.runs <= 0)
+            {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--output") == 0 && hasValue)
+        {
+            options.output = fopen(argv[++i], "w");
+            if (options.output == nullptr)
+            {
+                fprintf(stderr, "Cannot write %s\n", argv[i]);
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+
+int
+main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "Usage: %s [--assets <dir>] [--filter <text>] [--runs <count>] [--output <file>]\n", argv[0]);
+        return 2;
+    }
+
+    int failed = 0;
+    for (const char* model : MODELS)
+    {
+        std::string name = strrchr(model, '/') + 1;
+        // Reading and loading the large models takes a while, they are skipped if the filter selects none of their benchmarks
+        bool selected = false;
+        for (const char* benchmark : MODEL_BENCHMARKS)
+        {
+            selected |= isSelected(options, benchmark, name);
+        }
+        if (!selected)
+        {
+            continue;
+        }
+        std::vector<char> obj;
+        if (!readFile(options.assets + "/" + model, obj))
+        {
+            fprintf(stderr, "%s/%s not found, skipping it\n", options.assets.c_str(), model);
+            ++failed;
+            continue;
+        }
+        if (!benchmarkModel(options, name, obj))
+        {
+            ++failed;
+        }
+    }
+
+    benchmarkPixels(options);
+    benchmarkFrameMath(options);
+
+    if (options.output != stdout)
+    {
+        fclose(options.output);
+    }
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,314 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+// Micro-benchmark of the MatrixMath functions against their scalar reference and the vuMatrix44F functions
+//
+// Usage: MatrixMathBench [<matrix count>]
+//
+// Every function is checked against the scalar reference on random rigid poses first, the exit code is 1 on a mismatch.
+// The vuMatrix44F functions are only measured in a build for the device ABI, which links libVuforiaEngine.so:
+// configure with the NDK toolchain file and run it through adb shell, with the engine library next to it.
+
+#include <MatrixMath.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+
+namespace
+{
+constexpr int RUNS = 10;
+/// Passes over the matrices per run, so that a run takes long enough to be timed
+constexpr int PASSES = 100;
+/// Largest difference to the scalar reference, the vector paths may round differently
+constexpr float TOLERANCE = 1e-5f;
+
+// The builders and the scalar functions are constant expressions
+constexpr VuMatrix44F TRANSLATED_SCALING =
+    MatrixMath::Scalar::multiply(MatrixMath::translation({ 1.0f, 2.0f, 3.0f }), MatrixMath::scaling({ 2.0f, 2.0f, 2.0f }));
+static_assert(TRANSLATED_SCALING.data[0] == 2.0f && TRANSLATED_SCALING.data[12] == 1.0f,
+              "MatrixMath must be usable in constant expressions");
+
+
+/// Rigid pose rotated by angle around a random axis and translated within a meter
+VuMatrix44F
+randomPose(std::mt19937& random)
+{
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    float axis[3] = { distribution(random), distribution(random), distribution(random) };
+    float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    for (float& value : axis)
+    {
+        value /= std::max(length, 1e-3f);
+    }
+    float angle = 3.14159265f * distribution(random);
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    float t = 1.0f - c;
+
+    // Rodrigues' rotation formula, column-major
+    VuMatrix44F pose = MatrixMath::translation({ distribution(random), distribution(random), distribution(random) });
+    for (int column = 0; column < 3; ++column)
+    {
+        for (int row = 0; row < 3; ++row)
+        {
+            float value = t * axis[row] * axis[column];
+            if (row == column)
+            {
+                value += c;
+            }
+            else
+            {
+                int other = 3 - row - column;
+                // The cross product matrix of the axis
+                float sign = (column == (row + 1) % 3) ? -1.0f : 1.0f;
+                value += sign * s * axis[other];
+            }
+            pose.data[column * 4 + row] = value;
+        }
+    }
+    return pose;
+}
+
+
+float
+maxDifference(const std::vector<VuMatrix44F>& a, const std::vector<VuMatrix44F>& b)
+{
+    float difference = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        for (int j = 0; j < 16; ++j)
+        {
+            difference = std::max(difference, std::fabs(a[i].data[j] - b[i].data[j]));
+        }
+    }
+    return difference;
+}
+
+
+/// Best time of RUNS runs in nanoseconds per matrix
+double
+measure(size_t count, const std::function<void()>& run)
+{
+    double best = 1e30;
+    for (int i = 0; i < RUNS; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < PASSES; ++pass)
+        {
+            run();
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / (static_cast<double>(count) * PASSES));
+    }
+    return best;
+}
+
+
+/// Print the timings of a function, its reference and the Vuforia function if there is one, returns false on a mismatch
+bool
+report(const char* name, size_t count, const std::vector<VuMatrix44F>& result, const std::vector<VuMatrix44F>& expected,
+       const std::function<void()>& function, const std::function<void()>& reference, const std::function<void()>& vuforia)
+{
+    function();
+    reference();
+    float difference = maxDifference(result, expected);
+    bool matches = difference <= TOLERANCE;
+
+    double functionTime = measure(count, function);
+    double referenceTime = measure(count, reference);
+    printf("%-14s %7.2f ns   scalar %7.2f ns  %5.2fx", name, functionTime, referenceTime, referenceTime / functionTime);
+    if (vuforia)
+    {
+        vuforia();
+        float vuforiaDifference = maxDifference(result, expected);
+        if (vuforiaDifference > TOLERANCE)
+        {
+            fprintf(stderr, "%s: differs from the vuMatrix44F function by up to %g\n", name, vuforiaDifference);
+            matches = false;
+        }
+        double vuforiaTime = measure(count, vuforia);
+        printf("   vuMatrix44F %7.2f ns  %5.2fx", vuforiaTime, vuforiaTime / functionTime);
+    }
+    printf("%s\n", matches ? "" : "   MISMATCH");
+    if (difference > TOLERANCE)
+    {
+        fprintf(stderr, "%s: differs from the reference by up to %g\n", name, difference);
+    }
+    return matches;
+}
+} // namespace
+
+
+int
+main(int argc, char** argv)
+{
+    int count = 1024;
+    if (argc == 2)
+    {
+        count = atoi(argv[1]);
+    }
+    else if (argc != 1)
+    {
+        fprintf(stderr, "Usage: %s [<matrix count>]\n", argv[0]);
+        return 2;
+    }
+    if (count <= 0)
+    {
+        fprintf(stderr, "Invalid matrix count %d\n", count);
+        return 2;
+    }
+
+    std::mt19937 random(42);
+    std::vector<VuMatrix44F> poses(count);
+    std::vector<VuMatrix44F> views(count);
+    std::vector<VuVector3F> scales(count);
+    std::uniform_real_distribution<float> scaleDistribution(0.01f, 2.0f);
+    for (int i = 0; i < count; ++i)
+    {
+        poses[i] = randomPose(random);
+        views[i] = randomPose(random);
+        scales[i] = { scaleDistribution(random), scaleDistribution(random), scaleDistribution(random) };
+    }
+    // A perspective projection as the renderer gets it
+    VuMatrix44F projection{};
+    projection.data[0] = 1.8f;
+    projection.data[5] = 3.2f;
+    projection.data[10] = -1.002f;
+    projection.data[11] = -1.0f;
+    projection.data[14] = -0.02f;
+
+    std::vector<VuMatrix44F> result(count);
+    std::vector<VuMatrix44F> expected(count);
+    bool passed = true;
+
+#if MATRIXMATH_NEON
+    const char* path = "NEON";
+#elif MATRIXMATH_SSE
+    const char* path = "SSE";
+#else
+    const char* path = "scalar";
+#endif
+    printf("%d matrices, %s, best of %d runs, time per matrix\n", count, path, RUNS);
+
+    std::function<void()> vuforia;
+
+#ifdef MATRIXMATH_BENCH_VUFORIA
+    vuforia = [&]() {
+        for (int i = 0; i < count; ++i)
+        {
+            expected[i] = vuMatrix44FMultiplyMatrix(views[i], poses[i]);
+        }
+    };
+#endif
+    passed &= report(
+        "multiply", count, result, expected,
+        [&]() {
+            for (int i = 0; i < count; ++i)
+            {
+                result[i] = MatrixMath::multiply(views[i], poses[i]);
+            }
+        },
+        [&]() {
+            for (int i = 0; i < count; ++i)
+            {
+                expected[i] = MatrixMath::Scalar::multiply(views[i], poses[i]);
+            }
+        },
+        vuforia);
+
+#ifdef MATRIXMATH_BENCH_VUFORIA
+    vuforia = [&]() {
+        for (int i = 0; i < count; ++i)
+        {
+            expected[i] = vuMatrix44FMultiplyMatrix(projection, poses[i]);
+        }
+    };
+#endif
+    passed &= report(
+        "multiplyBatch", count, result, expected, [&]() { MatrixMath::multiplyBatch(projection, poses.data(), count, result.data()); },
+        [&]() {
+            for (int i = 0; i < count; ++i)
+            {
+                expected[i] = MatrixMath::Scalar::multiply(projection, poses[i]);
+            }
+        },
+        vuforia);
+
+#ifdef MATRIXMATH_BENCH_VUFORIA
+    vuforia = [&]() {
+        for (int i = 0; i < count; ++i)
+        {
+            expected[i] = vuMatrix44FScale(scales[i], poses[i]);
+        }
+    };
+#endif
+    passed &= report(
+        "scale", count, result, expected,
+        [&]() {
+            for (int i = 0; i < count; ++i)
+            {
+                result[i] = MatrixMath::scale(scales[i], poses[i]);
+            }
+        },
+        [&]() {
+            for (int i = 0; i < count; ++i)
+            {
+                expected[i] = MatrixMath::Scalar::scale(scales[i], poses[i]);
+            }
+        },
+        vuforia);
+
+    // Compared against the general inverse, which is what the app called before
+#ifdef MATRIXMATH_BENCH_VUFORIA
+    vuforia = [&]() {
+        for (int i = 0; i < count; ++i)
+        {
+            expected[i] = vuMatrix44FInverse(poses[i]);
+        }
+    };
+#endif
+    passed &= report(
+        "inverseRigid", count, result, expected,
+        [&]() {
+            for (int i = 0; i < count; ++i)
+            {
+                result[i] = MatrixMath::inverseRigid(poses[i]);
+            }
+        },
+        [&]() {
+            for (int i = 0; i < count; ++i)
+            {
+                expected[i] = MatrixMath::Scalar::inverseRigid(poses[i]);
+            }
+        },
+        vuforia);
+
+    // The inverse of a pose times the pose is the identity
+    float identityError = 0.0f;
+    for (int i = 0; i < count; ++i)
+    {
+        VuMatrix44F product = MatrixMath::Scalar::multiply(MatrixMath::Scalar::inverseRigid(poses[i]), poses[i]);
+        for (int j = 0; j < 16; ++j)
+        {
+            identityError = std::max(identityError, std::fabs(product.data[j] - MatrixMath::identity().data[j]));
+        }
+    }
+    if (identityError > TOLERANCE)
+    {
+        fprintf(stderr, "inverseRigid: the inverse times the pose differs from the identity by up to %g\n", identityError);
+        passed = false;
+    }
+
+    return passed ? 0 : 1;
+}
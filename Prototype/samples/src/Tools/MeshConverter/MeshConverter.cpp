@@ -0,0 +1,165 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+// Command line tool converting OBJ models into the binary mesh format (see MeshFormat.h)
+//
+// Usage: MeshConverter [--quantize] [--lods <count>] [--extract-lod <level>] [--bake-shading] [--light <x,y,z>]
+//                      <input.obj> <output.mesh>
+//
+// --quantize stores 16-bit normalized positions and texture coordinates, see MeshFormat::QuantizedVertex
+// --lods generates up to count levels of detail in total, see MeshLoader::generateLods
+// --extract-lod writes only one of the generated levels, e.g. the coarse model of a remote artwork, see ContentManifest
+// --bake-shading stores a byte of ambient occlusion and directional light per vertex, see VertexShadingBaker
+// --light sets the direction towards the light for --bake-shading in model space
+
+#include <Log.h>
+#include <MeshLoader.h>
+#include <VertexShadingBaker.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+
+namespace
+{
+bool
+readFile(const char* path, std::vector<char>& data)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        LOG("Error opening %s", path);
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+
+bool
+writeFile(const char* path, const std::vector<char>& data)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file || !file.write(data.data(), data.size()))
+    {
+        LOG("Error writing %s", path);
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+
+int
+main(int argc, char** argv)
+{
+    bool quantize = false;
+    bool bakeShading = false;
+    VertexShadingBaker::Options shadingOptions;
+    int lodCount = 1;
+    int extractedLod = -1;
+    int argument = 1;
+    for (; argument < argc - 2; ++argument)
+    {
+        if (strcmp(argv[argument], "--quantize") == 0)
+        {
+            quantize = true;
+        }
+        else if (strcmp(argv[argument], "--lods") == 0 && argument + 1 < argc - 2)
+        {
+            lodCount = atoi(argv[++argument]);
+        }
+        else if (strcmp(argv[argument], "--extract-lod") == 0 && argument + 1 < argc - 2)
+        {
+            extractedLod = atoi(argv[++argument]);
+        }
+        else if (strcmp(argv[argument], "--bake-shading") == 0)
+        {
+            bakeShading = true;
+        }
+        else if (strcmp(argv[argument], "--light") == 0 && argument + 1 < argc - 2)
+        {
+            float* light = shadingOptions.lightDirection;
+            if (sscanf(argv[++argument], "%f,%f,%f", &light[0], &light[1], &light[2]) != 3)
+            {
+                break;
+            }
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (argument != argc - 2 || lodCount < 1 || (extractedLod != -1 && (extractedLod < 0 || extractedLod >= lodCount)))
+    {
+        fprintf(stderr,
+                "Usage: %s [--quantize] [--lods <count>] [--extract-lod <level>] [--bake-shading] [--light <x,y,z>] <input.obj> "
+                "<output.mesh>\n",
+                argv[0]);
+        return 2;
+    }
+    const char* inputPath = argv[argc - 2];
+    const char* outputPath = argv[argc - 1];
+
+    std::vector<char> objData;
+    if (!readFile(inputPath, objData))
+    {
+        return 1;
+    }
+
+    MeshData mesh;
+    if (!MeshLoader::loadObjStreaming(objData.data(), objData.size(), mesh))
+    {
+        LOG("Error converting %s", inputPath);
+        return 1;
+    }
+    // Baked on the full resolution mesh, the levels of detail share its vertices
+    if (bakeShading && !VertexShadingBaker::bake(mesh, shadingOptions))
+    {
+        LOG("Error baking the shading of %s", inputPath);
+        return 1;
+    }
+    if (lodCount > 1)
+    {
+        MeshLoader::generateLods(mesh, lodCount);
+        for (size_t i = 0; i < mesh.lods.size(); ++i)
+        {
+            LOG("  level %zu: %u triangles, error %f", i, mesh.lods[i].indexCount / 3, mesh.lods[i].error);
+        }
+    }
+    if (extractedLod != -1)
+    {
+        MeshLoader::extractLod(mesh, extractedLod);
+    }
+    if (quantize)
+    {
+        MeshLoader::quantize(mesh);
+    }
+
+    std::vector<char> meshData;
+    if (!MeshLoader::writeBinary(MeshLoader::view(mesh), meshData) || !writeFile(outputPath, meshData))
+    {
+        return 1;
+    }
+
+    // Round-trip the output so that a corrupt file never makes it into the APK
+    MeshView check;
+    if (!MeshLoader::parseBinary(meshData.data(), meshData.size(), check) || check.vertexCount != mesh.vertexCount ||
+        (check.quantizedVertices != nullptr) != quantize || check.shaded != bakeShading || check.lodCount != static_cast<int>(mesh.lods.size()))
+    {
+        LOG("Error validating %s", outputPath);
+        return 1;
+    }
+
+    LOG("%s: %d vertices, %zu bytes -> %s: %zu bytes%s%s", inputPath, mesh.vertexCount, objData.size(), outputPath, meshData.size(),
+        quantize ? " (quantized)" : "", bakeShading ? " (shaded)" : "");
+    return 0;
+}
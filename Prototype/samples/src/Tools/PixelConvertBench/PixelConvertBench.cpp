@@ -0,0 +1,208 @@
+/*===============================================================================
+Copyright (c) 2022 PTC Inc. All Rights Reserved.
+
+Vuforia is a trademark of PTC Inc., registered in the United States and other
+countries.
+===============================================================================*/
+
+// Micro-benchmark of the PixelConvert kernels against straightforward scalar loops
+//
+// Usage: PixelConvertBench [<width> <height>]
+//
+// Every kernel is checked against the scalar reference on random pixels first, the exit code is 1 on a mismatch.
+// Build it for the device ABI to measure the NEON paths, e.g. with the NDK toolchain file and run it through adb shell.
+
+#include <PixelConvert.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+
+namespace
+{
+constexpr int RUNS = 10;
+
+void
+referenceArgbToRgba(const uint32_t* argb, uint8_t* rgba, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint32_t color = argb[i];
+        rgba[i * 4] = static_cast<uint8_t>(color >> 16);
+        rgba[i * 4 + 1] = static_cast<uint8_t>(color >> 8);
+        rgba[i * 4 + 2] = static_cast<uint8_t>(color);
+        rgba[i * 4 + 3] = static_cast<uint8_t>(color >> 24);
+    }
+}
+
+
+void
+referenceRgbToRgba(const uint8_t* rgb, uint8_t* rgba, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        rgba[i * 4] = rgb[i * 3];
+        rgba[i * 4 + 1] = rgb[i * 3 + 1];
+        rgba[i * 4 + 2] = rgb[i * 3 + 2];
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+
+void
+referenceRgb565ToRgba(const uint16_t* rgb565, uint8_t* rgba, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint32_t r = rgb565[i] >> 11;
+        uint32_t g = (rgb565[i] >> 5) & 0x3F;
+        uint32_t b = rgb565[i] & 0x1F;
+        // Replicating the high bits, as GPUs expand 565 textures
+        rgba[i * 4] = static_cast<uint8_t>((r << 3) | (r >> 2));
+        rgba[i * 4 + 1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+        rgba[i * 4 + 2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+
+void
+referencePremultiply(uint8_t* rgba, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            rgba[i * 4 + channel] = static_cast<uint8_t>(std::lround(rgba[i * 4 + channel] * rgba[i * 4 + 3] / 255.0));
+        }
+    }
+}
+
+
+/// Best time of RUNS runs in milliseconds
+double
+measure(const std::function<void()>& run)
+{
+    double best = 1e30;
+    for (int i = 0; i < RUNS; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+
+/// Print the timings of a kernel and its reference, returns false if their outputs differ
+bool
+report(const char* name, size_t pixelCount, const std::vector<uint8_t>& result, const std::vector<uint8_t>& expected,
+       const std::function<void()>& kernel, const std::function<void()>& reference)
+{
+    size_t mismatches = 0;
+    for (size_t i = 0; i < result.size(); ++i)
+    {
+        mismatches += result[i] != expected[i] ? 1 : 0;
+    }
+
+    double kernelTime = measure(kernel);
+    double referenceTime = measure(reference);
+    printf("%-20s %8.2f ms %8.1f Mpixel/s   reference %8.2f ms   speedup %5.2fx%s\n", name, kernelTime,
+           pixelCount / kernelTime / 1000.0, referenceTime, referenceTime / kernelTime, mismatches ? "   MISMATCH" : "");
+    if (mismatches)
+    {
+        fprintf(stderr, "%s: %zu bytes differ from the reference\n", name, mismatches);
+    }
+    return mismatches == 0;
+}
+} // namespace
+
+
+int
+main(int argc, char** argv)
+{
+    int width = 2048;
+    int height = 2048;
+    if (argc == 3)
+    {
+        width = atoi(argv[1]);
+        height = atoi(argv[2]);
+    }
+    else if (argc != 1)
+    {
+        fprintf(stderr, "Usage: %s [<width> <height>]\n", argv[0]);
+        return 2;
+    }
+    if (width <= 0 || height <= 0)
+    {
+        fprintf(stderr, "Invalid image size %dx%d\n", width, height);
+        return 2;
+    }
+
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    std::mt19937 random(42);
+    std::vector<uint32_t> argb(pixelCount);
+    std::vector<uint8_t> rgb(pixelCount * 3);
+    std::vector<uint16_t> rgb565(pixelCount);
+    for (auto& value : argb)
+    {
+        value = random();
+    }
+    for (auto& value : rgb)
+    {
+        value = static_cast<uint8_t>(random());
+    }
+    for (auto& value : rgb565)
+    {
+        value = static_cast<uint16_t>(random());
+    }
+
+    std::vector<uint8_t> result(pixelCount * 4);
+    std::vector<uint8_t> expected(pixelCount * 4);
+    bool passed = true;
+
+    printf("%dx%d pixels, best of %d runs\n", width, height, RUNS);
+
+    auto argbKernel = [&]() { PixelConvert::argbToRgba(argb.data(), result.data(), pixelCount); };
+    auto argbReference = [&]() { referenceArgbToRgba(argb.data(), expected.data(), pixelCount); };
+    argbKernel();
+    argbReference();
+    passed &= report("argbToRgba", pixelCount, result, expected, argbKernel, argbReference);
+
+    auto rgbKernel = [&]() { PixelConvert::rgbToRgba(rgb.data(), result.data(), pixelCount); };
+    auto rgbReference = [&]() { referenceRgbToRgba(rgb.data(), expected.data(), pixelCount); };
+    rgbKernel();
+    rgbReference();
+    passed &= report("rgbToRgba", pixelCount, result, expected, rgbKernel, rgbReference);
+
+    auto rgb565Kernel = [&]() { PixelConvert::rgb565ToRgba(rgb565.data(), result.data(), pixelCount); };
+    auto rgb565Reference = [&]() { referenceRgb565ToRgba(rgb565.data(), expected.data(), pixelCount); };
+    rgb565Kernel();
+    rgb565Reference();
+    passed &= report("rgb565ToRgba", pixelCount, result, expected, rgb565Kernel, rgb565Reference);
+
+    // Premultiplication works in place, every run starts from the same unpremultiplied pixels
+    std::vector<uint8_t> source(argb.size() * 4);
+    memcpy(source.data(), argb.data(), source.size());
+    auto premultiplyKernel = [&]() {
+        memcpy(result.data(), source.data(), source.size());
+        PixelConvert::premultiplyAlpha(result.data(), pixelCount);
+    };
+    auto premultiplyReference = [&]() {
+        memcpy(expected.data(), source.data(), source.size());
+        referencePremultiply(expected.data(), pixelCount);
+    };
+    premultiplyKernel();
+    premultiplyReference();
+    passed &= report("premultiplyAlpha", pixelCount, result, expected, premultiplyKernel, premultiplyReference);
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+"""
+Compress a texture for the app into KTX 1.1 containers.
+
+Two variants are written next to each other:
+  <name>.astc.ktx  ASTC, encoded with astcenc (https://github.com/ARM-software/astc-encoder)
+  <name>.etc2.ktx  ETC2, encoded with EtcTool (https://github.com/google/etc2comp)
+
+The app uploads the ASTC variant where GL_KHR_texture_compression_astc_ldr is supported
+and the ETC2 variant otherwise, ETC2 is core in OpenGL ES 3.0. Without either file the app
+decodes the original image into an uncompressed RGBA8 texture.
+
+The image is flipped before encoding so that the rows are stored bottom-up as GL expects them,
+matching the uncompressed path in Texture.kt. The full mip chain down to 1x1 is stored, each level
+is downsampled from the previous one and encoded separately.
+
+Usage: python3 compress_texture.py [--block 6x6] [--alpha] [--no-mipmaps] -o <output dir> <texture.jpg>
+"""
+import argparse
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+
+from PIL import Image
+
+
+KTX_IDENTIFIER = bytes([0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A])
+KTX_ENDIANNESS = 0x04030201
+
+GL_RGB = 0x1907
+GL_RGBA = 0x1908
+GL_COMPRESSED_RGB8_ETC2 = 0x9274
+GL_COMPRESSED_RGBA8_ETC2_EAC = 0x9278
+
+# GL_COMPRESSED_RGBA_ASTC_<w>x<h>_KHR, the formats are numbered in this order from 0x93B0
+ASTC_BLOCKS = ['4x4', '5x4', '5x5', '6x5', '6x6', '8x5', '8x6', '8x8', '10x5', '10x6', '10x8', '10x10', '12x10', '12x12']
+ASTC_MAGIC = 0x5CA1AB13
+
+
+def write_ktx(path, internal_format, base_internal_format, width, height, levels):
+    with open(path, 'wb') as ktx:
+        ktx.write(KTX_IDENTIFIER)
+        # glType, glTypeSize and glFormat are 0, 1 and 0 for compressed formats. No array elements, one face
+        ktx.write(struct.pack('<13I', KTX_ENDIANNESS, 0, 1, 0, internal_format, base_internal_format,
+                              width, height, 0, 0, 1, len(levels), 0))
+        for level in levels:
+            ktx.write(struct.pack('<I', len(level)))
+            ktx.write(level)
+            ktx.write(b'\0' * (-len(level) % 4))
+
+
+def read_ktx_level(path):
+    """Return the base level of a KTX 1.1 file written by an encoder"""
+    with open(path, 'rb') as ktx:
+        data = ktx.read()
+    if data[:12] != KTX_IDENTIFIER:
+        raise RuntimeError(path + ' is not a KTX 1.1 file')
+    header = struct.unpack('<13I', data[12:64])
+    if header[0] != KTX_ENDIANNESS:
+        raise RuntimeError(path + ' is not little-endian')
+    offset = 64 + header[12]
+    size = struct.unpack('<I', data[offset:offset + 4])[0]
+    return data[offset + 4:offset + 4 + size]
+
+
+def encode_astc(astcenc, image_path, work_dir, block, quality):
+    output = os.path.join(work_dir, 'level.astc')
+    subprocess.run([astcenc, '-cl', image_path, output, block, '-' + quality, '-silent'], check=True)
+    with open(output, 'rb') as astc:
+        data = astc.read()
+    # 16 byte header: magic, block size in x, y, z and the image size as 24-bit values
+    if struct.unpack('<I', data[:4])[0] != ASTC_MAGIC:
+        raise RuntimeError('astcenc wrote an unexpected file')
+    return data[16:]
+
+
+def encode_etc2(etctool, image_path, work_dir, alpha, effort):
+    output = os.path.join(work_dir, 'level.ktx')
+    subprocess.run([etctool, image_path, '-format', 'RGBA8' if alpha else 'RGB8', '-effort', str(effort),
+                    '-output', output], check=True, stdout=subprocess.DEVNULL)
+    return read_ktx_level(output)
+
+
+def build_mip_chain(image, mipmaps):
+    levels = [image]
+    while mipmaps and levels[-1].size != (1, 1):
+        width, height = levels[-1].size
+        levels.append(levels[-1].resize((max(width // 2, 1), max(height // 2, 1)), Image.BOX))
+    return levels
+
+
+def compress_texture(source_texture, output_dir, block, alpha, mipmaps, quality, effort, astcenc, etctool):
+    name = os.path.splitext(os.path.basename(source_texture))[0]
+    image = Image.open(source_texture).convert('RGBA' if alpha else 'RGB').transpose(Image.FLIP_TOP_BOTTOM)
+    width, height = image.size
+    levels = build_mip_chain(image, mipmaps)
+
+    print("Encoding {} with {} mip levels".format(name, len(levels)))
+    astc = []
+    etc2 = []
+    with tempfile.TemporaryDirectory() as work_dir:
+        image_path = os.path.join(work_dir, 'level.png')
+        for level in levels:
+            level.save(image_path)
+            astc.append(encode_astc(astcenc, image_path, work_dir, block, quality))
+            etc2.append(encode_etc2(etctool, image_path, work_dir, alpha, effort))
+
+    write_ktx(os.path.join(output_dir, name + '.astc.ktx'), 0x93B0 + ASTC_BLOCKS.index(block), GL_RGBA,
+              width, height, astc)
+    write_ktx(os.path.join(output_dir, name + '.etc2.ktx'),
+              GL_COMPRESSED_RGBA8_ETC2_EAC if alpha else GL_COMPRESSED_RGB8_ETC2, GL_RGBA if alpha else GL_RGB,
+              width, height, etc2)
+
+    print("Compressed {}: {} KB RGBA8, {} KB ASTC {}, {} KB ETC2".format(
+        name, width * height * 4 // 1024, sum(map(len, astc)) // 1024, block, sum(map(len, etc2)) // 1024))
+    return True
+
+
+def parse_arguments():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('texture', type=str)
+    parser.add_argument('-o', '--output', required=True, type=str, help='directory receiving the KTX files')
+    parser.add_argument('--block', default='6x6', choices=ASTC_BLOCKS, help='ASTC block size, larger blocks compress more')
+    parser.add_argument('--alpha', action='store_true', help='keep the alpha channel, uses ETC2 RGBA8 instead of RGB8')
+    parser.add_argument('--no-mipmaps', dest='mipmaps', action='store_false', help='only store the base level')
+    parser.add_argument('--quality', default='medium', choices=['fast', 'medium', 'thorough', 'exhaustive'])
+    parser.add_argument('--effort', default=60, type=int, help='EtcTool effort between 0 and 100')
+    parser.add_argument('--astcenc', default='astcenc', type=str, help='path to the astcenc executable')
+    parser.add_argument('--etctool', default='EtcTool', type=str, help='path to the EtcTool executable')
+    return parser
+
+
+def main():
+    parameters = parse_arguments().parse_args(sys.argv[1:])
+    os.makedirs(parameters.output, exist_ok=True)
+    compress_texture(parameters.texture, parameters.output, parameters.block, parameters.alpha, parameters.mipmaps,
+                     parameters.quality, parameters.effort, parameters.astcenc, parameters.etctool)
+
+
+if __name__ == '__main__':
+    main()